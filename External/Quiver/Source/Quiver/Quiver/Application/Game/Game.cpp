@@ -1,6 +1,9 @@
 #include "Game.h"
 
+#include <ctime>
+
 #include <SFML/Audio/Listener.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/RenderTexture.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Sprite.hpp>
@@ -14,11 +17,16 @@
 #include "Quiver/Input/RawInput.h"
 #include "Quiver/Input/InputDebug.h"
 #include "Quiver/Misc/ImGuiHelpers.h"
+#include "Quiver/Misc/Profiler.h"
 #include "Quiver/World/World.h"
 #include "Quiver/World/WorldContext.h"
 
 namespace qvr {
 
+// Live in World.cpp.
+extern Profiler sStepProfiler;
+extern Profiler sRenderProfiler;
+
 Game::Game(ApplicationStateContext& context)
 	: Game(context, nullptr)
 {}
@@ -56,8 +64,10 @@ void Game::ProcessFrame()
 	using namespace std::chrono_literals;
 
 	if (GetContext().WindowResized()) {
-		const auto newSize = GetContext().GetWindow().getSize();
-		mFrameTex->create(newSize.x, newSize.y);
+		UpdateFrameTexture(
+			*mFrameTex,
+			GetContext().GetWindow().getSize(),
+			GetFrameTextureScale());
 	}
 
 	// Clamp excessively large delta times.
@@ -111,6 +121,12 @@ void Game::ProcessFrame()
 
 			mFrameTex->display();
 		}
+
+		if (mKeyboard.JustDown(qvr::KeyboardKey::F12)) {
+			TakeScreenshot();
+		}
+
+		UpdateDynamicResolution();
 	}
 
 	mMouse.OnFrame();
@@ -182,6 +198,71 @@ void Game::OnTogglePause()
 	}
 }
 
+float Game::GetFrameTextureScale()
+{
+	return
+		mDynamicResolutionActive ?
+		mDynamicResolution.GetScale() :
+		GetContext().GetFrameTextureResolutionRatio();
+}
+
+void Game::UpdateDynamicResolution()
+{
+	const RenderSettings& settings = mWorld->GetRenderSettings();
+
+	bool resize = false;
+
+	if (settings.m_DynamicResolution != mDynamicResolutionActive)
+	{
+		mDynamicResolutionActive = settings.m_DynamicResolution;
+
+		if (mDynamicResolutionActive) {
+			// Start from wherever the user had it.
+			mDynamicResolution.Reset(settings, GetContext().GetFrameTextureResolutionRatio());
+		}
+
+		resize = true;
+	}
+	else if (mDynamicResolutionActive)
+	{
+		resize = mDynamicResolution.Update(
+			settings,
+			sStepProfiler.GetLatest(),
+			sRenderProfiler.GetLatest());
+	}
+
+	if (resize)
+	{
+		UpdateFrameTexture(
+			*mFrameTex,
+			GetContext().GetWindow().getSize(),
+			GetFrameTextureScale());
+	}
+}
+
+void Game::TakeScreenshot()
+{
+	auto log = spdlog::get("console");
+	assert(log);
+
+	sf::Image image;
+	image.create(mFrameTex->getSize().x, mFrameTex->getSize().y);
+
+	mWorld->Render3D(
+		image,
+		mWorld->GetMainCamera() ? *mWorld->GetMainCamera() : mDefaultCamera3D,
+		mWorldRaycastRenderer);
+
+	const std::string filename = fmt::format("Screenshot-{}.png", std::time(nullptr));
+
+	if (image.saveToFile(filename)) {
+		log->info("Saved a screenshot to {}.", filename);
+	}
+	else {
+		log->error("Couldn't save a screenshot to {}.", filename);
+	}
+}
+
 void Game::ProcessGui()
 {
 	ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
@@ -226,10 +307,17 @@ void Game::ProcessGui()
 		}
 	}
 
+	if (ImGui::Button("Screenshot (F12)")) {
+		TakeScreenshot();
+	}
+
 	if (ImGui::CollapsingHeader("Options")) {
 		ImGui::AutoIndent indent;
 		{
-			if (ImGui::SliderFloat("Horizontal Resolution", &GetContext().GetFrameTextureResolutionRatio(), 0.2f, 1.0f)) {
+			if (mDynamicResolutionActive) {
+				ImGui::Text("Resolution: %.0f%% (Dynamic)", mDynamicResolution.GetScale() * 100.0f);
+			}
+			else if (ImGui::SliderFloat("Horizontal Resolution", &GetContext().GetFrameTextureResolutionRatio(), 0.2f, 1.0f)) {
 				UpdateFrameTexture(
 					*mFrameTex, 
 					GetContext().GetWindow().getSize(), 
@@ -252,6 +340,11 @@ void Game::ProcessGui()
 			if (ImGui::CollapsingHeader("World")) {
 				mWorld->GuiPerformanceInfo();
 			}
+
+			if (ImGui::CollapsingHeader("Raycast Renderer")) {
+				ImGui::AutoIndent indent2;
+				mWorldRaycastRenderer.GuiPerformanceInfo();
+			}
 		}
 	}
 
@@ -7,6 +7,7 @@
 #include "Quiver/Application/ApplicationState.h"
 #include "Quiver/Graphics/Camera2D.h"
 #include "Quiver/Graphics/Camera3D.h"
+#include "Quiver/Graphics/DynamicResolution.h"
 #include "Quiver/Graphics/WorldRaycastRenderer.h"
 #include "Quiver/Input/SfmlJoystick.h"
 #include "Quiver/Input/SfmlKeyboard.h"
@@ -39,6 +40,16 @@ private:
 	void OnTogglePause();
 	void ProcessGui();
 
+	// Scale of mFrameTex relative to the window.
+	float GetFrameTextureScale();
+
+	// Resizes mFrameTex if the World's RenderSettings say it should follow the frame time.
+	void UpdateDynamicResolution();
+
+	// Renders the World again with the raycast renderer's software rasterizer, at mFrameTex's
+	// resolution, and saves it to a PNG in the working directory.
+	void TakeScreenshot();
+
 	bool mCamera2DFollowCamera3D = true;
 	bool mDrawOverhead = false;
 
@@ -58,6 +69,9 @@ private:
 
 	std::unique_ptr<sf::RenderTexture> mFrameTex;
 
+	DynamicResolution mDynamicResolution;
+	bool mDynamicResolutionActive = false;
+
 	bool mPaused = false;
 
 	qvr::SfmlJoystickSet mJoysticks;
@@ -22,6 +22,8 @@
 #include "Quiver/Graphics/Camera3D.h"
 #include "Quiver/Misc/ImGuiHelpers.h"
 #include "Quiver/Misc/Logging.h"
+#include "Quiver/World/SectorGraph.h"
+#include "Quiver/World/TileMap.h"
 #include "Quiver/World/World.h"
 
 namespace {
@@ -51,6 +53,9 @@ b2Fixture* GetFixtureAtPoint(const b2World& world, const b2Vec2& point)
 	world.QueryAABB(&callback, aabb);
 
 	for (b2Fixture* fixture : callback.mFixtures) {
+		// Bodies without user data, like the Tile Map's, don't belong to an Entity.
+		if (!fixture->GetBody()->GetUserData()) continue;
+
 		if (fixture->TestPoint(point)) {
 			return fixture;
 		}
@@ -107,8 +112,8 @@ void SelectTool::OnMouseClick3D(WorldEditor & editor,
 
 		float32 ReportFixture(
 			b2Fixture* fixture,
-			const b2Vec2& point,
-			const b2Vec2& normal,
+			const b2Vec2&,
+			const b2Vec2&,
 			float32 fraction) override
 		{
 			// Filter out render-only fixtures
@@ -117,6 +122,13 @@ void SelectTool::OnMouseClick3D(WorldEditor & editor,
 				return -1;
 			}
 
+			// Tile walls hide Entities behind them, but can't be selected.
+			if (!fixture->GetBody()->GetUserData())
+			{
+				closestFixture = nullptr;
+				return fraction;
+			}
+
 			closestFixture = fixture;
 
 			return fraction;
@@ -684,4 +696,159 @@ void CreatePolygonTool::Draw(sf::RenderTarget & target, const Camera2D & camera)
 	}
 }
 
+void PaintTilesTool::Paint(WorldEditor& editor, const b2Vec2& worldPos)
+{
+	TileMap* tileMap = editor.GetWorld()->GetTileMap();
+
+	if (!tileMap) return;
+
+	int x, y;
+	if (tileMap->GetTileCoords(worldPos, x, y)) {
+		tileMap->SetTile(x, y, mStrokeTile);
+	}
+}
+
+void PaintTilesTool::OnMouseClick(WorldEditor & editor, const Camera2D& camera, const sf::Event::MouseButtonEvent & mouseInfo)
+{
+	if (mStrokeInProgress) {
+		mStrokeInProgress = false;
+		return;
+	}
+
+	const TileMap* tileMap = editor.GetWorld()->GetTileMap();
+
+	if (!tileMap) return;
+
+	mStrokeInProgress = true;
+	mStrokeTile = mouseInfo.button == sf::Mouse::Button::Right ? 0 : tileMap->GetSelectedTile();
+
+	Paint(editor, camera.ScreenToWorld(GetVecFromMouseEvent(mouseInfo)));
+}
+
+void PaintTilesTool::OnMouseMove(WorldEditor & editor, const Camera2D& camera, const sf::Event::MouseMoveEvent & mouseInfo)
+{
+	const b2Vec2 mouseWorldPos = camera.ScreenToWorld(GetVecFromMouseEvent(mouseInfo));
+
+	mHovering = false;
+
+	const TileMap* tileMap = editor.GetWorld()->GetTileMap();
+
+	if (!tileMap) return;
+
+	int x, y;
+	if (tileMap->GetTileCoords(mouseWorldPos, x, y))
+	{
+		const float size = tileMap->GetTileSize();
+		const b2Vec2 corner = tileMap->GetOrigin() + size * b2Vec2((float)x, (float)y);
+
+		mHovering = true;
+		mHoveredCorners[0] = corner;
+		mHoveredCorners[1] = corner + b2Vec2(size, 0.0f);
+		mHoveredCorners[2] = corner + b2Vec2(size, size);
+		mHoveredCorners[3] = corner + b2Vec2(0.0f, size);
+	}
+
+	if (mStrokeInProgress) {
+		Paint(editor, mouseWorldPos);
+	}
+}
+
+void PaintTilesTool::OnCancel(WorldEditor &, const Camera2D&)
+{
+	mStrokeInProgress = false;
+}
+
+void PaintTilesTool::Draw(sf::RenderTarget& target, const Camera2D& camera)
+{
+	if (!mHovering) return;
+
+	const sf::Color color = mStrokeInProgress ? sf::Color::Green : sf::Color::White;
+
+	std::array<sf::Vertex, 5> verts;
+
+	for (int i = 0; i < 5; i++) {
+		verts[i].position = b2VecToSfVec(camera.WorldToCamera(mHoveredCorners[i % 4]));
+		verts[i].color = color;
+	}
+
+	target.draw(verts.data(), verts.size(), sf::PrimitiveType::LinesStrip);
+}
+
+void PaintTilesTool::DoGui(WorldEditor& editor)
+{
+	const TileMap* tileMap = editor.GetWorld()->GetTileMap();
+
+	if (!tileMap) {
+		ImGui::Text("The World has no Tile Map. Create one under World > Tile Map.");
+		return;
+	}
+
+	const int tile = tileMap->GetSelectedTile();
+
+	ImGui::Text("Painting: %s", tile > 0 ? tileMap->GetType(tile - 1).name.c_str() : "(Empty)");
+	ImGui::Text("Left-click to start or stop painting. Right-click to erase instead.");
+}
+
+void CreateSectorTool::OnMouseClick(WorldEditor & editor, const Camera2D& camera, const sf::Event::MouseButtonEvent & mouseInfo)
+{
+	const b2Vec2 mouseWorldPos = camera.ScreenToWorld(GetVecFromMouseEvent(mouseInfo));
+
+	if (!mDragInProgress) {
+		mDragInProgress = true;
+		mDragStartPos = mouseWorldPos;
+		mDragCurrentPos = mouseWorldPos;
+		return;
+	}
+
+	mDragInProgress = false;
+
+	b2AABB bounds;
+	bounds.lowerBound = b2Min(mDragStartPos, mouseWorldPos);
+	bounds.upperBound = b2Max(mDragStartPos, mouseWorldPos);
+
+	SectorGraph& sectors = editor.GetWorld()->GetSectors();
+
+	const int sector = sectors.AddSector(bounds);
+
+	if (sector < 0) {
+		GetConsoleLogger()->warn("Couldn't create a Sector there. Sectors can't overlap.");
+		return;
+	}
+
+	sectors.DerivePortals(sector);
+}
+
+void CreateSectorTool::OnMouseMove(WorldEditor &, const Camera2D& camera, const sf::Event::MouseMoveEvent & mouseInfo)
+{
+	if (!mDragInProgress) return;
+
+	mDragCurrentPos = camera.ScreenToWorld(GetVecFromMouseEvent(mouseInfo));
+}
+
+void CreateSectorTool::OnCancel(WorldEditor &, const Camera2D&)
+{
+	mDragInProgress = false;
+}
+
+void CreateSectorTool::Draw(sf::RenderTarget& target, const Camera2D& camera)
+{
+	if (!mDragInProgress) return;
+
+	const std::array<b2Vec2, 4> corners = {
+		mDragStartPos,
+		b2Vec2(mDragCurrentPos.x, mDragStartPos.y),
+		mDragCurrentPos,
+		b2Vec2(mDragStartPos.x, mDragCurrentPos.y)
+	};
+
+	std::array<sf::Vertex, 5> verts;
+
+	for (int i = 0; i < 5; i++) {
+		verts[i].position = b2VecToSfVec(camera.WorldToCamera(corners[i % 4]));
+		verts[i].color = sf::Color::Cyan;
+	}
+
+	target.draw(verts.data(), verts.size(), sf::PrimitiveType::LinesStrip);
+}
+
 }
\ No newline at end of file
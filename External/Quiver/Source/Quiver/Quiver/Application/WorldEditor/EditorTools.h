@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 
@@ -162,6 +163,52 @@ private:
 	std::experimental::optional<int> mGrabbedVertex;
 };
 
+class PaintTilesTool : public EditorTool {
+public:
+	const char* GetName() const override { return "Paint Tiles"; }
+	const char* GetDescription() const override { return "Paint the World's Tile Map with its selected tile"; }
+
+	void OnMouseClick(WorldEditor& editor, const Camera2D& camera, const sf::Event::MouseButtonEvent & mouseInfo) override;
+	void OnMouseMove(WorldEditor& editor, const Camera2D& camera, const sf::Event::MouseMoveEvent & mouseInfo) override;
+
+	void OnCancel(WorldEditor& editor, const Camera2D& camera) override;
+
+	void Draw(sf::RenderTarget& target, const Camera2D& camera) override;
+
+	void DoGui(WorldEditor& editor) override;
+
+private:
+	void Paint(WorldEditor& editor, const b2Vec2& worldPos);
+
+	// Clicking starts a stroke, which paints wherever the mouse goes until the next click.
+	bool mStrokeInProgress = false;
+	// What the stroke paints: the selected tile for the left button, empty for the right.
+	int mStrokeTile = 0;
+
+	// The hovered tile's corners, in world space, for Draw.
+	bool mHovering = false;
+	std::array<b2Vec2, 4> mHoveredCorners;
+};
+
+class CreateSectorTool : public EditorTool {
+public:
+	const char* GetName() const override { return "Create Sector"; }
+	const char* GetDescription() const override { return "Drag out a Sector, with portals to any Sectors it borders"; }
+
+	void OnMouseClick(WorldEditor& editor, const Camera2D& camera, const sf::Event::MouseButtonEvent & mouseInfo) override;
+	void OnMouseMove(WorldEditor& editor, const Camera2D& camera, const sf::Event::MouseMoveEvent & mouseInfo) override;
+
+	void OnCancel(WorldEditor& editor, const Camera2D& camera) override;
+
+	void Draw(sf::RenderTarget& target, const Camera2D& camera) override;
+
+private:
+	// Sectors are axis-aligned in world space, whichever way the camera is turned.
+	bool mDragInProgress = false;
+	b2Vec2 mDragStartPos;
+	b2Vec2 mDragCurrentPos;
+};
+
 class CreateInstanceOfPrefabTool : public EditorTool {
 public:
 	const char* GetName() const override { return "Create Instance of Prefab"; }
@@ -57,6 +57,8 @@ WorldEditor::WorldEditor(ApplicationStateContext& context, std::unique_ptr<World
 	mTools.push_back(std::make_unique<CreateBoxTool>());
 	mTools.push_back(std::make_unique<CreatePolygonTool>());
 	mTools.push_back(std::make_unique<CreateInstanceOfPrefabTool>());
+	mTools.push_back(std::make_unique<PaintTilesTool>());
+	mTools.push_back(std::make_unique<CreateSectorTool>());
 
 	mCurrentToolIndex = 1;
 
@@ -314,6 +316,11 @@ void WorldEditor::ProcessGUI()
 		if (ImGui::CollapsingHeader("World##perf")) {
 			mWorld->GuiPerformanceInfo();
 		}
+
+		if (ImGui::CollapsingHeader("Raycast Renderer##perf")) {
+			ImGui::AutoIndent indent2;
+			mWorldRaycastRenderer.GuiPerformanceInfo();
+		}
 	}
 
 	if (ImGui::CollapsingHeader("World##ctrl")) {
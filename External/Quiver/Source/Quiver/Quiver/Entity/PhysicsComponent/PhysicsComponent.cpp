@@ -47,6 +47,15 @@ PhysicsComponent::~PhysicsComponent()
 	mBody->SetUserData(nullptr);
 };
 
+Entity* GetEntityFromFixture(const b2Fixture& fixture)
+{
+	const auto physicsComp = static_cast<PhysicsComponent*>(fixture.GetBody()->GetUserData());
+
+	if (!physicsComp) return nullptr;
+
+	return &physicsComp->GetEntity();
+}
+
 namespace
 {
 
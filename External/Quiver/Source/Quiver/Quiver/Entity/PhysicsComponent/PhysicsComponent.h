@@ -8,6 +8,7 @@
 #include "Quiver/Physics/PhysicsUtils.h"
 
 class b2Body;
+class b2Fixture;
 class b2Shape;
 struct b2BodyDef;
 struct b2FixtureDef;
@@ -41,4 +42,8 @@ private:
 
 };
 
+// The Entity whose PhysicsComponent owns the fixture's body. nullptr for bodies that don't
+// belong to an Entity, like the TileMap's.
+Entity* GetEntityFromFixture(const b2Fixture& fixture);
+
 }
\ No newline at end of file
@@ -1,9 +1,7 @@
 #include "RenderComponent.h"
 
-#include <Box2D/Collision/Shapes/b2EdgeShape.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
-#include <Box2D/Dynamics/b2World.h>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Shader.hpp>
 #include <SFML/Graphics/Texture.hpp>
@@ -13,6 +11,7 @@
 #include "Quiver/Graphics/Camera3D.h"
 #include "Quiver/Graphics/ColourUtils.h"
 #include "Quiver/Graphics/Light.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
 #include "Quiver/Graphics/TextureLibrary.h"
 #include "Quiver/Misc/Logging.h"
 #include "Quiver/World/World.h"
@@ -30,10 +29,6 @@ TextureLibrary& GetTextureLibrary(const RenderComponent& renderComponent) {
 	return renderComponent.GetEntity().GetWorld().GetTextureLibrary();
 }
 
-b2World* GetPhysicsWorld(RenderComponent& rc) {
-	return const_cast<b2World*>(rc.GetEntity().GetWorld().GetPhysicsWorld());
-}
-
 Animation::Rect SfVecToRect(const sf::Vector2u& v) {
 	Animation::Rect rect;
 	rect.top = 0;
@@ -52,16 +47,26 @@ b2Fixture* RenderComponent::GetFixture() {
 }
 
 b2Body* RenderComponent::GetBody() {
-	return GetDetachedBody() != nullptr ?
-		GetDetachedBody() :
-		&GetEntity().GetPhysics()->GetBody();
+	return &GetEntity().GetPhysics()->GetBody();
+}
+
+RenderProxyIndex& RenderComponent::GetRenderProxies() {
+	return GetEntity().GetWorld().GetRenderProxies();
+}
+
+PointLightIndex& RenderComponent::GetPointLights() {
+	return GetEntity().GetWorld().GetPointLights();
+}
+
+void RenderComponent::RenderDataChanged() {
+	GetRenderProxies().RenderDataChanged(mRenderProxy);
 }
 
 RenderComponent::RenderComponent(Entity& entity)
 	: Component(entity)
 	, mFixtureRenderData(std::make_unique<qvr::FixtureRenderData>())
 {
-	GetFixture()->SetUserData(mFixtureRenderData.get());
+	mRenderProxy = GetRenderProxies().AddAttached(*GetFixture(), *mFixtureRenderData);
 }
 
 RenderComponent::~RenderComponent()
@@ -78,9 +83,11 @@ RenderComponent::~RenderComponent()
 		mAnimatorId = AnimatorId::Invalid;
 	}
 
-	GetFixture()->SetUserData(nullptr);
+	GetRenderProxies().Remove(mRenderProxy);
+
+	RemoveLight();
 
-	if (mDetachedBody) {
+	if (mDetached) {
 		GetEntity().GetWorld().UnregisterDetachedRenderComponent(*this);
 	}
 }
@@ -93,10 +100,18 @@ bool RenderComponent::ToJson(nlohmann::json & j) const
 	j["Colour"] = ColourUtils::ToJson(GetColor());
 	j["SpriteRadius"] = GetSpriteRadius();
 
+	if (IsOpaque()) {
+		j["Opaque"] = true;
+	}
+
 	if (GetTexture()) {
 		j["Texture"] = mTextureFilename;
 	}
 
+	if (const PointLight* light = GetLight()) {
+		light->ToJson(j["Light"]);
+	}
+
 	{
 		const AnimatorCollection& animSystem = GetAnimators(*this);
 
@@ -131,6 +146,7 @@ bool RenderComponent::FromJson(const nlohmann::json & j)
 
 	SetHeight(j.value<float>("Height", 1.0f));
 	SetGroundOffset(j.value<float>("GroundOffset", 0.0f));
+	SetOpaque(j.value<bool>("Opaque", false));
 
 	if (j.count("Colour") &&
 		!ColourUtils::DeserializeSFColorFromJson(
@@ -139,6 +155,8 @@ bool RenderComponent::FromJson(const nlohmann::json & j)
 	{
 		return false;
 	}
+
+	RenderDataChanged();
 	
 	{
 		const auto renderType = j.value<std::string>("RenderType", {});
@@ -151,6 +169,15 @@ bool RenderComponent::FromJson(const nlohmann::json & j)
 
 	SetSpriteRadius(j.value<float>("SpriteRadius", 0.5f));
 
+	if (j.find("Light") != j.end()) {
+		PointLight light;
+		if (!light.FromJson(j["Light"])) {
+			log->error("RenderComponent::FromJson: Light is invalid.");
+			return false;
+		}
+		SetLight(light);
+	}
+
 	auto FieldExistsInJson = [](std::string fieldName, const nlohmann::json& j)
 	{
 		return j.find(fieldName) != j.end();
@@ -170,6 +197,7 @@ bool RenderComponent::FromJson(const nlohmann::json & j)
 				else {
 					mTextureFilename.clear();
 				}
+				RenderDataChanged();
 			}
 		}
 		else {
@@ -208,76 +236,35 @@ bool RenderComponent::FromJson(const nlohmann::json & j)
 	return true;
 }
 
-void RenderComponent::UpdateDetachedBodyRotation(const float cameraAngle)
-{
-	assert(IsDetached());
-
-	mDetachedBody->SetTransform(mDetachedBody->GetPosition(), cameraAngle);
-}
-
-void RenderComponent::UpdateDetachedBodyPosition()
+void RenderComponent::UpdateDetachedSpritePosition()
 {
 	assert(IsDetached());
 
 	const b2Vec2 position = GetEntity().GetPhysics()->GetPosition();
 
-	mDetachedBody->SetTransform(position, mDetachedBody->GetAngle());
-
 	mFixtureRenderData->mSpritePosition = position;
-}
-
-// User is responsible for setting the resulting fixture's user data.
-b2Fixture* CreateFlatSpriteFixture(b2Body* body, const float halfWidth) {
-	assert(body != nullptr);
-	assert(body->GetFixtureList() == nullptr);
-
-	b2FixtureDef fdef;
-	// Not sure what I'm doing with the filter tbh.
-	fdef.filter.categoryBits = 0xF000; // Detached RenderComponent category.
-	fdef.filter.maskBits = 0;          // Collide with nothing.
-	fdef.filter.groupIndex = -1;       // Never collide with anything. 
 
-	b2EdgeShape shape;
-	shape.Set(b2Vec2(-halfWidth, 0.0f), b2Vec2(halfWidth, 0.0f));
-
-	fdef.shape = &shape;
-
-	b2Fixture* newFixture = body->CreateFixture(&fdef);
-
-	return newFixture;
+	GetRenderProxies().SetBillboardPosition(mRenderProxy, position);
 }
 
 void RenderComponent::SetDetached(const bool detached)
 {
 	if (detached == IsDetached()) return;
 
+	GetRenderProxies().Remove(mRenderProxy);
+
 	if (detached)
 	{
 		// Go to detached mode.
 
-		// If the PhysicsComponent body has multiple fixtures, make sure none of them have 
-		// fixture render data.
-		{
-			b2Fixture* physicsComponentFixture = GetFixture();
-			while (physicsComponentFixture) {
-				physicsComponentFixture->SetUserData(nullptr);
-				physicsComponentFixture = physicsComponentFixture->GetNext();
-			}
-		}
-
-		{
-			b2BodyDef bdef;
-			bdef.type = b2BodyType::b2_staticBody;
-
-			mDetachedBody.reset(GetPhysicsWorld(*this)->CreateBody(&bdef));
-		}
+		mFixtureRenderData->mSpritePosition = GetEntity().GetPhysics()->GetPosition();
 
-		{
-			b2Fixture* newFixture = CreateFlatSpriteFixture(mDetachedBody.get(), GetSpriteRadius());
-			assert(newFixture);
+		mRenderProxy = GetRenderProxies().AddBillboard(
+			mFixtureRenderData->mSpritePosition,
+			GetSpriteRadius(),
+			*mFixtureRenderData);
 
-			newFixture->SetUserData(mFixtureRenderData.get());
-		}
+		mDetached = true;
 
 		GetEntity().GetWorld().RegisterDetachedRenderComponent(*this);
 	}
@@ -286,32 +273,82 @@ void RenderComponent::SetDetached(const bool detached)
 		// Reattach.
 
 		GetEntity().GetWorld().UnregisterDetachedRenderComponent(*this);
-		
-		mDetachedBody.reset();
 
-		GetFixture()->SetUserData(mFixtureRenderData.get());
+		mDetached = false;
+
+		mRenderProxy = GetRenderProxies().AddAttached(*GetFixture(), *mFixtureRenderData);
 	}
 }
 
-void RenderComponent::SetSpriteRadius(const float spriteRadius) 
+const PointLight* RenderComponent::GetLight() const
 {
-	auto log = GetConsoleLogger();
+	if (mLight == InvalidPointLightId) return nullptr;
 
-	mFixtureRenderData->mSpriteRadius = spriteRadius;
+	return GetEntity().GetWorld().GetPointLights().GetLight(mLight);
+}
 
-	if (IsDetached())
-	{
-		// We can't just change shapes of fixtures after they've been created,
-		// so we need to re-create the fixture with the new length.
+void RenderComponent::SetLight(const PointLight& light)
+{
+	if (mLight != InvalidPointLightId) {
+		GetPointLights().SetLight(mLight, light);
+		return;
+	}
 
-		// Remove old fixture.
-		mDetachedBody->DestroyFixture(mDetachedBody->GetFixtureList());
+	mLight = GetPointLights().AddAttached(*GetBody(), light);
+}
+
+void RenderComponent::RemoveLight()
+{
+	if (mLight == InvalidPointLightId) return;
+
+	GetPointLights().Remove(mLight);
+
+	mLight = InvalidPointLightId;
+}
+
+void RenderComponent::SetHeight(const float height)
+{
+	if (mFixtureRenderData->mHeight == height) return;
+
+	mFixtureRenderData->mHeight = height;
+
+	RenderDataChanged();
+}
+
+void RenderComponent::SetGroundOffset(const float groundOffset)
+{
+	if (mFixtureRenderData->mGroundOffset == groundOffset) return;
 
-		// Create new one.
-		b2Fixture* newFixture = CreateFlatSpriteFixture(mDetachedBody.get(), GetSpriteRadius());
-		newFixture->SetUserData(mFixtureRenderData.get());
+	mFixtureRenderData->mGroundOffset = groundOffset;
 
-		log->debug("RenderComponent::SetSpriteRadius: Recreated fixture for flat sprite.");
+	RenderDataChanged();
+}
+
+void RenderComponent::SetColor(const sf::Color& color)
+{
+	if (mFixtureRenderData->mBlendColor == color) return;
+
+	mFixtureRenderData->mBlendColor = color;
+
+	RenderDataChanged();
+}
+
+void RenderComponent::SetOpaque(const bool opaque)
+{
+	if (mFixtureRenderData->mOpaque == opaque) return;
+
+	mFixtureRenderData->mOpaque = opaque;
+
+	RenderDataChanged();
+}
+
+void RenderComponent::SetSpriteRadius(const float spriteRadius) 
+{
+	mFixtureRenderData->mSpriteRadius = spriteRadius;
+
+	if (IsDetached())
+	{
+		GetRenderProxies().SetBillboardHalfWidth(mRenderProxy, GetSpriteRadius());
 	}
 }
 
@@ -321,6 +358,8 @@ bool RenderComponent::SetTexture(const std::string& filename)
 
 	this->mFixtureRenderData->mTexture = texture;
 
+	RenderDataChanged();
+
 	if (texture)
 	{
 		this->mTextureFilename = filename;
@@ -338,6 +377,8 @@ bool RenderComponent::SetTexture(const std::string& filename)
 void RenderComponent::RemoveTexture() {
 	this->mFixtureRenderData->mTexture = nullptr;
 	this->mTextureFilename.clear();
+
+	RenderDataChanged();
 }
 
 void RenderComponent::SetTextureRect(const Animation::Rect& rect)
@@ -8,7 +8,9 @@
 
 #include "Quiver/Animation/Animators.h"
 #include "Quiver/Graphics/FixtureRenderData.h"
-#include "Quiver/Physics/PhysicsUtils.h"
+#include "Quiver/Graphics/Light.h"
+#include "Quiver/Graphics/PointLights.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
 
 class b2Fixture;
 class b2Body;
@@ -29,8 +31,7 @@ public:
 	bool ToJson(nlohmann::json& j) const;
 	bool FromJson(const nlohmann::json& j);
 
-	void UpdateDetachedBodyRotation(const float cameraAngle);
-	void UpdateDetachedBodyPosition();
+	void UpdateDetachedSpritePosition();
 
 	float GetHeight()                 const { return mFixtureRenderData->GetHeight(); }
 	float GetGroundOffset()           const { return mFixtureRenderData->GetGroundOffset(); }
@@ -38,11 +39,14 @@ public:
 	float GetObjectAngle()            const { return mFixtureRenderData->GetObjectAngle(); }
 	const b2Vec2& GetSpritePosition() const { return mFixtureRenderData->GetSpritePosition(); }
 	const sf::Color GetColor()        const { return mFixtureRenderData->GetColor(); }
+	// Just the flag. FixtureRenderData::IsOpaque also takes the texture and colour into account.
+	bool IsOpaque()                   const { return mFixtureRenderData->mOpaque; }
 
-	void SetHeight      (const float height)       { mFixtureRenderData->mHeight = height; }
-	void SetGroundOffset(const float groundOffset) { mFixtureRenderData->mGroundOffset = groundOffset; }
+	void SetHeight      (const float height);
+	void SetGroundOffset(const float groundOffset);
 	void SetObjectAngle (const float radians)      { mFixtureRenderData->mObjectAngle = radians; }
-	void SetColor       (const sf::Color& color)   { mFixtureRenderData->mBlendColor = color; }
+	void SetColor       (const sf::Color& color);
+	void SetOpaque      (const bool opaque);
 	void SetSpriteRadius(const float spriteRadius);
 
 	const sf::Texture* GetTexture()         const { return mFixtureRenderData->GetTexture(); }
@@ -61,15 +65,26 @@ public:
 
 	void RemoveAnimation();
 	
-	// Returns true if the RenderComponent has its own (non-collidable) physical body.
-	bool IsDetached() const { return mDetachedBody != nullptr; }
+	// Returns true if the RenderComponent is drawn as a flat sprite that faces the camera
+	// instead of as the PhysicsComponent's fixture.
+	bool IsDetached() const { return mDetached; }
 
 	void SetDetached(const bool detached);
 
+	// A light that goes wherever the entity does. nullptr if it doesn't have one.
+	const PointLight* GetLight() const;
+	void SetLight(const PointLight& light);
+	void RemoveLight();
+
 private:
-	b2Body* GetDetachedBody() { return mDetachedBody.get(); }
 	b2Body* GetBody();
 	b2Fixture* GetFixture();
+
+	RenderProxyIndex& GetRenderProxies();
+	PointLightIndex& GetPointLights();
+
+	// Lets the RenderProxyIndex know that the raycast renderer might need to look again.
+	void RenderDataChanged();
 	
 	AnimatorId mAnimatorId = AnimatorId::Invalid;
 
@@ -77,8 +92,14 @@ private:
 
 	std::unique_ptr<qvr::FixtureRenderData> mFixtureRenderData;
 
-	// Set when the RenderComponent has a different b2Body from the PhysicsComponent.
-	Physics::b2BodyUniquePtr mDetachedBody;
+	// Our entry in the World's RenderProxyIndex. Detached sprites are billboards there; they
+	// don't have a b2Body of their own.
+	RenderProxyId mRenderProxy = InvalidRenderProxyId;
+
+	bool mDetached = false;
+
+	// Our entry in the World's PointLightIndex, if we have a light.
+	PointLightId mLight = InvalidPointLightId;
 };
 
 }
\ No newline at end of file
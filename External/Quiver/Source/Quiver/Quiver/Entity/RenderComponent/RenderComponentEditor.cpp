@@ -64,6 +64,13 @@ void RenderComponentEditor::GuiControls()
 		}
 	}
 
+	{
+		bool opaque = m_RenderComponent.IsOpaque();
+		if (ImGui::Checkbox("Opaque", &opaque)) {
+			m_RenderComponent.SetOpaque(opaque);
+		}
+	}
+
 	{
 		sf::Color c = m_RenderComponent.GetColor();
 		ColourUtils::ImGuiColourEdit("Colour", c);
@@ -104,6 +111,29 @@ void RenderComponentEditor::GuiControls()
 		}
 	}
 
+	if (ImGui::CollapsingHeader("Light##RC")) {
+		ImGui::AutoIndent indent;
+
+		if (const PointLight* current = m_RenderComponent.GetLight()) {
+			PointLight light = *current;
+
+			if (light.GuiControls()) {
+				m_RenderComponent.SetLight(light);
+			}
+
+			if (ImGui::Button("Remove Light")) {
+				m_RenderComponent.RemoveLight();
+			}
+		}
+		else {
+			ImGui::Text("No Light");
+
+			if (ImGui::Button("Add Light")) {
+				m_RenderComponent.SetLight(PointLight());
+			}
+		}
+	}
+
 	if (ImGui::CollapsingHeader("Animation##RC")) {
 		ImGui::AutoIndent indent;
 
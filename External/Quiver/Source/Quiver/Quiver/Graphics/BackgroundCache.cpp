@@ -0,0 +1,119 @@
+#include "BackgroundCache.h"
+
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include "Quiver/Graphics/Camera3D.h"
+#include "Quiver/Graphics/Fog.h"
+
+namespace qvr {
+
+namespace {
+
+void AddQuad(
+	std::vector<sf::Vertex>& vertices,
+	const float left,
+	const float top,
+	const float right,
+	const float bottom,
+	const sf::Color topColor,
+	const sf::Color bottomColor)
+{
+	vertices.emplace_back(sf::Vector2f(left, top), topColor);
+	vertices.emplace_back(sf::Vector2f(left, bottom), bottomColor);
+	vertices.emplace_back(sf::Vector2f(right, bottom), bottomColor);
+	vertices.emplace_back(sf::Vector2f(right, top), topColor);
+}
+
+// Where the ground at distanceMetres is, in pixels below the horizon.
+float DistanceToPixelsBelowHorizon(
+	const unsigned targetHeight,
+	const float distanceMetres,
+	const float cameraHeightMetres)
+{
+	return (float)(int)((targetHeight / distanceMetres) * cameraHeightMetres);
+}
+
+}
+
+bool BackgroundCache::Key::operator==(const Key& other) const
+{
+	return
+		targetSize == other.targetSize &&
+		horizon == other.horizon &&
+		cameraHeight == other.cameraHeight &&
+		groundColor == other.groundColor &&
+		skyColor == other.skyColor &&
+		fogColor == other.fogColor &&
+		fogMinDistance == other.fogMinDistance &&
+		fogMaxDistance == other.fogMaxDistance &&
+		fogMaxIntensity == other.fogMaxIntensity;
+}
+
+void BackgroundCache::Draw(
+	sf::RenderTarget& target,
+	const Camera3D& camera,
+	const Fog& fog,
+	const sf::Color groundColor,
+	const sf::Color skyColor)
+{
+	Key key;
+	key.targetSize = target.getSize();
+	key.horizon = (int)(key.targetSize.y / 2) + GetPitchOffsetInPixels(camera, key.targetSize.y);
+	key.cameraHeight = camera.GetHeight();
+	key.groundColor = groundColor;
+	key.skyColor = skyColor;
+	key.fogColor = fog.GetColor();
+	key.fogMinDistance = fog.GetMinDistance();
+	key.fogMaxDistance = fog.GetMaxDistance();
+	key.fogMaxIntensity = fog.GetMaxIntensity();
+
+	if (!mValid || !(key == mKey)) {
+		Rebuild(key);
+	}
+
+	target.draw(mVertices.data(), mVertices.size(), sf::PrimitiveType::Quads);
+}
+
+void BackgroundCache::Rebuild(const Key& key)
+{
+	mKey = key;
+	mValid = true;
+	mRebuildCount++;
+
+	mVertices.clear();
+
+	const float width = (float)key.targetSize.x;
+	const float height = (float)key.targetSize.y;
+	const float horizon = (float)key.horizon;
+
+	// The ground.
+	AddQuad(mVertices, 0.0f, horizon, width, height, key.groundColor, key.groundColor);
+
+	// The fog is at its thickest from the horizon down to where the ground is fog.GetMaxDistance()
+	// away, and fades out from there to where it's fog.GetMinDistance() away.
+	{
+		const float maxIntensityPoint = horizon + DistanceToPixelsBelowHorizon(
+			key.targetSize.y,
+			key.fogMaxDistance,
+			key.cameraHeight);
+
+		const float minIntensityPoint = horizon + DistanceToPixelsBelowHorizon(
+			key.targetSize.y,
+			key.fogMinDistance,
+			key.cameraHeight);
+
+		const sf::Color maxIntensityColor(
+			key.fogColor.r,
+			key.fogColor.g,
+			key.fogColor.b,
+			(sf::Uint8)(key.fogMaxIntensity * 255));
+
+		AddQuad(mVertices, 0.0f, horizon, width, maxIntensityPoint, maxIntensityColor, maxIntensityColor);
+		AddQuad(mVertices, 0.0f, maxIntensityPoint, width, minIntensityPoint, maxIntensityColor, key.fogColor);
+	}
+
+	// Behind the sky's layers.
+	AddQuad(mVertices, 0.0f, 0.0f, width, horizon, key.skyColor, key.skyColor);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+
+namespace sf {
+class RenderTarget;
+}
+
+namespace qvr {
+
+class Camera3D;
+class Fog;
+
+// The ground, the fog over it and the sky's background colour: everything behind the sky
+// layers and the raycast columns. None of it depends on where the camera is or which way
+// it's turned, so its vertices only get rebuilt when the pitch, the camera's height, the
+// fog, the colours or the target's size change. Drawing it is then a single draw.
+class BackgroundCache
+{
+public:
+	// groundColor should already be lit.
+	void Draw(
+		sf::RenderTarget& target,
+		const Camera3D& camera,
+		const Fog& fog,
+		const sf::Color groundColor,
+		const sf::Color skyColor);
+
+	// How many times the vertices have been built. For the performance GUI.
+	unsigned GetRebuildCount() const { return mRebuildCount; }
+
+private:
+	struct Key
+	{
+		sf::Vector2u targetSize;
+		int horizon = 0;
+		float cameraHeight = 0.0f;
+		sf::Color groundColor;
+		sf::Color skyColor;
+		sf::Color fogColor;
+		float fogMinDistance = 0.0f;
+		float fogMaxDistance = 0.0f;
+		float fogMaxIntensity = 0.0f;
+
+		bool operator==(const Key& other) const;
+	};
+
+	void Rebuild(const Key& key);
+
+	std::vector<sf::Vertex> mVertices;
+
+	Key mKey;
+	bool mValid = false;
+
+	unsigned mRebuildCount = 0;
+};
+
+}
\ No newline at end of file
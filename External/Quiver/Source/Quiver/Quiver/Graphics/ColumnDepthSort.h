@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iterator>
+#include <utility>
+
+namespace qvr {
+
+// Depth ordering for the raycast renderer.
+//
+// Each screen column only ever has a handful of intersections (at most 32), and columns never
+// overlap each other on screen. So instead of sorting every intersection in the frame by
+// distance we sort each column on its own and then lay the columns out one after another:
+// every pixel still gets painted back-to-front, but the work is O(n * k) for tiny k instead of
+// O(n log n) over the whole frame, and it can happen on the thread that cast the column's ray.
+
+// Sorts [first, last) so that the element with the greatest distance comes first.
+// Insertion sort, because the ranges are tiny. Stable.
+template<typename RandomIt, typename GetDistance>
+void SortBackToFront(RandomIt first, RandomIt last, GetDistance getDistance)
+{
+	if (first == last) return;
+
+	for (RandomIt it = std::next(first); it != last; ++it)
+	{
+		auto value = std::move(*it);
+		const auto distance = getDistance(value);
+
+		RandomIt hole = it;
+
+		while (hole != first && getDistance(*std::prev(hole)) < distance)
+		{
+			*hole = std::move(*std::prev(hole));
+			--hole;
+		}
+
+		*hole = std::move(value);
+	}
+}
+
+}
\ No newline at end of file
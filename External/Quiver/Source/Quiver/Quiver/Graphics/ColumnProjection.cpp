@@ -0,0 +1,156 @@
+#include "ColumnProjection.h"
+
+#include <cmath>
+#include <initializer_list>
+
+#include "Quiver/Graphics/Camera3D.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUIVER_COLUMN_PROJECTION_SSE 1
+#include <emmintrin.h>
+#else
+#define QUIVER_COLUMN_PROJECTION_SSE 0
+#endif
+
+namespace qvr {
+
+ColumnProjection::ColumnProjection(const Camera3D& camera, const unsigned targetHeight)
+	: cameraPosition(camera.GetPosition())
+	, cameraForwards(camera.GetForwards())
+	, cameraRight(-camera.GetForwards().y, camera.GetForwards().x)
+	, targetHeight((float)targetHeight)
+	, cameraHeightOffset(camera.GetHeightOffset())
+	, cameraPitchOffset((float)GetPitchOffsetInPixels(camera, targetHeight))
+	, horizon((float)targetHeight / 2 + cameraPitchOffset)
+	, cameraHeightOffsetTerm(2.0f * cameraHeightOffset)
+{}
+
+void ColumnBatch::Clear()
+{
+	for (std::vector<float>* array : {
+		&pointX, &pointY, &height, &groundOffset, &spriteX, &spriteY, &spriteRadius,
+		&textureLeft, &textureWidth, &distance, &top, &bottom, &u })
+	{
+		array->resize(0);
+	}
+}
+
+void ColumnBatch::Add(
+	const b2Vec2& point,
+	const float height,
+	const float groundOffset,
+	const b2Vec2& spritePosition,
+	const float spriteRadius,
+	const float textureLeft,
+	const float textureWidth)
+{
+	this->pointX.push_back(point.x);
+	this->pointY.push_back(point.y);
+	this->height.push_back(height);
+	this->groundOffset.push_back(groundOffset);
+	this->spriteX.push_back(spritePosition.x);
+	this->spriteY.push_back(spritePosition.y);
+	this->spriteRadius.push_back(spriteRadius);
+	this->textureLeft.push_back(textureLeft);
+	this->textureWidth.push_back(textureWidth);
+}
+
+void ProjectColumns(const ColumnProjection& projection, ColumnBatch& batch)
+{
+	const std::size_t count = batch.Size();
+
+	batch.distance.resize(count);
+	batch.top.resize(count);
+	batch.bottom.resize(count);
+	batch.u.resize(count);
+
+	std::size_t i = 0;
+
+#if QUIVER_COLUMN_PROJECTION_SSE
+	{
+		const __m128 cameraX = _mm_set1_ps(projection.cameraPosition.x);
+		const __m128 cameraY = _mm_set1_ps(projection.cameraPosition.y);
+		const __m128 forwardsX = _mm_set1_ps(projection.cameraForwards.x);
+		const __m128 forwardsY = _mm_set1_ps(projection.cameraForwards.y);
+		const __m128 rightX = _mm_set1_ps(projection.cameraRight.x);
+		const __m128 rightY = _mm_set1_ps(projection.cameraRight.y);
+		const __m128 halfTargetHeight = _mm_set1_ps(0.5f * projection.targetHeight);
+		const __m128 horizon = _mm_set1_ps(projection.horizon);
+		const __m128 cameraHeightOffsetTerm = _mm_set1_ps(projection.cameraHeightOffsetTerm);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 pointX = _mm_loadu_ps(&batch.pointX[i]);
+			const __m128 pointY = _mm_loadu_ps(&batch.pointY[i]);
+			const __m128 height = _mm_loadu_ps(&batch.height[i]);
+			const __m128 groundOffset = _mm_loadu_ps(&batch.groundOffset[i]);
+
+			const __m128 distance = _mm_add_ps(
+				_mm_mul_ps(_mm_sub_ps(pointX, cameraX), forwardsX),
+				_mm_mul_ps(_mm_sub_ps(pointY, cameraY), forwardsY));
+
+			const __m128 halfMetreInPixels = _mm_div_ps(halfTargetHeight, _mm_andnot_ps(signBit, distance));
+
+			const __m128 raise = _mm_add_ps(
+				_mm_sub_ps(_mm_add_ps(groundOffset, height), one),
+				cameraHeightOffsetTerm);
+
+			const __m128 top = _mm_sub_ps(horizon, _mm_mul_ps(halfMetreInPixels, _mm_add_ps(raise, height)));
+			const __m128 bottom = _mm_sub_ps(horizon, _mm_mul_ps(halfMetreInPixels, _mm_sub_ps(raise, height)));
+
+			_mm_storeu_ps(&batch.distance[i], distance);
+			_mm_storeu_ps(&batch.top[i], top);
+			_mm_storeu_ps(&batch.bottom[i], bottom);
+
+			// How far along the sprite, from its left edge, the hit is.
+			const __m128 spriteRadius = _mm_loadu_ps(&batch.spriteRadius[i]);
+
+			const __m128 fromLeftX = _mm_add_ps(
+				_mm_sub_ps(pointX, _mm_loadu_ps(&batch.spriteX[i])),
+				_mm_mul_ps(spriteRadius, rightX));
+			const __m128 fromLeftY = _mm_add_ps(
+				_mm_sub_ps(pointY, _mm_loadu_ps(&batch.spriteY[i])),
+				_mm_mul_ps(spriteRadius, rightY));
+
+			const __m128 fromLeft = _mm_sqrt_ps(_mm_add_ps(
+				_mm_mul_ps(fromLeftX, fromLeftX),
+				_mm_mul_ps(fromLeftY, fromLeftY)));
+
+			const __m128 along = _mm_div_ps(_mm_mul_ps(fromLeft, half), spriteRadius);
+
+			const __m128 u = _mm_add_ps(
+				_mm_mul_ps(along, _mm_loadu_ps(&batch.textureWidth[i])),
+				_mm_loadu_ps(&batch.textureLeft[i]));
+
+			_mm_storeu_ps(&batch.u[i], u);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const b2Vec2 point(batch.pointX[i], batch.pointY[i]);
+
+		const float distance = projection.GetDistance(point);
+
+		batch.distance[i] = distance;
+
+		projection.GetTopAndBottom(
+			distance,
+			batch.height[i],
+			batch.groundOffset[i],
+			batch.top[i],
+			batch.bottom[i]);
+
+		const float spriteRadius = batch.spriteRadius[i];
+		const b2Vec2 left = b2Vec2(batch.spriteX[i], batch.spriteY[i]) - (spriteRadius * projection.cameraRight);
+		const float along = (point - left).Length() * 0.5f / spriteRadius;
+
+		batch.u[i] = along * batch.textureWidth[i] + batch.textureLeft[i];
+	}
+}
+
+}
\ No newline at end of file
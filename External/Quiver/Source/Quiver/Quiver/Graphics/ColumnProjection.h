@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+
+namespace qvr {
+
+class Camera3D;
+
+// Works out where things land on screen for the raycast renderer. Everything that only
+// depends on the camera and the target is worked out once, when this is constructed.
+struct ColumnProjection
+{
+	ColumnProjection() = default;
+
+	ColumnProjection(const Camera3D& camera, const unsigned targetHeight);
+
+	// Distance along the camera's forward axis, which is what perspective divides by.
+	float GetDistance(const b2Vec2& point) const {
+		return b2Dot(point - cameraPosition, cameraForwards);
+	}
+
+	float GetHorizon() const { return horizon; }
+
+	void GetTopAndBottom(
+		const float distance,
+		const float height,
+		const float groundOffset,
+		float& top,
+		float& bottom) const
+	{
+		// At a distance of 1 metre, a vertical metre is enough pixels in height to fill the screen.
+		const float halfMetreInPixels = 0.5f * targetHeight / std::abs(distance);
+
+		// How far the middle of the line is above the horizon, in units of half a line height.
+		const float raise = groundOffset + height - 1.0f + cameraHeightOffsetTerm;
+
+		top = horizon - halfMetreInPixels * (raise + height);
+		bottom = horizon - halfMetreInPixels * (raise - height);
+	}
+
+	b2Vec2 cameraPosition = b2Vec2_zero;
+	b2Vec2 cameraForwards = b2Vec2(1.0f, 0.0f);
+	// Runs along flat sprites from their left edge to their right.
+	b2Vec2 cameraRight = b2Vec2(0.0f, 1.0f);
+	float targetHeight = 0.0f;
+	float cameraHeightOffset = 0.0f;
+	float cameraPitchOffset = 0.0f;
+
+	// targetHeight / 2 + cameraPitchOffset.
+	float horizon = 0.0f;
+	// 2 * cameraHeightOffset.
+	float cameraHeightOffsetTerm = 0.0f;
+};
+
+// A batch of ray hits for ProjectColumns, as structure-of-arrays.
+struct ColumnBatch
+{
+	void Clear();
+
+	std::size_t Size() const { return pointX.size(); }
+
+	void Add(
+		const b2Vec2& point,
+		const float height,
+		const float groundOffset,
+		const b2Vec2& spritePosition,
+		const float spriteRadius,
+		const float textureLeft,
+		const float textureWidth);
+
+	// In:
+	std::vector<float> pointX;
+	std::vector<float> pointY;
+	std::vector<float> height;
+	std::vector<float> groundOffset;
+	std::vector<float> spriteX;
+	std::vector<float> spriteY;
+	std::vector<float> spriteRadius;
+	// In texels.
+	std::vector<float> textureLeft;
+	std::vector<float> textureWidth;
+
+	// Out:
+	std::vector<float> distance;
+	std::vector<float> top;
+	std::vector<float> bottom;
+	// Horizontal texture coordinate, in texels.
+	std::vector<float> u;
+};
+
+// Fills in the batch's outputs, four hits at a time where SSE is available.
+// Gives the same results as GetDistance and GetTopAndBottom, give or take rounding.
+void ProjectColumns(const ColumnProjection& projection, ColumnBatch& batch);
+
+}
\ No newline at end of file
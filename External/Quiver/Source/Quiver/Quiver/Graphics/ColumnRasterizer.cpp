@@ -0,0 +1,172 @@
+#include "ColumnRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Quiver/Graphics/MipChain.h"
+
+namespace qvr {
+
+namespace {
+
+const std::uint8_t White[4] = { 255, 255, 255, 255 };
+
+float Clamp01(const float f) {
+	return std::min(std::max(f, 0.0f), 1.0f);
+}
+
+std::uint8_t ToByte(const float f) {
+	return (std::uint8_t)(Clamp01(f) * 255.0f + 0.5f);
+}
+
+int ClampIndex(const float f, const unsigned size) {
+	return std::min(std::max((int)std::floor(f), 0), (int)size - 1);
+}
+
+}
+
+void ColumnMajorTexture::Assign(
+	const unsigned width,
+	const unsigned height,
+	const std::uint8_t* rowMajorPixels)
+{
+	this->width = width;
+	this->height = height;
+
+	texels.resize(4 * width * height);
+	mips.clear();
+
+	for (unsigned y = 0; y < height; ++y)
+	{
+		for (unsigned x = 0; x < width; ++x)
+		{
+			std::copy_n(
+				rowMajorPixels + 4 * (y * width + x),
+				4,
+				&texels[4 * (x * height + y)]);
+		}
+	}
+}
+
+void ColumnMajorTexture::GenerateMips()
+{
+	mips.clear();
+
+	unsigned levelWidth = width;
+	unsigned levelHeight = height;
+	const std::vector<std::uint8_t>* levelTexels = &texels;
+
+	while (levelWidth > 1 || levelHeight > 1)
+	{
+		ColumnMajorTexture mip;
+		mip.width = std::max(levelWidth / 2, 1u);
+		mip.height = std::max(levelHeight / 2, 1u);
+
+		// Column by column is row by row with the sides swapped.
+		DownsampleMip(levelTexels->data(), levelHeight, levelWidth, mip.texels);
+
+		mips.push_back(std::move(mip));
+
+		levelWidth = mips.back().width;
+		levelHeight = mips.back().height;
+		levelTexels = &mips.back().texels;
+	}
+}
+
+const ColumnMajorTexture& ColumnMajorTexture::GetMip(const int level) const
+{
+	if (level <= 0 || mips.empty()) return *this;
+
+	return mips[std::min((std::size_t)level, mips.size()) - 1];
+}
+
+void RasterizeColumn(
+	std::uint8_t* column,
+	const unsigned height,
+	const RasterHit* hits,
+	const unsigned hitCount,
+	const ColumnLighting& lighting)
+{
+	for (unsigned hitIndex = 0; hitIndex < hitCount; ++hitIndex)
+	{
+		const RasterHit& hit = hits[hitIndex];
+
+		if (!(hit.bottom > hit.top)) continue;
+
+		// Pixels whose centres are in [top, bottom).
+		const int firstRow = std::max((int)std::ceil(hit.top - 0.5f), 0);
+		const int endRow = std::min((int)std::ceil(hit.bottom - 0.5f), (int)height);
+
+		if (firstRow >= endRow) continue;
+
+		// Everything but the texture is the same all the way down the column.
+		float frontColor[4];
+		for (int c = 0; c < 4; ++c) {
+			frontColor[c] = Clamp01(lighting.ambientColor[c] * (hit.color[c] / 255.0f));
+		}
+
+		const float fogRange = lighting.fogMaxDistance - lighting.fogMinDistance;
+		const float fogIntensity = fogRange > 0.0f ?
+			std::min(
+				(std::min(std::max(hit.distance, lighting.fogMinDistance), lighting.fogMaxDistance) - lighting.fogMinDistance) / fogRange,
+				lighting.fogMaxIntensity) :
+			lighting.fogMaxIntensity;
+
+		const float directionalIntensity = Clamp01(
+			-(hit.normalX * lighting.directionalDirection[0] + hit.normalY * lighting.directionalDirection[1]));
+
+		float added[4];
+		for (int c = 0; c < 4; ++c) {
+			added[c] =
+				lighting.fogColor[c] * fogIntensity +
+				lighting.directionalColor[c] * directionalIntensity;
+		}
+
+		const ColumnMajorTexture* texture = nullptr;
+		const std::uint8_t* textureColumn = nullptr;
+
+		// Texel coordinates are for level 0, so they're scaled to fit the level's size.
+		float mipScaleU = 1.0f;
+		float mipScaleV = 1.0f;
+
+		if (hit.texture)
+		{
+			texture = &hit.texture->GetMip(
+				GetMipLevel(GetColumnTexelsPerPixel(hit.vTop, hit.vBottom, hit.top, hit.bottom)));
+
+			mipScaleU = (float)texture->width / hit.texture->width;
+			mipScaleV = (float)texture->height / hit.texture->height;
+
+			textureColumn = texture->GetColumn(ClampIndex(hit.u * mipScaleU, texture->width));
+		}
+
+		const float vPerPixel = (hit.vBottom - hit.vTop) / (hit.bottom - hit.top);
+
+		for (int row = firstRow; row < endRow; ++row)
+		{
+			const std::uint8_t* texel = White;
+
+			if (textureColumn)
+			{
+				const float v = hit.vTop + (row + 0.5f - hit.top) * vPerPixel;
+				texel = textureColumn + 4 * ClampIndex(v * mipScaleV, texture->height);
+			}
+
+			float source[4];
+			for (int c = 0; c < 4; ++c) {
+				source[c] = Clamp01(frontColor[c] * (texel[c] / 255.0f) + added[c]);
+			}
+
+			// sf::BlendAlpha: source alpha for colour, one for alpha.
+			std::uint8_t* pixel = column + 4 * row;
+			const float sourceAlpha = source[3];
+
+			for (int c = 0; c < 3; ++c) {
+				pixel[c] = ToByte(source[c] * sourceAlpha + (pixel[c] / 255.0f) * (1.0f - sourceAlpha));
+			}
+			pixel[3] = ToByte(sourceAlpha + (pixel[3] / 255.0f) * (1.0f - sourceAlpha));
+		}
+	}
+}
+
+}
\ No newline at end of file
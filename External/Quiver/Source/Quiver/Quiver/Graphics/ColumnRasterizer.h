@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace qvr {
+
+// The CPU side of the raycast renderer's software backend: paints columns into RGBA pixels
+// with the same lighting, fog and blending as the GL column shader.
+
+// A copy of a texture laid out column by column, so that walking down a screen column walks
+// through memory in order. RGBA, 8 bits per channel.
+struct ColumnMajorTexture
+{
+	unsigned width = 0;
+	unsigned height = 0;
+	std::vector<std::uint8_t> texels;
+
+	// Smaller and smaller copies, for far away columns, down to 1 by 1. mips[0] is level 1.
+	// Left empty unless GenerateMips is called.
+	std::vector<ColumnMajorTexture> mips;
+
+	// rowMajorPixels is RGBA, row by row, like sf::Image. Throws away any mips.
+	void Assign(const unsigned width, const unsigned height, const std::uint8_t* rowMajorPixels);
+
+	void GenerateMips();
+
+	// Level 0 is the texture itself. Asking for a level past the smallest gets the smallest.
+	const ColumnMajorTexture& GetMip(const int level) const;
+
+	const std::uint8_t* GetColumn(const unsigned x) const { return &texels[4 * x * height]; }
+};
+
+// Colours are RGBA, from 0 to 1.
+struct ColumnLighting
+{
+	float ambientColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	float directionalColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float directionalDirection[2] = { 0.0f, 0.0f };
+
+	float fogColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float fogMinDistance = 0.0f;
+	float fogMaxDistance = 1.0f;
+	float fogMaxIntensity = 0.0f;
+};
+
+// One column's worth of a hit.
+struct RasterHit
+{
+	float top;
+	float bottom;
+	float distance;
+	// In texels.
+	float u;
+	float vTop;
+	float vBottom;
+	float normalX;
+	float normalY;
+	std::uint8_t color[4];
+	// nullptr for plain white.
+	const ColumnMajorTexture* texture;
+};
+
+// Paints the hits, in the order given, into a column of RGBA pixels that goes from the top of
+// the screen to the bottom. Covers the pixels whose centres are between top and bottom, samples
+// the nearest texel (clamped to the texture's edges) from the mip level GetMipLevel picks, and
+// blends like sf::BlendAlpha.
+void RasterizeColumn(
+	std::uint8_t* column,
+	const unsigned height,
+	const RasterHit* hits,
+	const unsigned hitCount,
+	const ColumnLighting& lighting);
+
+}
\ No newline at end of file
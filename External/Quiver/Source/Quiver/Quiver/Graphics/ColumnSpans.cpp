@@ -0,0 +1,272 @@
+#include "ColumnSpans.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace qvr {
+
+namespace {
+
+// Hits this close to the camera aren't merged; their interpolation gets too touchy.
+const float MinSpanDistance = 1e-3f;
+
+float Lerp(const float a, const float b, const float t) {
+	return a + (b - a) * t;
+}
+
+}
+
+const float ColumnSpanBuilder::sm_MaxPixelError = 0.01f;
+const float ColumnSpanBuilder::sm_MaxTexelError = 0.01f;
+const float ColumnSpanBuilder::sm_MaxRelativeDistanceError = 1e-4f;
+const float ColumnSpanBuilder::sm_MaxColorError = 2.0f;
+
+void ColumnSpanBuilder::Build(const ColumnSpanInput& hits, std::vector<ColumnSpan>& spans)
+{
+	spans.resize(0);
+
+	const unsigned count = (unsigned)hits.count;
+
+	if (count == 0) return;
+
+	// Link each hit to the matching hit in the next column, if there is one.
+	mNextInChain.assign(count, -1);
+	mHasPrevious.assign(count, 0);
+
+	{
+		unsigned previousBegin = 0, previousEnd = 0;
+		unsigned columnBegin = 0;
+
+		while (columnBegin < count)
+		{
+			unsigned columnEnd = columnBegin + 1;
+			while (columnEnd < count && hits.x[columnEnd] == hits.x[columnBegin]) {
+				++columnEnd;
+			}
+
+			const bool adjacent =
+				previousEnd > previousBegin &&
+				hits.x[columnBegin] == hits.x[previousBegin] + 1.0f;
+
+			for (unsigned hit = columnBegin; adjacent && hit < columnEnd; ++hit)
+			{
+				if (hits.distance[hit] < MinSpanDistance) continue;
+
+				for (unsigned previous = previousBegin; previous < previousEnd; ++previous)
+				{
+					if (mNextInChain[previous] >= 0) continue;
+					if (hits.proxy[previous] != hits.proxy[hit]) continue;
+					if (hits.normalX[previous] != hits.normalX[hit]) continue;
+					if (hits.normalY[previous] != hits.normalY[hit]) continue;
+					if (hits.distance[previous] < MinSpanDistance) continue;
+
+					mNextInChain[previous] = (int)hit;
+					mHasPrevious[hit] = 1;
+					break;
+				}
+			}
+
+			previousBegin = columnBegin;
+			previousEnd = columnEnd;
+			columnBegin = columnEnd;
+		}
+	}
+
+	// Chop each chain into spans that interpolate well enough.
+	mUnordered.resize(0);
+	mSpanOfHit.assign(count, 0);
+
+	for (unsigned head = 0; head < count; ++head)
+	{
+		if (mHasPrevious[head]) continue;
+
+		mChain.resize(0);
+		for (int hit = (int)head; hit >= 0; hit = mNextInChain[hit]) {
+			mChain.push_back((unsigned)hit);
+		}
+
+		unsigned begin = 0;
+		while (begin < mChain.size())
+		{
+			unsigned end = begin + 1;
+			while (end < mChain.size() && SpanFits(hits, begin, end)) {
+				++end;
+			}
+
+			const unsigned spanIndex = (unsigned)mUnordered.size();
+			mUnordered.push_back(ColumnSpan{ mChain[begin], mChain[end - 1] });
+
+			for (unsigned i = begin; i < end; ++i) {
+				mSpanOfHit[mChain[i]] = spanIndex;
+			}
+
+			begin = end;
+		}
+	}
+
+	const unsigned spanCount = (unsigned)mUnordered.size();
+
+	// Nothing merged, so the order they came in is already right.
+	if (spanCount == count)
+	{
+		spans.reserve(count);
+		for (unsigned hit = 0; hit < count; ++hit) {
+			spans.push_back(ColumnSpan{ hit, hit });
+		}
+		return;
+	}
+
+	// Within a column, whatever is behind has to be drawn first. Gather those constraints
+	// between spans and sort them topologically.
+	mEdgeCount.assign(spanCount + 1, 0);
+	mIncoming.assign(spanCount, 0);
+
+	for (unsigned hit = 0; hit + 1 < count; ++hit)
+	{
+		if (hits.x[hit] != hits.x[hit + 1]) continue;
+
+		const unsigned from = mSpanOfHit[hit];
+		const unsigned to = mSpanOfHit[hit + 1];
+
+		if (from == to) continue;
+
+		mEdgeCount[from + 1]++;
+		mIncoming[to]++;
+	}
+
+	mEdgeBegin.resize(spanCount + 1);
+	mEdgeBegin[0] = 0;
+	for (unsigned span = 0; span < spanCount; ++span) {
+		mEdgeBegin[span + 1] = mEdgeBegin[span] + mEdgeCount[span + 1];
+	}
+
+	mEdges.resize(mEdgeBegin[spanCount]);
+
+	// mEdgeCount gets reused as each span's fill position.
+	std::copy(mEdgeBegin.begin(), mEdgeBegin.end() - 1, mEdgeCount.begin());
+
+	for (unsigned hit = 0; hit + 1 < count; ++hit)
+	{
+		if (hits.x[hit] != hits.x[hit + 1]) continue;
+
+		const unsigned from = mSpanOfHit[hit];
+		const unsigned to = mSpanOfHit[hit + 1];
+
+		if (from == to) continue;
+
+		mEdges[mEdgeCount[from]++] = to;
+	}
+
+	// Of the spans that are ready, take the one that starts earliest, so the result is as
+	// close to the order the hits came in as it can be.
+	const auto startsLater = [this](const unsigned a, const unsigned b) {
+		return mUnordered[a].first > mUnordered[b].first;
+	};
+
+	mReady.resize(0);
+	for (unsigned span = 0; span < spanCount; ++span) {
+		if (mIncoming[span] == 0) {
+			mReady.push_back(span);
+		}
+	}
+	std::make_heap(mReady.begin(), mReady.end(), startsLater);
+
+	spans.reserve(spanCount);
+
+	while (!mReady.empty())
+	{
+		std::pop_heap(mReady.begin(), mReady.end(), startsLater);
+		const unsigned span = mReady.back();
+		mReady.pop_back();
+
+		spans.push_back(mUnordered[span]);
+
+		for (unsigned edge = mEdgeBegin[span]; edge < mEdgeBegin[span + 1]; ++edge)
+		{
+			const unsigned to = mEdges[edge];
+
+			if (--mIncoming[to] == 0)
+			{
+				mReady.push_back(to);
+				std::push_heap(mReady.begin(), mReady.end(), startsLater);
+			}
+		}
+	}
+
+	if (spans.size() < spanCount)
+	{
+		// There's a cycle: no order of spans works, so don't merge anything.
+		spans.resize(0);
+		for (unsigned hit = 0; hit < count; ++hit) {
+			spans.push_back(ColumnSpan{ hit, hit });
+		}
+	}
+}
+
+bool ColumnSpanBuilder::SpanFits(
+	const ColumnSpanInput& hits,
+	const unsigned begin,
+	const unsigned end) const
+{
+	const unsigned first = mChain[begin];
+	const unsigned last = mChain[end];
+
+	const float width = hits.x[last] - hits.x[first];
+
+	const float firstInverseDistance = 1.0f / hits.distance[first];
+	const float lastInverseDistance = 1.0f / hits.distance[last];
+
+	// The quad reaches half a column past its outermost columns, so these get extrapolated.
+	const float edgeT = 0.5f / width;
+	if (Lerp(firstInverseDistance, lastInverseDistance, -edgeT) <= 0.0f) return false;
+	if (Lerp(firstInverseDistance, lastInverseDistance, 1.0f + edgeT) <= 0.0f) return false;
+
+	const float firstUOverDistance = hits.u[first] * firstInverseDistance;
+	const float lastUOverDistance = hits.u[last] * lastInverseDistance;
+
+	for (unsigned i = begin + 1; i < end; ++i)
+	{
+		const unsigned hit = mChain[i];
+
+		const float t = (hits.x[hit] - hits.x[first]) / width;
+
+		const float distance = 1.0f / Lerp(firstInverseDistance, lastInverseDistance, t);
+
+		if (std::abs(distance - hits.distance[hit]) > sm_MaxRelativeDistanceError * hits.distance[hit]) {
+			return false;
+		}
+
+		if (std::abs(Lerp(hits.top[first], hits.top[last], t) - hits.top[hit]) > sm_MaxPixelError) {
+			return false;
+		}
+
+		if (std::abs(Lerp(hits.bottom[first], hits.bottom[last], t) - hits.bottom[hit]) > sm_MaxPixelError) {
+			return false;
+		}
+
+		const float u = Lerp(firstUOverDistance, lastUOverDistance, t) * distance;
+
+		if (std::abs(u - hits.u[hit]) > sm_MaxTexelError) {
+			return false;
+		}
+
+		if (hits.color)
+		{
+			for (unsigned c = 0; c < 4; ++c)
+			{
+				const float interpolated = Lerp(
+					hits.color[4 * first + c] * firstInverseDistance,
+					hits.color[4 * last + c] * lastInverseDistance,
+					t) * distance;
+
+				if (std::abs(interpolated - hits.color[4 * hit + c]) > sm_MaxColorError) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace qvr {
+
+// A run of neighbouring screen columns that hit the same flat face of the same thing. It can be
+// drawn as one quad instead of a line per column: everything that varies along it (top, bottom,
+// 1 / distance and u / distance) varies linearly across the screen, so perspective-correct
+// interpolation between its ends gives back what each column would have had.
+struct ColumnSpan
+{
+	// Hits at the span's leftmost and rightmost columns. The same hit for a single column.
+	unsigned first;
+	unsigned last;
+};
+
+// A chunk of hits, as structure-of-arrays. Hits must be grouped by screen column, with columns
+// going left to right and each column's hits going back to front.
+struct ColumnSpanInput
+{
+	std::size_t count = 0;
+
+	const float* x = nullptr;
+	// Hits can only share a span if they're on the same proxy, with the same normal.
+	const int* proxy = nullptr;
+	const float* normalX = nullptr;
+	const float* normalY = nullptr;
+
+	const float* distance = nullptr;
+	const float* top = nullptr;
+	const float* bottom = nullptr;
+	const float* u = nullptr;
+
+	// RGBA, 4 per hit. Optional: without it, hits are taken to be the same colour all along a
+	// span. With it, colour has to interpolate like U does.
+	const std::uint8_t* color = nullptr;
+};
+
+// Merges hits into spans, and puts the spans in an order that still paints every column back to
+// front. If no such order exists (things that poke through each other can cause that), every
+// hit gets a span of its own, in the order they came in.
+class ColumnSpanBuilder
+{
+public:
+	void Build(const ColumnSpanInput& hits, std::vector<ColumnSpan>& spans);
+
+	// Allowed differences between what a span interpolates and what its columns had.
+	static const float sm_MaxPixelError;
+	static const float sm_MaxTexelError;
+	static const float sm_MaxRelativeDistanceError;
+	// Out of 255.
+	static const float sm_MaxColorError;
+
+private:
+	bool SpanFits(const ColumnSpanInput& hits, const unsigned begin, const unsigned end) const;
+
+	// Scratch space, kept around between chunks.
+	std::vector<int> mNextInChain;
+	std::vector<char> mHasPrevious;
+	std::vector<unsigned> mChain;
+	std::vector<unsigned> mSpanOfHit;
+	std::vector<unsigned> mEdgeCount;
+	std::vector<unsigned> mEdges;
+	std::vector<unsigned> mEdgeBegin;
+	std::vector<unsigned> mIncoming;
+	std::vector<unsigned> mReady;
+	std::vector<ColumnSpan> mUnordered;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Quiver/Graphics/RenderSettings.h"
+
+namespace qvr {
+
+namespace {
+
+// Frames to wait after a change before trusting the timings again.
+const int MinSampleCount = 8;
+
+// How much each new sample counts for in the smoothed timings.
+const float Smoothing = 0.1f;
+
+// Only grow if the render takes less than this much of the time it has, and then only
+// as far as would use up this much of it. Stops the scale from see-sawing.
+const float GrowThreshold = 0.8f;
+const float GrowTarget = 0.9f;
+
+// At most this much bigger per change. Shrinking isn't limited.
+const float MaxGrowth = 1.1f;
+
+// Smaller changes aren't worth recreating the texture for.
+const float MinChange = 0.02f;
+
+}
+
+bool DynamicResolution::Update(
+	const RenderSettings& settings,
+	const Profiler::SampleUnit stepTime,
+	const Profiler::SampleUnit renderTime)
+{
+	if (mSampleCount == 0)
+	{
+		mStepTime = stepTime.count();
+		mRenderTime = renderTime.count();
+	}
+	else
+	{
+		mStepTime += (stepTime.count() - mStepTime) * Smoothing;
+		mRenderTime += (renderTime.count() - mRenderTime) * Smoothing;
+	}
+
+	mSampleCount++;
+
+	if (mSampleCount < MinSampleCount || mRenderTime <= 0.0f) return false;
+
+	// The step takes as long as it takes, whatever the resolution.
+	const float targetFrameTime = settings.m_TargetFrameTime;
+	const float renderBudget = std::max(targetFrameTime - mStepTime, targetFrameTime * 0.1f);
+
+	float newScale = mScale;
+
+	if (mRenderTime > renderBudget)
+	{
+		newScale = mScale * (renderBudget / mRenderTime);
+	}
+	else if (mRenderTime < renderBudget * GrowThreshold)
+	{
+		newScale = std::min(
+			mScale * (renderBudget * GrowTarget / mRenderTime),
+			mScale * MaxGrowth);
+	}
+
+	newScale = settings.ClampResolutionScale(newScale);
+
+	// Small changes are still allowed if they take the scale right up to a bound.
+	const bool atBound =
+		newScale == settings.m_MinResolutionScale ||
+		newScale == settings.m_MaxResolutionScale;
+
+	if (newScale == mScale || (std::abs(newScale - mScale) < MinChange && !atBound)) {
+		return false;
+	}
+
+	mScale = newScale;
+	mSampleCount = 0;
+
+	return true;
+}
+
+void DynamicResolution::Reset(const RenderSettings& settings, const float scale)
+{
+	mScale = settings.ClampResolutionScale(scale);
+	mSampleCount = 0;
+}
+
+}
\ No newline at end of file
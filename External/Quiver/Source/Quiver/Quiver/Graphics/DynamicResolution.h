@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Quiver/Misc/Profiler.h"
+
+namespace qvr {
+
+struct RenderSettings;
+
+// Picks a scale for the 3D frame texture that keeps the World's step and 3D render inside
+// RenderSettings::m_TargetFrameTime. The raycast renderer casts one ray per column, so its
+// cost goes up roughly in step with the scale; the scale is nudged by the ratio of the time
+// the render has to the time it took.
+class DynamicResolution
+{
+public:
+	// Call once for every frame that was rendered. Returns true if the scale changed.
+	bool Update(
+		const RenderSettings& settings,
+		const Profiler::SampleUnit stepTime,
+		const Profiler::SampleUnit renderTime);
+
+	// Starts again from the given scale (clamped to the settings' bounds).
+	void Reset(const RenderSettings& settings, const float scale);
+
+	float GetScale() const { return mScale; }
+
+private:
+	float mScale = 1.0f;
+
+	// Smoothed, in milliseconds.
+	float mStepTime = 0.0f;
+	float mRenderTime = 0.0f;
+
+	// Since the scale last changed.
+	int mSampleCount = 0;
+};
+
+}
\ No newline at end of file
@@ -11,10 +11,12 @@ namespace qvr
 {
 
 class RenderComponent;
+class TileMap;
 
 class FixtureRenderData
 {
 	friend class RenderComponent;
+	friend class TileMap;
 
 	float mHeight = 1.0f;
 	float mGroundOffset = 0.0f;
@@ -24,6 +26,9 @@ class FixtureRenderData
 
 	sf::Color mBlendColor = sf::Color(255, 255, 255, 255);
 
+	// Set for things like walls, whose textures have no see-through bits.
+	bool mOpaque = false;
+
 	std::shared_ptr<sf::Texture> mTexture;
 
 	AnimatorTarget mTextureRects;
@@ -38,7 +43,12 @@ public:
 
 	sf::Color GetColor() const { return mBlendColor; }
 
+	// True if nothing behind this can be seen through it. Untextured fixtures are drawn in a
+	// solid colour, so they count.
+	bool IsOpaque() const { return (mOpaque || !mTexture) && mBlendColor.a == 255; }
+
 	const sf::Texture* GetTexture() const { return mTexture.get(); }
+	const std::shared_ptr<sf::Texture>& GetSharedTexture() const { return mTexture; }
 
 	const ViewBuffer& GetViews() const { return mTextureRects.views; }
 };
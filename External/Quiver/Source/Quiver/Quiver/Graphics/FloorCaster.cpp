@@ -0,0 +1,569 @@
+#include "FloorCaster.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <ImGui/imgui.h>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+
+#include "Quiver/Graphics/Camera3D.h"
+#include "Quiver/Graphics/ColourUtils.h"
+#include "Quiver/Graphics/Fog.h"
+#include "Quiver/Graphics/Light.h"
+#include "Quiver/Graphics/MipChain.h"
+#include "Quiver/Graphics/TextureLibrary.h"
+#include "Quiver/Misc/ImGuiHelpers.h"
+#include "Quiver/Misc/Logging.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUIVER_FLOOR_CASTER_SSE 1
+#include <emmintrin.h>
+#else
+#define QUIVER_FLOOR_CASTER_SSE 0
+#endif
+
+namespace qvr {
+
+namespace {
+
+// Where a texture coordinate lands once it's wrapped around the texture, as a whole texel.
+// The SSE kernel does the same float operations in the same order, so they always agree.
+int WrapTexel(const float coordinate, const float size, const float inverseSize)
+{
+	const float q = coordinate * inverseSize;
+	const float wrapped = (q - std::floor(q)) * size;
+	return (int)std::min(wrapped, size - 1.0f);
+}
+
+std::uint32_t Shade(const std::uint32_t texel, const FloorRow& row)
+{
+	std::uint32_t pixel = 0;
+
+	for (int c = 0; c < 4; ++c)
+	{
+		const unsigned channel = (texel >> (8 * c)) & 0xff;
+		const unsigned shaded = std::min((channel * row.scale[c] >> 8) + row.add[c], 255u);
+		pixel |= shaded << (8 * c);
+	}
+
+	return pixel;
+}
+
+std::uint16_t ToScale(const float f) {
+	return (std::uint16_t)(std::min(std::max(f, 0.0f), 1.0f) * 256.0f + 0.5f);
+}
+
+std::uint16_t ToAdd(const float f) {
+	return (std::uint16_t)(std::min(std::max(f, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+#if QUIVER_FLOOR_CASTER_SSE
+
+// SSE2 has no floor, so truncate and step down where that went up.
+__m128 Floor(const __m128 a)
+{
+	const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+	return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+}
+
+__m128i WrapTexels(const __m128 coordinate, const __m128 size, const __m128 inverseSize, const __m128 maxTexel)
+{
+	const __m128 q = _mm_mul_ps(coordinate, inverseSize);
+	const __m128 wrapped = _mm_mul_ps(_mm_sub_ps(q, Floor(q)), size);
+	return _mm_cvttps_epi32(_mm_min_ps(wrapped, maxTexel));
+}
+
+#endif
+
+// Pixels from begin up to end, one at a time.
+void CastPixels(
+	std::uint32_t* pixels,
+	const unsigned begin,
+	const unsigned end,
+	const FloorRow& row,
+	const FloorTexture& texture)
+{
+	const float width = (float)texture.width;
+	const float height = (float)texture.height;
+	const float inverseWidth = 1.0f / width;
+	const float inverseHeight = 1.0f / height;
+
+	for (unsigned i = begin; i < end; ++i)
+	{
+		const float index = (float)i;
+		const float u = row.startU + index * row.stepU;
+		const float v = row.startV + index * row.stepV;
+
+		const int x = WrapTexel(u, width, inverseWidth);
+		const int y = WrapTexel(v, height, inverseHeight);
+
+		pixels[i] = Shade(texture.texels[y * texture.width + x], row);
+	}
+}
+
+}
+
+void FloorTexture::Assign(const unsigned width, const unsigned height, const std::uint8_t* rowMajorPixels)
+{
+	if (width == 0 || height == 0) {
+		*this = FloorTexture();
+		return;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	texels.resize(width * height);
+
+	std::memcpy(texels.data(), rowMajorPixels, 4 * texels.size());
+
+	mips.clear();
+
+	std::vector<std::uint8_t> mipPixels;
+
+	const FloorTexture* above = this;
+
+	while (above->width > 1 || above->height > 1)
+	{
+		DownsampleMip(
+			reinterpret_cast<const std::uint8_t*>(above->texels.data()),
+			above->width,
+			above->height,
+			mipPixels);
+
+		FloorTexture mip;
+		mip.width = std::max(above->width / 2, 1u);
+		mip.height = std::max(above->height / 2, 1u);
+		mip.texels.resize(mip.width * mip.height);
+
+		std::memcpy(mip.texels.data(), mipPixels.data(), mipPixels.size());
+
+		mips.push_back(std::move(mip));
+
+		above = &mips.back();
+	}
+}
+
+const FloorTexture& FloorTexture::GetMip(const int level) const
+{
+	if (level <= 0 || mips.empty()) return *this;
+
+	return mips[std::min((std::size_t)level, mips.size()) - 1];
+}
+
+void CastFloorRowScalar(std::uint32_t* pixels, const unsigned count, const FloorRow& row, const FloorTexture& texture)
+{
+	CastPixels(pixels, 0, count, row, texture);
+}
+
+void CastFloorRow(std::uint32_t* pixels, const unsigned count, const FloorRow& row, const FloorTexture& texture)
+{
+	unsigned i = 0;
+
+#if QUIVER_FLOOR_CASTER_SSE
+	{
+		const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		const __m128 startU = _mm_set1_ps(row.startU);
+		const __m128 startV = _mm_set1_ps(row.startV);
+		const __m128 stepU = _mm_set1_ps(row.stepU);
+		const __m128 stepV = _mm_set1_ps(row.stepV);
+		const __m128 width = _mm_set1_ps((float)texture.width);
+		const __m128 height = _mm_set1_ps((float)texture.height);
+		const __m128 inverseWidth = _mm_set1_ps(1.0f / (float)texture.width);
+		const __m128 inverseHeight = _mm_set1_ps(1.0f / (float)texture.height);
+		const __m128 maxX = _mm_set1_ps((float)texture.width - 1.0f);
+		const __m128 maxY = _mm_set1_ps((float)texture.height - 1.0f);
+
+		// Two pixels' worth of channels at a time, once they're widened to 16 bits.
+		const __m128i scale = _mm_setr_epi16(
+			row.scale[0], row.scale[1], row.scale[2], row.scale[3],
+			row.scale[0], row.scale[1], row.scale[2], row.scale[3]);
+		const __m128i add = _mm_setr_epi16(
+			row.add[0], row.add[1], row.add[2], row.add[3],
+			row.add[0], row.add[1], row.add[2], row.add[3]);
+		const __m128i zero = _mm_setzero_si128();
+
+		const std::uint32_t* texels = texture.texels.data();
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 index = _mm_add_ps(_mm_set1_ps((float)i), lanes);
+			const __m128 u = _mm_add_ps(startU, _mm_mul_ps(index, stepU));
+			const __m128 v = _mm_add_ps(startV, _mm_mul_ps(index, stepV));
+
+			alignas(16) std::int32_t x[4];
+			alignas(16) std::int32_t y[4];
+			_mm_store_si128((__m128i*)x, WrapTexels(u, width, inverseWidth, maxX));
+			_mm_store_si128((__m128i*)y, WrapTexels(v, height, inverseHeight, maxY));
+
+			const __m128i gathered = _mm_setr_epi32(
+				(int)texels[y[0] * texture.width + x[0]],
+				(int)texels[y[1] * texture.width + x[1]],
+				(int)texels[y[2] * texture.width + x[2]],
+				(int)texels[y[3] * texture.width + x[3]]);
+
+			// Channels are at most 255 and scales at most 256, so the products fit in 16 bits.
+			__m128i low = _mm_unpacklo_epi8(gathered, zero);
+			__m128i high = _mm_unpackhi_epi8(gathered, zero);
+			low = _mm_adds_epu16(_mm_srli_epi16(_mm_mullo_epi16(low, scale), 8), add);
+			high = _mm_adds_epu16(_mm_srli_epi16(_mm_mullo_epi16(high, scale), 8), add);
+
+			_mm_storeu_si128((__m128i*)(pixels + i), _mm_packus_epi16(low, high));
+		}
+	}
+#endif
+
+	// Whatever's left over, or all of it without SSE.
+	CastPixels(pixels, i, count, row, texture);
+}
+
+bool FloorCaster::RowTableKey::operator==(const RowTableKey& other) const
+{
+	return
+		size == other.size &&
+		horizon == other.horizon &&
+		floorEyeHeight == other.floorEyeHeight &&
+		ceilingEyeHeight == other.ceilingEyeHeight &&
+		fogMinDistance == other.fogMinDistance &&
+		fogMaxDistance == other.fogMaxDistance &&
+		fogMaxIntensity == other.fogMaxIntensity;
+}
+
+void FloorCaster::UpdateRowTable(const RowTableKey& key)
+{
+	mRowTableKey = key;
+	mRowTableValid = true;
+
+	const unsigned height = key.size.y;
+	const float targetHeight = (float)height;
+
+	mRowPlane.assign(height, RowPlane::None);
+	mRowDistance.assign(height, 0.0f);
+	mRowFog.assign(height, 0.0f);
+
+	mFirstRow = height;
+	mEndRow = 0;
+
+	const float fogRange = key.fogMaxDistance - key.fogMinDistance;
+
+	for (unsigned y = 0; y < height; ++y)
+	{
+		// From the middle of the row.
+		const float belowHorizon = (float)y + 0.5f - key.horizon;
+
+		// At a distance of 1 metre, a vertical metre is targetHeight pixels, as for the columns.
+		float distance = 0.0f;
+
+		if (belowHorizon > 0.0f && key.floorEyeHeight > 0.0f) {
+			mRowPlane[y] = RowPlane::Floor;
+			distance = targetHeight * key.floorEyeHeight / belowHorizon;
+		}
+		else if (belowHorizon < 0.0f && key.ceilingEyeHeight > 0.0f) {
+			mRowPlane[y] = RowPlane::Ceiling;
+			distance = targetHeight * key.ceilingEyeHeight / -belowHorizon;
+		}
+		else {
+			continue;
+		}
+
+		mRowDistance[y] = distance;
+
+		// Same as the columns get.
+		mRowFog[y] = fogRange > 0.0f ?
+			std::min(
+				(std::min(std::max(distance, key.fogMinDistance), key.fogMaxDistance) - key.fogMinDistance) / fogRange,
+				key.fogMaxIntensity) :
+			key.fogMaxIntensity;
+
+		mFirstRow = std::min(mFirstRow, y);
+		mEndRow = y + 1;
+	}
+
+	if (mFirstRow > mEndRow) {
+		mFirstRow = mEndRow = 0;
+	}
+}
+
+void FloorCaster::Cast(
+	const Camera3D& camera,
+	const Fog& fog,
+	const AmbientLight& ambientLight,
+	const sf::Vector2u size,
+	std::uint32_t* pixels)
+{
+	// Where the floor is relative to the camera, the way ColumnProjection puts the bottoms of
+	// columns on it.
+	const float floorEyeHeight = camera.GetHeight() + 0.5f - camera.GetBaseHeight();
+
+	RowTableKey key;
+	key.size = size;
+	key.horizon = (float)size.y / 2 + (float)GetPitchOffsetInPixels(camera, size.y);
+	key.floorEyeHeight = mFloor.enabled ? floorEyeHeight : 0.0f;
+	key.ceilingEyeHeight = mCeiling.enabled ? mCeiling.height - floorEyeHeight : 0.0f;
+	key.fogMinDistance = fog.GetMinDistance();
+	key.fogMaxDistance = fog.GetMaxDistance();
+	key.fogMaxIntensity = fog.GetMaxIntensity();
+
+	if (!mRowTableValid || !(key == mRowTableKey)) {
+		UpdateRowTable(key);
+	}
+
+	const sf::Color fogColor = fog.GetColor();
+	const sf::Color ambient = ambientLight.mColor;
+
+	// Like the columns' rays: column x goes through forwards + screenX * viewPlane, where
+	// screenX runs from -1 at the left edge of the screen.
+	const b2Vec2 cameraPosition = camera.GetPosition();
+	const b2Vec2 forwards = camera.GetForwards();
+	const float viewPlaneWidthModifier = camera.GetViewPlaneWidthModifier();
+	const b2Vec2 viewPlane(-forwards.y * viewPlaneWidthModifier, forwards.x * viewPlaneWidthModifier);
+	const float screenXDelta = 2.0f / (float)size.x;
+
+	for (unsigned y = mFirstRow; y < mEndRow; ++y)
+	{
+		if (mRowPlane[y] == RowPlane::None) continue;
+
+		const Plane& plane = mRowPlane[y] == RowPlane::Floor ? mFloor : mCeiling;
+
+		const float distance = mRowDistance[y];
+
+		const b2Vec2 start = cameraPosition + distance * (forwards - viewPlane);
+		const b2Vec2 step = (distance * screenXDelta) * viewPlane;
+
+		const float texelsPerMetreU = plane.texels.width / plane.tileSize;
+		const float texelsPerMetreV = plane.texels.height / plane.tileSize;
+
+		// Wrapped here first, so that the row's coordinates stay small enough to be precise.
+		const double startU = (double)start.x * texelsPerMetreU;
+		const double startV = (double)start.y * texelsPerMetreV;
+
+		// Texels per pixel along the row, and from this row to the next, pick the mip level.
+		// Rows get further apart the nearer they are to the horizon.
+		const float metresToNextRow = distance / std::abs((float)y + 0.5f - mRowTableKey.horizon);
+		const float texelsPerPixel = std::max({
+			std::abs(step.x * texelsPerMetreU),
+			std::abs(step.y * texelsPerMetreV),
+			metresToNextRow * std::max(texelsPerMetreU, texelsPerMetreV) });
+
+		const FloorTexture& mip = plane.texels.GetMip(GetMipLevel(texelsPerPixel));
+
+		// The mip's texels are bigger, so there are fewer of them to the metre.
+		const float mipScaleU = (float)mip.width / plane.texels.width;
+		const float mipScaleV = (float)mip.height / plane.texels.height;
+
+		FloorRow row;
+		row.startU = (float)(startU - std::floor(startU / plane.texels.width) * plane.texels.width) * mipScaleU;
+		row.startV = (float)(startV - std::floor(startV / plane.texels.height) * plane.texels.height) * mipScaleV;
+		row.stepU = step.x * texelsPerMetreU * mipScaleU;
+		row.stepV = step.y * texelsPerMetreV * mipScaleV;
+
+		const float fogIntensity = mRowFog[y];
+
+		row.scale[0] = ToScale((ambient.r / 255.0f) * (plane.color.r / 255.0f));
+		row.scale[1] = ToScale((ambient.g / 255.0f) * (plane.color.g / 255.0f));
+		row.scale[2] = ToScale((ambient.b / 255.0f) * (plane.color.b / 255.0f));
+		row.add[0] = ToAdd((fogColor.r / 255.0f) * fogIntensity);
+		row.add[1] = ToAdd((fogColor.g / 255.0f) * fogIntensity);
+		row.add[2] = ToAdd((fogColor.b / 255.0f) * fogIntensity);
+
+		// The planes are always opaque.
+		row.scale[3] = 0;
+		row.add[3] = 255;
+
+		CastFloorRow(pixels + y * size.x, size.x, row, mip);
+	}
+}
+
+void FloorCaster::Render(
+	sf::RenderTarget& target,
+	const Camera3D& camera,
+	const Fog& fog,
+	const AmbientLight& ambientLight)
+{
+	if (!IsEnabled()) return;
+
+	const sf::Vector2u size = target.getSize();
+
+	if (size.x == 0 || size.y == 0) return;
+
+	mPixels.resize(size.x * size.y);
+
+	// This runs on the main thread while the raycast renderer's workers cast rays.
+	Cast(camera, fog, ambientLight, size, mPixels.data());
+
+	if (mFirstRow >= mEndRow) return;
+
+	// Rows in between that neither plane covers (around the horizon) let what's behind show.
+	for (unsigned y = mFirstRow; y < mEndRow; ++y) {
+		if (mRowPlane[y] == RowPlane::None) {
+			std::fill_n(mPixels.data() + y * size.x, size.x, 0u);
+		}
+	}
+
+	if (mTexture.getSize() != size) {
+		if (!mTexture.create(size.x, size.y)) {
+			GetConsoleLogger()->error("FloorCaster: Could not create a {}x{} texture.", size.x, size.y);
+			mFloor.enabled = mCeiling.enabled = false;
+			return;
+		}
+	}
+
+	// Only the rows that are covered get uploaded.
+	const unsigned rowCount = mEndRow - mFirstRow;
+
+	mTexture.update(
+		(const sf::Uint8*)(mPixels.data() + mFirstRow * size.x),
+		size.x,
+		rowCount,
+		0,
+		mFirstRow);
+
+	sf::Sprite sprite(mTexture, sf::IntRect(0, (int)mFirstRow, (int)size.x, (int)rowCount));
+	sprite.setPosition(0.0f, (float)mFirstRow);
+
+	target.draw(sprite);
+}
+
+bool FloorCaster::Plane::LoadTexture(const std::string& filename, TextureLibrary& textureLibrary)
+{
+	auto log = GetConsoleLogger();
+
+	UnloadTexture();
+
+	texture = textureLibrary.LoadTexture(filename);
+
+	if (!texture) {
+		log->error("FloorCaster: Couldn't load texture {}.", filename);
+		return false;
+	}
+
+	textureFilename = filename;
+
+	// The kernel reads texels on the CPU, so they're copied back once, here.
+	const sf::Image image = texture->copyToImage();
+
+	texels.Assign(image.getSize().x, image.getSize().y, image.getPixelsPtr());
+
+	return true;
+}
+
+void FloorCaster::Plane::UnloadTexture()
+{
+	texture.reset();
+	texels = FloorTexture();
+	textureFilename.clear();
+}
+
+nlohmann::json FloorCaster::Plane::ToJson() const
+{
+	nlohmann::json j;
+
+	j["Enabled"] = enabled;
+	j["Height"] = height;
+	j["TileSize"] = tileSize;
+	ColourUtils::SerializeSFColorToJson(color, j["Colour"]);
+
+	if (!textureFilename.empty()) {
+		j["Texture"] = textureFilename;
+	}
+
+	return j;
+}
+
+void FloorCaster::Plane::FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary)
+{
+	enabled = j.value<bool>("Enabled", false);
+	height = std::max(j.value<float>("Height", 1.0f), 0.0f);
+	tileSize = std::max(j.value<float>("TileSize", 1.0f), 0.01f);
+
+	if (j.find("Colour") != j.end()) {
+		ColourUtils::DeserializeSFColorFromJson(color, j["Colour"]);
+	}
+
+	const std::string filename = j.value<std::string>("Texture", "");
+
+	if (filename.empty()) {
+		UnloadTexture();
+	}
+	else {
+		LoadTexture(filename, textureLibrary);
+	}
+}
+
+void FloorCaster::Plane::EditorImGuiControls(const char* label, TextureLibrary& textureLibrary)
+{
+	ImGui::PushID(label);
+
+	ImGui::Checkbox(label, &enabled);
+
+	if (enabled)
+	{
+		ImGui::AutoIndent indent;
+
+		ImGui::SliderFloat("Tile Size", &tileSize, 0.25f, 8.0f);
+
+		ColourUtils::ImGuiColourEditRGB("Colour", color);
+
+		if (texture) {
+			ImGui::Text("Texture: %s", textureFilename.c_str());
+
+			if (ImGui::Button("Remove Texture")) {
+				UnloadTexture();
+			}
+		}
+		else {
+			ImGui::InputText<128>("Texture Filename", textureFilenameInput);
+
+			if (ImGui::Button("Try to Load") && !textureFilenameInput.empty()) {
+				LoadTexture(textureFilenameInput, textureLibrary);
+			}
+		}
+	}
+
+	ImGui::PopID();
+}
+
+nlohmann::json FloorCaster::ToJson() const
+{
+	nlohmann::json j;
+
+	j["Floor"] = mFloor.ToJson();
+	j["Ceiling"] = mCeiling.ToJson();
+
+	return j;
+}
+
+bool FloorCaster::FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary)
+{
+	if (!j.is_object()) {
+		GetConsoleLogger()->error("FloorCaster::FromJson: Expected an object.");
+		return false;
+	}
+
+	if (j.find("Floor") != j.end()) {
+		mFloor.FromJson(j["Floor"], textureLibrary);
+	}
+
+	if (j.find("Ceiling") != j.end()) {
+		mCeiling.FromJson(j["Ceiling"], textureLibrary);
+	}
+
+	return true;
+}
+
+void FloorCaster::EditorImGuiControls(TextureLibrary& textureLibrary)
+{
+	mFloor.EditorImGuiControls("Textured Floor", textureLibrary);
+
+	mCeiling.EditorImGuiControls("Textured Ceiling", textureLibrary);
+
+	if (mCeiling.enabled) {
+		ImGui::AutoIndent indent;
+		ImGui::SliderFloat("Ceiling Height", &mCeiling.height, 0.5f, 8.0f);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <json.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/System/Vector2.hpp>
+
+namespace sf {
+class RenderTarget;
+}
+
+namespace qvr {
+
+class Camera3D;
+class Fog;
+class TextureLibrary;
+struct AmbientLight;
+
+// A copy of a texture for CastFloorRow, which wraps around it in both directions.
+// Starts out as a single white texel.
+struct FloorTexture
+{
+	FloorTexture() { texels.assign(1, 0xffffffffu); }
+
+	unsigned width = 1;
+	unsigned height = 1;
+	// RGBA, 8 bits per channel, in that order in memory.
+	std::vector<std::uint32_t> texels;
+
+	// Smaller and smaller copies, down to 1 by 1, for rows further away. mips[0] is level 1.
+	std::vector<FloorTexture> mips;
+
+	// rowMajorPixels is RGBA, row by row, like sf::Image. Makes the mips too.
+	void Assign(const unsigned width, const unsigned height, const std::uint8_t* rowMajorPixels);
+
+	// Level 0 is the texture itself. Asking for a level past the smallest gets the smallest.
+	const FloorTexture& GetMip(const int level) const;
+};
+
+// One screen row of a flat plane. Everything that's the same all the way along it is worked out
+// before it gets to the kernel.
+struct FloorRow
+{
+	// In texels, under the row's first pixel, and from one pixel to the next.
+	float startU;
+	float startV;
+	float stepU;
+	float stepV;
+
+	// Each channel is (texel * scale) / 256 + add, saturated. Per channel, RGBA.
+	std::uint16_t scale[4];
+	std::uint16_t add[4];
+};
+
+// Fills count pixels (RGBA, like FloorTexture) from the texture, four at a time where SSE is
+// available. Samples the nearest texel.
+void CastFloorRow(std::uint32_t* pixels, const unsigned count, const FloorRow& row, const FloorTexture& texture);
+
+// The same, a pixel at a time. Gives exactly the same results.
+void CastFloorRowScalar(std::uint32_t* pixels, const unsigned count, const FloorRow& row, const FloorTexture& texture);
+
+// An optional textured floor, and ceiling, under and over the raycast columns. Each screen row of
+// a flat plane is all the same distance away, so the distance and fog for each row only get
+// worked out again when the camera's pitch or height, the fog or the target change, and filling
+// a row is a matter of stepping through the texture at a fixed rate, at the mip level that suits
+// the row's distance. Lit by the ambient light
+// and fogged like the columns are.
+class FloorCaster
+{
+public:
+	bool IsEnabled() const { return mFloor.enabled || mCeiling.enabled; }
+	bool HasCeiling() const { return mCeiling.enabled; }
+
+	// Casts the planes into pixels (RGBA, row by row, size.x * size.y). Rows that neither plane
+	// covers are left alone.
+	void Cast(
+		const Camera3D& camera,
+		const Fog& fog,
+		const AmbientLight& ambientLight,
+		const sf::Vector2u size,
+		std::uint32_t* pixels);
+
+	// Casts into a texture of its own, and draws the rows it covers over the target.
+	void Render(
+		sf::RenderTarget& target,
+		const Camera3D& camera,
+		const Fog& fog,
+		const AmbientLight& ambientLight);
+
+	nlohmann::json ToJson() const;
+	bool FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary);
+
+	void EditorImGuiControls(TextureLibrary& textureLibrary);
+
+private:
+	struct Plane
+	{
+		bool enabled = false;
+
+		// Metres from the ground. Only for the ceiling.
+		float height = 1.0f;
+
+		// Metres from one repeat of the texture to the next.
+		float tileSize = 1.0f;
+
+		sf::Color color = sf::Color::White;
+
+		std::shared_ptr<sf::Texture> texture;
+		FloorTexture texels;
+
+		// Serialization-only.
+		std::string textureFilename;
+
+		// WorldEditor-only.
+		std::string textureFilenameInput;
+
+		bool LoadTexture(const std::string& filename, TextureLibrary& textureLibrary);
+		void UnloadTexture();
+
+		nlohmann::json ToJson() const;
+		void FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary);
+
+		void EditorImGuiControls(const char* label, TextureLibrary& textureLibrary);
+	};
+
+	enum class RowPlane : std::uint8_t { None, Floor, Ceiling };
+
+	struct RowTableKey
+	{
+		sf::Vector2u size;
+		float horizon = 0.0f;
+		// How far above the floor, and below the ceiling, the camera is. 0 for planes that are off.
+		float floorEyeHeight = 0.0f;
+		float ceilingEyeHeight = 0.0f;
+		float fogMinDistance = 0.0f;
+		float fogMaxDistance = 0.0f;
+		float fogMaxIntensity = 0.0f;
+
+		bool operator==(const RowTableKey& other) const;
+	};
+
+	void UpdateRowTable(const RowTableKey& key);
+
+	Plane mFloor;
+	Plane mCeiling;
+
+	// Per screen row: which plane covers it, how far away it is along the camera's forward
+	// axis, and how thick the fog is there.
+	RowTableKey mRowTableKey;
+	bool mRowTableValid = false;
+	std::vector<RowPlane> mRowPlane;
+	std::vector<float> mRowDistance;
+	std::vector<float> mRowFog;
+
+	// The rows between these are the only ones that either plane covers.
+	unsigned mFirstRow = 0;
+	unsigned mEndRow = 0;
+
+	std::vector<std::uint32_t> mPixels;
+	sf::Texture mTexture;
+};
+
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <limits>
 #include <json.hpp>
 
 #include <SFML/Graphics/Color.hpp>
@@ -29,6 +30,13 @@ public:
 				GetMaxIntensity());
 	}
 
+	// Distance beyond which the fog hides everything, or infinity if it never does. Fog is
+	// added to what's behind it, so only white fog at full intensity is ever opaque.
+	float GetOpaqueDistance() const {
+		const bool white = color.r == 255 && color.g == 255 && color.b == 255;
+		return white && maxIntensity >= 1.0f ? maxDistance : std::numeric_limits<float>::infinity();
+	}
+
 	void SetColor(const sf::Color newColor) {
 		this->color = sf::Color(newColor.r, newColor.g, newColor.b, 0);
 	}
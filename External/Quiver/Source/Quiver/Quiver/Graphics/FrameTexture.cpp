@@ -13,9 +13,11 @@ void UpdateFrameTexture(
 	unsigned const y = unsigned(windowDimensions.y * ratio);
 
 	if (texture.getSize() != sf::Vector2u(x, y)) {
+		// With a depth buffer, for the raycast renderer's opaque pass.
 		texture.create(
 			unsigned(windowDimensions.x * ratio),
-			unsigned(windowDimensions.y * ratio));
+			unsigned(windowDimensions.y * ratio),
+			true);
 	}
 }
 
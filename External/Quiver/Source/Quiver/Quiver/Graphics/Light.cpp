@@ -71,4 +71,50 @@ void DirectionalLight::GuiControls()
 	ColourUtils::ImGuiColourEditRGB("Colour##DirectionalLight", mColor);
 }
 
+bool PointLight::ToJson(nlohmann::json & j) const
+{
+	j["Radius"] = mRadius;
+	j["Intensity"] = mIntensity;
+
+	return ColourUtils::SerializeSFColorToJson(mColor, j["Colour"]);
+}
+
+bool PointLight::FromJson(const nlohmann::json & j)
+{
+	if (!j.is_object()) {
+		return false;
+	}
+
+	SetRadius(j.value<float>("Radius", 4.0f));
+	SetIntensity(j.value<float>("Intensity", 1.0f));
+
+	if (j.find("Colour") != j.end()) {
+		if (!ColourUtils::DeserializeSFColorFromJson(mColor, j["Colour"])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool PointLight::GuiControls()
+{
+	bool changed = false;
+
+	if (ImGui::SliderFloat("Radius", &mRadius, 0.5f, 16.0f)) {
+		SetRadius(mRadius);
+		changed = true;
+	}
+
+	if (ImGui::SliderFloat("Intensity", &mIntensity, 0.0f, 4.0f)) {
+		SetIntensity(mIntensity);
+		changed = true;
+	}
+
+	const sf::Color oldColor = mColor;
+	ColourUtils::ImGuiColourEditRGB("Colour##PointLight", mColor);
+
+	return changed || mColor != oldColor;
+}
+
 }
\ No newline at end of file
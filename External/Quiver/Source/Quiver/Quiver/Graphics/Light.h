@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+
 #include <Box2D/Common/b2Math.h>
 #include <SFML/Graphics/Color.hpp>
 #include <json.hpp>
@@ -47,4 +49,29 @@ private:
 	sf::Color mColor = sf::Color(64, 64, 64, 0);
 };
 
+// Lights up whatever faces it, out to mRadius, fading away to nothing at the edge. It doesn't
+// say where it is; see PointLightIndex.
+class PointLight {
+public:
+	sf::Color GetColor() const { return mColor; }
+	float GetRadius() const { return mRadius; }
+	// How much of the colour it gives right next to it. Can be more than 1.
+	float GetIntensity() const { return mIntensity; }
+
+	void SetColor(const sf::Color color) { mColor = color; }
+	void SetRadius(const float radius) { mRadius = std::max(radius, 0.0f); }
+	void SetIntensity(const float intensity) { mIntensity = std::max(intensity, 0.0f); }
+
+	bool ToJson(nlohmann::json& j) const;
+	bool FromJson(const nlohmann::json& j);
+
+	// Returns true if anything changed.
+	bool GuiControls();
+
+private:
+	sf::Color mColor = sf::Color(255, 160, 64);
+	float mRadius = 4.0f;
+	float mIntensity = 1.0f;
+};
+
 }
\ No newline at end of file
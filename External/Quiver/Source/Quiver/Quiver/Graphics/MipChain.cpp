@@ -0,0 +1,40 @@
+#include "MipChain.h"
+
+namespace qvr {
+
+void DownsampleMip(
+	const std::uint8_t* pixels,
+	const unsigned width,
+	const unsigned height,
+	std::vector<std::uint8_t>& mip)
+{
+	const unsigned mipWidth = std::max(width / 2, 1u);
+	const unsigned mipHeight = std::max(height / 2, 1u);
+
+	mip.resize(4 * mipWidth * mipHeight);
+
+	// Where a side is only 1 texel long, both samples come from it. An odd one out at the end
+	// of a longer side gets left out.
+	const unsigned stepX = width > 1 ? 1 : 0;
+	const unsigned stepY = height > 1 ? 1 : 0;
+
+	for (unsigned y = 0; y < mipHeight; ++y)
+	{
+		const std::uint8_t* row0 = pixels + 4 * (2 * y * stepY * width);
+		const std::uint8_t* row1 = row0 + 4 * (stepY * width);
+
+		for (unsigned x = 0; x < mipWidth; ++x)
+		{
+			const unsigned x0 = 4 * (2 * x * stepX);
+			const unsigned x1 = x0 + 4 * stepX;
+
+			std::uint8_t* out = &mip[4 * (y * mipWidth + x)];
+
+			for (unsigned c = 0; c < 4; ++c) {
+				out[c] = (std::uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace qvr {
+
+// Mip chains for the CPU side of the renderer, picked the same way the column shader picks
+// them. Each level is half the size of the one above it, rounding down but never below 1
+// texel, as in GL.
+
+// Box-filters an RGBA image (width by height, row by row) down into the next level.
+// Works just as well on images stored column by column, with width and height swapped.
+void DownsampleMip(
+	const std::uint8_t* pixels,
+	const unsigned width,
+	const unsigned height,
+	std::vector<std::uint8_t>& mip);
+
+// The nearest level to sample, given how many texels each screen pixel steps over.
+inline int GetMipLevel(const float texelsPerPixel)
+{
+	return (int)std::floor(std::log2(std::max(texelsPerPixel, 1.0f)) + 0.5f);
+}
+
+// A view is never blurred down to fewer texels from top to bottom than this, or its
+// neighbours on a sprite sheet would bleed into it.
+const float MinMipTexelsPerView = 8.0f;
+
+// How many texels down a column's view each pixel down the screen steps over. That's the
+// same all the way down, and grows with distance, so it's what picks a column's mip level.
+inline float GetColumnTexelsPerPixel(
+	const float vTop,
+	const float vBottom,
+	const float top,
+	const float bottom)
+{
+	const float texels = std::abs(vBottom - vTop);
+	const float pixels = bottom - top;
+
+	if (!(pixels > 0.0f)) return 1.0f;
+
+	return std::min(texels / pixels, std::max(texels / MinMipTexelsPerView, 1.0f));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Quiver/Graphics/ColumnProjection.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUIVER_PARTICLES_SSE 1
+#include <emmintrin.h>
+#else
+#define QUIVER_PARTICLES_SSE 0
+#endif
+
+namespace qvr {
+
+namespace {
+
+// Closer than this, a particle would fill the screen.
+const float NearDistance = 0.05f;
+
+// Far off particles still get a pixel, rather than flickering in and out.
+const float MinHalfSizeInPixels = 0.5f;
+
+}
+
+ParticleSystem::ParticleSystem(const unsigned capacity)
+	: mPositionX(capacity)
+	, mPositionY(capacity)
+	, mHeight(capacity)
+	, mVelocityX(capacity)
+	, mVelocityY(capacity)
+	, mVelocityZ(capacity)
+	, mGravity(capacity)
+	, mAge(capacity)
+	, mLifetime(capacity)
+	, mSize(capacity)
+	, mGrowth(capacity)
+	, mColor(capacity)
+{}
+
+float ParticleSystem::Random(const float spread)
+{
+	if (spread == 0.0f) return 0.0f;
+
+	return std::uniform_real_distribution<float>(-spread, spread)(mRandom);
+}
+
+unsigned ParticleSystem::Emit(const ParticleEmitter& emitter, const unsigned count)
+{
+	const unsigned added = std::min(count, GetCapacity() - mCount);
+
+	mDroppedCount += count - added;
+
+	for (unsigned n = 0; n < added; ++n)
+	{
+		const unsigned i = mCount++;
+
+		mPositionX[i] = emitter.position.x + Random(emitter.positionSpread);
+		mPositionY[i] = emitter.position.y + Random(emitter.positionSpread);
+		mHeight[i] = std::max(emitter.height + Random(emitter.heightSpread), 0.0f);
+		mVelocityX[i] = emitter.velocity.x + Random(emitter.velocitySpread);
+		mVelocityY[i] = emitter.velocity.y + Random(emitter.velocitySpread);
+		mVelocityZ[i] = emitter.verticalVelocity + Random(emitter.verticalVelocitySpread);
+		mGravity[i] = emitter.gravity;
+		mAge[i] = 0.0f;
+		mLifetime[i] = std::max(emitter.lifetime + Random(emitter.lifetimeSpread), 0.0f);
+		mSize[i] = emitter.size;
+		mGrowth[i] = emitter.growth;
+		mColor[i] = emitter.color;
+	}
+
+	return added;
+}
+
+unsigned ParticleSystem::EmitOverTime(
+	const ParticleEmitter& emitter,
+	const float rate,
+	const float deltaTime)
+{
+	const float expected = std::max(rate * deltaTime, 0.0f);
+
+	const unsigned count =
+		(unsigned)(expected + std::uniform_real_distribution<float>(0.0f, 1.0f)(mRandom));
+
+	return Emit(emitter, count);
+}
+
+void ParticleSystem::Update(const float deltaTime)
+{
+	unsigned i = 0;
+
+#if QUIVER_PARTICLES_SSE
+	{
+		const __m128 dt = _mm_set1_ps(deltaTime);
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4 <= mCount; i += 4)
+		{
+			__m128 velocityX = _mm_loadu_ps(&mVelocityX[i]);
+			__m128 velocityY = _mm_loadu_ps(&mVelocityY[i]);
+			__m128 velocityZ = _mm_loadu_ps(&mVelocityZ[i]);
+
+			velocityZ = _mm_sub_ps(velocityZ, _mm_mul_ps(_mm_loadu_ps(&mGravity[i]), dt));
+
+			const __m128 positionX = _mm_add_ps(_mm_loadu_ps(&mPositionX[i]), _mm_mul_ps(velocityX, dt));
+			const __m128 positionY = _mm_add_ps(_mm_loadu_ps(&mPositionY[i]), _mm_mul_ps(velocityY, dt));
+			__m128 height = _mm_add_ps(_mm_loadu_ps(&mHeight[i]), _mm_mul_ps(velocityZ, dt));
+
+			// Anything that hits the floor stays there.
+			const __m128 landed = _mm_cmplt_ps(height, zero);
+			height = _mm_max_ps(height, zero);
+			velocityX = _mm_andnot_ps(landed, velocityX);
+			velocityY = _mm_andnot_ps(landed, velocityY);
+			velocityZ = _mm_andnot_ps(landed, velocityZ);
+
+			const __m128 age = _mm_add_ps(_mm_loadu_ps(&mAge[i]), dt);
+			const __m128 size = _mm_max_ps(
+				_mm_add_ps(_mm_loadu_ps(&mSize[i]), _mm_mul_ps(_mm_loadu_ps(&mGrowth[i]), dt)),
+				zero);
+
+			_mm_storeu_ps(&mPositionX[i], positionX);
+			_mm_storeu_ps(&mPositionY[i], positionY);
+			_mm_storeu_ps(&mHeight[i], height);
+			_mm_storeu_ps(&mVelocityX[i], velocityX);
+			_mm_storeu_ps(&mVelocityY[i], velocityY);
+			_mm_storeu_ps(&mVelocityZ[i], velocityZ);
+			_mm_storeu_ps(&mAge[i], age);
+			_mm_storeu_ps(&mSize[i], size);
+		}
+	}
+#endif
+
+	for (; i < mCount; ++i)
+	{
+		mVelocityZ[i] -= mGravity[i] * deltaTime;
+
+		mPositionX[i] += mVelocityX[i] * deltaTime;
+		mPositionY[i] += mVelocityY[i] * deltaTime;
+		mHeight[i] += mVelocityZ[i] * deltaTime;
+
+		if (mHeight[i] < 0.0f)
+		{
+			mHeight[i] = 0.0f;
+			mVelocityX[i] = 0.0f;
+			mVelocityY[i] = 0.0f;
+			mVelocityZ[i] = 0.0f;
+		}
+
+		mAge[i] += deltaTime;
+		mSize[i] = std::max(mSize[i] + mGrowth[i] * deltaTime, 0.0f);
+	}
+
+	for (unsigned j = 0; j < mCount;)
+	{
+		if (mAge[j] >= mLifetime[j]) {
+			Remove(j);
+		}
+		else {
+			++j;
+		}
+	}
+}
+
+void ParticleSystem::Remove(const unsigned index)
+{
+	const unsigned last = --mCount;
+
+	if (index == last) return;
+
+	mPositionX[index] = mPositionX[last];
+	mPositionY[index] = mPositionY[last];
+	mHeight[index] = mHeight[last];
+	mVelocityX[index] = mVelocityX[last];
+	mVelocityY[index] = mVelocityY[last];
+	mVelocityZ[index] = mVelocityZ[last];
+	mGravity[index] = mGravity[last];
+	mAge[index] = mAge[last];
+	mLifetime[index] = mLifetime[last];
+	mSize[index] = mSize[last];
+	mGrowth[index] = mGrowth[last];
+	mColor[index] = mColor[last];
+}
+
+void ParticleSystem::Clear()
+{
+	mCount = 0;
+}
+
+void ProjectParticles(
+	const ParticleSystem& particles,
+	const ColumnProjection& projection,
+	const b2Vec2& viewPlane,
+	const std::vector<float>& columnDepth,
+	std::vector<ScreenParticle>& screenParticles)
+{
+	screenParticles.resize(0);
+
+	const float viewPlaneLength = viewPlane.Length();
+	const int columnCount = (int)columnDepth.size();
+
+	if (viewPlaneLength <= 0.0f || columnCount == 0) return;
+
+	const float* positionX = particles.GetPositionX();
+	const float* positionY = particles.GetPositionY();
+	const float* height = particles.GetHeight();
+	const float* size = particles.GetSize();
+	const float* age = particles.GetAge();
+	const float* lifetime = particles.GetLifetime();
+	const sf::Color* color = particles.GetColor();
+
+	const b2Vec2 right = (1.0f / viewPlaneLength) * viewPlane;
+
+	const float halfWidth = 0.5f * columnCount;
+	// At a depth of 1: pixels per metre sideways, and per half a unit of height.
+	const float pixelsPerMetre = halfWidth / viewPlaneLength;
+	const float halfTargetHeight = 0.5f * projection.targetHeight;
+
+	// Where each particle lands, four at a time where SSE is available.
+	float depth[4];
+	float centreX[4];
+	float centreY[4];
+	float halfSizeX[4];
+	float halfSizeY[4];
+
+	const auto addVisible = [&](const unsigned first, const unsigned count)
+	{
+		for (unsigned lane = 0; lane < count; ++lane)
+		{
+			const unsigned i = first + lane;
+
+			if (!(depth[lane] >= NearDistance)) continue;
+
+			const float halfX = std::max(halfSizeX[lane], MinHalfSizeInPixels);
+			const float halfY = std::max(halfSizeY[lane], MinHalfSizeInPixels);
+
+			ScreenParticle particle;
+			particle.depth = depth[lane];
+			particle.left = centreX[lane] - halfX;
+			particle.right = centreX[lane] + halfX;
+			particle.top = centreY[lane] - halfY;
+			particle.bottom = centreY[lane] + halfY;
+
+			if (particle.right <= 0.0f || particle.left >= (float)columnCount) continue;
+			if (particle.bottom <= 0.0f || particle.top >= projection.targetHeight) continue;
+
+			// The depth test, at the particle's centre.
+			const int column = std::min(std::max((int)centreX[lane], 0), columnCount - 1);
+
+			if (particle.depth >= columnDepth[column]) continue;
+
+			const float life = lifetime[i] > 0.0f ? 1.0f - age[i] / lifetime[i] : 0.0f;
+			const float alpha = color[i].a * std::min(std::max(life, 0.0f), 1.0f);
+
+			if (alpha < 1.0f) continue;
+
+			particle.color = color[i];
+			particle.color.a = (sf::Uint8)(alpha + 0.5f);
+
+			screenParticles.push_back(particle);
+		}
+	};
+
+	const unsigned count = particles.GetCount();
+
+	unsigned i = 0;
+
+#if QUIVER_PARTICLES_SSE
+	{
+		const __m128 cameraX = _mm_set1_ps(projection.cameraPosition.x);
+		const __m128 cameraY = _mm_set1_ps(projection.cameraPosition.y);
+		const __m128 forwardsX = _mm_set1_ps(projection.cameraForwards.x);
+		const __m128 forwardsY = _mm_set1_ps(projection.cameraForwards.y);
+		const __m128 rightX = _mm_set1_ps(right.x);
+		const __m128 rightY = _mm_set1_ps(right.y);
+		const __m128 screenCentre = _mm_set1_ps(halfWidth);
+		const __m128 horizontalScale = _mm_set1_ps(pixelsPerMetre);
+		const __m128 verticalScale = _mm_set1_ps(halfTargetHeight);
+		const __m128 horizon = _mm_set1_ps(projection.horizon);
+		const __m128 raiseOffset = _mm_set1_ps(projection.cameraHeightOffsetTerm - 1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 relativeX = _mm_sub_ps(_mm_loadu_ps(positionX + i), cameraX);
+			const __m128 relativeY = _mm_sub_ps(_mm_loadu_ps(positionY + i), cameraY);
+
+			const __m128 d = _mm_add_ps(_mm_mul_ps(relativeX, forwardsX), _mm_mul_ps(relativeY, forwardsY));
+			const __m128 lateral = _mm_add_ps(_mm_mul_ps(relativeX, rightX), _mm_mul_ps(relativeY, rightY));
+
+			// Particles behind the camera get thrown out by addVisible, whatever this comes to.
+			const __m128 inverseDepth = _mm_div_ps(one, d);
+			const __m128 horizontalPixels = _mm_mul_ps(horizontalScale, inverseDepth);
+			const __m128 verticalPixels = _mm_mul_ps(verticalScale, inverseDepth);
+
+			const __m128 s = _mm_loadu_ps(size + i);
+			const __m128 raise = _mm_add_ps(_mm_mul_ps(two, _mm_loadu_ps(height + i)), raiseOffset);
+
+			_mm_storeu_ps(depth, d);
+			_mm_storeu_ps(centreX, _mm_add_ps(screenCentre, _mm_mul_ps(lateral, horizontalPixels)));
+			_mm_storeu_ps(centreY, _mm_sub_ps(horizon, _mm_mul_ps(verticalPixels, raise)));
+			_mm_storeu_ps(halfSizeX, _mm_mul_ps(_mm_mul_ps(half, s), horizontalPixels));
+			_mm_storeu_ps(halfSizeY, _mm_mul_ps(s, verticalPixels));
+
+			addVisible(i, 4);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		const b2Vec2 relative(positionX[i] - projection.cameraPosition.x, positionY[i] - projection.cameraPosition.y);
+
+		depth[0] = b2Dot(relative, projection.cameraForwards);
+
+		const float inverseDepth = 1.0f / depth[0];
+		const float horizontalPixels = pixelsPerMetre * inverseDepth;
+		const float verticalPixels = halfTargetHeight * inverseDepth;
+
+		// Same as ColumnProjection::GetTopAndBottom, for a point rather than a line.
+		const float raise = 2.0f * height[i] - 1.0f + projection.cameraHeightOffsetTerm;
+
+		centreX[0] = halfWidth + b2Dot(relative, right) * horizontalPixels;
+		centreY[0] = projection.horizon - verticalPixels * raise;
+		halfSizeX[0] = 0.5f * size[i] * horizontalPixels;
+		halfSizeY[0] = size[i] * verticalPixels;
+
+		addVisible(i, 1);
+	}
+
+	// Back to front, so they blend properly over each other.
+	std::stable_sort(
+		screenParticles.begin(),
+		screenParticles.end(),
+		[](const ScreenParticle& a, const ScreenParticle& b) { return a.depth > b.depth; });
+}
+
+}
\ No newline at end of file
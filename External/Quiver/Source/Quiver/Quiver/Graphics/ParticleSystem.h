@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+#include <SFML/Graphics/Color.hpp>
+
+namespace qvr {
+
+struct ColumnProjection;
+
+// What to emit. Each particle gets these values, plus or minus a random amount of up to the
+// matching spread.
+struct ParticleEmitter
+{
+	b2Vec2 position = b2Vec2_zero;
+	// Above the floor, in the same units as a RenderComponent's height.
+	float height = 0.5f;
+	float positionSpread = 0.0f;
+	float heightSpread = 0.0f;
+
+	// Per second.
+	b2Vec2 velocity = b2Vec2_zero;
+	float verticalVelocity = 0.0f;
+	float velocitySpread = 0.0f;
+	float verticalVelocitySpread = 0.0f;
+
+	// Taken off the vertical velocity every second. Negative for things that rise, like smoke.
+	float gravity = 0.0f;
+
+	// In seconds.
+	float lifetime = 1.0f;
+	float lifetimeSpread = 0.0f;
+
+	// Width and height, in metres, and how much that changes by every second.
+	float size = 0.05f;
+	float growth = 0.0f;
+
+	// Fades out to nothing over the particle's lifetime.
+	sf::Color color = sf::Color::White;
+};
+
+// Short-lived specks for impacts, fire, smoke and the like, far too many and too brief to be
+// Entities. They fly about on their own, without touching the physics world, and land on the
+// floor rather than falling through it.
+//
+// Stored as structure-of-arrays in a pool that's allocated once, so that Update can run over
+// four particles at a time. Particles that don't fit are dropped.
+class ParticleSystem
+{
+public:
+	static constexpr unsigned sm_DefaultCapacity = 32768;
+
+	explicit ParticleSystem(const unsigned capacity = sm_DefaultCapacity);
+
+	// Returns the number of particles that fit.
+	unsigned Emit(const ParticleEmitter& emitter, const unsigned count);
+
+	// Emits rate particles per second, for deltaTime seconds. Rounds up or down at random so
+	// that it averages out to the right rate, however short the time step.
+	unsigned EmitOverTime(const ParticleEmitter& emitter, const float rate, const float deltaTime);
+
+	// Moves and ages the particles, and removes the ones that have had their time.
+	void Update(const float deltaTime);
+
+	void Clear();
+
+	unsigned GetCount() const { return mCount; }
+	unsigned GetCapacity() const { return (unsigned)mPositionX.size(); }
+
+	// Particles that didn't fit, since the system was made.
+	unsigned GetDroppedCount() const { return mDroppedCount; }
+
+	// Packed, from 0 up to GetCount(). Removing a particle moves the last one into its place.
+	const float* GetPositionX() const { return mPositionX.data(); }
+	const float* GetPositionY() const { return mPositionY.data(); }
+	const float* GetHeight() const { return mHeight.data(); }
+	const float* GetVerticalVelocity() const { return mVelocityZ.data(); }
+	const float* GetAge() const { return mAge.data(); }
+	const float* GetLifetime() const { return mLifetime.data(); }
+	const float* GetSize() const { return mSize.data(); }
+	const sf::Color* GetColor() const { return mColor.data(); }
+
+private:
+	void Remove(const unsigned index);
+
+	float Random(const float spread);
+
+	std::vector<float> mPositionX;
+	std::vector<float> mPositionY;
+	std::vector<float> mHeight;
+	std::vector<float> mVelocityX;
+	std::vector<float> mVelocityY;
+	std::vector<float> mVelocityZ;
+	std::vector<float> mGravity;
+	std::vector<float> mAge;
+	std::vector<float> mLifetime;
+	std::vector<float> mSize;
+	std::vector<float> mGrowth;
+	std::vector<sf::Color> mColor;
+
+	unsigned mCount = 0;
+	unsigned mDroppedCount = 0;
+
+	std::minstd_rand mRandom;
+};
+
+// A particle, where it lands on screen.
+struct ScreenParticle
+{
+	// Along the camera's forwards.
+	float depth;
+	// In pixels.
+	float left;
+	float right;
+	float top;
+	float bottom;
+	// Faded with age, but not lit or fogged.
+	sf::Color color;
+};
+
+// Projects the particles that are on screen and in front of the column depth buffer at their
+// centres, and sorts them back to front. columnDepth has one entry for each screen column,
+// giving how far it can see along the camera's forwards. Column x looks along
+// forwards + (-1 + 2x / columnCount) * viewPlane.
+void ProjectParticles(
+	const ParticleSystem& particles,
+	const ColumnProjection& projection,
+	const b2Vec2& viewPlane,
+	const std::vector<float>& columnDepth,
+	std::vector<ScreenParticle>& screenParticles);
+
+}
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "PointLights.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <Box2D/Dynamics/b2Body.h>
+
+namespace qvr {
+
+b2Vec2 PointLightIndex::Entry::GetPosition() const
+{
+	return body ? body->GetPosition() : position;
+}
+
+PointLightId PointLightIndex::AddAttached(const b2Body& body, const PointLight& light)
+{
+	const PointLightId id = Add(body.GetPosition(), light);
+
+	mLights.back().body = &body;
+
+	return id;
+}
+
+PointLightId PointLightIndex::Add(const b2Vec2& position, const PointLight& light)
+{
+	const PointLightId id(mNextId++);
+
+	Entry entry;
+	entry.id = id;
+	entry.light = light;
+	entry.position = position;
+
+	mIndexOfId[id.get()] = (int)mLights.size();
+	mLights.push_back(entry);
+
+	return id;
+}
+
+bool PointLightIndex::Remove(const PointLightId id)
+{
+	const auto it = mIndexOfId.find(id.get());
+
+	if (it == mIndexOfId.end()) return false;
+
+	const int index = it->second;
+
+	mIndexOfId.erase(it);
+
+	if (index != (int)mLights.size() - 1)
+	{
+		mLights[index] = mLights.back();
+		mIndexOfId[mLights[index].id.get()] = index;
+	}
+
+	mLights.pop_back();
+
+	return true;
+}
+
+bool PointLightIndex::SetLight(const PointLightId id, const PointLight& light)
+{
+	Entry* entry = Find(id);
+
+	if (!entry) return false;
+
+	entry->light = light;
+
+	return true;
+}
+
+bool PointLightIndex::SetPosition(const PointLightId id, const b2Vec2& position)
+{
+	Entry* entry = Find(id);
+
+	if (!entry || entry->body) return false;
+
+	entry->position = position;
+
+	return true;
+}
+
+const PointLight* PointLightIndex::GetLight(const PointLightId id) const
+{
+	const auto it = mIndexOfId.find(id.get());
+
+	if (it == mIndexOfId.end()) return nullptr;
+
+	return &mLights[it->second].light;
+}
+
+auto PointLightIndex::Find(const PointLightId id) -> Entry*
+{
+	const auto it = mIndexOfId.find(id.get());
+
+	if (it == mIndexOfId.end()) return nullptr;
+
+	return &mLights[it->second];
+}
+
+void PointLightClusters::Clear()
+{
+	mCandidates.resize(0);
+	mLights.resize(0);
+	mClusterLights.resize(0);
+	mClusterCounts.resize(0);
+	mDroppedCount = 0;
+	mMaxLightsInACluster = 0;
+}
+
+void PointLightClusters::Build(
+	const PointLightIndex& lights,
+	const b2Vec2& cameraPosition,
+	const b2Vec2& cameraForwards,
+	const b2Vec2& viewPlane,
+	const unsigned columnCount,
+	const float maxDistance)
+{
+	Clear();
+
+	const float viewPlaneLength = viewPlane.Length();
+
+	if (columnCount == 0 || lights.GetCount() == 0 || viewPlaneLength <= 0.0f) return;
+
+	const unsigned clusterCount = (columnCount + sm_ClusterWidth - 1) / sm_ClusterWidth;
+
+	mClusterCounts.assign(clusterCount, 0);
+	mClusterLights.resize(clusterCount * sm_MaxLightsPerCluster);
+
+	const b2Vec2 right = (1.0f / viewPlaneLength) * viewPlane;
+	const float columnsPerScreenX = (float)columnCount / 2.0f;
+
+	lights.ForEach([&](const b2Vec2& position, const PointLight& light)
+	{
+		const float radius = light.GetRadius();
+		const float intensity = light.GetIntensity();
+		const sf::Color color = light.GetColor();
+
+		if (radius <= 0.0f || intensity <= 0.0f) return;
+		if (color.r == 0 && color.g == 0 && color.b == 0) return;
+
+		const b2Vec2 relative = position - cameraPosition;
+		const float depth = b2Dot(relative, cameraForwards);
+
+		if (depth + radius <= 0.0f) return;
+		if (depth - radius > maxDistance) return;
+
+		unsigned firstColumn = 0;
+		unsigned lastColumn = columnCount - 1;
+
+		const float nearDepth = depth - radius;
+
+		// With the camera inside the circle, or nearly, it could be anywhere on screen.
+		if (nearDepth > 0.0f)
+		{
+			const float farDepth = depth + radius;
+			const float lateral = b2Dot(relative, right);
+
+			const float minLateral = lateral - radius;
+			const float maxLateral = lateral + radius;
+
+			const float minScreenX = std::min(minLateral / nearDepth, minLateral / farDepth) / viewPlaneLength;
+			const float maxScreenX = std::max(maxLateral / nearDepth, maxLateral / farDepth) / viewPlaneLength;
+
+			if (maxScreenX < -1.0f || minScreenX > 1.0f) return;
+
+			firstColumn = (unsigned)std::max((minScreenX + 1.0f) * columnsPerScreenX, 0.0f);
+			lastColumn = (unsigned)std::min((maxScreenX + 1.0f) * columnsPerScreenX, (float)(columnCount - 1));
+		}
+
+		Candidate candidate;
+		candidate.depth = depth;
+		candidate.firstCluster = firstColumn / sm_ClusterWidth;
+		candidate.lastCluster = std::min(lastColumn / sm_ClusterWidth, clusterCount - 1);
+		candidate.light.position = position;
+		candidate.light.radiusSquared = radius * radius;
+		candidate.light.inverseRadiusSquared = 1.0f / candidate.light.radiusSquared;
+		candidate.light.rgb[0] = intensity * color.r / 255.0f;
+		candidate.light.rgb[1] = intensity * color.g / 255.0f;
+		candidate.light.rgb[2] = intensity * color.b / 255.0f;
+
+		mCandidates.push_back(candidate);
+	});
+
+	// Nearest first, so when a cluster fills up it's the furthest lights that miss out.
+	std::stable_sort(
+		mCandidates.begin(),
+		mCandidates.end(),
+		[](const Candidate& a, const Candidate& b) { return a.depth < b.depth; });
+
+	for (const Candidate& candidate : mCandidates)
+	{
+		if (mLights.size() > std::numeric_limits<unsigned short>::max()) break;
+
+		const unsigned short index = (unsigned short)mLights.size();
+
+		bool added = false;
+
+		for (unsigned cluster = candidate.firstCluster; cluster <= candidate.lastCluster; ++cluster)
+		{
+			unsigned char& count = mClusterCounts[cluster];
+
+			if (count >= sm_MaxLightsPerCluster) {
+				mDroppedCount++;
+				continue;
+			}
+
+			mClusterLights[cluster * sm_MaxLightsPerCluster + count] = index;
+			count++;
+
+			added = true;
+		}
+
+		if (added) {
+			mLights.push_back(candidate.light);
+		}
+	}
+
+	for (const unsigned char count : mClusterCounts) {
+		mMaxLightsInACluster = std::max(mMaxLightsInACluster, (unsigned)count);
+	}
+}
+
+void PointLightClusters::Gather(
+	const unsigned column,
+	const b2Vec2& point,
+	const b2Vec2& normal,
+	float rgb[3]) const
+{
+	const unsigned cluster = column / sm_ClusterWidth;
+
+	if (cluster >= mClusterCounts.size()) return;
+
+	const unsigned short* indices = &mClusterLights[cluster * sm_MaxLightsPerCluster];
+	const unsigned count = mClusterCounts[cluster];
+
+	for (unsigned i = 0; i < count; ++i)
+	{
+		const ClusterLight& light = mLights[indices[i]];
+
+		const b2Vec2 toLight = light.position - point;
+		const float distanceSquared = toLight.LengthSquared();
+
+		if (distanceSquared >= light.radiusSquared) continue;
+
+		// Smooth all the way out to the edge, where it's 0.
+		const float falloff = 1.0f - distanceSquared * light.inverseRadiusSquared;
+
+		// Right on top of the light, there's no telling which way it's facing.
+		const float distance = std::sqrt(distanceSquared);
+		const float facing = distance > 1e-4f ? b2Dot(normal, toLight) / distance : 1.0f;
+
+		if (facing <= 0.0f) continue;
+
+		const float amount = falloff * falloff * facing;
+
+		rgb[0] += light.rgb[0] * amount;
+		rgb[1] += light.rgb[1] * amount;
+		rgb[2] += light.rgb[2] * amount;
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Box2D/Common/b2Math.h>
+#include <named_type.hpp>
+
+#include "Quiver/Graphics/Light.h"
+
+class b2Body;
+
+namespace qvr {
+
+using PointLightId = fluent::NamedType<int, struct PointLightIdTag, fluent::Comparable, fluent::Hashable>;
+
+const PointLightId InvalidPointLightId = PointLightId(0);
+
+// Every PointLight in a World, and where each one is. A light can follow a b2Body around (the
+// body must outlive the light) or be put somewhere and left there.
+class PointLightIndex
+{
+public:
+	PointLightId AddAttached(const b2Body& body, const PointLight& light);
+	PointLightId Add(const b2Vec2& position, const PointLight& light);
+
+	bool Remove(const PointLightId id);
+
+	bool SetLight(const PointLightId id, const PointLight& light);
+
+	// Only for lights that aren't attached to a body.
+	bool SetPosition(const PointLightId id, const b2Vec2& position);
+
+	// nullptr if there's no such light.
+	const PointLight* GetLight(const PointLightId id) const;
+
+	int GetCount() const { return (int)mLights.size(); }
+
+	// Calls func(const b2Vec2& position, const PointLight& light) for every light.
+	template<typename Function>
+	void ForEach(Function func) const;
+
+private:
+	struct Entry
+	{
+		PointLightId id = InvalidPointLightId;
+		PointLight light;
+		// nullptr if the light isn't attached.
+		const b2Body* body = nullptr;
+		b2Vec2 position;
+
+		b2Vec2 GetPosition() const;
+	};
+
+	Entry* Find(const PointLightId id);
+
+	// Kept packed, so that going through them all is quick. Removing a light moves the last
+	// one into its place.
+	std::vector<Entry> mLights;
+
+	std::unordered_map<int, int> mIndexOfId;
+
+	int mNextId = 1;
+};
+
+template<typename Function>
+void PointLightIndex::ForEach(Function func) const
+{
+	for (const Entry& entry : mLights) {
+		func(entry.GetPosition(), entry.light);
+	}
+}
+
+// Sorts the lights that could reach anything on screen into clusters of neighbouring screen
+// columns, so that each column only has to look at the few lights that are near what it sees.
+// A light goes in every cluster its circle of influence might cover. Each cluster keeps at most
+// sm_MaxLightsPerCluster, nearest to the camera first, so the cost per column stays the same
+// however many lights there are.
+//
+// Build copies what it needs out of the lights, so Gather doesn't touch the PointLightIndex
+// and any number of threads can call it at once.
+class PointLightClusters
+{
+public:
+	static constexpr unsigned sm_ClusterWidth = 16;
+	static constexpr unsigned sm_MaxLightsPerCluster = 8;
+
+	// Column x looks along forwards + (-1 + 2x / columnCount) * viewPlane. Lights that are
+	// all further away than maxDistance are left out.
+	void Build(
+		const PointLightIndex& lights,
+		const b2Vec2& cameraPosition,
+		const b2Vec2& cameraForwards,
+		const b2Vec2& viewPlane,
+		const unsigned columnCount,
+		const float maxDistance);
+
+	void Clear();
+
+	bool IsEmpty() const { return mLights.empty(); }
+
+	// Adds the light that reaches a surface at point, facing normal, seen through the given
+	// column, to rgb. From 0 to 1 per channel, but not clamped.
+	void Gather(
+		const unsigned column,
+		const b2Vec2& point,
+		const b2Vec2& normal,
+		float rgb[3]) const;
+
+	// Lights in at least one cluster.
+	unsigned GetVisibleLightCount() const { return (unsigned)mLights.size(); }
+
+	// Times a light didn't make it into a cluster because it was full.
+	unsigned GetDroppedCount() const { return mDroppedCount; }
+
+	unsigned GetMaxLightsInACluster() const { return mMaxLightsInACluster; }
+
+private:
+	struct ClusterLight
+	{
+		b2Vec2 position;
+		float radiusSquared;
+		float inverseRadiusSquared;
+		// Colour times intensity.
+		float rgb[3];
+	};
+
+	struct Candidate
+	{
+		float depth;
+		unsigned firstCluster;
+		unsigned lastCluster;
+		ClusterLight light;
+	};
+
+	std::vector<Candidate> mCandidates;
+
+	std::vector<ClusterLight> mLights;
+
+	// sm_MaxLightsPerCluster slots per cluster, of which the first mClusterCounts are used.
+	std::vector<unsigned short> mClusterLights;
+	std::vector<unsigned char> mClusterCounts;
+
+	unsigned mDroppedCount = 0;
+	unsigned mMaxLightsInACluster = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "RayPacket.h"
+
+#include <cassert>
+
+#include "Quiver/Graphics/RayPacketKernels.h"
+
+#if QUIVER_RAY_PACKET_SSE
+#include <emmintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+namespace qvr {
+
+namespace RayPacketKernels {
+
+unsigned RayCastScalar(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	unsigned mask = 0;
+
+	for (int i = 0; i < packet.size; ++i)
+	{
+		if (packet.maxFraction[i] < 0.0f) continue;
+
+		b2RayCastInput input;
+		input.p1 = packet.origin;
+		input.p2.Set(packet.endX[i], packet.endY[i]);
+		input.maxFraction = packet.maxFraction[i];
+
+		b2RayCastOutput output;
+
+		if (shape.RayCast(&output, input, transform, childIndex))
+		{
+			hits.fraction[i] = output.fraction;
+			hits.normalX[i] = output.normal.x;
+			hits.normalY[i] = output.normal.y;
+
+			mask |= 1u << i;
+		}
+	}
+
+	hits.mask = mask;
+
+	return mask;
+}
+
+#if QUIVER_RAY_PACKET_SSE
+
+struct SSEOps
+{
+	using Float = __m128;
+
+	static const int Width = 4;
+
+	static Float Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, const Float a) { _mm_storeu_ps(p, a); }
+	static Float Set(const float f) { return _mm_set1_ps(f); }
+	static Float Zero() { return _mm_setzero_ps(); }
+
+	static Float Add(const Float a, const Float b) { return _mm_add_ps(a, b); }
+	static Float Sub(const Float a, const Float b) { return _mm_sub_ps(a, b); }
+	static Float Mul(const Float a, const Float b) { return _mm_mul_ps(a, b); }
+	static Float Div(const Float a, const Float b) { return _mm_div_ps(a, b); }
+	static Float Sqrt(const Float a) { return _mm_sqrt_ps(a); }
+	static Float Max(const Float a, const Float b) { return _mm_max_ps(a, b); }
+
+	static Float Less(const Float a, const Float b) { return _mm_cmplt_ps(a, b); }
+	static Float LessEqual(const Float a, const Float b) { return _mm_cmple_ps(a, b); }
+	static Float Equal(const Float a, const Float b) { return _mm_cmpeq_ps(a, b); }
+	static Float NotEqual(const Float a, const Float b) { return _mm_cmpneq_ps(a, b); }
+
+	static Float And(const Float a, const Float b) { return _mm_and_ps(a, b); }
+	static Float AndNot(const Float a, const Float b) { return _mm_andnot_ps(b, a); }
+
+	static Float Select(const Float mask, const Float a, const Float b) {
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	static int MoveMask(const Float a) { return _mm_movemask_ps(a); }
+};
+
+unsigned RayCastSSE(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	return RayCast<SSEOps>(shape, childIndex, transform, packet, hits);
+}
+
+#endif
+
+}
+
+namespace {
+
+bool CPUSupportsAVX()
+{
+#if QUIVER_RAY_PACKET_SSE && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+
+	const bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+	const bool cpuHasAVX = (info[2] & (1 << 28)) != 0;
+
+	if (!osUsesXSave || !cpuHasAVX) return false;
+
+	// The OS also has to save the upper halves of the YMM registers on a context switch.
+	return (_xgetbv(0) & 0x6) == 0x6;
+#elif QUIVER_RAY_PACKET_SSE && defined(__GNUC__)
+	return __builtin_cpu_supports("avx");
+#else
+	return false;
+#endif
+}
+
+RayPacketKernels::KernelFunction GetKernelFunction(const RayPacketKernel kernel)
+{
+	switch (kernel)
+	{
+	case RayPacketKernel::Scalar:
+		return RayPacketKernels::RayCastScalar;
+	case RayPacketKernel::SSE:
+#if QUIVER_RAY_PACKET_SSE
+		return RayPacketKernels::RayCastSSE;
+#else
+		return nullptr;
+#endif
+	case RayPacketKernel::AVX:
+	{
+		static const RayPacketKernels::KernelFunction avx =
+			CPUSupportsAVX() ? RayPacketKernels::GetAVXKernel() : nullptr;
+		return avx;
+	}
+	}
+
+	return nullptr;
+}
+
+}
+
+const char* ToString(const RayPacketKernel kernel)
+{
+	switch (kernel)
+	{
+	case RayPacketKernel::Scalar: return "Scalar";
+	case RayPacketKernel::SSE:    return "SSE";
+	case RayPacketKernel::AVX:    return "AVX";
+	}
+
+	return "Unknown";
+}
+
+RayPacketKernel GetBestRayPacketKernel()
+{
+	if (IsRayPacketKernelSupported(RayPacketKernel::AVX)) return RayPacketKernel::AVX;
+	if (IsRayPacketKernelSupported(RayPacketKernel::SSE)) return RayPacketKernel::SSE;
+	return RayPacketKernel::Scalar;
+}
+
+bool IsRayPacketKernelSupported(const RayPacketKernel kernel)
+{
+	return GetKernelFunction(kernel) != nullptr;
+}
+
+int GetRayPacketWidth(const RayPacketKernel kernel)
+{
+	switch (kernel)
+	{
+	case RayPacketKernel::AVX: return 8;
+	default:                   return 4;
+	}
+}
+
+bool RayCastPacket(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits,
+	const RayPacketKernel kernel)
+{
+	assert(packet.size > 0 && packet.size <= RayPacket::MaxSize);
+
+	RayPacketKernels::KernelFunction function = GetKernelFunction(kernel);
+
+	if (!function) {
+		function = RayPacketKernels::RayCastScalar;
+	}
+
+	return function(shape, childIndex, transform, packet, hits) != 0;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Shape;
+
+namespace qvr {
+
+// A handful of rays that all start at the same point, like the camera rays for neighbouring
+// screen columns. Testing them against a shape together lets most of the work be shared, and
+// the rest can be done for every ray at once with SIMD instructions.
+struct RayPacket
+{
+	static const int MaxSize = 8;
+
+	b2Vec2 origin;
+
+	// Arrays are always MaxSize long so that the kernels can load whole vectors.
+	float32 endX[MaxSize];
+	float32 endY[MaxSize];
+
+	// Same as b2RayCastInput::maxFraction. Negative for rays that are finished.
+	float32 maxFraction[MaxSize];
+
+	int size = 0;
+};
+
+struct RayPacketHits
+{
+	// Bit i is set if ray i hit the shape.
+	unsigned mask = 0;
+
+	float32 fraction[RayPacket::MaxSize];
+	float32 normalX[RayPacket::MaxSize];
+	float32 normalY[RayPacket::MaxSize];
+};
+
+enum class RayPacketKernel
+{
+	// Calls b2Shape::RayCast for each ray in turn.
+	Scalar,
+	// 4 rays at a time.
+	SSE,
+	// 8 rays at a time.
+	AVX
+};
+
+const char* ToString(const RayPacketKernel kernel);
+
+// The widest kernel this build supports on this CPU.
+RayPacketKernel GetBestRayPacketKernel();
+
+bool IsRayPacketKernelSupported(const RayPacketKernel kernel);
+
+// How many rays should go into a packet to keep the kernel busy.
+int GetRayPacketWidth(const RayPacketKernel kernel);
+
+// Circles, polygons, edges and chains get SIMD kernels. Anything else falls back to
+// b2Shape::RayCast. The results match b2Shape::RayCast for each ray, give or take rounding.
+// Returns true if any ray hit.
+bool RayCastPacket(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits,
+	const RayPacketKernel kernel);
+
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+// Anything that gets compiled for AVX in here must not be shared with the rest of the program,
+// or the linker might pick the AVX copy for code that runs on CPUs without it. So Box2D's inline
+// functions are included before AVX code generation is switched on, and the kernels (which are
+// all templates on the Ops struct) after.
+#include "Quiver/Graphics/RayPacket.h"
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#define QUIVER_RAY_PACKET_AVX 1
+
+// MSVC lets us use AVX intrinsics without any special flags.
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx")
+#endif
+
+#include <immintrin.h>
+
+#endif
+
+#include "Quiver/Graphics/RayPacketKernels.h"
+
+namespace qvr {
+namespace RayPacketKernels {
+
+#if QUIVER_RAY_PACKET_AVX
+
+namespace {
+
+struct AVXOps
+{
+	using Float = __m256;
+
+	static const int Width = 8;
+
+	static Float Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, const Float a) { _mm256_storeu_ps(p, a); }
+	static Float Set(const float f) { return _mm256_set1_ps(f); }
+	static Float Zero() { return _mm256_setzero_ps(); }
+
+	static Float Add(const Float a, const Float b) { return _mm256_add_ps(a, b); }
+	static Float Sub(const Float a, const Float b) { return _mm256_sub_ps(a, b); }
+	static Float Mul(const Float a, const Float b) { return _mm256_mul_ps(a, b); }
+	static Float Div(const Float a, const Float b) { return _mm256_div_ps(a, b); }
+	static Float Sqrt(const Float a) { return _mm256_sqrt_ps(a); }
+	static Float Max(const Float a, const Float b) { return _mm256_max_ps(a, b); }
+
+	// Same predicates as the SSE versions: ordered for the comparisons, unordered for !=.
+	static Float Less(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OS); }
+	static Float LessEqual(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OS); }
+	static Float Equal(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static Float NotEqual(const Float a, const Float b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+
+	static Float And(const Float a, const Float b) { return _mm256_and_ps(a, b); }
+	static Float AndNot(const Float a, const Float b) { return _mm256_andnot_ps(b, a); }
+
+	static Float Select(const Float mask, const Float a, const Float b) {
+		return _mm256_blendv_ps(b, a, mask);
+	}
+
+	static int MoveMask(const Float a) { return _mm256_movemask_ps(a); }
+};
+
+unsigned RayCastAVX(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	return RayCast<AVXOps>(shape, childIndex, transform, packet, hits);
+}
+
+}
+
+#endif
+
+}
+}
+
+#if QUIVER_RAY_PACKET_AVX
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+namespace qvr {
+namespace RayPacketKernels {
+
+KernelFunction GetAVXKernel()
+{
+#if QUIVER_RAY_PACKET_AVX
+	return RayCastAVX;
+#else
+	return nullptr;
+#endif
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,345 @@
+#pragma once
+
+// Internal to RayPacket.cpp and RayPacketAVX.cpp.
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#include "Quiver/Graphics/RayPacket.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUIVER_RAY_PACKET_SSE 1
+#else
+#define QUIVER_RAY_PACKET_SSE 0
+#endif
+
+namespace qvr {
+namespace RayPacketKernels {
+
+using KernelFunction = unsigned(*)(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits);
+
+unsigned RayCastScalar(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits);
+
+// Defined in RayPacketAVX.cpp, the only file that generates AVX code.
+// Returns nullptr if this build doesn't have the AVX kernels.
+KernelFunction GetAVXKernel();
+
+// The kernels below are written against an Ops struct that wraps one instruction set:
+//   Float, Width, Load, Store, Set, Zero, Add, Sub, Mul, Div, Sqrt, Max,
+//   Less, LessEqual, Equal, NotEqual, And, AndNot (a & ~b), Select (mask ? a : b), MoveMask.
+// They follow the scalar b2Shape::RayCast code step by step so the results come out the same.
+// All rays in a packet share a start point, so anything that only depends on it is done once.
+
+// Templated on Ops like everything else in here, so that the AVX file gets its own copy.
+template<typename Ops>
+unsigned Finish(const unsigned mask, const RayPacket& packet, RayPacketHits& hits)
+{
+	hits.mask = mask & ((1u << packet.size) - 1);
+	return hits.mask;
+}
+
+template<typename Ops>
+unsigned RayCastCircle(
+	const b2CircleShape& shape,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	using Float = typename Ops::Float;
+
+	const b2Vec2 position = transform.p + b2Mul(transform.q, shape.m_p);
+	const b2Vec2 s = packet.origin - position;
+	const float32 b = b2Dot(s, s) - shape.m_radius * shape.m_radius;
+
+	const Float zero = Ops::Zero();
+	const Float one = Ops::Set(1.0f);
+	const Float epsilon = Ops::Set(b2_epsilon);
+	const Float sx = Ops::Set(s.x);
+	const Float sy = Ops::Set(s.y);
+	const Float bv = Ops::Set(b);
+	const Float originX = Ops::Set(packet.origin.x);
+	const Float originY = Ops::Set(packet.origin.y);
+
+	unsigned mask = 0;
+
+	for (int first = 0; first < packet.size; first += Ops::Width)
+	{
+		const Float rx = Ops::Sub(Ops::Load(packet.endX + first), originX);
+		const Float ry = Ops::Sub(Ops::Load(packet.endY + first), originY);
+		const Float maxFraction = Ops::Load(packet.maxFraction + first);
+
+		const Float c = Ops::Add(Ops::Mul(sx, rx), Ops::Mul(sy, ry));
+		const Float rr = Ops::Add(Ops::Mul(rx, rx), Ops::Mul(ry, ry));
+		const Float sigma = Ops::Sub(Ops::Mul(c, c), Ops::Mul(rr, bv));
+
+		Float a = Ops::Sub(zero, Ops::Add(c, Ops::Sqrt(Ops::Max(sigma, zero))));
+
+		Float hit = Ops::LessEqual(zero, a);
+		hit = Ops::And(hit, Ops::LessEqual(a, Ops::Mul(maxFraction, rr)));
+		hit = Ops::AndNot(hit, Ops::Less(sigma, zero));
+		hit = Ops::AndNot(hit, Ops::Less(rr, epsilon));
+
+		a = Ops::Div(a, rr);
+
+		// b2Vec2::Normalize leaves tiny vectors alone.
+		Float nx = Ops::Add(sx, Ops::Mul(a, rx));
+		Float ny = Ops::Add(sy, Ops::Mul(a, ry));
+		const Float length = Ops::Sqrt(Ops::Add(Ops::Mul(nx, nx), Ops::Mul(ny, ny)));
+		const Float invLength = Ops::Select(Ops::Less(length, epsilon), one, Ops::Div(one, length));
+		nx = Ops::Mul(nx, invLength);
+		ny = Ops::Mul(ny, invLength);
+
+		Ops::Store(hits.fraction + first, a);
+		Ops::Store(hits.normalX + first, nx);
+		Ops::Store(hits.normalY + first, ny);
+
+		mask |= (unsigned)Ops::MoveMask(hit) << first;
+	}
+
+	return Finish<Ops>(mask, packet, hits);
+}
+
+template<typename Ops>
+unsigned RayCastEdge(
+	const b2EdgeShape& shape,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	using Float = typename Ops::Float;
+
+	// Put the rays into the edge's frame of reference.
+	const b2Vec2 p1 = b2MulT(transform.q, packet.origin - transform.p);
+
+	const b2Vec2 v1 = shape.m_vertex1;
+	const b2Vec2 v2 = shape.m_vertex2;
+	const b2Vec2 e = v2 - v1;
+	b2Vec2 normal(e.y, -e.x);
+	normal.Normalize();
+
+	const float32 numerator = b2Dot(normal, v1 - p1);
+
+	const b2Vec2 r = v2 - v1;
+	const float32 rr = b2Dot(r, r);
+
+	if (rr == 0.0f) return Finish<Ops>(0, packet, hits);
+
+	// Which side the rays come from only depends on where they start.
+	const b2Vec2 hitNormal =
+		numerator > 0.0f ?
+		-b2Mul(transform.q, normal) :
+		b2Mul(transform.q, normal);
+
+	const Float zero = Ops::Zero();
+	const Float one = Ops::Set(1.0f);
+	const Float cosine = Ops::Set(transform.q.c);
+	const Float sine = Ops::Set(transform.q.s);
+	const Float negativeSine = Ops::Set(-transform.q.s);
+	const Float translationX = Ops::Set(transform.p.x);
+	const Float translationY = Ops::Set(transform.p.y);
+	const Float p1x = Ops::Set(p1.x);
+	const Float p1y = Ops::Set(p1.y);
+	const Float normalX = Ops::Set(normal.x);
+	const Float normalY = Ops::Set(normal.y);
+	const Float numeratorV = Ops::Set(numerator);
+	const Float v1x = Ops::Set(v1.x);
+	const Float v1y = Ops::Set(v1.y);
+	const Float rx = Ops::Set(r.x);
+	const Float ry = Ops::Set(r.y);
+	const Float rrV = Ops::Set(rr);
+	const Float hitNormalX = Ops::Set(hitNormal.x);
+	const Float hitNormalY = Ops::Set(hitNormal.y);
+
+	unsigned mask = 0;
+
+	for (int first = 0; first < packet.size; first += Ops::Width)
+	{
+		// b2MulT(q, end - p)
+		const Float wx = Ops::Sub(Ops::Load(packet.endX + first), translationX);
+		const Float wy = Ops::Sub(Ops::Load(packet.endY + first), translationY);
+		const Float p2x = Ops::Add(Ops::Mul(cosine, wx), Ops::Mul(sine, wy));
+		const Float p2y = Ops::Add(Ops::Mul(negativeSine, wx), Ops::Mul(cosine, wy));
+		const Float dx = Ops::Sub(p2x, p1x);
+		const Float dy = Ops::Sub(p2y, p1y);
+		const Float maxFraction = Ops::Load(packet.maxFraction + first);
+
+		const Float denominator = Ops::Add(Ops::Mul(normalX, dx), Ops::Mul(normalY, dy));
+		const Float t = Ops::Div(numeratorV, denominator);
+
+		Float hit = Ops::NotEqual(denominator, zero);
+		hit = Ops::AndNot(hit, Ops::Less(t, zero));
+		hit = Ops::AndNot(hit, Ops::Less(maxFraction, t));
+
+		const Float qx = Ops::Add(p1x, Ops::Mul(t, dx));
+		const Float qy = Ops::Add(p1y, Ops::Mul(t, dy));
+
+		const Float s = Ops::Div(
+			Ops::Add(
+				Ops::Mul(Ops::Sub(qx, v1x), rx),
+				Ops::Mul(Ops::Sub(qy, v1y), ry)),
+			rrV);
+
+		hit = Ops::AndNot(hit, Ops::Less(s, zero));
+		hit = Ops::AndNot(hit, Ops::Less(one, s));
+
+		Ops::Store(hits.fraction + first, t);
+		Ops::Store(hits.normalX + first, hitNormalX);
+		Ops::Store(hits.normalY + first, hitNormalY);
+
+		mask |= (unsigned)Ops::MoveMask(hit) << first;
+	}
+
+	return Finish<Ops>(mask, packet, hits);
+}
+
+template<typename Ops>
+unsigned RayCastPolygon(
+	const b2PolygonShape& shape,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	using Float = typename Ops::Float;
+
+	// Put the rays into the polygon's frame of reference.
+	const b2Vec2 p1 = b2MulT(transform.q, packet.origin - transform.p);
+
+	// dot(normal, v - p1) is the same for every ray.
+	float32 numerators[b2_maxPolygonVertices];
+
+	for (int32 i = 0; i < shape.m_count; ++i)
+	{
+		numerators[i] = b2Dot(shape.m_normals[i], shape.m_vertices[i] - p1);
+	}
+
+	const Float zero = Ops::Zero();
+	const Float cosine = Ops::Set(transform.q.c);
+	const Float sine = Ops::Set(transform.q.s);
+	const Float negativeSine = Ops::Set(-transform.q.s);
+	const Float translationX = Ops::Set(transform.p.x);
+	const Float translationY = Ops::Set(transform.p.y);
+	const Float p1x = Ops::Set(p1.x);
+	const Float p1y = Ops::Set(p1.y);
+
+	unsigned mask = 0;
+
+	for (int first = 0; first < packet.size; first += Ops::Width)
+	{
+		const Float wx = Ops::Sub(Ops::Load(packet.endX + first), translationX);
+		const Float wy = Ops::Sub(Ops::Load(packet.endY + first), translationY);
+		const Float p2x = Ops::Add(Ops::Mul(cosine, wx), Ops::Mul(sine, wy));
+		const Float p2y = Ops::Add(Ops::Mul(negativeSine, wx), Ops::Mul(cosine, wy));
+		const Float dx = Ops::Sub(p2x, p1x);
+		const Float dy = Ops::Sub(p2y, p1y);
+
+		const Float maxFraction = Ops::Load(packet.maxFraction + first);
+
+		Float lower = zero;
+		Float upper = maxFraction;
+		Float index = Ops::Set(-1.0f);
+
+		// Rays that are already finished have a negative maxFraction.
+		Float alive = Ops::LessEqual(zero, maxFraction);
+
+		for (int32 i = 0; i < shape.m_count; ++i)
+		{
+			const Float numerator = Ops::Set(numerators[i]);
+			const Float denominator = Ops::Add(
+				Ops::Mul(Ops::Set(shape.m_normals[i].x), dx),
+				Ops::Mul(Ops::Set(shape.m_normals[i].y), dy));
+
+			// Parallel to this face and outside of it.
+			if (numerators[i] < 0.0f)
+			{
+				alive = Ops::AndNot(alive, Ops::Equal(denominator, zero));
+			}
+
+			const Float quotient = Ops::Div(numerator, denominator);
+
+			// The segment enters this half-space.
+			const Float enter = Ops::And(
+				Ops::Less(denominator, zero),
+				Ops::Less(numerator, Ops::Mul(lower, denominator)));
+
+			// The segment exits this half-space.
+			const Float exit = Ops::And(
+				Ops::Less(zero, denominator),
+				Ops::Less(numerator, Ops::Mul(upper, denominator)));
+
+			lower = Ops::Select(enter, quotient, lower);
+			index = Ops::Select(enter, Ops::Set((float)i), index);
+			upper = Ops::Select(exit, quotient, upper);
+
+			alive = Ops::AndNot(alive, Ops::Less(upper, lower));
+
+			if (Ops::MoveMask(alive) == 0) break;
+		}
+
+		const Float hit = Ops::And(alive, Ops::LessEqual(zero, index));
+
+		const unsigned chunkMask = (unsigned)Ops::MoveMask(hit);
+
+		Ops::Store(hits.fraction + first, lower);
+
+		if (chunkMask != 0)
+		{
+			float indices[Ops::Width];
+			Ops::Store(indices, index);
+
+			for (int lane = 0; lane < Ops::Width; ++lane)
+			{
+				if ((chunkMask & (1u << lane)) == 0) continue;
+
+				const b2Vec2 normal = b2Mul(transform.q, shape.m_normals[(int)indices[lane]]);
+				hits.normalX[first + lane] = normal.x;
+				hits.normalY[first + lane] = normal.y;
+			}
+		}
+
+		mask |= chunkMask << first;
+	}
+
+	return Finish<Ops>(mask, packet, hits);
+}
+
+template<typename Ops>
+unsigned RayCast(
+	const b2Shape& shape,
+	const int32 childIndex,
+	const b2Transform& transform,
+	const RayPacket& packet,
+	RayPacketHits& hits)
+{
+	switch (shape.GetType())
+	{
+	case b2Shape::e_circle:
+		return RayCastCircle<Ops>((const b2CircleShape&)shape, transform, packet, hits);
+	case b2Shape::e_edge:
+		return RayCastEdge<Ops>((const b2EdgeShape&)shape, transform, packet, hits);
+	case b2Shape::e_polygon:
+		return RayCastPolygon<Ops>((const b2PolygonShape&)shape, transform, packet, hits);
+	case b2Shape::e_chain:
+	{
+		b2EdgeShape edge;
+		((const b2ChainShape&)shape).GetChildEdge(&edge, childIndex);
+		return RayCastEdge<Ops>(edge, transform, packet, hits);
+	}
+	default:
+		return RayCastScalar(shape, childIndex, transform, packet, hits);
+	}
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,495 @@
+#include "RenderProxyIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <initializer_list>
+
+#include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+
+namespace qvr {
+
+namespace {
+
+// RayCastPacket chops its rays into slices at least this long...
+const float32 MinPacketSliceLength = 1.0f;
+// ...and no more than this many.
+const int MaxPacketSlices = 8;
+
+bool operator==(const b2Transform& a, const b2Transform& b) {
+	return
+		a.p.x == b.p.x && a.p.y == b.p.y &&
+		a.q.s == b.q.s && a.q.c == b.q.c;
+}
+
+bool IsOnStaticBody(const b2Fixture& fixture) {
+	return fixture.GetBody()->GetType() == b2_staticBody;
+}
+
+// Shared by every index, so a generation number never means the same thing in two of them.
+unsigned NewStaticGeneration() {
+	static std::atomic<unsigned> lastGeneration(0);
+	return ++lastGeneration;
+}
+
+}
+
+RenderProxyIndex::RenderProxyIndex()
+	: mStaticGeneration(NewStaticGeneration())
+{}
+
+const b2Shape& RenderProxyIndex::Proxy::GetShape() const
+{
+	return *fixture->GetShape();
+}
+
+RenderProxyId RenderProxyIndex::AddAttached(
+	const b2Fixture& fixture,
+	const FixtureRenderData& renderData)
+{
+	const int id = mNextId++;
+
+	Proxy& proxy = mProxies[id];
+	proxy.renderData = &renderData;
+	proxy.fixture = &fixture;
+	proxy.transform = fixture.GetBody()->GetTransform();
+	proxy.isStatic = IsOnStaticBody(fixture);
+
+	AddToSlots(proxy);
+	CreateTreeProxies(proxy);
+
+	return RenderProxyId(id);
+}
+
+RenderProxyId RenderProxyIndex::AddBillboard(
+	const b2Vec2& position,
+	const float halfWidth,
+	const FixtureRenderData& renderData)
+{
+	const int id = mNextId++;
+
+	Proxy& proxy = mProxies[id];
+	proxy.renderData = &renderData;
+	proxy.transform.Set(position, 0.0f);
+	proxy.billboardHalfWidth = halfWidth;
+
+	// Never in a tree, so it has no children.
+	AddToSlots(proxy);
+
+	return RenderProxyId(id);
+}
+
+bool RenderProxyIndex::Remove(const RenderProxyId id)
+{
+	const auto it = mProxies.find(id.get());
+
+	if (it == mProxies.end()) return false;
+
+	DestroyTreeProxies(it->second);
+	RemoveFromSlots(it->second);
+
+	mProxies.erase(it);
+
+	return true;
+}
+
+bool RenderProxyIndex::SetBillboardPosition(const RenderProxyId id, const b2Vec2& position)
+{
+	Proxy* proxy = GetProxy(id);
+
+	if (!proxy) return false;
+
+	assert(proxy->IsBillboard());
+
+	proxy->transform.p = position;
+
+	return true;
+}
+
+bool RenderProxyIndex::SetBillboardHalfWidth(const RenderProxyId id, const float halfWidth)
+{
+	Proxy* proxy = GetProxy(id);
+
+	if (!proxy) return false;
+
+	assert(proxy->IsBillboard());
+
+	proxy->billboardHalfWidth = halfWidth;
+
+	return true;
+}
+
+void RenderProxyIndex::RenderDataChanged(const RenderProxyId id)
+{
+	const Proxy* proxy = GetProxy(id);
+
+	if (proxy && proxy->isStatic) {
+		StaticProxiesChanged();
+	}
+}
+
+void RenderProxyIndex::Synchronize()
+{
+	for (Proxy* const slot : mSlots)
+	{
+		Proxy& proxy = *slot;
+
+		if (proxy.IsBillboard()) continue;
+
+		const bool isStatic = IsOnStaticBody(*proxy.fixture);
+
+		if (proxy.isStatic != isStatic)
+		{
+			DestroyTreeProxies(proxy);
+			proxy.isStatic = isStatic;
+			proxy.transform = proxy.fixture->GetBody()->GetTransform();
+			CreateTreeProxies(proxy);
+
+			continue;
+		}
+
+		const b2Transform& bodyTransform = proxy.fixture->GetBody()->GetTransform();
+
+		if (!(proxy.transform == bodyTransform)) {
+			MoveTreeProxies(proxy, bodyTransform);
+		}
+	}
+}
+
+RenderProxyIndex::Proxy* RenderProxyIndex::GetProxy(const RenderProxyId id)
+{
+	const auto it = mProxies.find(id.get());
+
+	return it != mProxies.end() ? &it->second : nullptr;
+}
+
+void RenderProxyIndex::CreateTreeProxies(Proxy& proxy)
+{
+	const b2Shape& shape = proxy.GetShape();
+
+	proxy.children.resize(shape.GetChildCount());
+
+	for (int32 childIndex = 0; childIndex < shape.GetChildCount(); ++childIndex)
+	{
+		ChildProxy& child = proxy.children[childIndex];
+
+		b2AABB aabb;
+		shape.ComputeAABB(&aabb, proxy.transform, childIndex);
+
+		child.owner = &proxy;
+		child.childIndex = childIndex;
+		child.treeProxyId = GetTree(proxy).CreateProxy(aabb, &child);
+	}
+
+	if (proxy.isStatic) {
+		StaticProxiesChanged();
+	}
+}
+
+void RenderProxyIndex::DestroyTreeProxies(Proxy& proxy)
+{
+	for (const ChildProxy& child : proxy.children) {
+		GetTree(proxy).DestroyProxy(child.treeProxyId);
+	}
+
+	proxy.children.clear();
+
+	if (proxy.isStatic) {
+		StaticProxiesChanged();
+	}
+}
+
+void RenderProxyIndex::MoveTreeProxies(Proxy& proxy, const b2Transform& newTransform)
+{
+	const b2Shape& shape = proxy.GetShape();
+
+	const b2Vec2 displacement = newTransform.p - proxy.transform.p;
+
+	proxy.transform = newTransform;
+
+	for (const ChildProxy& child : proxy.children)
+	{
+		b2AABB aabb;
+		shape.ComputeAABB(&aabb, newTransform, child.childIndex);
+
+		// Cheap if the proxy is still inside its fattened AABB.
+		GetTree(proxy).MoveProxy(child.treeProxyId, aabb, displacement);
+	}
+
+	if (proxy.isStatic) {
+		StaticProxiesChanged();
+	}
+}
+
+void RenderProxyIndex::StaticProxiesChanged()
+{
+	mStaticGeneration = NewStaticGeneration();
+}
+
+void RenderProxyIndex::AddToSlots(Proxy& proxy)
+{
+	proxy.slot = (int)mSlots.size();
+	mSlots.push_back(&proxy);
+}
+
+void RenderProxyIndex::RemoveFromSlots(Proxy& proxy)
+{
+	Proxy* const last = mSlots.back();
+
+	if (last != &proxy)
+	{
+		last->slot = proxy.slot;
+		mSlots[proxy.slot] = last;
+
+		// Anybody who remembered the static proxy by its slot needs to find out it moved.
+		if (last->isStatic) {
+			StaticProxiesChanged();
+		}
+	}
+
+	mSlots.pop_back();
+	proxy.slot = -1;
+}
+
+// Does the narrow-phase test for b2DynamicTree::RayCast, like b2WorldRayCastWrapper.
+struct RenderProxyIndexRayCastWrapper
+{
+	float32 RayCastCallback(const b2RayCastInput& input, int32 treeProxyId)
+	{
+		using ChildProxy = RenderProxyIndex::ChildProxy;
+
+		const ChildProxy& child = *(const ChildProxy*)(tree->GetUserData(treeProxyId));
+		const RenderProxyIndex::Proxy& proxy = *child.owner;
+
+		b2RayCastOutput output;
+
+		const bool hit = proxy.GetShape().RayCast(
+			&output,
+			input,
+			proxy.transform,
+			child.childIndex);
+
+		if (!hit) return input.maxFraction;
+
+		const float32 fraction = output.fraction;
+		const b2Vec2 point = (1.0f - fraction) * input.p1 + fraction * input.p2;
+
+		const float32 value = callback->ReportProxy(*proxy.renderData, proxy.slot, point, output.normal, fraction);
+
+		// Keep track of where b2DynamicTree::RayCast got to, so the next tree can pick up
+		// from there.
+		if (value == 0.0f) {
+			maxFraction = -1.0f;
+		}
+		else if (value > 0.0f) {
+			maxFraction = value;
+		}
+
+		return value;
+	}
+
+	const b2DynamicTree* tree;
+	RenderProxyRayCastCallback* callback;
+
+	// Negative once the callback has stopped the ray.
+	float32 maxFraction;
+};
+
+void RenderProxyIndex::RayCast(
+	RenderProxyRayCastCallback& callback,
+	const b2Vec2& point1,
+	const b2Vec2& point2,
+	const RenderProxySet set,
+	const float32 maxFraction) const
+{
+	RenderProxyIndexRayCastWrapper wrapper;
+	wrapper.callback = &callback;
+	wrapper.maxFraction = maxFraction;
+
+	for (const b2DynamicTree* tree : { &mStaticTree, &mDynamicTree })
+	{
+		if (set == RenderProxySet::Static && tree != &mStaticTree) continue;
+		if (set == RenderProxySet::Dynamic && tree != &mDynamicTree) continue;
+
+		if (wrapper.maxFraction <= 0.0f) break;
+
+		wrapper.tree = tree;
+
+		b2RayCastInput input;
+		input.maxFraction = wrapper.maxFraction;
+		input.p1 = point1;
+		input.p2 = point2;
+
+		tree->RayCast(&wrapper, input);
+	}
+}
+
+// Does the narrow-phase test for RayCastPacket. The tree is queried with a box around each
+// slice of the packet in turn, so this also has to skip proxies that the previous slice found.
+struct RenderProxyIndexPacketQueryWrapper
+{
+	bool QueryCallback(int32 treeProxyId)
+	{
+		if (hasPreviousBox && b2TestOverlap(tree->GetFatAABB(treeProxyId), previousBox)) {
+			return true;
+		}
+
+		using ChildProxy = RenderProxyIndex::ChildProxy;
+
+		const ChildProxy& child = *(const ChildProxy*)(tree->GetUserData(treeProxyId));
+		const RenderProxyIndex::Proxy& proxy = *child.owner;
+
+		RayPacketHits hits;
+
+		if (!RayCastPacket(proxy.GetShape(), child.childIndex, proxy.transform, *packet, hits, kernel)) {
+			return true;
+		}
+
+		for (int i = 0; i < packet->size; ++i)
+		{
+			if ((hits.mask & (1u << i)) == 0) continue;
+
+			const float32 fraction = hits.fraction[i];
+			const b2Vec2 end(packet->endX[i], packet->endY[i]);
+			const b2Vec2 point = (1.0f - fraction) * packet->origin + fraction * end;
+
+			const float32 value = callbacks[i]->ReportProxy(
+				*proxy.renderData,
+				proxy.slot,
+				point,
+				b2Vec2(hits.normalX[i], hits.normalY[i]),
+				fraction);
+
+			// Same rules as b2DynamicTree::RayCast.
+			if (value == 0.0f) {
+				packet->maxFraction[i] = -1.0f;
+			}
+			else if (value > 0.0f) {
+				packet->maxFraction[i] = value;
+			}
+		}
+
+		// Carry on as long as any ray is still going.
+		return AnyRaysLeft();
+	}
+
+	bool AnyRaysLeft() const {
+		return std::any_of(
+			packet->maxFraction,
+			packet->maxFraction + packet->size,
+			[](const float32 maxFraction) { return maxFraction >= 0.0f; });
+	}
+
+	const b2DynamicTree* tree;
+	RenderProxyRayCastCallback* const* callbacks;
+	RayPacket* packet;
+	RayPacketKernel kernel;
+
+	b2AABB previousBox;
+	bool hasPreviousBox = false;
+};
+
+void RenderProxyIndex::RayCastPacket(
+	RenderProxyRayCastCallback* const callbacks[],
+	const b2Vec2& origin,
+	const b2Vec2 ends[],
+	const int rayCount,
+	const RayPacketKernel kernel,
+	const RenderProxySet set,
+	const float32 maxFractions[]) const
+{
+	assert(rayCount > 0 && rayCount <= RayPacket::MaxSize);
+
+	RayPacket packet;
+	packet.origin = origin;
+	packet.size = rayCount;
+
+	// Lanes past the end copy the last ray so the kernels never see garbage.
+	for (int i = 0; i < RayPacket::MaxSize; ++i)
+	{
+		const b2Vec2& end = ends[std::min(i, rayCount - 1)];
+		packet.endX[i] = end.x;
+		packet.endY[i] = end.y;
+		packet.maxFraction[i] = -1.0f;
+
+		if (i < rayCount)
+		{
+			const float32 maxFraction = maxFractions ? maxFractions[i] : 1.0f;
+
+			if (maxFraction > 0.0f) {
+				packet.maxFraction[i] = maxFraction;
+			}
+		}
+	}
+
+	// The rays fan out from the origin, so one box around all of them could be mostly empty
+	// space (think of a thin fan pointing diagonally). Instead the rays are chopped into slices
+	// along their length, roughly as long as the fan is wide, and the tree is queried with a
+	// box around each slice in turn, nearest first.
+	float32 rayLength = 0.0f;
+	b2AABB endBounds;
+	endBounds.lowerBound = endBounds.upperBound = ends[0];
+
+	for (int i = 0; i < rayCount; ++i)
+	{
+		rayLength = std::max(rayLength, (ends[i] - origin).Length());
+		endBounds.lowerBound = b2Min(endBounds.lowerBound, ends[i]);
+		endBounds.upperBound = b2Max(endBounds.upperBound, ends[i]);
+	}
+
+	const b2Vec2 endSpread = endBounds.upperBound - endBounds.lowerBound;
+	const float32 sliceLength = std::max(std::max(endSpread.x, endSpread.y), MinPacketSliceLength);
+	const int sliceCount = b2Clamp((int)std::ceil(rayLength / sliceLength), 1, MaxPacketSlices);
+
+	RenderProxyIndexPacketQueryWrapper wrapper;
+	wrapper.callbacks = callbacks;
+	wrapper.packet = &packet;
+	wrapper.kernel = kernel;
+
+	for (int slice = 0; slice < sliceCount; ++slice)
+	{
+		const float32 sliceBegin = (float32)slice / sliceCount;
+		const float32 sliceEnd = (float32)(slice + 1) / sliceCount;
+
+		b2AABB box;
+		bool anyRays = false;
+
+		for (int i = 0; i < rayCount; ++i)
+		{
+			// Finished, or clipped short of this slice.
+			if (packet.maxFraction[i] < sliceBegin) continue;
+
+			const b2Vec2 ray = ends[i] - origin;
+			const b2Vec2 near = origin + sliceBegin * ray;
+			const b2Vec2 far = origin + std::min(sliceEnd, packet.maxFraction[i]) * ray;
+
+			if (!anyRays) {
+				box.lowerBound = box.upperBound = near;
+				anyRays = true;
+			}
+
+			box.lowerBound = b2Min(box.lowerBound, b2Min(near, far));
+			box.upperBound = b2Max(box.upperBound, b2Max(near, far));
+		}
+
+		if (!anyRays) break;
+
+		if (set != RenderProxySet::Dynamic) {
+			wrapper.tree = &mStaticTree;
+			mStaticTree.Query(&wrapper, box);
+		}
+
+		if (set != RenderProxySet::Static && wrapper.AnyRaysLeft()) {
+			wrapper.tree = &mDynamicTree;
+			mDynamicTree.Query(&wrapper, box);
+		}
+
+		wrapper.previousBox = box;
+		wrapper.hasPreviousBox = true;
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Box2D/Collision/b2DynamicTree.h>
+#include <Box2D/Common/b2Math.h>
+#include <named_type.hpp>
+
+#include "Quiver/Graphics/RayPacket.h"
+
+class b2Fixture;
+class b2Shape;
+
+namespace qvr {
+
+class FixtureRenderData;
+
+using RenderProxyId = fluent::NamedType<int, struct RenderProxyIdTag, fluent::Comparable, fluent::Hashable>;
+
+const RenderProxyId InvalidRenderProxyId = RenderProxyId(0);
+
+// Static proxies belong to static bodies. Everything else is dynamic. Billboards aren't in either.
+enum class RenderProxySet
+{
+	All,
+	Static,
+	Dynamic
+};
+
+// Same contract as b2RayCastCallback::ReportFixture: return -1 to ignore the proxy, 0 to stop,
+// the fraction to clip the ray, or 1 to carry on.
+// slot is the proxy's slot in the RenderProxyIndex. See RenderProxyIndex::GetRenderData.
+class RenderProxyRayCastCallback
+{
+public:
+	virtual ~RenderProxyRayCastCallback() = default;
+
+	virtual float32 ReportProxy(
+		const FixtureRenderData& renderData,
+		const int slot,
+		const b2Vec2& point,
+		const b2Vec2& normal,
+		float32 fraction) = 0;
+};
+
+// The raycast renderer's own bounding volume hierarchy. It only contains things that can be
+// drawn, so camera rays never have to wade through sensors and other physics-only fixtures.
+//
+// Proxies come in two flavours:
+// - Attached proxies follow a b2Fixture around. The fixture must outlive the proxy.
+// - Billboards are flat sprites that always face the camera. They only exist here, not in the
+//   physics world, and aren't in the trees either: rays never hit them. The renderer projects
+//   them itself, so they never need turning to face the camera.
+//
+// Static and dynamic proxies are kept in separate trees so that either can be ray cast alone.
+class RenderProxyIndex
+{
+public:
+	RenderProxyIndex();
+	~RenderProxyIndex() = default;
+
+	RenderProxyIndex(const RenderProxyIndex&) = delete;
+	RenderProxyIndex(const RenderProxyIndex&&) = delete;
+
+	RenderProxyIndex& operator=(const RenderProxyIndex&) = delete;
+	RenderProxyIndex& operator=(const RenderProxyIndex&&) = delete;
+
+	RenderProxyId AddAttached(const b2Fixture& fixture, const FixtureRenderData& renderData);
+
+	// 2 * halfWidth wide, centred on position.
+	RenderProxyId AddBillboard(
+		const b2Vec2& position,
+		const float halfWidth,
+		const FixtureRenderData& renderData);
+
+	bool Remove(const RenderProxyId id);
+
+	bool SetBillboardPosition(const RenderProxyId id, const b2Vec2& position);
+	bool SetBillboardHalfWidth(const RenderProxyId id, const float halfWidth);
+
+	// Call when something about a proxy's FixtureRenderData changes that affects which other
+	// proxies it hides, like its height or opacity.
+	void RenderDataChanged(const RenderProxyId id);
+
+	// Moves attached proxies whose bodies have moved, or changed type, since the last call.
+	// Must not be called while anybody is ray casting.
+	void Synchronize();
+
+	// Changes whenever a static proxy is added, removed, moved or has its render data change.
+	// Never the same for two different RenderProxyIndexes.
+	unsigned GetStaticGeneration() const { return mStaticGeneration; }
+
+	// Any number of threads can ray cast at once, as long as nothing modifies the index.
+	void RayCast(
+		RenderProxyRayCastCallback& callback,
+		const b2Vec2& point1,
+		const b2Vec2& point2,
+		const RenderProxySet set = RenderProxySet::All,
+		const float32 maxFraction = 1.0f) const;
+
+	// Casts up to RayPacket::MaxSize rays that share a start point, and reports each ray's hits
+	// to its own callback. Hits for a single ray can come in a different order than RayCast's.
+	// maxFractions can be nullptr, which means 1 for every ray.
+	void RayCastPacket(
+		RenderProxyRayCastCallback* const callbacks[],
+		const b2Vec2& origin,
+		const b2Vec2 ends[],
+		const int rayCount,
+		const RayPacketKernel kernel,
+		const RenderProxySet set = RenderProxySet::All,
+		const float32 maxFractions[] = nullptr) const;
+
+	// Calls func(const b2AABB&) with the (fattened) bounding box of every dynamic proxy.
+	template<typename Function>
+	void ForEachDynamicBounds(Function func) const;
+
+	// Calls func(const int slot, const b2Vec2& position, const float halfWidth) for every billboard.
+	template<typename Function>
+	void ForEachBillboard(Function func) const;
+
+	int GetProxyCount() const { return (int)mProxies.size(); }
+
+	// Proxies fill slots 0 to GetProxyCount() - 1. Removing a proxy moves the one in the last
+	// slot into its place, so slots are only good until the index is next modified. A static
+	// proxy changing slot counts as a change to the static proxies.
+	const FixtureRenderData& GetRenderData(const int slot) const { return *mSlots[slot]->renderData; }
+
+private:
+	struct Proxy;
+
+	// One for each child of the shape (only chain shapes have more than one).
+	struct ChildProxy {
+		const Proxy* owner;
+		int32 childIndex;
+		int32 treeProxyId;
+	};
+
+	struct Proxy {
+		const FixtureRenderData* renderData = nullptr;
+
+		// nullptr for billboards.
+		const b2Fixture* fixture = nullptr;
+
+		// For attached proxies, the body transform as of the last Synchronize. For billboards,
+		// just the position.
+		b2Transform transform;
+
+		float billboardHalfWidth = 0.0f;
+
+		// Not resized after creation, so the tree can point into it.
+		std::vector<ChildProxy> children;
+
+		bool isStatic = false;
+
+		int slot = -1;
+
+		bool IsBillboard() const { return fixture == nullptr; }
+
+		// Attached proxies only.
+		const b2Shape& GetShape() const;
+	};
+
+	Proxy* GetProxy(const RenderProxyId id);
+
+	b2DynamicTree& GetTree(const Proxy& proxy) {
+		return proxy.isStatic ? mStaticTree : mDynamicTree;
+	}
+
+	void CreateTreeProxies(Proxy& proxy);
+	void DestroyTreeProxies(Proxy& proxy);
+	void MoveTreeProxies(Proxy& proxy, const b2Transform& newTransform);
+
+	void StaticProxiesChanged();
+
+	void AddToSlots(Proxy& proxy);
+	void RemoveFromSlots(Proxy& proxy);
+
+	b2DynamicTree mStaticTree;
+	b2DynamicTree mDynamicTree;
+
+	unsigned mStaticGeneration;
+
+	// Elements of an unordered_map don't move when it grows.
+	std::unordered_map<int, Proxy> mProxies;
+
+	// The same proxies, packed. Per-frame loops walk this rather than the map's buckets.
+	std::vector<Proxy*> mSlots;
+
+	int mNextId = 1;
+
+	friend struct RenderProxyIndexRayCastWrapper;
+	friend struct RenderProxyIndexPacketQueryWrapper;
+};
+
+template<typename Function>
+void RenderProxyIndex::ForEachDynamicBounds(Function func) const
+{
+	for (const Proxy* const slot : mSlots)
+	{
+		const Proxy& proxy = *slot;
+
+		if (proxy.isStatic) continue;
+
+		for (const ChildProxy& child : proxy.children) {
+			func(mDynamicTree.GetFatAABB(child.treeProxyId));
+		}
+	}
+}
+
+template<typename Function>
+void RenderProxyIndex::ForEachBillboard(Function func) const
+{
+	for (const Proxy* const slot : mSlots)
+	{
+		const Proxy& proxy = *slot;
+
+		if (!proxy.IsBillboard()) continue;
+
+		func(proxy.slot, proxy.transform.p, proxy.billboardHalfWidth);
+	}
+}
+
+}
\ No newline at end of file
@@ -1,23 +1,108 @@
 #pragma once
 
+#include <algorithm>
+
 #include <json.hpp>
 
+#include "Quiver/Graphics/Fog.h"
+
 namespace qvr {
 
 struct RenderSettings
 {
 	float m_RayLength = 50.0f;
 
+	// Stop rays where the World's fog becomes opaque. See Fog::GetOpaqueDistance. Off by
+	// default: walls past that point are drawn as fog-coloured silhouettes over the sky,
+	// which only looks the same without them when the sky is the fog's colour too.
+	bool m_FogCulling = false;
+
+	// Number of threads that cast rays. 0 means 'use every hardware thread'.
+	int m_RaycastThreadCount = 0;
+
+	// Cast neighbouring columns' rays together, with SIMD kernels where the CPU has them.
+	bool m_UseRayPackets = true;
+
+	// Keep what the rays hit of static bodies until the camera or these settings change,
+	// and only cast against moving things where they could be on screen.
+	bool m_IncrementalRaycast = true;
+
+	// Copy textures onto a few big atlas pages, so drawing columns needs fewer texture binds.
+	// The pages have no mips, so this and m_Mipmaps exclude each other for textured columns:
+	// while m_Mipmaps is on, only untextured columns go on the pages. Off by default for that
+	// reason; turn m_Mipmaps off as well to batch textured columns.
+	bool m_UseTextureAtlas = false;
+
+	// Sample far away walls and sprites from smaller copies of their textures, so they don't
+	// shimmer. Costs a texture bind per texture, since they have to stay off the atlas.
+	bool m_Mipmaps = true;
+
+	// Draw runs of neighbouring columns that hit the same flat surface as one quad each.
+	bool m_MergeColumnSpans = true;
+
+	// Draw opaque columns nearest first with the depth test on, so hidden ones don't get shaded,
+	// then paint translucent ones back-to-front over the top. Needs a target with a depth buffer.
+	bool m_OpaqueDepthPass = true;
+
+	// Let the Game change the 3D frame texture's resolution to keep the World's step and
+	// render inside m_TargetFrameTime (in milliseconds).
+	bool m_DynamicResolution = false;
+	float m_TargetFrameTime = 12.0f;
+	// Fractions of the window's size.
+	float m_MinResolutionScale = 0.25f;
+	float m_MaxResolutionScale = 1.0f;
+
+	float ClampResolutionScale(const float scale) const {
+		return std::min(std::max(scale, m_MinResolutionScale), m_MaxResolutionScale);
+	}
+
+	// Length of a ray that leaves the camera at an angle from straight ahead. Fog distance is
+	// measured along the camera's forward axis, so rays towards the edges of the screen have to
+	// go a bit further before the fog hides everything.
+	float GetRayLength(const Fog& fog, const float cosAngleFromForwards = 1.0f) const {
+		if (!m_FogCulling) return m_RayLength;
+		return std::min(m_RayLength, fog.GetOpaqueDistance() / cosAngleFromForwards);
+	}
+
 	RenderSettings() = default;
 
 	RenderSettings(const nlohmann::json& j) noexcept {
 		if (j.is_object()) {
 			m_RayLength = j.value<float>("RayLength", 50.0f);
+			m_FogCulling = j.value<bool>("FogCulling", false);
+			m_RaycastThreadCount = j.value<int>("RaycastThreadCount", 0);
+			m_UseRayPackets = j.value<bool>("UseRayPackets", true);
+			m_IncrementalRaycast = j.value<bool>("IncrementalRaycast", true);
+			m_UseTextureAtlas = j.value<bool>("UseTextureAtlas", false);
+			m_Mipmaps = j.value<bool>("Mipmaps", true);
+			m_MergeColumnSpans = j.value<bool>("MergeColumnSpans", true);
+			m_OpaqueDepthPass = j.value<bool>("OpaqueDepthPass", true);
+			m_DynamicResolution = j.value<bool>("DynamicResolution", false);
+			m_TargetFrameTime = j.value<float>("TargetFrameTime", 12.0f);
+			m_MinResolutionScale = j.value<float>("MinResolutionScale", 0.25f);
+			m_MaxResolutionScale = j.value<float>("MaxResolutionScale", 1.0f);
+
+			m_MinResolutionScale = std::min(std::max(m_MinResolutionScale, 0.05f), 1.0f);
+			m_MaxResolutionScale = std::min(std::max(m_MaxResolutionScale, m_MinResolutionScale), 1.0f);
 		}
 	}
 
 	nlohmann::json ToJson() const {
-		return nlohmann::json{ {"RayLength", m_RayLength} };
+		return nlohmann::json{
+			{"RayLength", m_RayLength},
+			{"FogCulling", m_FogCulling},
+			{"RaycastThreadCount", m_RaycastThreadCount},
+			{"UseRayPackets", m_UseRayPackets},
+			{"IncrementalRaycast", m_IncrementalRaycast},
+			{"UseTextureAtlas", m_UseTextureAtlas},
+			{"Mipmaps", m_Mipmaps},
+			{"MergeColumnSpans", m_MergeColumnSpans},
+			{"OpaqueDepthPass", m_OpaqueDepthPass},
+			{"DynamicResolution", m_DynamicResolution},
+			{"TargetFrameTime", m_TargetFrameTime},
+			{"MinResolutionScale", m_MinResolutionScale},
+			{"MaxResolutionScale", m_MaxResolutionScale}
+		};
 	}
 };
 
@@ -0,0 +1,44 @@
+#include "ShelfPacker.h"
+
+namespace qvr {
+
+ShelfPacker::ShelfPacker(const unsigned width, const unsigned height)
+	: mWidth(width)
+	, mHeight(height)
+{}
+
+bool ShelfPacker::Insert(const unsigned width, const unsigned height, unsigned& x, unsigned& y)
+{
+	if (width > mWidth || height > mHeight) return false;
+
+	Shelf* best = nullptr;
+
+	for (Shelf& shelf : mShelves)
+	{
+		if (shelf.height < height || mWidth - shelf.usedWidth < width) continue;
+
+		if (!best || shelf.height < best->height) {
+			best = &shelf;
+		}
+	}
+
+	if (!best)
+	{
+		const unsigned top = mShelves.empty() ? 0 : mShelves.back().y + mShelves.back().height;
+
+		if (mHeight - top < height) return false;
+
+		mShelves.push_back(Shelf{ top, height, 0 });
+
+		best = &mShelves.back();
+	}
+
+	x = best->usedWidth;
+	y = best->y;
+
+	best->usedWidth += width;
+
+	return true;
+}
+
+}
\ No newline at end of file
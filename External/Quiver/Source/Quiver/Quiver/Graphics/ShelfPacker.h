@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+namespace qvr {
+
+// Packs rectangles into a fixed-size area in rows, or 'shelves'. Each rectangle goes on the
+// shortest shelf it fits on, and a new shelf is only started when none of them will do.
+// Nothing is ever taken out again.
+class ShelfPacker
+{
+public:
+	ShelfPacker() = default;
+	ShelfPacker(const unsigned width, const unsigned height);
+
+	// Returns false if there's no room left for the rectangle.
+	bool Insert(const unsigned width, const unsigned height, unsigned& x, unsigned& y);
+
+	unsigned GetWidth() const { return mWidth; }
+	unsigned GetHeight() const { return mHeight; }
+
+private:
+	struct Shelf {
+		unsigned y;
+		unsigned height;
+		unsigned usedWidth;
+	};
+
+	std::vector<Shelf> mShelves;
+
+	unsigned mWidth = 0;
+	unsigned mHeight = 0;
+};
+
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "Quiver/Graphics/Camera3D.h"
 #include "Quiver/Graphics/ColourUtils.h"
+#include "Quiver/Graphics/TextureLibrary.h"
 #include "Quiver/Misc/ImGuiHelpers.h"
 #include "Quiver/Misc/Logging.h"
 
@@ -25,7 +26,7 @@ bool Sky::ToJson(nlohmann::json & j) const
 	return true;
 }
 
-bool Sky::FromJson(const nlohmann::json & j)
+bool Sky::FromJson(const nlohmann::json & j, TextureLibrary& textureLibrary)
 {
 	auto log = GetConsoleLogger();
 
@@ -33,6 +34,8 @@ bool Sky::FromJson(const nlohmann::json & j)
 
 	mLayers.clear();
 
+	mPanoramaValid = false;
+
 	if (j.find("Layers") != j.end()) {
 		if (!j["Layers"].is_array()) {
 			log->error("{} Layers must be an array.", logContext);
@@ -41,7 +44,7 @@ bool Sky::FromJson(const nlohmann::json & j)
 
 		for (auto layerJson : j["Layers"]) {
 			mLayers.push_back(SkyLayer());
-			if (!mLayers.back().FromJson(layerJson)) {
+			if (!mLayers.back().FromJson(layerJson, textureLibrary)) {
 				mLayers.pop_back();
 			}
 		}
@@ -50,7 +53,7 @@ bool Sky::FromJson(const nlohmann::json & j)
 	return true;
 }
 
-void Sky::EditorImGuiControls()
+void Sky::EditorImGuiControls(TextureLibrary& textureLibrary)
 {
 	auto log = GetConsoleLogger();
 
@@ -87,12 +90,14 @@ void Sky::EditorImGuiControls()
 				if (mSelectedLayerIndex > 0) {
 					std::swap(mLayers[mSelectedLayerIndex - 1], mLayers[mSelectedLayerIndex]);
 					mSelectedLayerIndex--;
+					mPanoramaValid = false;
 				}
 			}
 			if (ImGui::Button("Move Selected Layer Down")) {
 				if (mSelectedLayerIndex < (int)(mLayers.size() - 1)) {
 					std::swap(mLayers[mSelectedLayerIndex + 1], mLayers[mSelectedLayerIndex]);
 					mSelectedLayerIndex++;
+					mPanoramaValid = false;
 				}
 			}
 		}
@@ -118,23 +123,63 @@ void Sky::EditorImGuiControls()
 
 			ImGui::Indent();
 
-			selectedSkyLayer.EditorImGuiControls();
+			if (selectedSkyLayer.EditorImGuiControls(textureLibrary)) {
+				mPanoramaValid = false;
+			}
 
 			ImGui::Unindent();
 		}
 	}
 }
 
-void Sky::Render(sf::RenderTarget & target, const Camera3D & camera) const
+void Sky::Render(sf::RenderTarget & target, const Camera3D & camera)
 {
-	for (auto skyLayer : mLayers) {
-		skyLayer.Render(target, camera);
+	if (mLayers.empty()) return;
+
+	if (!mPanoramaValid) {
+		ComposePanorama();
 	}
+
+	if (mPanorama.getSize().x == 0) return;
+
+	const sf::Vector2f targetSize = sf::Vector2f((float)target.getSize().x, (float)target.getSize().y);
+	const sf::Vector2f panoramaSize = sf::Vector2f((float)mPanorama.getSize().x, (float)mPanorama.getSize().y);
+
+	const float tau = b2_pi * 2.0f;
+
+	const float pitchOffset = (float)GetPitchOffsetInPixels(camera, (int)targetSize.y);
+
+	const float top = pitchOffset;
+	const float bottom = (targetSize.y / 2.0f) + pitchOffset;
+
+	// The panorama goes all the way around, and repeats, so the view is just a window onto it.
+	const float texelsPerRadian = panoramaSize.x / tau;
+	const float centre = fmod(camera.GetRotation() + b2_pi, tau) * texelsPerRadian;
+	const float halfWidth = camera.GetViewPlaneWidthModifier() * texelsPerRadian;
+
+	const float left = centre - halfWidth;
+	const float right = centre + halfWidth;
+
+	sf::Vertex verts[4] =
+	{
+		sf::Vertex(sf::Vector2f(0.0f, top), sf::Vector2f(left, 0.0f)),
+		sf::Vertex(sf::Vector2f(0.0f, bottom), sf::Vector2f(left, panoramaSize.y)),
+
+		sf::Vertex(sf::Vector2f(targetSize.x, bottom), sf::Vector2f(right, panoramaSize.y)),
+		sf::Vertex(sf::Vector2f(targetSize.x, top), sf::Vector2f(right, 0.0f))
+	};
+
+	sf::RenderStates rs;
+	rs.texture = &mPanorama.getTexture();
+	rs.blendMode = sf::BlendMode(sf::BlendMode::One, sf::BlendMode::OneMinusSrcAlpha);
+
+	target.draw(verts, 4, sf::PrimitiveType::Quads, rs);
 }
 
 bool Sky::AddLayer() {
 	mLayers.push_back(SkyLayer());
 	mSelectedLayerIndex = mLayers.size() - 1;
+	mPanoramaValid = false;
 	return true;
 }
 
@@ -144,6 +189,8 @@ bool Sky::RemoveLayer(const int layerIndex) {
 
 	mLayers.erase(mLayers.begin() + layerIndex);
 
+	mPanoramaValid = false;
+
 	// WorldEditor-only:
 	// If the removed element was the last one, the new selection is the 
 	// new last element.
@@ -153,6 +200,81 @@ bool Sky::RemoveLayer(const int layerIndex) {
 	return true;
 }
 
+bool Sky::ComposePanorama()
+{
+	// Even if it fails, so that it doesn't get tried again every frame.
+	mPanoramaValid = true;
+
+	// Wide enough for every layer's texels to get one each, within reason.
+	const unsigned maxSize = std::min(sf::Texture::getMaximumSize(), 8192u);
+
+	unsigned width = 512;
+	unsigned height = 64;
+
+	for (const SkyLayer& layer : mLayers) {
+		width = std::max(width, layer.GetCircumferenceTexels());
+		height = std::max(height, layer.GetTextureHeight());
+	}
+
+	width = std::min(width, maxSize);
+	height = std::min(height, maxSize);
+
+	if (mPanorama.getSize() != sf::Vector2u(width, height))
+	{
+		if (!mPanorama.create(width, height)) {
+			GetConsoleLogger()->error("Sky: Could not create a {}x{} panorama.", width, height);
+			return false;
+		}
+
+		mPanorama.setRepeated(true);
+	}
+
+	// Blending layers over a transparent panorama leaves it premultiplied, which Render
+	// accounts for.
+	mPanorama.clear(sf::Color::Transparent);
+
+	const sf::Vector2f panoramaSize = sf::Vector2f((float)width, (float)height);
+
+	// Layers go in one draw for each run of them that samples their texture the same way.
+	std::vector<sf::Vertex> vertices;
+
+	for (unsigned first = 0; first < mLayers.size();)
+	{
+		sf::Texture* texture = mLayers[first].GetTexture();
+		const bool repeated = mLayers[first].IsTextureRepeated();
+
+		unsigned last = first;
+
+		vertices.clear();
+
+		while (last < mLayers.size() &&
+			mLayers[last].GetTexture() == texture &&
+			mLayers[last].IsTextureRepeated() == repeated)
+		{
+			mLayers[last].Compose(vertices, panoramaSize);
+			last++;
+		}
+
+		sf::RenderStates rs;
+		rs.texture = texture;
+
+		// The texture is shared, so it only repeats (or doesn't) for as long as it's drawn here.
+		const bool wasRepeated = texture ? texture->isRepeated() : false;
+
+		if (texture) texture->setRepeated(repeated);
+
+		mPanorama.draw(vertices.data(), vertices.size(), sf::PrimitiveType::Quads, rs);
+
+		if (texture) texture->setRepeated(wasRepeated);
+
+		first = last;
+	}
+
+	mPanorama.display();
+
+	return true;
+}
+
 namespace Keys {
 static const char* keyForName = "Name";
 static const char* keyForTexture = "Texture";
@@ -176,7 +298,7 @@ bool Sky::SkyLayer::ToJson(nlohmann::json & j) const
 		j[keyForOffsetRadians] = mOffsetRadians;
 	}
 
-	j[keyForTextureIsRepeating] = mTexture.isRepeated();
+	j[keyForTextureIsRepeating] = mTextureIsRepeated;
 
 	ColourUtils::SerializeSFColorToJson(mColour1, j[keyForColours][0]);
 	ColourUtils::SerializeSFColorToJson(mColour2, j[keyForColours][1]);
@@ -184,7 +306,7 @@ bool Sky::SkyLayer::ToJson(nlohmann::json & j) const
 	return true;
 }
 
-bool Sky::SkyLayer::FromJson(const nlohmann::json & j)
+bool Sky::SkyLayer::FromJson(const nlohmann::json & j, TextureLibrary& textureLibrary)
 {
 	using namespace Keys;
 
@@ -228,7 +350,7 @@ bool Sky::SkyLayer::FromJson(const nlohmann::json & j)
 
 	// Not a failure if we can't load the texture file?
 	if (j.find(keyForTexture) != j.end()) {
-		LoadTexture(j[keyForTexture].get<std::string>().c_str());
+		LoadTexture(j[keyForTexture].get<std::string>(), textureLibrary);
 	}
 
 	if (j.find(keyForRepeats) != j.end()) {
@@ -240,7 +362,7 @@ bool Sky::SkyLayer::FromJson(const nlohmann::json & j)
 	}
 
 	if (j.find(keyForTextureIsRepeating) != j.end()) {
-		mTexture.setRepeated(j[keyForTextureIsRepeating].get<bool>());
+		mTextureIsRepeated = j[keyForTextureIsRepeating].get<bool>();
 	}
 
 	if (j.find(keyForColours) != j.end()) {
@@ -253,18 +375,20 @@ bool Sky::SkyLayer::FromJson(const nlohmann::json & j)
 	return true;
 }
 
-bool Sky::SkyLayer::LoadTexture(const char* filename) {
+bool Sky::SkyLayer::LoadTexture(const std::string& filename, TextureLibrary& textureLibrary) {
 	auto log = GetConsoleLogger();
-	
+
 	mTextureName.clear();
-	
-	if (mTexture.loadFromFile(filename)) {
+
+	mTexture = textureLibrary.LoadTexture(filename);
+
+	if (mTexture) {
 		log->info("Loaded texture file '{}'.", filename);
 		mTextureName = filename;
 		return true;
 	}
 
-	log->error("Could not load texture file '{}'", filename);;
+	log->error("Could not load texture file '{}'", filename);
 	return false;
 }
 
@@ -273,8 +397,10 @@ void Sky::SkyLayer::SetTextureRepeats(float numRepeats)
 	mRepeatsPerCircle = std::fmaxf(1, numRepeats);
 }
 
-void Sky::SkyLayer::EditorImGuiControls()
+bool Sky::SkyLayer::EditorImGuiControls(TextureLibrary& textureLibrary)
 {
+	bool changed = false;
+
 	ImGui::InputText<64>("Layer Name", mName);
 
 	{
@@ -284,12 +410,14 @@ void Sky::SkyLayer::EditorImGuiControls()
 			ImGui::Text("Texture Filename : %s", mTextureName.c_str());
 
 			if (ImGui::Button("Unload")) {
-				mTexture = sf::Texture();
+				mTexture.reset();
 				mTextureName.clear();
+				changed = true;
 			}
 
 			if (ImGui::Button("Reload")) {
-				LoadTexture(mTextureName.c_str());
+				LoadTexture(mTextureName, textureLibrary);
+				changed = true;
 			}
 		}
 		else
@@ -298,7 +426,8 @@ void Sky::SkyLayer::EditorImGuiControls()
 			ImGui::InputText("Texture Filename", buffer);
 
 			if (ImGui::Button("Load")) {
-				LoadTexture(buffer);
+				LoadTexture(buffer, textureLibrary);
+				changed = true;
 			}
 		}
 
@@ -306,92 +435,78 @@ void Sky::SkyLayer::EditorImGuiControls()
 			float repeats = mRepeatsPerCircle;
 			if (ImGui::SliderFloat("Num Repeats", &repeats, 1.0f, 30.0f, "%.3f", 1.5f)) {
 				SetTextureRepeats(repeats);
+				changed = true;
 			}
 		}
 
 		{
-			bool textureIsRepeated = mTexture.isRepeated();
-			if (ImGui::Checkbox("Is Repeated", &textureIsRepeated)) {
-				mTexture.setRepeated(textureIsRepeated);
-			}
+			changed |= ImGui::Checkbox("Is Repeated", &mTextureIsRepeated);
 		}
 
-		ImGui::SliderAngle("Offset Degrees", &mOffsetRadians, 0, 360);
+		changed |= ImGui::SliderAngle("Offset Degrees", &mOffsetRadians, 0, 360);
+
+		const sf::Color oldColour1 = mColour1;
+		const sf::Color oldColour2 = mColour2;
 
 		ColourUtils::ImGuiColourEdit("Colour##1", mColour1);
 		ColourUtils::ImGuiColourEdit("Colour##2", mColour2);
+
+		changed |= mColour1 != oldColour1 || mColour2 != oldColour2;
 	}
+
+	return changed;
 }
 
-void Sky::SkyLayer::Render(sf::RenderTarget & target, const Camera3D & camera) const
+unsigned Sky::SkyLayer::GetCircumferenceTexels() const
 {
-	const sf::Vector2f targetSize = sf::Vector2f((float)target.getSize().x, (float)target.getSize().y);
+	const unsigned textureWidth = mTexture ? mTexture->getSize().x : 0;
 
-	const float tau = b2_pi * 2.0f;
+	// Repeated textures have to repeat a whole number of times, or there'd be a seam.
+	if (mTextureIsRepeated) {
+		return textureWidth * std::max(1, (int)mRepeatsPerCircle);
+	}
 
-	const float pitchOffset = (float)GetPitchOffsetInPixels(camera, (int)targetSize.y);
+	return (unsigned)(textureWidth * std::fmax(1.0f, mRepeatsPerCircle));
+}
 
-	const float top = pitchOffset;
-	const float bottom = (targetSize.y / 2.0f) + pitchOffset;
+unsigned Sky::SkyLayer::GetTextureHeight() const
+{
+	return mTexture ? mTexture->getSize().y : 0;
+}
 
-	if (mTexture.isRepeated()) {
-		const float texelsPerCircumference = (mTexture.getSize().x / tau) * std::max(1, (int)mRepeatsPerCircle);
-		const float rotation = camera.GetRotation() + b2_pi;
-		const float angle = fmod(rotation + mOffsetRadians, tau);
-		const float offsetTexels = angle * texelsPerCircumference;
-		const float halfWidthTexels = texelsPerCircumference * camera.GetViewPlaneWidthModifier();
+void Sky::SkyLayer::Compose(std::vector<sf::Vertex>& vertices, const sf::Vector2f panoramaSize) const
+{
+	const float textureHeight = (float)GetTextureHeight();
 
-		const float left = offsetTexels - halfWidthTexels;
-		const float right = offsetTexels + halfWidthTexels;
+	const float tau = b2_pi * 2.0f;
 
-		sf::Vertex verts[4] =
-		{
-			sf::Vertex(sf::Vector2f(0.0f, top), mColour1, sf::Vector2f(left, 0)),
-			sf::Vertex(sf::Vector2f(0.0f, bottom), mColour2, sf::Vector2f(left, (float)mTexture.getSize().y)),
+	const float circumference = (float)GetCircumferenceTexels();
 
-			sf::Vertex(sf::Vector2f(targetSize.x, bottom), mColour2, sf::Vector2f(right, (float)mTexture.getSize().y)),
-			sf::Vertex(sf::Vector2f(targetSize.x, top), mColour1, sf::Vector2f(right, 0.0f))
-		};
+	// Where the texture is at the panorama's left edge.
+	float start = fmod(mOffsetRadians, tau) / tau * circumference;
 
-		sf::RenderStates rs;
-		rs.texture = &mTexture;
+	if (start < 0.0f) {
+		start += circumference;
+	}
 
-		target.draw(verts, 4, sf::PrimitiveType::Quads, rs);
+	auto addQuad = [&](const float left, const float right, const float leftTexels, const float rightTexels)
+	{
+		vertices.emplace_back(sf::Vector2f(left, 0.0f), mColour1, sf::Vector2f(leftTexels, 0.0f));
+		vertices.emplace_back(sf::Vector2f(left, panoramaSize.y), mColour2, sf::Vector2f(leftTexels, textureHeight));
+		vertices.emplace_back(sf::Vector2f(right, panoramaSize.y), mColour2, sf::Vector2f(rightTexels, textureHeight));
+		vertices.emplace_back(sf::Vector2f(right, 0.0f), mColour1, sf::Vector2f(rightTexels, 0.0f));
+	};
+
+	if (mTextureIsRepeated || circumference == 0.0f) {
+		addQuad(0.0f, panoramaSize.x, start, start + circumference);
 	}
 	else {
-		// TODO: At mRepeatsPerCircle == 1, this is broken.
-
-		const float texelsPerCircumference = (mTexture.getSize().x / tau) * std::fmax(1.0f, mRepeatsPerCircle);
-		const float rotation = camera.GetRotation() + b2_pi;
-		const float angle = rotation + mOffsetRadians;
-		const float offsetTexels = fmod(angle * texelsPerCircumference, texelsPerCircumference * tau);
-		const float halfWidthTexels = texelsPerCircumference * camera.GetViewPlaneWidthModifier();
-
-		const float offsetTexelsA = offsetTexels;
-		const float left = offsetTexelsA - halfWidthTexels;
-
-		const float right = fmod(angle * texelsPerCircumference + halfWidthTexels, texelsPerCircumference * tau);
-		const float offsetTexelsB = right - halfWidthTexels;
-
-		sf::Vertex verts[8] =
-		{
-			sf::Vertex(sf::Vector2f(0.0f, top), mColour1, sf::Vector2f(left, 0)),
-			sf::Vertex(sf::Vector2f(0.0f, bottom), mColour2, sf::Vector2f(left, (float)mTexture.getSize().y)),
-
-			sf::Vertex(sf::Vector2f(targetSize.x / 2.0f, bottom), mColour2, sf::Vector2f(offsetTexelsA, (float)mTexture.getSize().y)),
-			sf::Vertex(sf::Vector2f(targetSize.x / 2.0f, top), mColour1, sf::Vector2f(offsetTexelsA, 0)),
-
-			sf::Vertex(sf::Vector2f(targetSize.x / 2.0f, top), mColour1, sf::Vector2f(offsetTexelsB, 0)),
-			sf::Vertex(sf::Vector2f(targetSize.x / 2.0f, bottom), mColour2, sf::Vector2f(offsetTexelsB, (float)mTexture.getSize().y)),
-
-			sf::Vertex(sf::Vector2f(targetSize.x, bottom), mColour2, sf::Vector2f(right, (float)mTexture.getSize().y)),
-			sf::Vertex(sf::Vector2f(targetSize.x, top), mColour1, sf::Vector2f(right, 0.0f))
-		};
-
-		sf::RenderStates rs;
-		rs.texture = &mTexture;
+		// Once around the circle, starting over where it gets back to the start. Past the
+		// texture's right edge, it's clamped.
+		const float split = (circumference - start) / circumference * panoramaSize.x;
 
-		target.draw(verts, 8, sf::PrimitiveType::Quads, rs);
+		addQuad(0.0f, split, start, circumference);
+		addQuad(split, panoramaSize.x, 0.0f, start);
 	}
 }
 
@@ -1,12 +1,18 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include <json.hpp>
 #include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Vertex.hpp>
 
 namespace qvr {
 
 class Camera3D;
+class TextureLibrary;
 
 class Sky {
 public:
@@ -18,11 +24,22 @@ public:
 		}
 
 		bool ToJson(nlohmann::json& j) const;
-		bool FromJson(const nlohmann::json& j);
+		bool FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary);
+
+		// Returns true if anything changed.
+		bool EditorImGuiControls(TextureLibrary& textureLibrary);
+
+		// Adds the quads that cover the panorama with the layer, all the way around the circle.
+		void Compose(std::vector<sf::Vertex>& vertices, const sf::Vector2f panoramaSize) const;
+
+		// How wide the layer is all the way around, in texels. 0 if it has no texture.
+		unsigned GetCircumferenceTexels() const;
+		unsigned GetTextureHeight() const;
 
-		void EditorImGuiControls();
+		// Shared with anything else that loaded the same file. nullptr if the layer has none.
+		sf::Texture* GetTexture() const { return mTexture.get(); }
 
-		void Render(sf::RenderTarget& target, const Camera3D& camera) const;
+		bool IsTextureRepeated() const { return mTextureIsRepeated; }
 
 		// WorldEditor-only.
 		const char* GetName() const {
@@ -35,14 +52,17 @@ public:
 
 	private:
 
-		bool LoadTexture(const char* filename);
+		bool LoadTexture(const std::string& filename, TextureLibrary& textureLibrary);
 
 		void SetTextureRepeats(float numRepeats);
 
 		sf::Color mColour1;
 		sf::Color mColour2;
 
-		sf::Texture mTexture;
+		std::shared_ptr<sf::Texture> mTexture;
+
+		// Layers can't change a shared texture's repeat mode, so they keep their own.
+		bool mTextureIsRepeated = false;
 
 		// WorldEditor-only.
 		std::string mName;
@@ -56,18 +76,25 @@ public:
 	};
 
 	bool ToJson(nlohmann::json& j) const;
-	bool FromJson(const nlohmann::json& j);
+	bool FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary);
 
-	void EditorImGuiControls();
+	void EditorImGuiControls(TextureLibrary& textureLibrary);
 
-	void Render(sf::RenderTarget& target, const Camera3D& camera) const;
+	void Render(sf::RenderTarget& target, const Camera3D& camera);
 
 private:
 	bool AddLayer();
 	bool RemoveLayer(const int layerIndex);
 
+	bool ComposePanorama();
+
 	std::vector<SkyLayer> mLayers;
 
+	// Every layer, composited in order, so that Render is one draw however many layers there
+	// are. Rebuilt when the layers change. Its colours are premultiplied by alpha.
+	sf::RenderTexture mPanorama;
+	bool mPanoramaValid = false;
+
 	// WorldEditor-only stuff:
 
 	int mSelectedLayerIndex = 0;
@@ -0,0 +1,172 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <spdlog/spdlog.h>
+
+namespace qvr {
+
+namespace {
+
+// Copies the image with a one pixel border around it, taken from its own edges.
+sf::Image AddBorder(const sf::Image& image)
+{
+	const sf::Vector2u size = image.getSize();
+
+	sf::Image bordered;
+	bordered.create(size.x + 2, size.y + 2);
+
+	for (unsigned y = 0; y < size.y + 2; ++y)
+	{
+		const unsigned sourceY = std::min(std::max(y, 1u), size.y) - 1;
+
+		for (unsigned x = 0; x < size.x + 2; ++x)
+		{
+			const unsigned sourceX = std::min(std::max(x, 1u), size.x) - 1;
+
+			bordered.setPixel(x, y, image.getPixel(sourceX, sourceY));
+		}
+	}
+
+	return bordered;
+}
+
+}
+
+TextureAtlas::TextureAtlas(const unsigned pageSize, const unsigned maxPageCount)
+	: mPageSize(pageSize)
+	, mMaxPageCount(maxPageCount)
+{}
+
+TextureAtlas::~TextureAtlas() = default;
+
+const TextureAtlas::Placement* TextureAtlas::Find(const sf::Texture* texture) const
+{
+	const auto it = mEntries.find(texture);
+
+	if (it == mEntries.end() || it->second.texture.expired()) return nullptr;
+
+	return &it->second.placement;
+}
+
+const TextureAtlas::Placement* TextureAtlas::Add(const std::shared_ptr<sf::Texture>& texture)
+{
+	if (!texture) return nullptr;
+
+	if (const Placement* existing = Find(texture.get())) return existing;
+
+	const sf::Vector2u size = texture->getSize();
+
+	if (size.x == 0 || size.y == 0) return nullptr;
+
+	Placement placement;
+
+	if (!Allocate(size.x + 2, size.y + 2, placement)) return nullptr;
+
+	const_cast<sf::Texture*>(placement.page)->update(
+		AddBorder(texture->copyToImage()),
+		placement.offsetX,
+		placement.offsetY);
+
+	mVersion++;
+
+	// Step inside the border.
+	placement.offsetX += 1;
+	placement.offsetY += 1;
+
+	// Replaces any entry left behind by a destroyed texture that had the same address.
+	Entry& entry = mEntries[texture.get()];
+	entry.texture = texture;
+	entry.placement = placement;
+
+	return &entry.placement;
+}
+
+const TextureAtlas::Placement* TextureAtlas::GetWhite()
+{
+	if (mWhite.page) return &mWhite;
+
+	Placement placement;
+
+	if (!Allocate(3, 3, placement)) return nullptr;
+
+	sf::Image white;
+	white.create(3, 3, sf::Color::White);
+
+	const_cast<sf::Texture*>(placement.page)->update(white, placement.offsetX, placement.offsetY);
+
+	mVersion++;
+
+	mWhite = placement;
+	mWhite.offsetX += 1;
+	mWhite.offsetY += 1;
+
+	return &mWhite;
+}
+
+bool TextureAtlas::HasExpiredTextures() const
+{
+	return std::any_of(
+		mEntries.begin(),
+		mEntries.end(),
+		[](const std::pair<const sf::Texture* const, Entry>& kvp)
+	{
+		return kvp.second.texture.expired();
+	});
+}
+
+void TextureAtlas::Clear()
+{
+	mEntries.clear();
+	mPages.clear();
+	mWhite = Placement();
+	mVersion++;
+}
+
+bool TextureAtlas::Allocate(const unsigned width, const unsigned height, Placement& placement)
+{
+	const unsigned pageSize = std::min(mPageSize, sf::Texture::getMaximumSize());
+
+	if (width > pageSize || height > pageSize) return false;
+
+	unsigned x, y;
+
+	for (Page& page : mPages)
+	{
+		if (page.packer.Insert(width, height, x, y))
+		{
+			placement.page = page.texture.get();
+			placement.offsetX = (int)x;
+			placement.offsetY = (int)y;
+			return true;
+		}
+	}
+
+	if (mPages.size() >= mMaxPageCount) return false;
+
+	Page page;
+	page.texture = std::make_unique<sf::Texture>();
+	page.packer = ShelfPacker(pageSize, pageSize);
+
+	if (!page.texture->create(pageSize, pageSize))
+	{
+		if (auto log = spdlog::get("console")) {
+			log->error("TextureAtlas: Couldn't create a {0}x{0} page.", pageSize);
+		}
+		return false;
+	}
+
+	page.packer.Insert(width, height, x, y);
+
+	placement.page = page.texture.get();
+	placement.offsetX = (int)x;
+	placement.offsetY = (int)y;
+
+	mPages.push_back(std::move(page));
+
+	return true;
+}
+
+}
\ No newline at end of file
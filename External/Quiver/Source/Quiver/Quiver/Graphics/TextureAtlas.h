@@ -0,0 +1,92 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Quiver/Graphics/ShelfPacker.h"
+
+namespace sf {
+	class Texture;
+}
+
+namespace qvr {
+
+// Copies textures onto a few big pages, so that lots of differently textured things can be
+// drawn with only a handful of texture binds. Textures are assumed not to change once loaded.
+//
+// Each texture gets a one texel border copied from its own edges, so that sampling right on
+// the edge of a texture never picks up its neighbour on the page.
+class TextureAtlas
+{
+public:
+	struct Placement
+	{
+		const sf::Texture* page = nullptr;
+
+		// Add these to texel coordinates in the original texture to get texel coordinates
+		// on the page.
+		int offsetX = 0;
+		int offsetY = 0;
+	};
+
+	// pageSize is capped at the biggest texture the GPU can handle.
+	TextureAtlas(const unsigned pageSize = 2048, const unsigned maxPageCount = 4);
+	~TextureAtlas();
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// nullptr if the texture hasn't been added, or if it has since been destroyed.
+	// Any number of threads can call this at once, as long as nobody is calling anything else.
+	const Placement* Find(const sf::Texture* texture) const;
+
+	// Copies the texture onto a page. Returns nullptr if it's too big for a page, or if there's
+	// no room left on any of them.
+	const Placement* Add(const std::shared_ptr<sf::Texture>& texture);
+
+	// A white texel, with more white all around it, for things that don't have a texture.
+	// offsetX and offsetY are its top-left corner.
+	const Placement* GetWhite();
+
+	// True if some textures that were added have since been destroyed, so a Clear would free
+	// up some room.
+	bool HasExpiredTextures() const;
+
+	void Clear();
+
+	unsigned GetPageSize() const { return mPageSize; }
+	int GetPageCount() const { return (int)mPages.size(); }
+	int GetTextureCount() const { return (int)mEntries.size(); }
+
+	// Changes whenever anything is drawn onto the pages, or they're thrown away, so that
+	// copies of the pages can tell when they're out of date.
+	unsigned GetVersion() const { return mVersion; }
+
+private:
+	struct Page {
+		std::unique_ptr<sf::Texture> texture;
+		ShelfPacker packer;
+	};
+
+	struct Entry {
+		std::weak_ptr<sf::Texture> texture;
+		Placement placement;
+	};
+
+	// Finds room for a width by height rectangle, making a new page if need be.
+	bool Allocate(const unsigned width, const unsigned height, Placement& placement);
+
+	std::vector<Page> mPages;
+
+	std::unordered_map<const sf::Texture*, Entry> mEntries;
+
+	Placement mWhite;
+
+	unsigned mPageSize;
+	unsigned mMaxPageCount;
+
+	unsigned mVersion = 0;
+};
+
+}
\ No newline at end of file
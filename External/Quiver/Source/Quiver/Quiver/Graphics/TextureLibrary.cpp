@@ -58,6 +58,15 @@ std::shared_ptr<sf::Texture> TextureLibrary::LoadTexture(std::string filename)
 			"{}: {} was loaded successfully.",
 			logCtx,
 			filename.c_str());
+
+		// So that far away columns can sample a smaller copy. See the raycast renderer's shader.
+		if (!texture->generateMipmap()) {
+			log->warn(
+				"{}: Couldn't generate mipmaps for {}.",
+				logCtx,
+				filename.c_str());
+		}
+
 		// Keep track of it.
 		mLoadedTextures[filename] = texture;
 		return texture;
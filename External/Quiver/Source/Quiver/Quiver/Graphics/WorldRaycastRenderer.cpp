@@ -1,24 +1,47 @@
 #include "WorldRaycastRenderer.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
 #include <vector>
 
 #include <SFML/OpenGL.hpp>
 #include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Shader.hpp>
 #include <SFML/System/Vector2.hpp>
 
 #include <Box2D/Common/b2Math.h>
-#include <Box2D/Dynamics/b2Fixture.h>
-#include <Box2D/Dynamics/b2World.h>
-#include <Box2D/Dynamics/b2WorldCallbacks.h>
+#include <ImGui/imgui.h>
 
 #include <spdlog/spdlog.h>
 
 #include "Quiver/Graphics/Camera3D.h"
+#include "Quiver/Graphics/ColumnDepthSort.h"
+#include "Quiver/Graphics/ColumnProjection.h"
+#include "Quiver/Graphics/ColumnRasterizer.h"
+#include "Quiver/Graphics/ColumnSpans.h"
 #include "Quiver/Graphics/FixtureRenderData.h"
+#include "Quiver/Graphics/Fog.h"
+#include "Quiver/Graphics/Light.h"
+#include "Quiver/Graphics/MipChain.h"
+#include "Quiver/Graphics/ParticleSystem.h"
+#include "Quiver/Graphics/PointLights.h"
+#include "Quiver/Graphics/RayPacket.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
 #include "Quiver/Graphics/RenderSettings.h"
+#include "Quiver/Graphics/TextureAtlas.h"
+#include "Quiver/Misc/Profiler.h"
+#include "Quiver/Misc/WorkerPool.h"
+#include "Quiver/World/SectorGraph.h"
+#include "Quiver/World/TileMap.h"
 #include "Quiver/World/World.h"
 
 namespace {
@@ -126,364 +149,2144 @@ inline sf::Vector2f B2VecToSFVec(const b2Vec2& b2vec) {
 	return sf::Vector2f(b2vec.x, b2vec.y);
 }
 
+// Light gets clamped to 1; it can only bring out what's in the colour and texture.
+inline sf::Uint8 LightChannel(const sf::Uint8 channel, const float light) {
+	return (sf::Uint8)(channel * std::min(light, 1.0f) + 0.5f);
+}
+
 }
 
 namespace qvr {
 
+Profiler sRaycastProfiler(512);
+
 class WorldRaycastRendererImpl {
-	class RaycastCallback : public b2RayCastCallback
+	// What a frame needs to know about a render proxy, copied out of its FixtureRenderData
+	// once per frame so that the workers aren't chasing pointers all over the heap.
+	struct ProxySnapshot
+	{
+		b2Vec2 m_SpritePosition;
+		float m_Height;
+		float m_GroundOffset;
+		float m_SpriteRadius;
+		bool m_Opaque;
+		sf::Color m_Color;
+		// An atlas page, if the texture is on one.
+		const sf::Texture* m_Texture;
+		// Already picked for where the camera is, and moved onto the atlas page.
+		Animation::Rect m_View;
+	};
+
+	class RaycastCallback : public RenderProxyRayCastCallback
 	{
 	public:
 		struct RayIntersection
 		{
-			b2Fixture* m_fixture;
+			// Slot in FrameSetup::m_Proxies. See FrameSetup::GetRenderData.
+			int m_Proxy;
 			b2Vec2 m_point;
 			b2Vec2 m_normal;
 			float32 m_fraction;
 			int m_screenX;
 		};
 
-		float32 ReportFixture(
-			b2Fixture* fixture,
-			const b2Vec2& point,
-			const b2Vec2& normal,
-			float32 fraction)
-			override;
+		float32 ReportProxy(
+			const FixtureRenderData& renderData,
+			const int slot,
+			const b2Vec2& point,
+			const b2Vec2& normal,
+			float32 fraction)
+			override;
+
+		// Throws away intersections behind the nearest occluder found so far.
+		void RemoveOccluded();
+
+		// Copy the column's current state to and from the static cache.
+		void SaveStatic();
+		void RestoreStatic();
+
+		static const unsigned sm_MaxNumIntersections = 32;
+
+		std::array<RayIntersection, sm_MaxNumIntersections> m_Intersections;
+
+		unsigned m_IntersectionCount = 0;
+		unsigned m_Index = 0;
+
+		// After any fog culling.
+		float m_RayLength = 0.0f;
+
+		// The ray stops at the first occluder: an opaque fixture that hides everything behind it.
+		float32 m_MaxFraction = 1.0f;
+
+		// Where the World's sectors cut the ray short, if they did. 1 if not.
+		float32 m_SectorFraction = 1.0f;
+
+		const ColumnProjection* m_Projection = nullptr;
+		const ProxySnapshot* m_Proxies = nullptr;
+		// See FrameSetup::m_TileSlotBase.
+		int m_TileSlotBase = 0;
+
+		// What this column hit when only static proxies were cast. See StaticCacheKey.
+		// Tile hits are kept as -1 - their tile type, since the tile slots move along whenever
+		// a dynamic proxy is added or removed, and that doesn't invalidate the cache.
+		std::array<RayIntersection, sm_MaxNumIntersections> m_StaticIntersections;
+		unsigned m_StaticIntersectionCount = 0;
+		float32 m_StaticMaxFraction = 1.0f;
+		float32 m_StaticSectorFraction = 1.0f;
+	};
+
+	std::vector<RaycastCallback> m_RaycastCallbacks;
+
+	// Static proxies' hits only need casting again if something in here changes.
+	struct StaticCacheKey
+	{
+		const RenderProxyIndex* m_RenderProxies;
+		unsigned m_StaticGeneration;
+		const TileMap* m_TileMap;
+		unsigned m_TileMapGeneration;
+		unsigned m_SectorGeneration;
+		b2Vec2 m_CameraPosition;
+		b2Vec2 m_CameraForwards;
+		float m_ViewPlaneWidthModifier;
+		float m_CameraHeightOffset;
+		float m_CameraPitchOffset;
+		unsigned m_TargetWidth;
+		unsigned m_TargetHeight;
+		// After fog culling.
+		float m_RayLength;
+
+		bool operator==(const StaticCacheKey& other) const {
+			return
+				m_RenderProxies == other.m_RenderProxies &&
+				m_StaticGeneration == other.m_StaticGeneration &&
+				m_TileMap == other.m_TileMap &&
+				m_TileMapGeneration == other.m_TileMapGeneration &&
+				m_SectorGeneration == other.m_SectorGeneration &&
+				m_CameraPosition.x == other.m_CameraPosition.x &&
+				m_CameraPosition.y == other.m_CameraPosition.y &&
+				m_CameraForwards.x == other.m_CameraForwards.x &&
+				m_CameraForwards.y == other.m_CameraForwards.y &&
+				m_ViewPlaneWidthModifier == other.m_ViewPlaneWidthModifier &&
+				m_CameraHeightOffset == other.m_CameraHeightOffset &&
+				m_CameraPitchOffset == other.m_CameraPitchOffset &&
+				m_TargetWidth == other.m_TargetWidth &&
+				m_TargetHeight == other.m_TargetHeight &&
+				m_RayLength == other.m_RayLength;
+		}
+	};
+
+	StaticCacheKey m_StaticCacheKey;
+	bool m_StaticCacheValid = false;
+
+	// Greater than zero for columns whose rays might hit a dynamic proxy.
+	std::vector<int> m_DynamicColumns;
+
+	// The raycast pass's depth buffer: how far each column can see along the camera's forwards
+	// before something hides everything behind it, or its ray runs out.
+	std::vector<float> m_ColumnDepth;
+
+	// Billboards closer than this get left out, rather than filling the screen.
+	static constexpr float sm_BillboardNearDistance = 0.01f;
+
+	// How far rays go past where the sectors stop them, so that walls standing on a sector's
+	// edge still get hit.
+	static constexpr float sm_SectorMargin = 0.05f;
+
+	// Fills in m_DynamicColumns, and returns the number of columns that need casting.
+	unsigned FindDynamicColumns(
+		const RenderProxyIndex& renderProxies,
+		const b2Vec2& cameraPosition,
+		const b2Vec2& cameraForwards,
+		const b2Vec2& viewPlane,
+		const float maxDistance);
+
+	// One chunk's worth of columns, as structure-of-arrays. The projection maths runs over
+	// m_Batch in SIMD batches; everything else gets copied straight out of the render data.
+	struct ChunkColumns {
+		ColumnBatch m_Batch;
+		std::vector<float> m_X;
+		std::vector<int> m_Proxy;
+		std::vector<float> m_VTop;
+		std::vector<float> m_VBottom;
+		// The proxy's colour, lit by the ambient light and any point lights.
+		std::vector<sf::Color> m_LitColor;
+		std::vector<char> m_Opaque;
+		std::vector<float> m_NormalX;
+		std::vector<float> m_NormalY;
+		std::vector<const sf::Texture*> m_Texture;
+
+		// Tile walls' U, by index, to put in m_Batch once it has been projected. Tiles aren't
+		// sprites, so the projection's U is no good for them.
+		std::vector<std::pair<unsigned, float>> m_TileU;
+
+		// Only filled in by SubmitFrame(sf::Image&), along with m_RasterHits when it gets to it.
+		std::vector<const ColumnMajorTexture*> m_SoftwareTexture;
+		std::vector<RasterHit> m_RasterHits;
+
+		// Only filled in when merging columns into spans, in the order they're to be drawn.
+		std::vector<ColumnSpan> m_Spans;
+		ColumnSpanBuilder m_SpanBuilder;
+
+		// Only filled in by SubmitFrame(sf::Image&): the particles over the chunk, as indices
+		// into m_ScreenParticles, back to front. m_ParticleHits is for one column at a time.
+		std::vector<unsigned> m_Particles;
+		std::vector<RasterHit> m_ParticleHits;
+
+		unsigned Size() const { return (unsigned)m_X.size(); }
+
+		void Clear() {
+			m_Batch.Clear();
+			m_X.resize(0);
+			m_Proxy.resize(0);
+			m_VTop.resize(0);
+			m_VBottom.resize(0);
+			m_LitColor.resize(0);
+			m_Opaque.resize(0);
+			m_NormalX.resize(0);
+			m_NormalY.resize(0);
+			m_Texture.resize(0);
+			m_TileU.resize(0);
+			m_SoftwareTexture.resize(0);
+			m_Spans.resize(0);
+			m_Particles.resize(0);
+		}
+	};
+
+	struct ColumnVertex {
+		sf::Vector3f position;
+		sf::Vector2f normal;
+		// U and V in texels, then texels per pixel down the screen, which picks the mip level.
+		sf::Vector3f texCoords;
+		sf::Color color;
+	};
+
+	// Streamed to GL every frame. Kept around so we don't reallocate it each time.
+	std::vector<ColumnVertex> m_ColumnVertices;
+
+	// Translucent columns or spans, by chunk and index, left for after the opaque pass.
+	std::vector<std::pair<unsigned, unsigned>> m_TranslucentItems;
+
+	// The particles that made it past the column depth buffer, back to front. Drawn after
+	// everything else.
+	std::vector<ScreenParticle> m_ScreenParticles;
+
+	sf::Shader mShader;
+
+	// Not until the first GL SubmitFrame, so that rendering to an sf::Image needs no GL at all.
+	bool m_ShaderLoaded = false;
+
+	// CPU copies of textures for SubmitFrame(sf::Image&), by the texture they were copied from.
+	struct SoftwareTexture
+	{
+		// Atlas pages are checked against the atlas's version, anything else against the
+		// texture itself still being around.
+		bool m_AtlasPage = false;
+		unsigned m_AtlasVersion = 0;
+		std::weak_ptr<sf::Texture> m_Original;
+		// See RenderSettings::m_Mipmaps.
+		bool m_Mipmaps = false;
+		ColumnMajorTexture m_Texels;
+	};
+
+	std::unordered_map<const sf::Texture*, SoftwareTexture> m_SoftwareTextures;
+
+	// The frame, column by column, for SubmitFrame(sf::Image&) to paint into.
+	std::vector<std::uint8_t> m_SoftwareColumns;
+	// The same, row by row again, for handing back to the sf::Image.
+	std::vector<std::uint8_t> m_SoftwarePixels;
+
+	// Casts the rays. Recreated whenever RenderSettings asks for a different thread count.
+	std::unique_ptr<WorkerPool> m_WorkerPool;
+
+	// Number of screen columns a worker claims at a time. A multiple of every ray packet width.
+	static const unsigned sm_RaycastChunkSize = 16;
+
+	// Number of proxies a worker snapshots at a time.
+	static const unsigned sm_SnapshotChunkSize = 256;
+
+	// Number of vertices the ColumnDrawer lets build up before it hands them to GL.
+	static const size_t sm_MinStreamedBatchSize = 4096;
+
+	TextureAtlas m_TextureAtlas;
+
+	// Set when a texture couldn't be added to the atlas.
+	bool m_TextureAtlasFull = false;
+
+	// Slots of proxies whose textures weren't on the atlas yet. Guarded by m_AtlasMissMutex.
+	std::vector<int> m_AtlasMisses;
+	std::mutex m_AtlasMissMutex;
+
+	// What the CPU side needs to know about the frame it's working on. Filled in by
+	// BeginFrame, so that the workers never need to look at the Camera or the RenderSettings.
+	struct FrameSetup
+	{
+		const RenderProxyIndex* m_RenderProxies = nullptr;
+		// nullptr if the World doesn't have one.
+		const TileMap* m_TileMap = nullptr;
+		// One for each of m_RenderProxies' slots, then one for each of m_TileMap's tile types.
+		std::vector<ProxySnapshot> m_Proxies;
+		// The first tile type's slot. Moves whenever the number of proxies changes.
+		int m_TileSlotBase = 0;
+
+		// nullptr if the World has no sectors. m_CameraSector is -1 outside of every sector.
+		const SectorGraph* m_Sectors = nullptr;
+		int m_CameraSector = -1;
+
+		// The World's point lights that might reach anything on screen, by cluster of columns.
+		PointLightClusters m_PointLights;
+
+		const ParticleSystem* m_Particles = nullptr;
+
+		bool IsTile(const int slot) const { return slot >= m_TileSlotBase; }
+
+		const FixtureRenderData& GetRenderData(const int slot) const {
+			return IsTile(slot) ?
+				m_TileMap->GetType(slot - m_TileSlotBase).renderData :
+				m_RenderProxies->GetRenderData(slot);
+		}
+
+		RenderSettings m_Settings;
+		Fog m_Fog;
+
+		b2Vec2 m_CameraPosition;
+		b2Vec2 m_CameraForwards;
+		// The camera's right-vector, stretched or squashed to fit the field of view.
+		b2Vec2 m_ViewPlane;
+		float m_ScreenXDelta = 0.0f;
+
+		ColumnProjection m_Projection;
+
+		// Billboards that are in front of the camera, within ray length, and on screen.
+		struct Billboard
+		{
+			// Slot in the RenderProxyIndex, and in m_Proxies.
+			int m_Proxy;
+			// Along the camera's forwards and right-vector.
+			float m_Depth;
+			float m_Lateral;
+			float m_HalfWidth;
+			// The screen columns it might cover.
+			unsigned m_FirstColumn;
+			unsigned m_EndColumn;
+		};
+
+		std::vector<Billboard> m_Billboards;
+
+		// See RenderSettings::m_UseTextureAtlas.
+		bool m_UseTextureAtlas = false;
+		// Where untextured proxies' views point. nullptr if the atlas isn't being used.
+		const TextureAtlas::Placement* m_White = nullptr;
+
+		// Static proxies are cast on their own and their hits are kept from one frame to
+		// the next. Dynamic proxies are then cast only for the columns they could show up in.
+		bool m_Incremental = false;
+		bool m_StaticCacheValid = false;
+
+		RayPacketKernel m_PacketKernel = RayPacketKernel::Scalar;
+		unsigned m_PacketWidth = 1;
+
+		std::chrono::steady_clock::time_point m_StartTime;
+	};
+
+	FrameSetup m_Setup;
+
+	// Everything the GL side needs to draw the frame. Columns are kept per chunk of screen
+	// columns, so each chunk can be drawn as soon as the CPU side has finished with it.
+	struct FramePacket
+	{
+		sf::Vector2u m_TargetSize;
+
+		AmbientLight m_AmbientLight;
+		DirectionalLight m_DirectionalLight;
+		Fog m_Fog;
+
+		std::vector<ChunkColumns> m_ChunkColumns;
+
+		// Guarded by m_ChunkMutex.
+		std::vector<char> m_ChunkReady;
+
+		// CPU time spent preparing each chunk's columns, in milliseconds.
+		std::vector<float> m_ChunkPrepareTime;
+
+		// Billboard columns that made it past the depth buffer, in each chunk.
+		std::vector<unsigned> m_ChunkBillboardColumns;
+	};
+
+	FramePacket m_Frame;
+
+	std::mutex m_ChunkMutex;
+	std::condition_variable m_ChunkDone;
+
+	// Between BeginFrame and SubmitFrame.
+	bool m_FrameInProgress = false;
+
+	b2Vec2 RayEnd(const unsigned columnIndex);
+	RaycastCallback& ResetColumn(const unsigned columnIndex);
+	bool HasRoomForDynamic(const unsigned columnIndex) const;
+	void FinishColumn(RaycastCallback& cb) const;
+
+	// Cuts the ray short where the sectors block it, then adds the tile map's walls, before
+	// anything gets cast against the render proxies. Both can clip the rays that follow.
+	void ClipRay(RaycastCallback& cb, const b2Vec2& rayEnd) const;
+
+	void CastColumn(const unsigned columnIndex);
+	void CastPacket(const unsigned firstColumn, const unsigned columnCount);
+
+	void SnapshotProxies(const unsigned begin, const unsigned end);
+
+	// Culls the billboards against the view frustum, and works out which columns they cover.
+	void ProjectBillboards(const unsigned targetWidth);
+
+	// Fills in the chunk's m_ColumnDepth, and adds the billboards in front of it to its columns.
+	// Returns the number of billboard columns added.
+	unsigned AddBillboards(const unsigned begin, const unsigned end);
+
+	// Fills in m_ScreenParticles. Needs every chunk's m_ColumnDepth.
+	void ProjectParticles();
+
+	// Adds the textures that SnapshotProxies couldn't find on the atlas. Needs the GL context.
+	void AddAtlasMisses();
+
+	static void MoveOntoAtlas(ProxySnapshot& proxy, const TextureAtlas::Placement& placement);
+
+	// Turns the chunk's intersections into columns.
+	void Prepare(const unsigned begin, const unsigned end, ChunkColumns& columns) const;
+
+	// Casts, sorts and prepares the columns [begin, end), which make up one chunk.
+	void ProcessChunk(const unsigned begin, const unsigned end);
+
+	// Returns once the chunk is ready to draw, helping out with other chunks in the meantime.
+	void WaitForChunk(const unsigned chunkIndex);
+
+	// Finds or makes the CPU copy of a texture. Making one needs the GL context.
+	const ColumnMajorTexture* GetSoftwareTexture(const sf::Texture* texture, const int proxySlot);
+
+	// Rasterizes the chunk's columns, [begin, end), from pixels into m_SoftwarePixels.
+	void RasterizeChunk(
+		const unsigned begin,
+		const unsigned end,
+		const std::uint8_t* pixels,
+		const ColumnLighting& lighting);
+
+	// Waits for the workers, and fills in the stats that don't depend on how the frame was drawn.
+	void FinishFrame(const unsigned intersectionCount);
+
+	void LoadShader();
+
+	WorkerPool& GetWorkerPool(const RenderSettings& settings);
+
+public:
+	WorldRaycastRendererImpl() = default;
+
+	~WorldRaycastRendererImpl()
+	{
+		// The workers might still be using us.
+		if (m_WorkerPool) {
+			m_WorkerPool->Wait();
+		}
+	}
+
+	void BeginFrame(const World& world, const Camera3D& camera, const RenderSettings& settings, const sf::Vector2u targetSize);
+	void SubmitFrame(sf::RenderTarget& target);
+	void SubmitFrame(sf::Image& image);
+
+	WorldRaycastRenderer::FrameStats m_LastFrameStats;
+};
+
+void WorldRaycastRendererImpl::BeginFrame(
+	const World& world,
+	const Camera3D& camera,
+	const RenderSettings& settings,
+	const sf::Vector2u targetSize)
+{
+	// Nobody submitted the last one. Let it finish so we can reuse its storage.
+	if (m_FrameInProgress)
+	{
+		m_WorkerPool->Wait();
+		m_FrameInProgress = false;
+	}
+
+	const auto targetWidth = targetSize.x;
+
+	if (m_RaycastCallbacks.size() != targetWidth)
+	{
+		m_RaycastCallbacks.resize(targetWidth);
+		m_ColumnDepth.resize(targetWidth);
+
+		m_ColumnVertices.reserve(targetWidth * RaycastCallback::sm_MaxNumIntersections * 2);
+	}
+
+	FrameSetup& setup = m_Setup;
+
+	setup.m_StartTime = std::chrono::steady_clock::now();
+	setup.m_RenderProxies = &world.GetRenderProxies();
+	setup.m_TileMap = world.GetTileMap();
+	setup.m_Sectors = world.GetSectors().IsEmpty() ? nullptr : &world.GetSectors();
+	setup.m_CameraSector = setup.m_Sectors ? setup.m_Sectors->GetSectorAt(camera.GetPosition()) : -1;
+	setup.m_Settings = settings;
+	setup.m_Fog = world.GetFog();
+	setup.m_CameraPosition = camera.GetPosition();
+	setup.m_CameraForwards = camera.GetForwards();
+	setup.m_ScreenXDelta = 2.0f / (float)targetWidth;
+
+	const float viewPlaneWidthModifier = camera.GetViewPlaneWidthModifier();
+	setup.m_ViewPlane.Set(
+		setup.m_CameraForwards.y * viewPlaneWidthModifier * (-1),
+		setup.m_CameraForwards.x * viewPlaneWidthModifier);
+
+	setup.m_Projection = ColumnProjection(camera, targetSize.y);
+
+	setup.m_PointLights.Build(
+		world.GetPointLights(),
+		setup.m_CameraPosition,
+		setup.m_CameraForwards,
+		setup.m_ViewPlane,
+		targetWidth,
+		settings.GetRayLength(setup.m_Fog));
+
+	setup.m_Particles = &world.GetParticles();
+
+	setup.m_UseTextureAtlas = settings.m_UseTextureAtlas;
+	setup.m_White = nullptr;
+
+	if (setup.m_UseTextureAtlas)
+	{
+		// Start again if that frees up some room. Textures that are still in use go back on
+		// as they turn up.
+		if (m_TextureAtlasFull && m_TextureAtlas.HasExpiredTextures()) {
+			m_TextureAtlas.Clear();
+		}
+
+		m_TextureAtlasFull = false;
+
+		setup.m_White = m_TextureAtlas.GetWhite();
+	}
+
+	setup.m_TileSlotBase = setup.m_RenderProxies->GetProxyCount();
+	setup.m_Proxies.resize(
+		setup.m_TileSlotBase + (setup.m_TileMap ? setup.m_TileMap->GetTypeCount() : 0));
+
+	m_AtlasMisses.resize(0);
+
+	GetWorkerPool(settings).ParallelFor(
+		(unsigned)setup.m_Proxies.size(),
+		sm_SnapshotChunkSize,
+		[this](const unsigned begin, const unsigned end)
+	{
+		SnapshotProxies(begin, end);
+	});
+
+	AddAtlasMisses();
+
+	ProjectBillboards(targetWidth);
+
+	setup.m_Incremental = settings.m_IncrementalRaycast;
+	setup.m_StaticCacheValid = false;
+
+	if (setup.m_Incremental)
+	{
+		StaticCacheKey key;
+		key.m_RenderProxies = setup.m_RenderProxies;
+		key.m_StaticGeneration = setup.m_RenderProxies->GetStaticGeneration();
+		key.m_TileMap = setup.m_TileMap;
+		key.m_TileMapGeneration = setup.m_TileMap ? setup.m_TileMap->GetGeneration() : 0;
+		key.m_SectorGeneration = world.GetSectors().GetGeneration();
+		key.m_CameraPosition = setup.m_CameraPosition;
+		key.m_CameraForwards = setup.m_CameraForwards;
+		key.m_ViewPlaneWidthModifier = viewPlaneWidthModifier;
+		key.m_CameraHeightOffset = setup.m_Projection.cameraHeightOffset;
+		key.m_CameraPitchOffset = setup.m_Projection.cameraPitchOffset;
+		key.m_TargetWidth = targetWidth;
+		key.m_TargetHeight = targetSize.y;
+		key.m_RayLength = settings.GetRayLength(setup.m_Fog);
+
+		setup.m_StaticCacheValid = m_StaticCacheValid && key == m_StaticCacheKey;
+
+		m_StaticCacheKey = key;
+		m_StaticCacheValid = true;
+
+		m_LastFrameStats.m_DynamicColumnCount = FindDynamicColumns(
+			*setup.m_RenderProxies,
+			setup.m_CameraPosition,
+			setup.m_CameraForwards,
+			setup.m_ViewPlane,
+			key.m_RayLength);
+	}
+	else
+	{
+		m_StaticCacheValid = false;
+	}
+
+	m_LastFrameStats.m_CameraSector = setup.m_CameraSector;
+	m_LastFrameStats.m_Incremental = setup.m_Incremental;
+	m_LastFrameStats.m_StaticCacheHit = setup.m_StaticCacheValid;
+
+	// Neighbouring columns' rays start at the same point and point in almost the same
+	// direction, so they can share a trip through the tree and be tested together.
+	setup.m_PacketKernel = GetBestRayPacketKernel();
+	setup.m_PacketWidth = settings.m_UseRayPackets ? (unsigned)GetRayPacketWidth(setup.m_PacketKernel) : 1;
+
+	FramePacket& frame = m_Frame;
+
+	frame.m_TargetSize = targetSize;
+	frame.m_AmbientLight = world.GetAmbientLight();
+	frame.m_DirectionalLight = world.GetDirectionalLight();
+	frame.m_Fog = world.GetFog();
+
+	const unsigned chunkCount = (targetWidth + sm_RaycastChunkSize - 1) / sm_RaycastChunkSize;
+
+	frame.m_ChunkColumns.resize(chunkCount);
+	frame.m_ChunkReady.assign(chunkCount, 0);
+	frame.m_ChunkPrepareTime.assign(chunkCount, 0.0f);
+	frame.m_ChunkBillboardColumns.assign(chunkCount, 0);
+
+	// Ray casts only read from the RenderProxyIndex, so it's fine to have several threads
+	// casting at once as long as nobody modifies the World until they're done.
+	// Each column writes only to its own RaycastCallback and each chunk only to its own
+	// Columns, so the result is the same no matter how the chunks get split between threads.
+	GetWorkerPool(settings).ParallelForAsync(
+		targetWidth,
+		sm_RaycastChunkSize,
+		[this](const unsigned begin, const unsigned end)
+	{
+		ProcessChunk(begin, end);
+	});
+
+	m_FrameInProgress = true;
+}
+
+void WorldRaycastRendererImpl::ProcessChunk(const unsigned begin, const unsigned end)
+{
+	if (m_Setup.m_PacketWidth > 1)
+	{
+		for (unsigned columnIndex = begin; columnIndex < end; columnIndex += m_Setup.m_PacketWidth)
+		{
+			CastPacket(columnIndex, std::min(m_Setup.m_PacketWidth, end - columnIndex));
+		}
+	}
+	else
+	{
+		for (unsigned columnIndex = begin; columnIndex < end; ++columnIndex)
+		{
+			CastColumn(columnIndex);
+		}
+	}
+
+	const unsigned chunkIndex = begin / sm_RaycastChunkSize;
+
+	m_Frame.m_ChunkBillboardColumns[chunkIndex] = AddBillboards(begin, end);
+
+	{
+		const auto prepareStart = std::chrono::steady_clock::now();
+
+		Prepare(begin, end, m_Frame.m_ChunkColumns[chunkIndex]);
+
+		m_Frame.m_ChunkPrepareTime[chunkIndex] =
+			std::chrono::duration_cast<Profiler::SampleUnit>(
+				std::chrono::steady_clock::now() - prepareStart).count();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_ChunkMutex);
+		m_Frame.m_ChunkReady[chunkIndex] = 1;
+	}
+
+	m_ChunkDone.notify_all();
+}
+
+void WorldRaycastRendererImpl::WaitForChunk(const unsigned chunkIndex)
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_ChunkMutex);
+			if (m_Frame.m_ChunkReady[chunkIndex]) return;
+		}
+
+		// Rather than sit about, take a chunk that nobody has started on yet.
+		if (m_WorkerPool->RunChunk()) continue;
+
+		// Every chunk has been claimed, so ours is on its way.
+		std::unique_lock<std::mutex> lock(m_ChunkMutex);
+		m_ChunkDone.wait(lock, [this, chunkIndex]() { return m_Frame.m_ChunkReady[chunkIndex] != 0; });
+		return;
+	}
+}
+
+b2Vec2 WorldRaycastRendererImpl::RayEnd(const unsigned columnIndex)
+{
+	const FrameSetup& setup = m_Setup;
+
+	const auto screenX = -1.0f + setup.m_ScreenXDelta * columnIndex;
+	auto rayDir = (setup.m_CameraForwards + (screenX * setup.m_ViewPlane));
+	rayDir.Normalize();
+
+	const float rayLength = setup.m_Settings.GetRayLength(setup.m_Fog, b2Dot(rayDir, setup.m_CameraForwards));
+	m_RaycastCallbacks[columnIndex].m_RayLength = rayLength;
+
+	return setup.m_CameraPosition + (rayLength * rayDir);
+}
+
+auto WorldRaycastRendererImpl::ResetColumn(const unsigned columnIndex) -> RaycastCallback&
+{
+	RaycastCallback& cb = m_RaycastCallbacks[columnIndex];
+
+	cb.m_Index = columnIndex;
+	cb.m_IntersectionCount = 0;
+	cb.m_MaxFraction = 1.0f;
+	cb.m_SectorFraction = 1.0f;
+	cb.m_Projection = &m_Setup.m_Projection;
+	cb.m_Proxies = m_Setup.m_Proxies.data();
+	cb.m_TileSlotBase = m_Setup.m_TileSlotBase;
+
+	return cb;
+}
+
+bool WorldRaycastRendererImpl::HasRoomForDynamic(const unsigned columnIndex) const
+{
+	return
+		m_DynamicColumns[columnIndex] > 0 &&
+		m_RaycastCallbacks[columnIndex].m_IntersectionCount < RaycastCallback::sm_MaxNumIntersections;
+}
+
+void WorldRaycastRendererImpl::FinishColumn(RaycastCallback& cb) const
+{
+	// Some of these might have been found before the occluder that hides them.
+	cb.RemoveOccluded();
+
+	// Further away intersections come first.
+	SortBackToFront(
+		cb.m_Intersections.begin(),
+		cb.m_Intersections.begin() + cb.m_IntersectionCount,
+		[](const RaycastCallback::RayIntersection& intersection)
+	{
+		return intersection.m_fraction;
+	});
+}
+
+void WorldRaycastRendererImpl::ClipRay(RaycastCallback& cb, const b2Vec2& rayEnd) const
+{
+	const FrameSetup& setup = m_Setup;
+
+	if (setup.m_CameraSector >= 0)
+	{
+		const float32 fraction = setup.m_Sectors->Clip(setup.m_CameraPosition, rayEnd, setup.m_CameraSector);
+
+		if (fraction < 1.0f)
+		{
+			cb.m_SectorFraction = fraction;
+			cb.m_MaxFraction = std::min(fraction + sm_SectorMargin / cb.m_RayLength, 1.0f);
+		}
+	}
+
+	if (setup.m_TileMap) {
+		setup.m_TileMap->RayCast(cb, setup.m_CameraPosition, rayEnd, setup.m_TileSlotBase, cb.m_MaxFraction);
+	}
+}
+
+void WorldRaycastRendererImpl::CastColumn(const unsigned columnIndex)
+{
+	const FrameSetup& setup = m_Setup;
+	const RenderProxyIndex& renderProxies = *setup.m_RenderProxies;
+
+	RaycastCallback& cb = ResetColumn(columnIndex);
+
+	const b2Vec2 rayEnd = RayEnd(columnIndex);
+
+	if (!setup.m_Incremental)
+	{
+		ClipRay(cb, rayEnd);
+		renderProxies.RayCast(cb, setup.m_CameraPosition, rayEnd, RenderProxySet::All, cb.m_MaxFraction);
+	}
+	else
+	{
+		if (setup.m_StaticCacheValid) {
+			cb.RestoreStatic();
+		}
+		else {
+			ClipRay(cb, rayEnd);
+			renderProxies.RayCast(
+				cb,
+				setup.m_CameraPosition,
+				rayEnd,
+				RenderProxySet::Static,
+				cb.m_MaxFraction);
+			cb.SaveStatic();
+		}
+
+		if (HasRoomForDynamic(columnIndex)) {
+			renderProxies.RayCast(
+				cb,
+				setup.m_CameraPosition,
+				rayEnd,
+				RenderProxySet::Dynamic,
+				cb.m_MaxFraction);
+		}
+	}
+
+	FinishColumn(cb);
+}
+
+void WorldRaycastRendererImpl::CastPacket(const unsigned firstColumn, const unsigned columnCount)
+{
+	const FrameSetup& setup = m_Setup;
+	const RenderProxyIndex& renderProxies = *setup.m_RenderProxies;
+
+	std::array<RenderProxyRayCastCallback*, RayPacket::MaxSize> callbacks;
+	std::array<b2Vec2, RayPacket::MaxSize> ends;
+	std::array<float32, RayPacket::MaxSize> maxFractions;
+
+	for (unsigned i = 0; i < columnCount; ++i)
+	{
+		callbacks[i] = &ResetColumn(firstColumn + i);
+		ends[i] = RayEnd(firstColumn + i);
+	}
+
+	// Sectors and tile walls first, so that they can clip the packet's rays.
+	auto clipRays = [&]()
+	{
+		for (unsigned i = 0; i < columnCount; ++i)
+		{
+			RaycastCallback& cb = m_RaycastCallbacks[firstColumn + i];
+			ClipRay(cb, ends[i]);
+			maxFractions[i] = cb.m_MaxFraction;
+		}
+	};
+
+	if (!setup.m_Incremental)
+	{
+		clipRays();
+
+		renderProxies.RayCastPacket(
+			callbacks.data(),
+			setup.m_CameraPosition,
+			ends.data(),
+			(int)columnCount,
+			setup.m_PacketKernel,
+			RenderProxySet::All,
+			maxFractions.data());
+	}
+	else
+	{
+		if (setup.m_StaticCacheValid)
+		{
+			for (unsigned i = 0; i < columnCount; ++i) {
+				m_RaycastCallbacks[firstColumn + i].RestoreStatic();
+			}
+		}
+		else
+		{
+			clipRays();
+
+			renderProxies.RayCastPacket(
+				callbacks.data(),
+				setup.m_CameraPosition,
+				ends.data(),
+				(int)columnCount,
+				setup.m_PacketKernel,
+				RenderProxySet::Static,
+				maxFractions.data());
+
+			for (unsigned i = 0; i < columnCount; ++i) {
+				m_RaycastCallbacks[firstColumn + i].SaveStatic();
+			}
+		}
+
+		// Only the columns that need it go into the dynamic packet.
+		std::array<RenderProxyRayCastCallback*, RayPacket::MaxSize> dynamicCallbacks;
+		std::array<b2Vec2, RayPacket::MaxSize> dynamicEnds;
+		std::array<float32, RayPacket::MaxSize> dynamicMaxFractions;
+		int dynamicCount = 0;
+
+		for (unsigned i = 0; i < columnCount; ++i)
+		{
+			if (!HasRoomForDynamic(firstColumn + i)) continue;
+
+			dynamicCallbacks[dynamicCount] = callbacks[i];
+			dynamicEnds[dynamicCount] = ends[i];
+			dynamicMaxFractions[dynamicCount] = m_RaycastCallbacks[firstColumn + i].m_MaxFraction;
+			dynamicCount++;
+		}
+
+		if (dynamicCount > 0)
+		{
+			renderProxies.RayCastPacket(
+				dynamicCallbacks.data(),
+				setup.m_CameraPosition,
+				dynamicEnds.data(),
+				dynamicCount,
+				setup.m_PacketKernel,
+				RenderProxySet::Dynamic,
+				dynamicMaxFractions.data());
+		}
+	}
+
+	for (unsigned i = 0; i < columnCount; ++i)
+	{
+		FinishColumn(m_RaycastCallbacks[firstColumn + i]);
+	}
+}
+
+void WorldRaycastRendererImpl::SnapshotProxies(const unsigned begin, const unsigned end)
+{
+	FrameSetup& setup = m_Setup;
+
+	for (unsigned slot = begin; slot < end; ++slot)
+	{
+		const FixtureRenderData& renderData = setup.GetRenderData(slot);
+		ProxySnapshot& proxy = setup.m_Proxies[slot];
+
+		proxy.m_SpritePosition = renderData.GetSpritePosition();
+		proxy.m_Height = renderData.GetHeight();
+		proxy.m_GroundOffset = renderData.GetGroundOffset();
+		proxy.m_SpriteRadius = renderData.GetSpriteRadius();
+		proxy.m_Opaque = renderData.IsOpaque();
+		proxy.m_Color = renderData.GetColor();
+		proxy.m_Texture = renderData.GetTexture();
+
+		// Multi-view sprites show a different view depending on where they're seen from.
+		// Working that out here means doing it once per object rather than once per column.
+		proxy.m_View =
+			renderData.GetViews().viewCount <= 1 ?
+			renderData.GetViews().views[0] :
+			CalculateView(
+				renderData.GetViews(),
+				renderData.GetObjectAngle(),
+				[&setup, &renderData]() {
+					const b2Vec2 disp = renderData.GetSpritePosition() - setup.m_CameraPosition;
+					return b2Atan2(disp.y, disp.x) + b2_pi;
+				}());
+
+		if (!setup.m_UseTextureAtlas) continue;
+
+		// Atlas pages have no mips, so mipmapped textures stay on their own.
+		if (proxy.m_Texture && setup.m_Settings.m_Mipmaps) continue;
+
+		const TextureAtlas::Placement* placement =
+			proxy.m_Texture ? m_TextureAtlas.Find(proxy.m_Texture) : setup.m_White;
+
+		if (placement)
+		{
+			MoveOntoAtlas(proxy, *placement);
+		}
+		else if (proxy.m_Texture)
+		{
+			// Pages can only be written to from the GL thread.
+			std::lock_guard<std::mutex> lock(m_AtlasMissMutex);
+			m_AtlasMisses.push_back(slot);
+		}
+	}
+}
+
+void WorldRaycastRendererImpl::ProjectBillboards(const unsigned targetWidth)
+{
+	FrameSetup& setup = m_Setup;
+
+	setup.m_Billboards.resize(0);
+
+	const float viewPlaneLength = setup.m_ViewPlane.Length();
+
+	if (viewPlaneLength <= 0.0f) return;
+
+	const b2Vec2 right = (1.0f / viewPlaneLength) * setup.m_ViewPlane;
+
+	// No ray gets further than this along the camera's forwards.
+	const float maxDepth = setup.m_Settings.GetRayLength(setup.m_Fog);
+
+	setup.m_RenderProxies->ForEachBillboard([&](
+		const int slot,
+		const b2Vec2& position,
+		const float halfWidth)
+	{
+		const b2Vec2 offset = position - setup.m_CameraPosition;
+		const float depth = b2Dot(offset, setup.m_CameraForwards);
+
+		if (depth < sm_BillboardNearDistance || depth > maxDepth) return;
+
+		const float lateral = b2Dot(offset, right);
+
+		// Column x's ray goes through forwards + screenX * m_ViewPlane, where screenX runs from
+		// -1 on the left of the screen to 1 on the right.
+		const float leftScreenX = (lateral - halfWidth) / (depth * viewPlaneLength);
+		const float rightScreenX = (lateral + halfWidth) / (depth * viewPlaneLength);
+
+		const int firstColumn = std::max(
+			(int)std::ceil((leftScreenX + 1.0f) / setup.m_ScreenXDelta),
+			0);
+		const int endColumn = std::min(
+			(int)std::floor((rightScreenX + 1.0f) / setup.m_ScreenXDelta) + 1,
+			(int)targetWidth);
+
+		if (firstColumn >= endColumn) return;
+
+		FrameSetup::Billboard billboard;
+		billboard.m_Proxy = slot;
+		billboard.m_Depth = depth;
+		billboard.m_Lateral = lateral;
+		billboard.m_HalfWidth = halfWidth;
+		billboard.m_FirstColumn = (unsigned)firstColumn;
+		billboard.m_EndColumn = (unsigned)endColumn;
+
+		setup.m_Billboards.push_back(billboard);
+	});
+}
+
+unsigned WorldRaycastRendererImpl::AddBillboards(const unsigned begin, const unsigned end)
+{
+	const FrameSetup& setup = m_Setup;
+
+	const float viewPlaneLength = setup.m_ViewPlane.Length();
+
+	// Billboards face the camera, so they all share its backwards as their normal.
+	const b2Vec2 normal = -setup.m_CameraForwards;
+
+	unsigned billboardColumnCount = 0;
+
+	for (unsigned columnIndex = begin; columnIndex < end; ++columnIndex)
+	{
+		RaycastCallback& cb = m_RaycastCallbacks[columnIndex];
+
+		const float screenX = -1.0f + setup.m_ScreenXDelta * columnIndex;
+
+		// The ray's direction, scaled so that it goes 1 along the camera's forwards.
+		const b2Vec2 rayDir = setup.m_CameraForwards + screenX * setup.m_ViewPlane;
+		const float rayDirLength = rayDir.Length();
+
+		m_ColumnDepth[columnIndex] = cb.m_MaxFraction * cb.m_RayLength / rayDirLength;
+
+		bool added = false;
+
+		for (const FrameSetup::Billboard& billboard : setup.m_Billboards)
+		{
+			if (columnIndex < billboard.m_FirstColumn || columnIndex >= billboard.m_EndColumn) continue;
+
+			// The depth test.
+			if (billboard.m_Depth >= m_ColumnDepth[columnIndex]) continue;
+
+			// Rounding might have let in a column just off the edge.
+			const float offset = billboard.m_Depth * screenX * viewPlaneLength - billboard.m_Lateral;
+
+			if (std::abs(offset) > billboard.m_HalfWidth) continue;
+
+			if (cb.m_IntersectionCount >= RaycastCallback::sm_MaxNumIntersections) break;
+
+			cb.m_Intersections[cb.m_IntersectionCount++] =
+			{
+				billboard.m_Proxy,
+				setup.m_CameraPosition + billboard.m_Depth * rayDir,
+				normal,
+				billboard.m_Depth * rayDirLength / cb.m_RayLength,
+				(int)columnIndex
+			};
+
+			added = true;
+			billboardColumnCount++;
+		}
+
+		if (added) {
+			FinishColumn(cb);
+		}
+	}
+
+	return billboardColumnCount;
+}
+
+void WorldRaycastRendererImpl::ProjectParticles()
+{
+	const FrameSetup& setup = m_Setup;
+
+	qvr::ProjectParticles(
+		*setup.m_Particles,
+		setup.m_Projection,
+		setup.m_ViewPlane,
+		m_ColumnDepth,
+		m_ScreenParticles);
+}
+
+void WorldRaycastRendererImpl::AddAtlasMisses()
+{
+	FrameSetup& setup = m_Setup;
+
+	for (const int slot : m_AtlasMisses)
+	{
+		const FixtureRenderData& renderData = setup.GetRenderData(slot);
+
+		if (const TextureAtlas::Placement* placement = m_TextureAtlas.Add(renderData.GetSharedTexture()))
+		{
+			MoveOntoAtlas(setup.m_Proxies[slot], *placement);
+		}
+		else
+		{
+			// Leave this one on its own texture for now.
+			m_TextureAtlasFull = true;
+		}
+	}
+}
+
+void WorldRaycastRendererImpl::MoveOntoAtlas(
+	ProxySnapshot& proxy,
+	const TextureAtlas::Placement& placement)
+{
+	Animation::Rect& view = proxy.m_View;
+
+	if (proxy.m_Texture)
+	{
+		view.left += placement.offsetX;
+		view.right += placement.offsetX;
+		view.top += placement.offsetY;
+		view.bottom += placement.offsetY;
+	}
+	else
+	{
+		// Untextured columns are plain white, whatever part of it they sample.
+		view.left = view.right = placement.offsetX;
+		view.top = view.bottom = placement.offsetY;
+	}
+
+	proxy.m_Texture = placement.page;
+}
+
+void WorldRaycastRendererImpl::Prepare(
+	const unsigned begin,
+	const unsigned end,
+	ChunkColumns& columns) const
+{
+	const FrameSetup& setup = m_Setup;
+
+	columns.Clear();
+
+	const sf::Color ambient = m_Frame.m_AmbientLight.mColor;
+	const float ambientLight[4] = {
+		ambient.r / 255.0f,
+		ambient.g / 255.0f,
+		ambient.b / 255.0f,
+		ambient.a / 255.0f
+	};
+
+	// Lay the chunk's columns out one after another. Columns don't overlap on screen so
+	// there's no need to sort across them: each one is already sorted back-to-front, which
+	// is all the painter's algorithm needs.
+	for (unsigned columnIndex = begin; columnIndex < end; ++columnIndex)
+	{
+		const RaycastCallback& cb = m_RaycastCallbacks[columnIndex];
+
+		for (unsigned i = 0; i < cb.m_IntersectionCount; ++i)
+		{
+			const RaycastCallback::RayIntersection& intersection = cb.m_Intersections[i];
+			const ProxySnapshot& proxy = setup.m_Proxies[intersection.m_Proxy];
+			const Animation::Rect& textureRect = proxy.m_View;
+
+			columns.m_Batch.Add(
+				intersection.m_point,
+				proxy.m_Height,
+				proxy.m_GroundOffset,
+				proxy.m_SpritePosition,
+				proxy.m_SpriteRadius,
+				(float)textureRect.left,
+				(float)(textureRect.right - textureRect.left));
+
+			columns.m_X.push_back((float)intersection.m_screenX);
+			columns.m_Proxy.push_back(intersection.m_Proxy);
+			columns.m_VTop.push_back((float)textureRect.top);
+			columns.m_VBottom.push_back((float)textureRect.bottom);
+			{
+				float light[3] = { ambientLight[0], ambientLight[1], ambientLight[2] };
+
+				if (!setup.m_PointLights.IsEmpty()) {
+					setup.m_PointLights.Gather(columnIndex, intersection.m_point, intersection.m_normal, light);
+				}
+
+				columns.m_LitColor.emplace_back(
+					LightChannel(proxy.m_Color.r, light[0]),
+					LightChannel(proxy.m_Color.g, light[1]),
+					LightChannel(proxy.m_Color.b, light[2]),
+					LightChannel(proxy.m_Color.a, ambientLight[3]));
+			}
+			columns.m_Opaque.push_back(proxy.m_Opaque);
+			columns.m_NormalX.push_back(intersection.m_normal.x);
+			columns.m_NormalY.push_back(intersection.m_normal.y);
+			columns.m_Texture.push_back(proxy.m_Texture);
+
+			if (setup.IsTile(intersection.m_Proxy))
+			{
+				const float across = setup.m_TileMap->GetFaceCoordinate(intersection.m_point, intersection.m_normal);
+
+				columns.m_TileU.emplace_back(
+					columns.Size() - 1,
+					textureRect.left + across * (textureRect.right - textureRect.left));
+			}
+		}
+	}
+
+	// Distance, top, bottom and U for the whole chunk at once.
+	ProjectColumns(setup.m_Projection, columns.m_Batch);
+
+	for (const auto& tileU : columns.m_TileU) {
+		columns.m_Batch.u[tileU.first] = tileU.second;
+	}
+
+	if (setup.m_Settings.m_MergeColumnSpans)
+	{
+		ColumnSpanInput input;
+		input.count = columns.Size();
+		input.x = columns.m_X.data();
+		input.proxy = columns.m_Proxy.data();
+		input.normalX = columns.m_NormalX.data();
+		input.normalY = columns.m_NormalY.data();
+		input.distance = columns.m_Batch.distance.data();
+		input.top = columns.m_Batch.top.data();
+		input.bottom = columns.m_Batch.bottom.data();
+		input.u = columns.m_Batch.u.data();
+		input.color = reinterpret_cast<const std::uint8_t*>(columns.m_LitColor.data());
+
+		columns.m_SpanBuilder.Build(input, columns.m_Spans);
+	}
+}
+
+void WorldRaycastRendererImpl::SubmitFrame(sf::RenderTarget& target)
+{
+	if (!m_FrameInProgress) return;
+
+	if (!m_ShaderLoaded)
+	{
+		LoadShader();
+		m_ShaderLoaded = true;
+	}
+
+	// Columns are written into one big vertex array and drawn with as few glDrawArrays
+	// calls as possible. A batch only needs to be broken when the texture changes, or when
+	// it gets big enough that it's worth getting GL started on it while the rest of the
+	// frame is still being worked on.
+	// Each column is either a line down the middle of its pixels or, when merging columns
+	// into spans, part of a quad that covers all of its pixels.
+	class ColumnDrawer {
+	public:
+		ColumnDrawer(
+			sf::RenderTarget& target, 
+			sf::Shader& shader, 
+			const FramePacket& frame,
+			std::vector<ColumnVertex>& vertices,
+			const bool drawSpans,
+			const bool opaqueDepthPass,
+			const bool mipmaps)
+			: m_Target(target)
+			, m_Shader(shader)
+			, m_Vertices(vertices)
+			, m_Primitive(drawSpans ? GL_QUADS : GL_LINES)
+		{
+			m_DefaultTexture.create(1, 1);
+			// Make it white.
+			{
+				auto c = sf::Color::White;
+				m_DefaultTexture.update(&c.r);
+			}
+
+			m_Vertices.resize(0);
+
+			sf::Shader::bind(&m_Shader);
+			shader.setUniform("directionalLightDirection", B2VecToSFVec(frame.m_DirectionalLight.GetDirection()));
+			shader.setUniform("directionalLightColor", sf::Glsl::Vec4(frame.m_DirectionalLight.GetColor()));
+
+			shader.setUniform("fogColor", sf::Glsl::Vec4(frame.m_Fog.GetColor()));
+			shader.setUniform("fogMaxIntensity", frame.m_Fog.GetMaxIntensity());
+			shader.setUniform("fogMaxDistance", frame.m_Fog.GetMaxDistance());
+
+			shader.setUniform("maxMipLevel", mipmaps ? 1000.0f : 0.0f);
+			shader.setUniform("fogMinDistance", frame.m_Fog.GetMinDistance());
+
+			sf::Texture::bind(&m_DefaultTexture, sf::Texture::CoordinateType::Pixels);
+			shader.setUniform("texture", sf::Shader::CurrentTexture);
+
+			glCheck(glEnableClientState(GL_VERTEX_ARRAY));
+			glCheck(glEnableClientState(GL_COLOR_ARRAY));
+			glCheck(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
+			glCheck(glEnableClientState(GL_NORMAL_ARRAY));
+
+			if (opaqueDepthPass)
+			{
+				// Without a depth buffer the depth test passes everything, which would leave
+				// whatever got drawn last on top.
+				GLint depthBits = 0;
+				glCheck(glGetIntegerv(GL_DEPTH_BITS, &depthBits));
+
+				m_DepthTested = depthBits > 0;
+			}
+
+			if (m_DepthTested)
+			{
+				glCheck(glClear(GL_DEPTH_BUFFER_BIT));
+				glCheck(glEnable(GL_DEPTH_TEST));
+				// Equal, so that sprites flat against a wall still show.
+				glCheck(glDepthFunc(GL_LEQUAL));
+				glCheck(glDepthMask(GL_TRUE));
+			}
+		}
+
+		ColumnDrawer(const ColumnDrawer&) = delete;
+		ColumnDrawer& operator=(const ColumnDrawer&) = delete;
+
+		void DrawColumn(const ChunkColumns& columns, const unsigned i) {
+			BindTexture(columns.m_Texture[i]);
+
+			const ColumnBatch& batch = columns.m_Batch;
+
+			const float x = columns.m_X[i] + 0.5f;
+
+			const sf::Color color = columns.m_LitColor[i];
+
+			const float texelsPerPixel = GetColumnTexelsPerPixel(
+				columns.m_VTop[i], columns.m_VBottom[i], batch.top[i], batch.bottom[i]);
+
+			m_Vertices.push_back(MakeVertex(columns, i, x, batch.top[i], batch.distance[i], batch.u[i], columns.m_VTop[i], texelsPerPixel, color));
+			m_Vertices.push_back(MakeVertex(columns, i, x, batch.bottom[i], batch.distance[i], batch.u[i], columns.m_VBottom[i], texelsPerPixel, color));
+		}
+
+		void DrawSpan(const ChunkColumns& columns, const ColumnSpan& span) {
+			const unsigned first = span.first;
+			const unsigned last = span.last;
+
+			BindTexture(columns.m_Texture[first]);
+
+			const ColumnBatch& batch = columns.m_Batch;
+
+			struct Edge {
+				float x, top, bottom, distance, u;
+				sf::Color color;
+			};
+
+			Edge left{ columns.m_X[first], batch.top[first], batch.bottom[first], batch.distance[first], batch.u[first], columns.m_LitColor[first] };
+			Edge right{ columns.m_X[last] + 1.0f, batch.top[last], batch.bottom[last], batch.distance[last], batch.u[last], columns.m_LitColor[last] };
+
+			if (first != last)
+			{
+				// The first and last columns' values belong in the middle of their pixels, so
+				// carry them on for another half a pixel. Top and bottom are linear across the
+				// screen; distance, U and colour are linear after dividing by distance.
+				const float width = columns.m_X[last] - columns.m_X[first];
+
+				const auto extrapolate = [&](Edge& edge, const float t)
+				{
+					const auto lerp = [t](const float a, const float b) { return a + (b - a) * t; };
+
+					const float inverseDistance = lerp(1.0f / batch.distance[first], 1.0f / batch.distance[last]);
+
+					edge.distance = 1.0f / inverseDistance;
+					edge.top = lerp(batch.top[first], batch.top[last]);
+					edge.bottom = lerp(batch.bottom[first], batch.bottom[last]);
+					edge.u = lerp(batch.u[first] / batch.distance[first], batch.u[last] / batch.distance[last]) * edge.distance;
+
+					const auto channel = [&](const sf::Uint8 a, const sf::Uint8 b) {
+						const float c = lerp(a / batch.distance[first], b / batch.distance[last]) * edge.distance;
+						return (sf::Uint8)std::min(std::max(c + 0.5f, 0.0f), 255.0f);
+					};
+
+					const sf::Color& a = columns.m_LitColor[first];
+					const sf::Color& b = columns.m_LitColor[last];
+					edge.color = sf::Color(channel(a.r, b.r), channel(a.g, b.g), channel(a.b, b.b), channel(a.a, b.a));
+				};
+
+				extrapolate(left, -0.5f / width);
+				extrapolate(right, 1.0f + 0.5f / width);
+			}
+
+			// Each edge is as far away as its own column, so it gets its own mip level.
+			const float leftTexelsPerPixel = GetColumnTexelsPerPixel(
+				columns.m_VTop[first], columns.m_VBottom[first], left.top, left.bottom);
+			const float rightTexelsPerPixel = GetColumnTexelsPerPixel(
+				columns.m_VTop[first], columns.m_VBottom[first], right.top, right.bottom);
+
+			m_Vertices.push_back(MakeVertex(columns, first, left.x, left.top, left.distance, left.u, columns.m_VTop[first], leftTexelsPerPixel, left.color));
+			m_Vertices.push_back(MakeVertex(columns, first, right.x, right.top, right.distance, right.u, columns.m_VTop[first], rightTexelsPerPixel, right.color));
+			m_Vertices.push_back(MakeVertex(columns, first, right.x, right.bottom, right.distance, right.u, columns.m_VBottom[first], rightTexelsPerPixel, right.color));
+			m_Vertices.push_back(MakeVertex(columns, first, left.x, left.bottom, left.distance, left.u, columns.m_VBottom[first], leftTexelsPerPixel, left.color));
+		}
+
+		unsigned GetTextureBindCount() const { return m_TextureBindCount; }
+		unsigned GetVertexCount() const { return m_VertexCount; }
+
+		bool IsDepthTested() const { return m_DepthTested; }
+
+		// Translucent things still get hidden by opaque things in front, but mustn't hide
+		// anything themselves.
+		void BeginTranslucentPass()
+		{
+			Flush();
+
+			glCheck(glDepthMask(GL_FALSE));
+		}
+
+		// Particles are quads of plain colour, whether or not columns are being merged into
+		// spans, and translucent like everything that comes after the opaque pass.
+		void BeginParticlePass()
+		{
+			Flush();
+
+			m_Primitive = GL_QUADS;
+
+			BindTexture(nullptr);
+
+			if (m_DepthTested) {
+				glCheck(glDepthMask(GL_FALSE));
+			}
+		}
+
+		void DrawParticle(const ScreenParticle& particle, const sf::Vector2f& normal) {
+			const auto vertex = [&](const float x, const float y) {
+				ColumnVertex v;
+				v.position = sf::Vector3f(x, y, particle.depth);
+				v.normal = normal;
+				v.texCoords = sf::Vector3f(0.5f, 0.5f, 1.0f);
+				v.color = particle.color;
+				return v;
+			};
+
+			m_Vertices.push_back(vertex(particle.left, particle.top));
+			m_Vertices.push_back(vertex(particle.right, particle.top));
+			m_Vertices.push_back(vertex(particle.right, particle.bottom));
+			m_Vertices.push_back(vertex(particle.left, particle.bottom));
+		}
+
+		void FlushIfBig()
+		{
+			if (m_Vertices.size() >= sm_MinStreamedBatchSize) {
+				Flush();
+			}
+		}
+
+		~ColumnDrawer()
+		{
+			Flush();
+
+			if (m_DepthTested) {
+				glCheck(glDepthMask(GL_TRUE));
+			}
+
+			m_Target.resetGLStates();
+		}
+
+	private:
+		void BindTexture(const sf::Texture* texture)
+		{
+			if (texture == m_LastTexture) return;
+
+			// Everything so far uses the previous texture.
+			Flush();
+
+			m_LastTexture = texture;
+
+			const sf::Texture* textureToBind;
+
+			if (texture)
+			{
+				textureToBind = texture;
+			}
+			else
+			{
+				textureToBind = &m_DefaultTexture;
+			}
+
+			sf::Texture::bind(textureToBind, sf::Texture::CoordinateType::Pixels);
+			m_Shader.setUniform("texture", sf::Shader::CurrentTexture);
+
+			m_TextureBindCount++;
+		}
+
+		static ColumnVertex MakeVertex(
+			const ChunkColumns& columns,
+			const unsigned i,
+			const float x,
+			const float y,
+			const float distance,
+			const float u,
+			const float v,
+			const float texelsPerPixel,
+			const sf::Color color)
+		{
+			ColumnVertex vertex;
+			vertex.position = sf::Vector3f(x, y, distance);
+			vertex.normal = sf::Vector2f(columns.m_NormalX[i], columns.m_NormalY[i]);
+			vertex.texCoords = sf::Vector3f(u, v, texelsPerPixel);
+			vertex.color = color;
+			return vertex;
+		}
+
+		void Flush()
+		{
+			if (m_Vertices.empty()) return;
+
+			m_VertexCount += (unsigned)m_Vertices.size();
+
+			// Pointers have to be set each time; the vector may have moved since the last batch.
+			const ColumnVertex* first = m_Vertices.data();
+
+			glCheck(glVertexPointer(3, GL_FLOAT, sizeof(ColumnVertex), &first->position));
+			glCheck(glNormalPointer(GL_FLOAT, sizeof(ColumnVertex), &first->normal));
+			glCheck(glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(ColumnVertex), &first->color));
+			glCheck(glTexCoordPointer(3, GL_FLOAT, sizeof(ColumnVertex), &first->texCoords));
+
+			glCheck(glDrawArrays(m_Primitive, 0, (GLsizei)m_Vertices.size()));
+
+			m_Vertices.resize(0);
+		}
+
+		sf::RenderTarget& m_Target;
+		sf::Shader& m_Shader;
+
+		std::vector<ColumnVertex>& m_Vertices;
+
+		GLenum m_Primitive;
+
+		bool m_DepthTested = false;
+
+		const sf::Texture* m_LastTexture = nullptr;
+
+		unsigned m_TextureBindCount = 0;
+		unsigned m_VertexCount = 0;
+
+		// Flat white, like a coffee.
+		sf::Texture m_DefaultTexture;
+	};
+
+	const bool drawSpans = m_Setup.m_Settings.m_MergeColumnSpans;
+
+	unsigned intersectionCount = 0;
+	unsigned spanCount = 0;
+	unsigned opaqueCount = 0;
+	unsigned textureBindCount = 0;
+	unsigned vertexCount = 0;
+	bool depthTested = false;
+
+	// Draw each chunk as soon as it's ready, while the workers get on with the rest.
+	{
+		ColumnDrawer drawer(
+			target,
+			mShader,
+			m_Frame,
+			m_ColumnVertices,
+			drawSpans,
+			m_Setup.m_Settings.m_OpaqueDepthPass,
+			m_Setup.m_Settings.m_Mipmaps);
+
+		depthTested = drawer.IsDepthTested();
+
+		// Items are spans, or single columns when not merging.
+		const auto getItemCount = [drawSpans](const ChunkColumns& columns) {
+			return drawSpans ? (unsigned)columns.m_Spans.size() : columns.Size();
+		};
+
+		const auto isOpaque = [drawSpans](const ChunkColumns& columns, const unsigned item) {
+			return columns.m_Opaque[drawSpans ? columns.m_Spans[item].first : item] != 0;
+		};
+
+		const auto drawItem = [drawSpans, &drawer](const ChunkColumns& columns, const unsigned item) {
+			if (drawSpans) {
+				drawer.DrawSpan(columns, columns.m_Spans[item]);
+			}
+			else {
+				drawer.DrawColumn(columns, item);
+			}
+		};
+
+		m_TranslucentItems.resize(0);
+
+		for (unsigned chunkIndex = 0; chunkIndex < m_Frame.m_ChunkColumns.size(); ++chunkIndex)
+		{
+			WaitForChunk(chunkIndex);
+
+			const ChunkColumns& columns = m_Frame.m_ChunkColumns[chunkIndex];
+
+			const unsigned itemCount = getItemCount(columns);
+
+			if (depthTested)
+			{
+				// Items are in back-to-front order, so going backwards draws opaque things
+				// nearest first, and the depth test skips shading whatever they hide.
+				for (unsigned item = itemCount; item-- > 0;)
+				{
+					if (isOpaque(columns, item))
+					{
+						drawItem(columns, item);
+						opaqueCount++;
+					}
+				}
+
+				for (unsigned item = 0; item < itemCount; ++item)
+				{
+					if (!isOpaque(columns, item))
+					{
+						m_TranslucentItems.emplace_back(chunkIndex, item);
+					}
+				}
+			}
+			else
+			{
+				for (unsigned item = 0; item < itemCount; ++item)
+				{
+					drawItem(columns, item);
+				}
+			}
+
+			spanCount += itemCount;
+			intersectionCount += columns.Size();
 
-		static const unsigned sm_MaxNumIntersections = 32;
+			drawer.FlushIfBig();
+		}
 
-		std::array<RayIntersection, sm_MaxNumIntersections> m_Intersections;
+		if (depthTested)
+		{
+			drawer.BeginTranslucentPass();
 
-		unsigned m_IntersectionCount = 0;
-		unsigned m_Index = 0;
-	};
+			// Back to front, so they blend properly over each other.
+			for (const auto& chunkAndItem : m_TranslucentItems)
+			{
+				drawItem(m_Frame.m_ChunkColumns[chunkAndItem.first], chunkAndItem.second);
 
-	std::vector<RaycastCallback> m_RaycastCallbacks;
+				drawer.FlushIfBig();
+			}
+		}
 
-	std::vector<RaycastCallback::RayIntersection> m_AllIntersections;
-
-	struct Column {
-		float m_Top;
-		float m_Bottom;
-		float m_X;
-		float m_Distance;
-		float m_U;
-		float m_VTop;
-		float m_VBottom;
-		sf::Color m_BlendColor;
-		sf::Vector2f m_Normal;
-		const sf::Texture* m_Texture;
-	};
+		// Every chunk is ready by now, so the column depth buffer is complete.
+		ProjectParticles();
 
-	std::vector<Column> m_AllColumns;
+		if (!m_ScreenParticles.empty())
+		{
+			drawer.BeginParticlePass();
 
-	sf::Shader mShader;
+			// Like billboards, they face the camera.
+			const sf::Vector2f normal = B2VecToSFVec(-m_Setup.m_CameraForwards);
 
-	void LoadShader();
+			for (const ScreenParticle& particle : m_ScreenParticles)
+			{
+				drawer.DrawParticle(particle, normal);
 
-public:
-	WorldRaycastRendererImpl()
-	{
-		LoadShader();
+				drawer.FlushIfBig();
+			}
+		}
+
+		textureBindCount = drawer.GetTextureBindCount();
+		vertexCount = drawer.GetVertexCount();
 	}
-	void Render(const World& world, const Camera3D& camera, const RenderSettings& settings, sf::RenderTarget& target);
-};
 
-void WorldRaycastRendererImpl::Render(const World & world, const Camera3D & camera, const RenderSettings& settings, sf::RenderTarget & target)
+	FinishFrame(intersectionCount);
+
+	m_LastFrameStats.m_TextureBindCount = textureBindCount;
+	m_LastFrameStats.m_PrimitiveCount = spanCount;
+	m_LastFrameStats.m_OpaqueDepthPass = depthTested;
+	m_LastFrameStats.m_OpaquePrimitiveCount = opaqueCount;
+	m_LastFrameStats.m_VertexCount = vertexCount;
+	m_LastFrameStats.m_ParticleCount = (unsigned)m_ScreenParticles.size();
+}
+
+void WorldRaycastRendererImpl::SubmitFrame(sf::Image& image)
 {
-	assert(world.GetPhysicsWorld());
+	if (!m_FrameInProgress) return;
 
-	const auto targetWidth = target.getSize().x;
+	// Everything has to be ready before the textures can be gathered up.
+	m_WorkerPool->Wait();
 
-	if (m_RaycastCallbacks.size() != targetWidth)
+	const unsigned width = m_Frame.m_TargetSize.x;
+	const unsigned height = m_Frame.m_TargetSize.y;
+
+	if (image.getSize() != m_Frame.m_TargetSize) {
+		image.create(width, height, sf::Color::Black);
+	}
+
+	// Throw away copies of textures that are gone or have changed.
+	for (auto it = m_SoftwareTextures.begin(); it != m_SoftwareTextures.end();)
 	{
-		m_RaycastCallbacks.resize(targetWidth);
+		const SoftwareTexture& copy = it->second;
 
-		m_AllIntersections.reserve(targetWidth * RaycastCallback::sm_MaxNumIntersections);
+		const bool stale = copy.m_AtlasPage ?
+			copy.m_AtlasVersion != m_TextureAtlas.GetVersion() :
+			copy.m_Original.expired() || copy.m_Mipmaps != m_Setup.m_Settings.m_Mipmaps;
 
-		m_AllColumns.reserve(m_AllIntersections.size());
+		if (stale) {
+			it = m_SoftwareTextures.erase(it);
+		}
+		else {
+			++it;
+		}
 	}
 
-	m_AllIntersections.resize(0);
-	m_AllColumns.resize(0);
+	unsigned intersectionCount = 0;
 
-	// This is a bit grim.
-	for (unsigned i = 0; i < m_RaycastCallbacks.size(); ++i)
+	// Copying textures might need GL, so it's done here rather than on the workers.
+	for (ChunkColumns& columns : m_Frame.m_ChunkColumns)
 	{
-		m_RaycastCallbacks[i].m_Index = i;
-		m_RaycastCallbacks[i].m_IntersectionCount = 0;
-	}
+		columns.m_SoftwareTexture.resize(columns.Size());
 
-	auto DoRaycast = [&](RaycastCallback& cb)
-	{
-		const b2World& physicsWorld = *world.GetPhysicsWorld();
+		const sf::Texture* lastTexture = nullptr;
+		const ColumnMajorTexture* lastCopy = nullptr;
 
-		const auto cameraPosition = camera.GetPosition();
-		const auto cameraForwards = camera.GetForwards();
-		const float screenXDelta = 2.0f / (float)targetWidth;
+		for (unsigned i = 0; i < columns.Size(); ++i)
+		{
+			const sf::Texture* texture = columns.m_Texture[i];
 
-		const float viewPlaneWidthModifier = camera.GetViewPlaneWidthModifier();
-		// The 'view plane' vector is the camera's right-vector, stretched/squashed a bit:
-		const b2Vec2 viewPlane(
-			cameraForwards.y * viewPlaneWidthModifier * (-1),
-			cameraForwards.x * viewPlaneWidthModifier);
+			if (texture && texture != lastTexture)
+			{
+				lastTexture = texture;
+				lastCopy = GetSoftwareTexture(texture, columns.m_Proxy[i]);
+			}
 
-		// Cheeky wee lambda to calculate the end point of the ray.
-		const auto rayEnd = [&]()
-		{
-			const auto screenX = -1.0f + screenXDelta * cb.m_Index;
-			auto rayDir = (cameraForwards + (screenX * viewPlane));
-			rayDir.Normalize();
-			return cameraPosition + (settings.m_RayLength * rayDir);
-		}();
+			columns.m_SoftwareTexture[i] = texture ? lastCopy : nullptr;
+		}
 
-		physicsWorld.RayCast(&cb, cameraPosition, rayEnd);
-	};
+		intersectionCount += columns.Size();
+	}
 
-	std::for_each(
-		m_RaycastCallbacks.begin(),
-		m_RaycastCallbacks.end(),
-		DoRaycast);
+	ProjectParticles();
 
-	// shove all intersections into one big array
-	for (const auto& raycastCallback : m_RaycastCallbacks)
+	// Hand each particle to the chunks it covers, keeping them in order.
+	for (unsigned p = 0; p < m_ScreenParticles.size(); ++p)
 	{
-		const auto begin = std::begin(raycastCallback.m_Intersections);
-		const auto end = begin + raycastCallback.m_IntersectionCount;
+		const ScreenParticle& particle = m_ScreenParticles[p];
 
-		m_AllIntersections.insert(
-			std::end(m_AllIntersections),
-			begin,
-			end);
+		// Columns whose centres are in [left, right), like RasterizeColumn does rows.
+		const int firstColumn = std::max((int)std::ceil(particle.left - 0.5f), 0);
+		const int endColumn = std::min((int)std::ceil(particle.right - 0.5f), (int)width);
+
+		if (firstColumn >= endColumn) continue;
+
+		const unsigned firstChunk = (unsigned)firstColumn / sm_RaycastChunkSize;
+		const unsigned lastChunk = (unsigned)(endColumn - 1) / sm_RaycastChunkSize;
+
+		for (unsigned chunk = firstChunk; chunk <= lastChunk; ++chunk) {
+			m_Frame.m_ChunkColumns[chunk].m_Particles.push_back(p);
+		}
 	}
-	
-	using RayIntersection = RaycastCallback::RayIntersection;
 
-	// sort by distance such that further away intersections come first
-	std::sort(
-		m_AllIntersections.begin(),
-		m_AllIntersections.end(),
-		[](const RayIntersection& a, const RayIntersection& b)
+	const auto toFloats = [](const sf::Color& color, float* out) {
+		out[0] = color.r / 255.0f;
+		out[1] = color.g / 255.0f;
+		out[2] = color.b / 255.0f;
+		out[3] = color.a / 255.0f;
+	};
+
+	// The ambient light is already in the columns' colours, along with any point lights.
+	ColumnLighting lighting;
+	toFloats(m_Frame.m_DirectionalLight.GetColor(), lighting.directionalColor);
+	lighting.directionalDirection[0] = m_Frame.m_DirectionalLight.GetDirection().x;
+	lighting.directionalDirection[1] = m_Frame.m_DirectionalLight.GetDirection().y;
+	toFloats(m_Frame.m_Fog.GetColor(), lighting.fogColor);
+	lighting.fogMinDistance = m_Frame.m_Fog.GetMinDistance();
+	lighting.fogMaxDistance = m_Frame.m_Fog.GetMaxDistance();
+	lighting.fogMaxIntensity = m_Frame.m_Fog.GetMaxIntensity();
+
+	m_SoftwareColumns.resize(4 * width * height);
+	m_SoftwarePixels.resize(4 * width * height);
+
+	const std::uint8_t* pixels = image.getPixelsPtr();
+
+	// Each chunk is a band of screen columns, and only ever touches its own columns' pixels.
+	m_WorkerPool->ParallelFor(
+		width,
+		sm_RaycastChunkSize,
+		[this, pixels, &lighting](const unsigned begin, const unsigned end)
 	{
-		return (a.m_fraction > b.m_fraction);
+		RasterizeChunk(begin, end, pixels, lighting);
 	});
 
-	const auto targetSize = target.getSize();
+	if (width > 0 && height > 0) {
+		image.create(width, height, m_SoftwarePixels.data());
+	}
 
-	auto Prepare = [targetSize, &camera](const RayIntersection& intersection) -> Column
-	{
-		const auto& renderData =
-			*(qvr::FixtureRenderData*)(intersection.m_fixture->GetUserData());
+	FinishFrame(intersectionCount);
 
-		const b2Vec2 displacement = intersection.m_point - camera.GetPosition();
-		const float  distance = b2Dot(displacement, camera.GetForwards());
+	m_LastFrameStats.m_TextureBindCount = 0;
+	m_LastFrameStats.m_PrimitiveCount = intersectionCount;
+	m_LastFrameStats.m_OpaqueDepthPass = false;
+	m_LastFrameStats.m_OpaquePrimitiveCount = 0;
+	m_LastFrameStats.m_VertexCount = 0;
+	m_LastFrameStats.m_ParticleCount = (unsigned)m_ScreenParticles.size();
+}
 
-		// At a distance of 1 metre, a vertical metre is enough pixels in height to fill the screen.
-		const float oneMetreInPixels = abs(targetSize.y / distance);
+const ColumnMajorTexture* WorldRaycastRendererImpl::GetSoftwareTexture(
+	const sf::Texture* texture,
+	const int proxySlot)
+{
+	const auto it = m_SoftwareTextures.find(texture);
 
-		const float lineOffset = [&renderData, &camera, oneMetreInPixels]()
-		{
-			const float groundOffset = renderData.GetGroundOffset()    * oneMetreInPixels;
-			const float heightOffset = (renderData.GetHeight() - 1.0f) * oneMetreInPixels;
-			const float cameraHeightOffset = camera.GetHeightOffset() * 2.0f * oneMetreInPixels;
+	if (it != m_SoftwareTextures.end()) return &it->second.m_Texels;
 
-			return -groundOffset - heightOffset - cameraHeightOffset;
-		}();
+	SoftwareTexture& copy = m_SoftwareTextures[texture];
 
-		const float cameraPitchOffset = (float)GetPitchOffsetInPixels(camera, targetSize.y);
+	// The snapshot swaps the proxy's own texture for an atlas page when it's on one.
+	const std::shared_ptr<sf::Texture>& original =
+		m_Setup.GetRenderData(proxySlot).GetSharedTexture();
 
-		const float lineHeight = renderData.GetHeight() * oneMetreInPixels;
-		const float lineStartY = ((targetSize.y - lineHeight + lineOffset) / 2) + cameraPitchOffset;
-		const float lineEndY = ((targetSize.y + lineHeight + lineOffset) / 2) + cameraPitchOffset;
+	if (original.get() == texture) {
+		copy.m_Original = original;
+	}
+	else {
+		copy.m_AtlasPage = true;
+		copy.m_AtlasVersion = m_TextureAtlas.GetVersion();
+	}
 
-		const Animation::Rect textureRect = 
-			renderData.GetViews().viewCount <= 1 ?
-			renderData.GetViews().views[0] :
-			CalculateView(
-				renderData.GetViews(),
-				renderData.GetObjectAngle(),
-				[&camera, &renderData]() {
-					const b2Vec2 disp = renderData.GetSpritePosition() - camera.GetPosition();
-					return b2Atan2(disp.y, disp.x) + b2_pi;
-				}());
+	const sf::Image image = texture->copyToImage();
 
-		auto CalculateU = [&camera](
-			const b2Vec2& hitPoint,
-			const b2Vec2& flatSpritePos,
-			const float flatSpriteRadius,
-			const Animation::Rect& textureRect)
-		{
-			const b2Vec2 perp(-camera.GetForwards().y, camera.GetForwards().x);
+	copy.m_Texels.Assign(image.getSize().x, image.getSize().y, image.getPixelsPtr());
 
-			const b2Vec2 left = flatSpritePos - (flatSpriteRadius * perp);
+	// Like the original, which the TextureLibrary gave mips. Atlas pages don't have any.
+	if (!copy.m_AtlasPage && m_Setup.m_Settings.m_Mipmaps) {
+		copy.m_Texels.GenerateMips();
+		copy.m_Mipmaps = true;
+	}
 
-			float u = (hitPoint - left).Length() / (flatSpriteRadius * 2);
+	return &copy.m_Texels;
+}
 
-			// Convert to texels.
-			u *= textureRect.right - textureRect.left;
-			u += textureRect.left;
+void WorldRaycastRendererImpl::RasterizeChunk(
+	const unsigned begin,
+	const unsigned end,
+	const std::uint8_t* pixels,
+	const ColumnLighting& lighting)
+{
+	const unsigned width = m_Frame.m_TargetSize.x;
+	const unsigned height = m_Frame.m_TargetSize.y;
 
-			return u;
-		};
+	ChunkColumns& columns = m_Frame.m_ChunkColumns[begin / sm_RaycastChunkSize];
+	const ColumnBatch& batch = columns.m_Batch;
 
-		const float u = CalculateU(
-			intersection.m_point,
-			renderData.GetSpritePosition(),
-			renderData.GetSpriteRadius(),
-			textureRect);
-
-		Column output;
-		output.m_BlendColor = renderData.GetColor();
-		output.m_Texture = renderData.GetTexture();
-		output.m_X = (float)intersection.m_screenX;
-		output.m_Top = lineStartY;
-		output.m_Bottom = lineEndY;
-		output.m_Distance = distance;
-		output.m_U = u;
-		output.m_VTop = (float)textureRect.top;
-		output.m_VBottom = (float)textureRect.bottom;
-		output.m_Normal = sf::Vector2f(intersection.m_normal.x, intersection.m_normal.y);
-		return output;
-	};
+	// Sort the hits by screen column, keeping them in back-to-front order within each one.
+	std::array<unsigned, sm_RaycastChunkSize + 1> columnStart{};
 
-	std::transform(
-		m_AllIntersections.begin(),
-		m_AllIntersections.end(),
-		std::back_inserter(m_AllColumns),
-		Prepare);
+	for (unsigned i = 0; i < columns.Size(); ++i) {
+		columnStart[(unsigned)columns.m_X[i] - begin + 1]++;
+	}
 
-	class ColumnDrawer {
-	public:
-		ColumnDrawer(sf::RenderTarget& target, sf::Shader& shader, const World& world)
-			: m_Target(target)
-			, m_Shader(shader)
+	std::partial_sum(columnStart.begin(), columnStart.end(), columnStart.begin());
+
+	std::array<unsigned, sm_RaycastChunkSize + 1> columnFill = columnStart;
+
+	columns.m_RasterHits.resize(columns.Size());
+
+	for (unsigned i = 0; i < columns.Size(); ++i)
+	{
+		RasterHit& hit = columns.m_RasterHits[columnFill[(unsigned)columns.m_X[i] - begin]++];
+
+		hit.top = batch.top[i];
+		hit.bottom = batch.bottom[i];
+		hit.distance = batch.distance[i];
+		hit.u = batch.u[i];
+		hit.vTop = columns.m_VTop[i];
+		hit.vBottom = columns.m_VBottom[i];
+		hit.normalX = columns.m_NormalX[i];
+		hit.normalY = columns.m_NormalY[i];
+		hit.color[0] = columns.m_LitColor[i].r;
+		hit.color[1] = columns.m_LitColor[i].g;
+		hit.color[2] = columns.m_LitColor[i].b;
+		hit.color[3] = columns.m_LitColor[i].a;
+		hit.texture = columns.m_SoftwareTexture[i];
+	}
+
+	for (unsigned x = begin; x < end; ++x)
+	{
+		std::uint8_t* column = &m_SoftwareColumns[4 * x * height];
+
+		for (unsigned y = 0; y < height; ++y) {
+			std::copy_n(pixels + 4 * (y * width + x), 4, column + 4 * y);
+		}
+
+		const unsigned first = columnStart[x - begin];
+
+		RasterizeColumn(
+			column,
+			height,
+			columns.m_RasterHits.data() + first,
+			columnStart[x - begin + 1] - first,
+			lighting);
+
+		// Particles go over everything else, but behind anything that hides the rest of
+		// the column, which here can be tested column by column.
+		columns.m_ParticleHits.resize(0);
+
+		for (const unsigned p : columns.m_Particles)
 		{
-			m_DefaultTexture.create(1, 1);
-			// Make it white.
-			{
-				auto c = sf::Color::White;
-				m_DefaultTexture.update(&c.r);
-			}
+			const ScreenParticle& particle = m_ScreenParticles[p];
+
+			const float centre = x + 0.5f;
+
+			if (centre < particle.left || centre >= particle.right) continue;
+			if (particle.depth >= m_ColumnDepth[x]) continue;
+
+			RasterHit hit;
+			hit.top = particle.top;
+			hit.bottom = particle.bottom;
+			hit.distance = particle.depth;
+			hit.u = 0.0f;
+			hit.vTop = 0.0f;
+			hit.vBottom = 0.0f;
+			hit.normalX = -m_Setup.m_CameraForwards.x;
+			hit.normalY = -m_Setup.m_CameraForwards.y;
+			hit.color[0] = particle.color.r;
+			hit.color[1] = particle.color.g;
+			hit.color[2] = particle.color.b;
+			hit.color[3] = particle.color.a;
+			hit.texture = nullptr;
+
+			columns.m_ParticleHits.push_back(hit);
+		}
 
-			sf::Shader::bind(&m_Shader);
-			shader.setUniform("ambientLightColor", sf::Glsl::Vec4(world.GetAmbientLight().mColor));
+		RasterizeColumn(
+			column,
+			height,
+			columns.m_ParticleHits.data(),
+			(unsigned)columns.m_ParticleHits.size(),
+			lighting);
+
+		for (unsigned y = 0; y < height; ++y) {
+			std::copy_n(column + 4 * y, 4, &m_SoftwarePixels[4 * (y * width + x)]);
+		}
+	}
+}
 
-			shader.setUniform("directionalLightDirection", B2VecToSFVec(world.GetDirectionalLight().GetDirection()));
-			shader.setUniform("directionalLightColor", sf::Glsl::Vec4(world.GetDirectionalLight().GetColor()));
+void WorldRaycastRendererImpl::FinishFrame(const unsigned intersectionCount)
+{
+	m_WorkerPool->Wait();
 
-			shader.setUniform("fogColor", sf::Glsl::Vec4(world.GetFog().GetColor()));
-			shader.setUniform("fogMaxIntensity", world.GetFog().GetMaxIntensity());
-			shader.setUniform("fogMaxDistance", world.GetFog().GetMaxDistance());
-			shader.setUniform("fogMinDistance", world.GetFog().GetMinDistance());
+	m_FrameInProgress = false;
 
-			sf::Texture::bind(&m_DefaultTexture, sf::Texture::CoordinateType::Pixels);
-			shader.setUniform("texture", sf::Shader::CurrentTexture);
+	// From BeginFrame to the last chunk, whatever the caller got up to in between.
+	sRaycastProfiler.AddSample(
+		std::chrono::duration_cast<Profiler::SampleUnit>(
+			std::chrono::steady_clock::now() - m_Setup.m_StartTime));
 
-			glCheck(glEnableClientState(GL_VERTEX_ARRAY));
-			glCheck(glEnableClientState(GL_COLOR_ARRAY));
-			glCheck(glEnableClientState(GL_TEXTURE_COORD_ARRAY));
-			glCheck(glEnableClientState(GL_NORMAL_ARRAY));
+	float totalRayLength = 0.0f;
+	unsigned sectorClippedCount = 0;
 
-			glCheck(glVertexPointer(3, GL_FLOAT, sizeof(Vertex), &line[0].position));
-			glCheck(glNormalPointer(GL_FLOAT, sizeof(Vertex), &line[0].normal));
-			glCheck(glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &line[0].color));
-			glCheck(glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &line[0].texCoords));
+	for (const auto& raycastCallback : m_RaycastCallbacks)
+	{
+		totalRayLength += raycastCallback.m_RayLength;
+
+		if (raycastCallback.m_SectorFraction < 1.0f) {
+			sectorClippedCount++;
 		}
+	}
 
-		void operator()(const Column& column) {
-			if (column.m_Texture != m_LastTexture) {
-				m_LastTexture = column.m_Texture;
+	const unsigned targetWidth = m_Frame.m_TargetSize.x;
+
+	m_LastFrameStats.m_RayLength = m_Setup.m_Settings.m_RayLength;
+	m_LastFrameStats.m_AverageRayLength = targetWidth > 0 ? totalRayLength / targetWidth : 0.0f;
+	m_LastFrameStats.m_ColumnCount = targetWidth;
+	m_LastFrameStats.m_IntersectionCount = intersectionCount;
+	m_LastFrameStats.m_SectorClippedColumnCount = sectorClippedCount;
+	m_LastFrameStats.m_BillboardCount = (unsigned)m_Setup.m_Billboards.size();
+	m_LastFrameStats.m_PointLightCount = m_Setup.m_PointLights.GetVisibleLightCount();
+	m_LastFrameStats.m_MaxPointLightsPerCluster = m_Setup.m_PointLights.GetMaxLightsInACluster();
+	m_LastFrameStats.m_DroppedPointLightCount = m_Setup.m_PointLights.GetDroppedCount();
+	m_LastFrameStats.m_BillboardColumnCount = std::accumulate(
+		m_Frame.m_ChunkBillboardColumns.begin(),
+		m_Frame.m_ChunkBillboardColumns.end(),
+		0u);
+	m_LastFrameStats.m_PrepareTime = std::accumulate(
+		m_Frame.m_ChunkPrepareTime.begin(),
+		m_Frame.m_ChunkPrepareTime.end(),
+		0.0f);
+	m_LastFrameStats.m_AtlasPageCount = m_Setup.m_UseTextureAtlas ? m_TextureAtlas.GetPageCount() : 0;
+}
 
-				const sf::Texture* textureToBind;
+unsigned WorldRaycastRendererImpl::FindDynamicColumns(
+	const RenderProxyIndex& renderProxies,
+	const b2Vec2& cameraPosition,
+	const b2Vec2& cameraForwards,
+	const b2Vec2& viewPlane,
+	const float maxDistance)
+{
+	const int columnCount = (int)m_RaycastCallbacks.size();
 
-				if (column.m_Texture)
-				{
-					textureToBind = column.m_Texture;
-				}
-				else
-				{
-					textureToBind = &m_DefaultTexture;
-				}
+	// Each box adds 1 where its columns start and takes 1 away just after they end. Adding
+	// these up from left to right gives the number of boxes over each column.
+	m_DynamicColumns.assign(columnCount + 1, 0);
 
-				sf::Texture::bind(textureToBind, sf::Texture::CoordinateType::Pixels);
-				m_Shader.setUniform("texture", sf::Shader::CurrentTexture);
-			}
+	const float screenXDelta = 2.0f / (float)columnCount;
+	const float viewPlaneLengthSquared = viewPlane.LengthSquared();
+
+	renderProxies.ForEachDynamicBounds([&](const b2AABB& aabb)
+	{
+		const b2Vec2 corners[4] = {
+			aabb.lowerBound,
+			b2Vec2(aabb.upperBound.x, aabb.lowerBound.y),
+			aabb.upperBound,
+			b2Vec2(aabb.lowerBound.x, aabb.upperBound.y)
+		};
+
+		float minScreenX = b2_maxFloat;
+		float maxScreenX = -b2_maxFloat;
+		float minDistance = b2_maxFloat;
+		bool anyBehind = false;
+		bool allBehind = true;
+
+		for (const b2Vec2& corner : corners)
+		{
+			const b2Vec2 relative = corner - cameraPosition;
+			const float distance = b2Dot(relative, cameraForwards);
 
-			line[0].position.x = column.m_X;
-			line[1].position.x = column.m_X;
-			line[0].position.y = column.m_Top;
-			line[1].position.y = column.m_Bottom;
-			line[0].position.z = column.m_Distance;
-			line[1].position.z = column.m_Distance;
+			minDistance = std::min(minDistance, distance);
 
-			line[0].normal = column.m_Normal;
-			line[1].normal = column.m_Normal;
+			if (distance <= 0.0f) {
+				anyBehind = true;
+				continue;
+			}
 
-			line[0].color = column.m_BlendColor;
-			line[1].color = column.m_BlendColor;
+			allBehind = false;
 
-			line[0].texCoords.x = column.m_U;
-			line[0].texCoords.y = column.m_VTop;
-			line[1].texCoords.x = column.m_U;
-			line[1].texCoords.y = column.m_VBottom;
+			// The inverse of RayEnd: the ray for screenX points along forwards + screenX * viewPlane.
+			const float screenX = b2Dot(relative, viewPlane) / (viewPlaneLengthSquared * distance);
 
-			// Draw the line.
-			glCheck(glDrawArrays(GL_LINES, 0, 2));
+			minScreenX = std::min(minScreenX, screenX);
+			maxScreenX = std::max(maxScreenX, screenX);
 		}
 
-		~ColumnDrawer()
+		if (allBehind || minDistance > maxDistance) return;
+
+		int first = 0;
+		int last = columnCount - 1;
+
+		// A box the camera is inside of (or level with) could be in front of any column.
+		if (!anyBehind)
 		{
-			m_Target.resetGLStates();
-		}
+			if (maxScreenX < -1.0f || minScreenX > 1.0f) return;
 
-	private:
-		sf::RenderTarget& m_Target;
-		sf::Shader& m_Shader;
+			first = std::max(first, (int)std::floor((minScreenX + 1.0f) / screenXDelta));
+			last = std::min(last, (int)std::ceil((maxScreenX + 1.0f) / screenXDelta));
+		}
 
-		const sf::Texture* m_LastTexture = nullptr;
+		m_DynamicColumns[first]++;
+		m_DynamicColumns[last + 1]--;
+	});
 
-		// Flat white, like a coffee.
-		sf::Texture m_DefaultTexture;
+	unsigned dynamicColumnCount = 0;
+	int boxCount = 0;
 
-		struct Vertex {
-			sf::Vector3f position;
-			sf::Vector2f normal;
-			sf::Vector2f texCoords;
-			sf::Color color;
-		};
+	for (int columnIndex = 0; columnIndex < columnCount; ++columnIndex)
+	{
+		boxCount += m_DynamicColumns[columnIndex];
+		m_DynamicColumns[columnIndex] = boxCount;
 
-		// Maybe use a custom vertex type in future.
-		Vertex line[2];
-	};
+		if (boxCount > 0) dynamicColumnCount++;
+	}
 
-	std::for_each(
-		m_AllColumns.begin(),
-		m_AllColumns.end(),
-		ColumnDrawer(target, mShader, world));
+	return dynamicColumnCount;
 }
 
-float32 WorldRaycastRendererImpl::RaycastCallback::ReportFixture(b2Fixture * fixture, const b2Vec2 & point, const b2Vec2 & normal, float32 fraction)
+WorkerPool& WorldRaycastRendererImpl::GetWorkerPool(const RenderSettings& settings)
 {
-	if (fixture->GetUserData() == nullptr)
+	const unsigned desiredThreadCount =
+		settings.m_RaycastThreadCount > 0 ?
+		(unsigned)settings.m_RaycastThreadCount :
+		WorkerPool::GetHardwareThreadCount();
+
+	if (!m_WorkerPool || m_WorkerPool->GetThreadCount() != desiredThreadCount)
 	{
-		return 1;
+		m_WorkerPool = std::make_unique<WorkerPool>(desiredThreadCount);
+
+		if (auto log = spdlog::get("console"))
+		{
+			log->debug(
+				"WorldRaycastRenderer: Casting rays with {} thread(s).",
+				m_WorkerPool->GetThreadCount());
+		}
 	}
 
+	return *m_WorkerPool;
+}
+
+float32 WorldRaycastRendererImpl::RaycastCallback::ReportProxy(const FixtureRenderData& renderData, const int slot, const b2Vec2 & point, const b2Vec2 & normal, float32 fraction)
+{
+	const ProxySnapshot& proxy = m_Proxies[slot];
+
 	m_Intersections[m_IntersectionCount++] =
 	{
-		fixture,
+		slot,
 		point,
 		normal,
 		fraction,
 		(int)m_Index
 	};
 
+	// An opaque fixture hides everything behind it if it stands on the ground (everything
+	// behind it is further away, so its bottom edge is closer to the horizon) and its top is
+	// off the top of the screen.
+	if (proxy.m_Opaque && proxy.m_GroundOffset <= 0.0f)
+	{
+		float top, bottom;
+		m_Projection->GetTopAndBottom(
+			m_Projection->GetDistance(point),
+			proxy.m_Height,
+			proxy.m_GroundOffset,
+			top,
+			bottom);
+
+		if (top <= 0.0f && bottom >= m_Projection->GetHorizon())
+		{
+			m_MaxFraction = fraction;
+		}
+	}
+
 	if (m_IntersectionCount >= m_Intersections.size())
 	{
-		return 0;
+		RemoveOccluded();
+
+		if (m_IntersectionCount >= m_Intersections.size())
+		{
+			return 0;
+		}
+	}
+
+	// Not 1: that would undo the clipping.
+	return m_MaxFraction;
+}
+
+void WorldRaycastRendererImpl::RaycastCallback::RemoveOccluded()
+{
+	const auto begin = m_Intersections.begin();
+	const auto end = begin + m_IntersectionCount;
+
+	const auto newEnd = std::remove_if(
+		begin,
+		end,
+		[this](const RayIntersection& intersection)
+	{
+		return intersection.m_fraction > m_MaxFraction;
+	});
+
+	m_IntersectionCount = (unsigned)(newEnd - begin);
+}
+
+void WorldRaycastRendererImpl::RaycastCallback::SaveStatic()
+{
+	RemoveOccluded();
+
+	for (unsigned i = 0; i < m_IntersectionCount; ++i)
+	{
+		RayIntersection& saved = m_StaticIntersections[i];
+		saved = m_Intersections[i];
+
+		if (saved.m_Proxy >= m_TileSlotBase) {
+			saved.m_Proxy = -1 - (saved.m_Proxy - m_TileSlotBase);
+		}
+	}
+
+	m_StaticIntersectionCount = m_IntersectionCount;
+	m_StaticMaxFraction = m_MaxFraction;
+	m_StaticSectorFraction = m_SectorFraction;
+}
+
+void WorldRaycastRendererImpl::RaycastCallback::RestoreStatic()
+{
+	for (unsigned i = 0; i < m_StaticIntersectionCount; ++i)
+	{
+		RayIntersection& restored = m_Intersections[i];
+		restored = m_StaticIntersections[i];
+
+		if (restored.m_Proxy < 0) {
+			restored.m_Proxy = m_TileSlotBase + (-1 - restored.m_Proxy);
+		}
 	}
 
-	return 1;
+	m_IntersectionCount = m_StaticIntersectionCount;
+	m_MaxFraction = m_StaticMaxFraction;
+	m_SectorFraction = m_StaticSectorFraction;
 }
 
 void WorldRaycastRendererImpl::LoadShader() {
@@ -491,8 +2294,6 @@ void WorldRaycastRendererImpl::LoadShader() {
 	
 	#version 130
 
-	uniform vec4 ambientLightColor;
-
 	uniform vec4 directionalLightColor;
 	uniform vec2 directionalLightDirection;
 
@@ -500,33 +2301,36 @@ void WorldRaycastRendererImpl::LoadShader() {
 	uniform float fogMaxIntensity;
 	uniform float fogMaxDistance;
 	uniform float fogMinDistance;
+
+	// Anything closer than this gets the same depth.
+	const float nearDistance = 0.01f;
 	
-	out vec4 appliedFogColor;
+	out float columnDistance;
+	out float texelsPerPixel;
 	out vec4 appliedDirectionalLightColor;
 
 	void main() {
-		float fogIntensity = 
-			min(
-				((min(
-					max(
-						gl_Vertex.z, 
-						fogMinDistance), 
-					fogMaxDistance) 
-				- fogMinDistance) 
-				/ (fogMaxDistance - fogMinDistance)),
-				fogMaxIntensity);
-		appliedFogColor = fogColor * fogIntensity;
+		columnDistance = gl_Vertex.z;
+		texelsPerPixel = gl_MultiTexCoord0.z;
 
 		appliedDirectionalLightColor = 
 			directionalLightColor * 
 			clamp(dot(vec2(gl_Normal), -directionalLightDirection), 0.0f, 1.0f);
 
 		gl_Position = ftransform();
-		gl_Position.z = 0.0f;
+
+		// Depth for the opaque pass. It's affine in 1 / distance, so it interpolates linearly
+		// across wall spans just like the rest of the position does.
+		gl_Position.z = 1.0f - 2.0f * nearDistance / max(gl_Vertex.z, nearDistance);
+
+		// Scaling the whole thing by the distance leaves it in the same place on screen, but
+		// has GL interpolate perspective-correctly across wall spans.
+		gl_Position *= max(gl_Vertex.z, 0.0001f);
 		
-		gl_FrontColor = ambientLightColor * gl_Color;
+		// Already lit by the ambient light and any point lights.
+		gl_FrontColor = gl_Color;
 		
-		gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+		gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(gl_MultiTexCoord0.xy, 0.0f, 1.0f);
 	}
 
 	)";
@@ -536,14 +2340,40 @@ void WorldRaycastRendererImpl::LoadShader() {
 	#version 130	
 
 	uniform sampler2D texture;
+
+	uniform vec4 fogColor;
+	uniform float fogMaxIntensity;
+	uniform float fogMaxDistance;
+	uniform float fogMinDistance;
+
+	// 0 when RenderSettings::m_Mipmaps is off.
+	uniform float maxMipLevel;
 	
-	in vec4 appliedFogColor;
+	in float columnDistance;
+	in float texelsPerPixel;
 	in vec4 appliedDirectionalLightColor;
 
 	void main() {
+		// Per fragment, since distance isn't constant across a span.
+		float fogIntensity = 
+			min(
+				((min(
+					max(
+						columnDistance, 
+						fogMinDistance), 
+					fogMaxDistance) 
+				- fogMinDistance) 
+				/ (fogMaxDistance - fogMinDistance)),
+				fogMaxIntensity);
+		vec4 appliedFogColor = fogColor * fogIntensity;
+
 		vec4 blendColor = gl_Color;
 	
-		vec4 textureColor = texture2D(texture, gl_TexCoord[0].xy);
+		// The nearest level, as GetMipLevel picks for the software rasterizer. Textures without
+		// mips just get their only level.
+		float mipLevel = min(floor(log2(max(texelsPerPixel, 1.0f)) + 0.5f), maxMipLevel);
+
+		vec4 textureColor = textureLod(texture, gl_TexCoord[0].xy, mipLevel);
 	
 		gl_FragColor = (blendColor * textureColor) + appliedFogColor + appliedDirectionalLightColor;
 	}
@@ -566,7 +2396,120 @@ void WorldRaycastRenderer::Render(
 	const RenderSettings& settings,
 	sf::RenderTarget & target)
 {
-	m_Impl->Render(world, camera, settings, target);
+	BeginFrame(world, camera, settings, target.getSize());
+	SubmitFrame(target);
+}
+
+void WorldRaycastRenderer::BeginFrame(
+	const World& world,
+	const Camera3D& camera,
+	const RenderSettings& settings,
+	const sf::Vector2u targetSize)
+{
+	m_Impl->BeginFrame(world, camera, settings, targetSize);
+}
+
+void WorldRaycastRenderer::SubmitFrame(sf::RenderTarget& target)
+{
+	m_Impl->SubmitFrame(target);
+}
+
+void WorldRaycastRenderer::SubmitFrame(sf::Image& image)
+{
+	m_Impl->SubmitFrame(image);
+}
+
+auto WorldRaycastRenderer::GetLastFrameStats() const -> const FrameStats&
+{
+	return m_Impl->m_LastFrameStats;
+}
+
+void WorldRaycastRenderer::GuiPerformanceInfo() const
+{
+	const FrameStats& stats = GetLastFrameStats();
+
+	if (stats.m_ColumnCount == 0) {
+		ImGui::Text("Nothing rendered yet.");
+		return;
+	}
+
+	const float rayLengthSaved =
+		stats.m_RayLength > 0.0f ?
+		1.0f - (stats.m_AverageRayLength / stats.m_RayLength) :
+		0.0f;
+
+	ImGui::Text(
+		"Ray Length: %.1fm of %.1fm (%.0f%% culled by fog)",
+		stats.m_AverageRayLength,
+		stats.m_RayLength,
+		rayLengthSaved * 100.0f);
+
+	ImGui::Text(
+		"Intersections: %u (%.1f per column)",
+		stats.m_IntersectionCount,
+		(float)stats.m_IntersectionCount / stats.m_ColumnCount);
+
+	if (stats.m_Incremental)
+	{
+		ImGui::Text(
+			"Static Hits: %s",
+			stats.m_StaticCacheHit ? "Cached" : "Cast");
+
+		ImGui::Text(
+			"Dynamic Columns: %u (%.0f%%)",
+			stats.m_DynamicColumnCount,
+			100.0f * stats.m_DynamicColumnCount / stats.m_ColumnCount);
+	}
+	ImGui::Text("Prepare Time: %.3fms (all threads)", stats.m_PrepareTime);
+
+	if (stats.m_CameraSector >= 0)
+	{
+		ImGui::Text(
+			"Sectors: camera in #%d, %u columns cut short (%.0f%%)",
+			stats.m_CameraSector,
+			stats.m_SectorClippedColumnCount,
+			100.0f * stats.m_SectorClippedColumnCount / stats.m_ColumnCount);
+	}
+	else
+	{
+		ImGui::Text("Sectors: camera outside");
+	}
+
+	ImGui::Text(
+		"Billboards: %u on screen (%u columns)",
+		stats.m_BillboardCount,
+		stats.m_BillboardColumnCount);
+
+	ImGui::Text("Particles: %u on screen", stats.m_ParticleCount);
+
+	ImGui::Text(
+		"Point Lights: %u on screen, at most %u of %u per cluster (%u dropped)",
+		stats.m_PointLightCount,
+		stats.m_MaxPointLightsPerCluster,
+		PointLightClusters::sm_MaxLightsPerCluster,
+		stats.m_DroppedPointLightCount);
+
+	ImGui::Text(
+		"Primitives: %u (%u vertices)",
+		stats.m_PrimitiveCount,
+		stats.m_VertexCount);
+
+	if (stats.m_OpaqueDepthPass)
+	{
+		ImGui::Text(
+			"Opaque Pass: %u primitives, %u translucent",
+			stats.m_OpaquePrimitiveCount,
+			stats.m_PrimitiveCount - stats.m_OpaquePrimitiveCount);
+	}
+	else
+	{
+		ImGui::Text("Opaque Pass: Off");
+	}
+
+	ImGui::Text(
+		"Texture Binds: %u (%d atlas page(s))",
+		stats.m_TextureBindCount,
+		stats.m_AtlasPageCount);
 }
 
 }
\ No newline at end of file
@@ -2,10 +2,11 @@
 
 #include <memory>
 
-class b2World;
+#include <SFML/System/Vector2.hpp>
 
 namespace sf
 {
+class Image;
 class RenderTarget;
 }
 
@@ -23,6 +24,62 @@ public:
 	WorldRaycastRenderer();
 	~WorldRaycastRenderer();
 	void Render(const World& world, const Camera3D& camera, const RenderSettings& settings, sf::RenderTarget& target);
+
+	// Render in two halves. BeginFrame sets the worker threads casting rays and preparing
+	// columns, and returns straight away; SubmitFrame draws the columns as they come in.
+	// The caller can draw other things in between, but must not change the World.
+	void BeginFrame(const World& world, const Camera3D& camera, const RenderSettings& settings, const sf::Vector2u targetSize);
+	void SubmitFrame(sf::RenderTarget& target);
+
+	// Like SubmitFrame, but rasterizes the columns on the CPU, over whatever is already in the
+	// image, with the same lighting and fog as the shader. Doesn't touch GL unless a texture
+	// needs copying back from it, so it can run without a window once textures are cached
+	// (as long as RenderSettings::m_UseTextureAtlas is off).
+	void SubmitFrame(sf::Image& image);
+
+	struct FrameStats
+	{
+		// As set in the RenderSettings.
+		float m_RayLength = 0.0f;
+		// What the rays actually got, after fog culling.
+		float m_AverageRayLength = 0.0f;
+		unsigned m_ColumnCount = 0;
+		unsigned m_IntersectionCount = 0;
+		// CPU time spent turning intersections into columns, over all threads, in milliseconds.
+		float m_PrepareTime = 0.0f;
+		// See RenderSettings::m_IncrementalRaycast.
+		bool m_Incremental = false;
+		bool m_StaticCacheHit = false;
+		// Columns that were cast against dynamic proxies.
+		unsigned m_DynamicColumnCount = 0;
+		// The sector the camera was in (-1 if none), and the columns whose rays it cut short.
+		int m_CameraSector = -1;
+		unsigned m_SectorClippedColumnCount = 0;
+		// Billboards left after frustum culling, and the columns of them left after depth testing.
+		unsigned m_BillboardCount = 0;
+		unsigned m_BillboardColumnCount = 0;
+		// Point lights that might reach anything on screen, the most any cluster of columns had
+		// to look at, and how many times a full cluster left one out.
+		unsigned m_PointLightCount = 0;
+		unsigned m_MaxPointLightsPerCluster = 0;
+		unsigned m_DroppedPointLightCount = 0;
+		// Particles left after culling against the column depth buffer.
+		unsigned m_ParticleCount = 0;
+		// See RenderSettings::m_UseTextureAtlas.
+		unsigned m_TextureBindCount = 0;
+		int m_AtlasPageCount = 0;
+		// Lines, or quads when merging columns into spans. See RenderSettings::m_MergeColumnSpans.
+		unsigned m_PrimitiveCount = 0;
+		unsigned m_VertexCount = 0;
+		// See RenderSettings::m_OpaqueDepthPass. False if the target has no depth buffer.
+		bool m_OpaqueDepthPass = false;
+		unsigned m_OpaquePrimitiveCount = 0;
+	};
+
+	const FrameStats& GetLastFrameStats() const;
+
+	void GuiPerformanceInfo() const;
+
 private:
 	std::unique_ptr<WorldRaycastRendererImpl> m_Impl;
 };
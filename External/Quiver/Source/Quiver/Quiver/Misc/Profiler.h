@@ -26,6 +26,12 @@ public:
 		return mFront;
 	}
 
+	// The most recent sample, or zero if there aren't any yet.
+	SampleUnit GetLatest() const {
+		if (mFront == 0) return SampleUnit(0);
+		return samples[(mFront - 1) % samples.size()];
+	}
+
 	SampleUnit GetAverage() const {
 		const auto total =
 			std::accumulate(
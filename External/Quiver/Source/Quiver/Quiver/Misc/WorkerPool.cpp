@@ -0,0 +1,161 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace qvr
+{
+
+unsigned WorkerPool::GetHardwareThreadCount()
+{
+	// hardware_concurrency is allowed to return 0 if it can't tell.
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+WorkerPool::WorkerPool(const unsigned threadCount)
+{
+	const unsigned totalThreads = threadCount > 0 ? threadCount : GetHardwareThreadCount();
+
+	// The calling thread counts as one of them.
+	for (unsigned i = 1; i < totalThreads; ++i)
+	{
+		mThreads.emplace_back([this]() { WorkerMain(); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+
+	mWorkAvailable.notify_all();
+
+	for (auto& thread : mThreads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::ParallelFor(const unsigned count, const unsigned chunkSize, const RangeFunction& func)
+{
+	assert(chunkSize > 0);
+
+	if (count == 0) return;
+
+	// Not worth waking anybody up.
+	if (mThreads.empty() || count <= chunkSize)
+	{
+		func(0, count);
+		return;
+	}
+
+	Start(count, chunkSize, func);
+
+	ProcessChunks();
+
+	Finish();
+}
+
+void WorkerPool::ParallelForAsync(const unsigned count, const unsigned chunkSize, RangeFunction func)
+{
+	assert(chunkSize > 0);
+	assert(mFunc == nullptr);
+
+	mAsyncFunc = std::move(func);
+
+	Start(count, chunkSize, mAsyncFunc);
+}
+
+bool WorkerPool::RunChunk()
+{
+	assert(mFunc != nullptr);
+
+	const unsigned begin = mNextChunkBegin.fetch_add(mChunkSize);
+
+	if (begin >= mCount) return false;
+
+	const unsigned end = std::min(begin + mChunkSize, mCount);
+
+	(*mFunc)(begin, end);
+
+	return true;
+}
+
+void WorkerPool::Wait()
+{
+	if (mFunc == nullptr) return;
+
+	ProcessChunks();
+
+	Finish();
+
+	mAsyncFunc = nullptr;
+}
+
+void WorkerPool::Start(const unsigned count, const unsigned chunkSize, const RangeFunction& func)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		assert(mFunc == nullptr);
+
+		mFunc = &func;
+		mCount = count;
+		mChunkSize = chunkSize;
+		mNextChunkBegin = 0;
+		mBusyWorkerCount = (unsigned)mThreads.size();
+		mJobGeneration++;
+	}
+
+	if (!mThreads.empty()) {
+		mWorkAvailable.notify_all();
+	}
+}
+
+void WorkerPool::Finish()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	mWorkDone.wait(lock, [this]() { return mBusyWorkerCount == 0; });
+
+	mFunc = nullptr;
+}
+
+void WorkerPool::ProcessChunks()
+{
+	while (RunChunk()) {}
+}
+
+void WorkerPool::WorkerMain()
+{
+	unsigned lastGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mWorkAvailable.wait(lock, [this, lastGeneration]()
+			{
+				return mQuit || mJobGeneration != lastGeneration;
+			});
+
+			if (mQuit) return;
+
+			lastGeneration = mJobGeneration;
+		}
+
+		ProcessChunks();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBusyWorkerCount--;
+		}
+
+		mWorkDone.notify_one();
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace qvr
+{
+
+// A fixed set of worker threads that can be handed a range of indices to chew through.
+// The thread that calls ParallelFor takes part in the work, so a WorkerPool with a thread
+// count of 1 has no worker threads at all and just runs everything serially.
+class WorkerPool
+{
+public:
+	// Passing 0 means 'use every hardware thread'.
+	explicit WorkerPool(const unsigned threadCount = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(const WorkerPool&&) = delete;
+
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&&) = delete;
+
+	// The number of threads that take part in a ParallelFor, including the calling thread.
+	unsigned GetThreadCount() const { return (unsigned)mThreads.size() + 1; }
+
+	// Splits [0, count) into chunks of chunkSize indices and calls func(begin, end) for each
+	// chunk on whichever thread gets to it first. Blocks until every chunk is done.
+	// func must not call ParallelFor on the same WorkerPool.
+	using RangeFunction = std::function<void(unsigned begin, unsigned end)>;
+
+	void ParallelFor(const unsigned count, const unsigned chunkSize, const RangeFunction& func);
+
+	// Like ParallelFor, but returns straight away and leaves the chunks to the worker threads,
+	// so the calling thread can get on with something else. It can pitch in with RunChunk,
+	// and must call Wait before posting anything else.
+	void ParallelForAsync(const unsigned count, const unsigned chunkSize, RangeFunction func);
+
+	// Runs the next unclaimed chunk of the current job on the calling thread.
+	// Returns false if every chunk has already been claimed.
+	bool RunChunk();
+
+	// Helps with any chunks that are left, then blocks until every chunk is done.
+	void Wait();
+
+	static unsigned GetHardwareThreadCount();
+
+private:
+	void WorkerMain();
+
+	// Hands the job to the workers.
+	void Start(const unsigned count, const unsigned chunkSize, const RangeFunction& func);
+
+	// Returns once there are no chunks left to claim.
+	void ProcessChunks();
+
+	// Waits for the workers to finish whatever chunks they claimed.
+	void Finish();
+
+	std::vector<std::thread> mThreads;
+
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+
+	// Bumped every time a new job is posted so sleeping workers know to wake up.
+	unsigned mJobGeneration = 0;
+	unsigned mBusyWorkerCount = 0;
+	bool mQuit = false;
+
+	// The current job.
+	const RangeFunction* mFunc = nullptr;
+	// ParallelForAsync's caller might not keep its function alive, so it is copied here.
+	RangeFunction mAsyncFunc;
+	unsigned mCount = 0;
+	unsigned mChunkSize = 1;
+	std::atomic<unsigned> mNextChunkBegin{ 0 };
+};
+
+}
\ No newline at end of file
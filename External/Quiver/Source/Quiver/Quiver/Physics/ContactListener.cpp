@@ -6,21 +6,6 @@
 #include "Quiver/Entity/CustomComponent/CustomComponent.h"
 #include "Quiver/Entity/PhysicsComponent/PhysicsComponent.h"
 
-namespace {
-
-qvr::Entity* GetEntityFromFixture(const b2Fixture& fixture) {
-	auto physicsComp
-		= static_cast<qvr::PhysicsComponent*>(fixture.GetBody()->GetUserData());
-
-	if (physicsComp) {
-		return &physicsComp->GetEntity();
-	}
-
-	return nullptr;
-}
-
-}
-
 namespace qvr {
 
 namespace Physics
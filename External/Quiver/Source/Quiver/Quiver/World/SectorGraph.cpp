@@ -0,0 +1,536 @@
+#include "SectorGraph.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include <Box2D/Common/b2Draw.h>
+#include <ImGui/imgui.h>
+
+#include "Quiver/Misc/ImGuiHelpers.h"
+#include "Quiver/Misc/Logging.h"
+
+namespace qvr {
+
+namespace {
+
+// Shared by every graph, so a generation number never means the same thing in two of them.
+unsigned NewSectorGraphGeneration() {
+	static std::atomic<unsigned> lastGeneration(0);
+	return ++lastGeneration;
+}
+
+// How close edges have to be to count as shared, and points to count as on them.
+const float32 sEdgeTolerance = b2_linearSlop;
+
+bool Overlap(const b2AABB& a, const b2AABB& b)
+{
+	return
+		a.lowerBound.x < b.upperBound.x - sEdgeTolerance &&
+		b.lowerBound.x < a.upperBound.x - sEdgeTolerance &&
+		a.lowerBound.y < b.upperBound.y - sEdgeTolerance &&
+		b.lowerBound.y < a.upperBound.y - sEdgeTolerance;
+}
+
+// The stretch of edge two boxes share, if they're side by side.
+bool GetSharedEdge(const b2AABB& a, const b2AABB& b, b2Vec2& start, b2Vec2& end)
+{
+	auto shared = [&](const int axis, const float32 at) {
+		const int other = 1 - axis;
+		const float32 low = std::max(a.lowerBound(other), b.lowerBound(other));
+		const float32 high = std::min(a.upperBound(other), b.upperBound(other));
+
+		if (high - low <= sEdgeTolerance) return false;
+
+		start(axis) = at;
+		end(axis) = at;
+		start(other) = low;
+		end(other) = high;
+
+		return true;
+	};
+
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		if (std::abs(a.upperBound(axis) - b.lowerBound(axis)) <= sEdgeTolerance) {
+			if (shared(axis, a.upperBound(axis))) return true;
+		}
+
+		if (std::abs(b.upperBound(axis) - a.lowerBound(axis)) <= sEdgeTolerance) {
+			if (shared(axis, a.lowerBound(axis))) return true;
+		}
+	}
+
+	return false;
+}
+
+// Portals are always axis-aligned.
+bool IsOnSegment(const b2Vec2& point, const b2Vec2& start, const b2Vec2& end)
+{
+	return
+		point.x >= std::min(start.x, end.x) - sEdgeTolerance &&
+		point.x <= std::max(start.x, end.x) + sEdgeTolerance &&
+		point.y >= std::min(start.y, end.y) - sEdgeTolerance &&
+		point.y <= std::max(start.y, end.y) + sEdgeTolerance;
+}
+
+nlohmann::json ToJson(const b2Vec2& v) {
+	return { v.x, v.y };
+}
+
+bool FromJson(const nlohmann::json& j, b2Vec2& v) {
+	if (!j.is_array() || j.size() != 2 || !j[0].is_number() || !j[1].is_number()) return false;
+	v.Set(j[0], j[1]);
+	return true;
+}
+
+}
+
+SectorGraph::SectorGraph()
+	: mGeneration(NewSectorGraphGeneration())
+{}
+
+void SectorGraph::Changed()
+{
+	mGeneration = NewSectorGraphGeneration();
+}
+
+int SectorGraph::AddSector(const b2AABB& bounds, const std::string& name)
+{
+	const b2Vec2 size = bounds.upperBound - bounds.lowerBound;
+
+	if (size.x <= sEdgeTolerance || size.y <= sEdgeTolerance) return -1;
+
+	for (const Sector& sector : mSectors) {
+		if (Overlap(sector.bounds, bounds)) return -1;
+	}
+
+	Sector sector;
+	sector.name = name;
+	sector.bounds = bounds;
+
+	mSectors.push_back(sector);
+
+	Changed();
+
+	return GetSectorCount() - 1;
+}
+
+bool SectorGraph::RemoveSector(const int index)
+{
+	if (index < 0 || index >= GetSectorCount()) return false;
+
+	mSectors.erase(mSectors.begin() + index);
+
+	mPortals.erase(
+		std::remove_if(
+			mPortals.begin(),
+			mPortals.end(),
+			[index](const Portal& portal) {
+				return portal.sectors[0] == index || portal.sectors[1] == index;
+			}),
+		mPortals.end());
+
+	for (Portal& portal : mPortals) {
+		for (int& sector : portal.sectors) {
+			if (sector > index) sector--;
+		}
+	}
+
+	RebuildPortalLists();
+
+	if (mSelectedSector >= GetSectorCount()) {
+		mSelectedSector = std::max(GetSectorCount() - 1, 0);
+	}
+
+	Changed();
+
+	return true;
+}
+
+int SectorGraph::AddPortal(const int sectorA, const int sectorB, const b2Vec2& start, const b2Vec2& end)
+{
+	if (sectorA < 0 || sectorA >= GetSectorCount()) return -1;
+	if (sectorB < 0 || sectorB >= GetSectorCount()) return -1;
+	if (sectorA == sectorB) return -1;
+
+	b2Vec2 edgeStart, edgeEnd;
+	if (!GetSharedEdge(mSectors[sectorA].bounds, mSectors[sectorB].bounds, edgeStart, edgeEnd)) return -1;
+
+	if (!IsOnSegment(start, edgeStart, edgeEnd) || !IsOnSegment(end, edgeStart, edgeEnd)) return -1;
+
+	if ((end - start).Length() <= sEdgeTolerance) return -1;
+
+	Portal portal;
+	portal.sectors[0] = sectorA;
+	portal.sectors[1] = sectorB;
+	portal.start = start;
+	portal.end = end;
+
+	mPortals.push_back(portal);
+
+	const int portalIndex = GetPortalCount() - 1;
+
+	mSectors[sectorA].portals.push_back(portalIndex);
+	mSectors[sectorB].portals.push_back(portalIndex);
+
+	Changed();
+
+	return portalIndex;
+}
+
+bool SectorGraph::RemovePortal(const int index)
+{
+	if (index < 0 || index >= GetPortalCount()) return false;
+
+	mPortals.erase(mPortals.begin() + index);
+
+	RebuildPortalLists();
+
+	Changed();
+
+	return true;
+}
+
+int SectorGraph::DerivePortals(const int sector)
+{
+	if (sector < 0 || sector >= GetSectorCount()) return 0;
+
+	int addedCount = 0;
+
+	for (int other = 0; other < GetSectorCount(); ++other)
+	{
+		if (other == sector) continue;
+
+		const bool alreadyJoined = std::any_of(
+			mSectors[sector].portals.begin(),
+			mSectors[sector].portals.end(),
+			[this, other](const int portal) {
+				return mPortals[portal].sectors[0] == other || mPortals[portal].sectors[1] == other;
+			});
+
+		if (alreadyJoined) continue;
+
+		b2Vec2 start, end;
+		if (!GetSharedEdge(mSectors[sector].bounds, mSectors[other].bounds, start, end)) continue;
+
+		if (AddPortal(sector, other, start, end) >= 0) {
+			addedCount++;
+		}
+	}
+
+	return addedCount;
+}
+
+int SectorGraph::DeriveAllPortals()
+{
+	int addedCount = 0;
+
+	for (int sector = 0; sector < GetSectorCount(); ++sector) {
+		addedCount += DerivePortals(sector);
+	}
+
+	return addedCount;
+}
+
+void SectorGraph::Clear()
+{
+	mSectors.clear();
+	mPortals.clear();
+	mSelectedSector = 0;
+
+	Changed();
+}
+
+void SectorGraph::RebuildPortalLists()
+{
+	for (Sector& sector : mSectors) {
+		sector.portals.clear();
+	}
+
+	for (int i = 0; i < GetPortalCount(); ++i) {
+		mSectors[mPortals[i].sectors[0]].portals.push_back(i);
+		mSectors[mPortals[i].sectors[1]].portals.push_back(i);
+	}
+}
+
+int SectorGraph::GetSectorAt(const b2Vec2& point) const
+{
+	for (int i = 0; i < GetSectorCount(); ++i)
+	{
+		const b2AABB& bounds = mSectors[i].bounds;
+
+		if (point.x >= bounds.lowerBound.x && point.x < bounds.upperBound.x &&
+			point.y >= bounds.lowerBound.y && point.y < bounds.upperBound.y)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+float32 SectorGraph::Clip(const b2Vec2& point1, const b2Vec2& point2, const int startSector) const
+{
+	if (startSector < 0) return 1.0f;
+
+	const b2Vec2 d = point2 - point1;
+
+	int sector = startSector;
+	float32 fraction = 0.0f;
+
+	// Sectors are convex and don't overlap, so the segment can't go through one twice.
+	for (int step = 0; step < GetSectorCount(); ++step)
+	{
+		const b2AABB& bounds = mSectors[sector].bounds;
+
+		// Where the segment leaves this sector.
+		float32 exitFraction = std::numeric_limits<float32>::infinity();
+
+		for (int axis = 0; axis < 2; ++axis)
+		{
+			if (d(axis) > 0.0f) {
+				exitFraction = std::min(exitFraction, (bounds.upperBound(axis) - point1(axis)) / d(axis));
+			}
+			else if (d(axis) < 0.0f) {
+				exitFraction = std::min(exitFraction, (bounds.lowerBound(axis) - point1(axis)) / d(axis));
+			}
+		}
+
+		if (exitFraction >= 1.0f) return 1.0f;
+
+		// Only clipped the corner of this one.
+		if (exitFraction <= fraction) return fraction;
+
+		fraction = exitFraction;
+
+		const b2Vec2 exitPoint = point1 + exitFraction * d;
+
+		int next = -1;
+
+		for (const int portalIndex : mSectors[sector].portals)
+		{
+			const Portal& portal = mPortals[portalIndex];
+
+			if (IsOnSegment(exitPoint, portal.start, portal.end)) {
+				next = portal.sectors[0] == sector ? portal.sectors[1] : portal.sectors[0];
+				break;
+			}
+		}
+
+		if (next < 0) return fraction;
+
+		sector = next;
+	}
+
+	return fraction;
+}
+
+nlohmann::json SectorGraph::ToJson() const
+{
+	nlohmann::json j;
+
+	j["Sectors"] = nlohmann::json::array();
+
+	for (const Sector& sector : mSectors)
+	{
+		nlohmann::json sectorJson;
+		sectorJson["Name"] = sector.name;
+		sectorJson["Min"] = qvr::ToJson(sector.bounds.lowerBound);
+		sectorJson["Max"] = qvr::ToJson(sector.bounds.upperBound);
+
+		j["Sectors"].push_back(sectorJson);
+	}
+
+	j["Portals"] = nlohmann::json::array();
+
+	for (const Portal& portal : mPortals)
+	{
+		nlohmann::json portalJson;
+		portalJson["Sectors"] = { portal.sectors[0], portal.sectors[1] };
+		portalJson["Start"] = qvr::ToJson(portal.start);
+		portalJson["End"] = qvr::ToJson(portal.end);
+
+		j["Portals"].push_back(portalJson);
+	}
+
+	return j;
+}
+
+bool SectorGraph::FromJson(const nlohmann::json& j)
+{
+	auto log = GetConsoleLogger();
+
+	static const char* logContext = "SectorGraph::FromJson:";
+
+	Clear();
+
+	if (!j.is_object()) {
+		log->error("{} Expected an object.", logContext);
+		return false;
+	}
+
+	// Where each sector in the JSON ended up, if anywhere.
+	std::vector<int> sectorIndices;
+
+	if (j.find("Sectors") != j.end() && j["Sectors"].is_array())
+	{
+		for (const auto& sectorJson : j["Sectors"])
+		{
+			b2AABB bounds;
+
+			const bool valid =
+				sectorJson.is_object() &&
+				sectorJson.find("Min") != sectorJson.end() &&
+				sectorJson.find("Max") != sectorJson.end() &&
+				qvr::FromJson(sectorJson["Min"], bounds.lowerBound) &&
+				qvr::FromJson(sectorJson["Max"], bounds.upperBound);
+
+			const int index =
+				valid ?
+				AddSector(bounds, sectorJson.value<std::string>("Name", "Sector")) :
+				-1;
+
+			if (index < 0) {
+				log->error("{} Skipped sector {}: it's malformed, empty or overlaps another.", logContext, sectorIndices.size());
+			}
+
+			sectorIndices.push_back(index);
+		}
+	}
+
+	if (j.find("Portals") != j.end() && j["Portals"].is_array())
+	{
+		for (const auto& portalJson : j["Portals"])
+		{
+			b2Vec2 start, end;
+
+			if (!portalJson.is_object() ||
+				portalJson.find("Sectors") == portalJson.end() ||
+				!portalJson["Sectors"].is_array() ||
+				portalJson["Sectors"].size() != 2 ||
+				portalJson.find("Start") == portalJson.end() ||
+				portalJson.find("End") == portalJson.end() ||
+				!qvr::FromJson(portalJson["Start"], start) ||
+				!qvr::FromJson(portalJson["End"], end))
+			{
+				log->error("{} Skipped a malformed portal.", logContext);
+				continue;
+			}
+
+			auto getSector = [&sectorIndices](const nlohmann::json& index) {
+				if (!index.is_number_integer()) return -1;
+				const int i = index.get<int>();
+				return i >= 0 && i < (int)sectorIndices.size() ? sectorIndices[i] : -1;
+			};
+
+			if (AddPortal(getSector(portalJson["Sectors"][0]), getSector(portalJson["Sectors"][1]), start, end) < 0) {
+				log->error("{} Skipped a portal that isn't on an edge its sectors share.", logContext);
+			}
+		}
+	}
+
+	return true;
+}
+
+void SectorGraph::DebugDraw(b2Draw& draw) const
+{
+	const b2Color sectorColor(0.3f, 0.5f, 1.0f);
+	const b2Color portalColor(0.2f, 1.0f, 0.4f);
+
+	for (const Sector& sector : mSectors)
+	{
+		const b2Vec2 vertices[4] = {
+			sector.bounds.lowerBound,
+			b2Vec2(sector.bounds.upperBound.x, sector.bounds.lowerBound.y),
+			sector.bounds.upperBound,
+			b2Vec2(sector.bounds.lowerBound.x, sector.bounds.upperBound.y)
+		};
+
+		draw.DrawPolygon(vertices, 4, sectorColor);
+	}
+
+	for (const Portal& portal : mPortals) {
+		draw.DrawSegment(portal.start, portal.end, portalColor);
+	}
+}
+
+void SectorGraph::EditorImGuiControls()
+{
+	ImGui::Text("%d sectors, %d portals", GetSectorCount(), GetPortalCount());
+
+	if (ImGui::Button("Derive Portals")) {
+		auto log = GetConsoleLogger();
+		log->info("Added {} portals.", DeriveAllPortals());
+	}
+
+	if (IsEmpty()) {
+		ImGui::Text("Use the Create Sector tool to add some.");
+		return;
+	}
+
+	ImGui::SameLine();
+
+	if (ImGui::Button("Remove All")) {
+		Clear();
+		return;
+	}
+
+	auto sectorNameGetter = [](void* data, int index, const char** itemText)
+	{
+		auto& sectors = *static_cast<std::vector<Sector>*>(data);
+
+		if (index < 0) return false;
+		if (index >= (int)sectors.size()) return false;
+
+		*itemText = sectors[index].name.c_str();
+
+		return true;
+	};
+
+	ImGui::ListBox("Sectors", &mSelectedSector, sectorNameGetter, &mSectors, GetSectorCount());
+
+	if (mSelectedSector < 0 || mSelectedSector >= GetSectorCount()) return;
+
+	ImGui::AutoIndent indent;
+
+	Sector& sector = mSectors[mSelectedSector];
+
+	ImGui::InputText<64>("Name", sector.name);
+
+	ImGui::Text(
+		"From (%.2f, %.2f) to (%.2f, %.2f)",
+		sector.bounds.lowerBound.x,
+		sector.bounds.lowerBound.y,
+		sector.bounds.upperBound.x,
+		sector.bounds.upperBound.y);
+
+	if (ImGui::Button("Remove Sector")) {
+		RemoveSector(mSelectedSector);
+		return;
+	}
+
+	for (const int portalIndex : sector.portals)
+	{
+		const Portal& portal = mPortals[portalIndex];
+		const int other = portal.sectors[0] == mSelectedSector ? portal.sectors[1] : portal.sectors[0];
+
+		ImGui::PushID(portalIndex);
+
+		ImGui::Text("Portal to %s", mSectors[other].name.c_str());
+		ImGui::SameLine();
+
+		const bool removed = ImGui::SmallButton("Remove");
+
+		ImGui::PopID();
+
+		// The list we're going through is about to change.
+		if (removed) {
+			RemovePortal(portalIndex);
+			break;
+		}
+	}
+}
+
+}
\ No newline at end of file
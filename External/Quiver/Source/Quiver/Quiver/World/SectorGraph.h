@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2Math.h>
+#include <json.hpp>
+
+class b2Draw;
+
+namespace qvr {
+
+// Splits a level up into sectors (axis-aligned boxes that don't overlap, like rooms) joined by
+// portals (stretches of edge that two sectors share, like doorways). A line of sight that
+// leaves a sector anywhere but through a portal is blocked, so whatever is past it can't be
+// seen. The renderer uses this to cut rays short, and anything else (AI, say) can ask CanSee.
+//
+// Outside of every sector, nothing is blocked.
+class SectorGraph
+{
+public:
+	struct Sector
+	{
+		std::string name;
+		b2AABB bounds;
+		// Indices of the portals on its edges.
+		std::vector<int> portals;
+	};
+
+	struct Portal
+	{
+		int sectors[2];
+		// On the edge the two sectors share.
+		b2Vec2 start;
+		b2Vec2 end;
+	};
+
+	SectorGraph();
+
+	bool IsEmpty() const { return mSectors.empty(); }
+
+	int GetSectorCount() const { return (int)mSectors.size(); }
+	int GetPortalCount() const { return (int)mPortals.size(); }
+
+	const Sector& GetSector(const int index) const { return mSectors[index]; }
+	const Portal& GetPortal(const int index) const { return mPortals[index]; }
+
+	// Returns the new sector's index, or -1 if it's empty or overlaps another sector.
+	int AddSector(const b2AABB& bounds, const std::string& name = "Sector");
+
+	// Takes the sector's portals with it. Later sectors move down one.
+	bool RemoveSector(const int index);
+
+	// Returns the new portal's index, or -1 if the stretch from start to end isn't on an edge
+	// the two sectors share.
+	int AddPortal(const int sectorA, const int sectorB, const b2Vec2& start, const b2Vec2& end);
+
+	bool RemovePortal(const int index);
+
+	// Adds a portal along each edge the sector shares with another, unless the two are already
+	// joined. Returns the number added.
+	int DerivePortals(const int sector);
+	int DeriveAllPortals();
+
+	void Clear();
+
+	// -1 if the point isn't in any sector.
+	int GetSectorAt(const b2Vec2& point) const;
+
+	// How far (as a fraction) the segment from point1 to point2 gets before it's blocked, going
+	// from sector to sector through portals. 1 if it isn't blocked. startSector is the sector
+	// point1 is in, as GetSectorAt would find it; -1 means nothing blocks the segment.
+	float32 Clip(const b2Vec2& point1, const b2Vec2& point2, const int startSector) const;
+
+	// Coarse: true if nothing but the sectors' edges could hide one point from the other.
+	bool CanSee(const b2Vec2& from, const b2Vec2& to) const {
+		return Clip(from, to, GetSectorAt(from)) >= 1.0f;
+	}
+
+	// Changes whenever anything about the graph does. Never the same for two different graphs.
+	unsigned GetGeneration() const { return mGeneration; }
+
+	nlohmann::json ToJson() const;
+	bool FromJson(const nlohmann::json& j);
+
+	// Sector outlines, with portals in a different colour.
+	void DebugDraw(b2Draw& draw) const;
+
+	void EditorImGuiControls();
+
+private:
+	void Changed();
+
+	// Fills in each Sector's portals from mPortals.
+	void RebuildPortalLists();
+
+	std::vector<Sector> mSectors;
+	std::vector<Portal> mPortals;
+
+	unsigned mGeneration;
+
+	// WorldEditor-only stuff:
+
+	int mSelectedSector = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,588 @@
+#include "TileMap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include <ImGui/imgui.h>
+#include <SFML/Graphics/Texture.hpp>
+
+#include "Quiver/Graphics/ColourUtils.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
+#include "Quiver/Graphics/TextureLibrary.h"
+#include "Quiver/Misc/ImGuiHelpers.h"
+#include "Quiver/Misc/Logging.h"
+
+namespace qvr {
+
+namespace {
+
+// Shared by every map, so a generation number never means the same thing in two of them.
+unsigned NewTileMapGeneration() {
+	static std::atomic<unsigned> lastGeneration(0);
+	return ++lastGeneration;
+}
+
+}
+
+TileMap::TileMap(const int width, const int height, const float tileSize, const b2Vec2& origin)
+	: mWidth(std::max(width, 1))
+	, mHeight(std::max(height, 1))
+	, mTileSize(std::max(tileSize, b2_linearSlop))
+	, mOrigin(origin)
+	, mTiles(mWidth * mHeight, 0)
+	, mGeneration(NewTileMapGeneration())
+{}
+
+void TileMap::Changed()
+{
+	mGeneration = NewTileMapGeneration();
+}
+
+void TileMap::SetTile(const int x, const int y, const int tile)
+{
+	assert(x >= 0 && x < mWidth);
+	assert(y >= 0 && y < mHeight);
+
+	if (tile < 0 || tile > GetTypeCount()) return;
+
+	std::uint8_t& current = mTiles[y * mWidth + x];
+
+	if (current == tile) return;
+
+	current = (std::uint8_t)tile;
+
+	Changed();
+}
+
+bool TileMap::GetTileCoords(const b2Vec2& point, int& x, int& y) const
+{
+	const float gridX = (point.x - mOrigin.x) / mTileSize;
+	const float gridY = (point.y - mOrigin.y) / mTileSize;
+
+	if (gridX < 0.0f || gridY < 0.0f) return false;
+
+	x = (int)gridX;
+	y = (int)gridY;
+
+	return x < mWidth && y < mHeight;
+}
+
+void TileMap::Resize(const int width, const int height)
+{
+	const int newWidth = std::max(width, 1);
+	const int newHeight = std::max(height, 1);
+
+	if (newWidth == mWidth && newHeight == mHeight) return;
+
+	std::vector<std::uint8_t> newTiles(newWidth * newHeight, 0);
+
+	for (int y = 0; y < std::min(mHeight, newHeight); ++y) {
+		for (int x = 0; x < std::min(mWidth, newWidth); ++x) {
+			newTiles[y * newWidth + x] = mTiles[y * mWidth + x];
+		}
+	}
+
+	mWidth = newWidth;
+	mHeight = newHeight;
+	mTiles = std::move(newTiles);
+
+	Changed();
+}
+
+int TileMap::AddType(const std::string& name)
+{
+	if (GetTypeCount() >= MaxTypeCount) return -1;
+
+	auto type = std::make_unique<TileType>();
+	type->name = name;
+	type->renderData.mOpaque = true;
+
+	mTypes.push_back(std::move(type));
+
+	Changed();
+
+	return GetTypeCount() - 1;
+}
+
+bool TileMap::RemoveType(const int index)
+{
+	if (index < 0 || index >= GetTypeCount()) return false;
+
+	mTypes.erase(mTypes.begin() + index);
+
+	const int removedTile = index + 1;
+
+	for (std::uint8_t& tile : mTiles)
+	{
+		if (tile == removedTile) {
+			tile = 0;
+		}
+		else if (tile > removedTile) {
+			tile--;
+		}
+	}
+
+	if (mSelectedTile > GetTypeCount()) {
+		mSelectedTile = GetTypeCount();
+	}
+
+	Changed();
+
+	return true;
+}
+
+void TileMap::SetTypeName(const int index, const std::string& name)
+{
+	mTypes[index]->name = name;
+}
+
+void TileMap::SetTypeColor(const int index, const sf::Color color)
+{
+	mTypes[index]->renderData.mBlendColor = color;
+	Changed();
+}
+
+void TileMap::SetTypeHeight(const int index, const float height)
+{
+	mTypes[index]->renderData.mHeight = height;
+	Changed();
+}
+
+void TileMap::SetTypeOpaque(const int index, const bool opaque)
+{
+	mTypes[index]->renderData.mOpaque = opaque;
+	Changed();
+}
+
+void TileMap::SetTypeTexture(
+	const int index,
+	const std::shared_ptr<sf::Texture>& texture,
+	const std::string& filename)
+{
+	TileType& type = *mTypes[index];
+
+	type.renderData.mTexture = texture;
+	type.textureFilename = texture ? filename : std::string();
+
+	Animation::Rect view;
+
+	if (texture)
+	{
+		view.right = (int)texture->getSize().x;
+		view.bottom = (int)texture->getSize().y;
+	}
+
+	SetView(type.renderData.mTextureRects.views, view);
+
+	Changed();
+}
+
+void TileMap::RayCast(
+	RenderProxyRayCastCallback& callback,
+	const b2Vec2& point1,
+	const b2Vec2& point2,
+	const int slotBase,
+	float32 maxFraction) const
+{
+	const b2Vec2 d = point2 - point1;
+
+	// Clip the ray to the grid's bounds, remembering which side it came in through.
+	float32 enterFraction = -std::numeric_limits<float32>::infinity();
+	float32 exitFraction = std::numeric_limits<float32>::infinity();
+	b2Vec2 enterNormal = b2Vec2_zero;
+
+	const b2Vec2 lower = mOrigin;
+	const b2Vec2 upper = mOrigin + b2Vec2(mWidth * mTileSize, mHeight * mTileSize);
+
+	for (int axis = 0; axis < 2; ++axis)
+	{
+		const float32 start = axis == 0 ? point1.x : point1.y;
+		const float32 delta = axis == 0 ? d.x : d.y;
+		const float32 low = axis == 0 ? lower.x : lower.y;
+		const float32 high = axis == 0 ? upper.x : upper.y;
+
+		if (delta == 0.0f)
+		{
+			if (start < low || start >= high) return;
+			continue;
+		}
+
+		float32 t1 = (low - start) / delta;
+		float32 t2 = (high - start) / delta;
+
+		if (t1 > t2) std::swap(t1, t2);
+
+		if (t1 > enterFraction)
+		{
+			enterFraction = t1;
+			enterNormal = axis == 0 ?
+				b2Vec2(delta > 0.0f ? -1.0f : 1.0f, 0.0f) :
+				b2Vec2(0.0f, delta > 0.0f ? -1.0f : 1.0f);
+		}
+
+		exitFraction = std::min(exitFraction, t2);
+	}
+
+	if (enterFraction > exitFraction || exitFraction < 0.0f || enterFraction > maxFraction) return;
+
+	const bool startsOutside = enterFraction > 0.0f;
+
+	const b2Vec2 start = startsOutside ? point1 + enterFraction * d : point1;
+
+	int x = std::min(std::max((int)std::floor((start.x - mOrigin.x) / mTileSize), 0), mWidth - 1);
+	int y = std::min(std::max((int)std::floor((start.y - mOrigin.y) / mTileSize), 0), mHeight - 1);
+
+	const int stepX = d.x > 0.0f ? 1 : -1;
+	const int stepY = d.y > 0.0f ? 1 : -1;
+
+	// How far along the ray (as a fraction) it takes to cross one tile on each axis.
+	const float32 deltaX = d.x != 0.0f ? mTileSize / std::abs(d.x) : std::numeric_limits<float32>::infinity();
+	const float32 deltaY = d.y != 0.0f ? mTileSize / std::abs(d.y) : std::numeric_limits<float32>::infinity();
+
+	// Where the ray crosses into the next column and row of tiles.
+	float32 nextX =
+		d.x != 0.0f ?
+		(mOrigin.x + (x + (stepX > 0 ? 1 : 0)) * mTileSize - point1.x) / d.x :
+		std::numeric_limits<float32>::infinity();
+	float32 nextY =
+		d.y != 0.0f ?
+		(mOrigin.y + (y + (stepY > 0 ? 1 : 0)) * mTileSize - point1.y) / d.y :
+		std::numeric_limits<float32>::infinity();
+
+	auto report = [&](const b2Vec2& normal, const float32 fraction) -> bool
+	{
+		const int tile = mTiles[y * mWidth + x];
+
+		if (tile == 0) return true;
+
+		const float32 result = callback.ReportProxy(
+			mTypes[tile - 1]->renderData,
+			slotBase + tile - 1,
+			point1 + fraction * d,
+			normal,
+			fraction);
+
+		if (result == 0.0f) return false;
+
+		if (result > 0.0f) {
+			maxFraction = result;
+		}
+
+		return true;
+	};
+
+	if (startsOutside && !report(enterNormal, enterFraction)) return;
+
+	while (true)
+	{
+		float32 fraction;
+		b2Vec2 normal;
+
+		if (nextX < nextY)
+		{
+			fraction = nextX;
+			nextX += deltaX;
+			x += stepX;
+			normal.Set((float32)-stepX, 0.0f);
+		}
+		else
+		{
+			fraction = nextY;
+			nextY += deltaY;
+			y += stepY;
+			normal.Set(0.0f, (float32)-stepY);
+		}
+
+		if (fraction > maxFraction) return;
+		if (x < 0 || x >= mWidth || y < 0 || y >= mHeight) return;
+
+		if (!report(normal, fraction)) return;
+	}
+}
+
+float TileMap::GetFaceCoordinate(const b2Vec2& point, const b2Vec2& normal) const
+{
+	// Seen from in front, the face's left-to-right runs along the normal turned clockwise.
+	const b2Vec2 tangent(normal.y, -normal.x);
+
+	const float across = b2Dot(point - mOrigin, tangent) / mTileSize;
+
+	return across - std::floor(across);
+}
+
+std::vector<b2AABB> TileMap::GetSolidRects() const
+{
+	std::vector<b2AABB> rects;
+
+	std::vector<char> covered(mTiles.size(), 0);
+
+	auto isFree = [&](const int x, const int y) {
+		const int index = y * mWidth + x;
+		return mTiles[index] != 0 && !covered[index];
+	};
+
+	for (int y = 0; y < mHeight; ++y)
+	{
+		for (int x = 0; x < mWidth; ++x)
+		{
+			if (!isFree(x, y)) continue;
+
+			// As wide as the row allows, then as tall as every row below stays that wide.
+			int endX = x + 1;
+			while (endX < mWidth && isFree(endX, y)) endX++;
+
+			int endY = y + 1;
+			while (endY < mHeight)
+			{
+				bool rowFree = true;
+
+				for (int i = x; i < endX && rowFree; ++i) {
+					rowFree = isFree(i, endY);
+				}
+
+				if (!rowFree) break;
+
+				endY++;
+			}
+
+			for (int j = y; j < endY; ++j) {
+				for (int i = x; i < endX; ++i) {
+					covered[j * mWidth + i] = 1;
+				}
+			}
+
+			b2AABB rect;
+			rect.lowerBound = mOrigin + mTileSize * b2Vec2((float32)x, (float32)y);
+			rect.upperBound = mOrigin + mTileSize * b2Vec2((float32)endX, (float32)endY);
+
+			rects.push_back(rect);
+		}
+	}
+
+	return rects;
+}
+
+nlohmann::json TileMap::ToJson() const
+{
+	nlohmann::json j;
+
+	j["Width"] = mWidth;
+	j["Height"] = mHeight;
+	j["TileSize"] = mTileSize;
+	j["Origin"] = { mOrigin.x, mOrigin.y };
+
+	j["Types"] = nlohmann::json::array();
+
+	for (const auto& type : mTypes)
+	{
+		nlohmann::json typeJson;
+
+		typeJson["Name"] = type->name;
+
+		if (!type->textureFilename.empty()) {
+			typeJson["Texture"] = type->textureFilename;
+		}
+
+		ColourUtils::SerializeSFColorToJson(type->renderData.GetColor(), typeJson["Colour"]);
+
+		typeJson["Height"] = type->renderData.GetHeight();
+		typeJson["Opaque"] = type->renderData.mOpaque;
+
+		j["Types"].push_back(typeJson);
+	}
+
+	j["Tiles"] = mTiles;
+
+	return j;
+}
+
+std::unique_ptr<TileMap> TileMap::FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary)
+{
+	auto log = GetConsoleLogger();
+
+	static const char* logContext = "TileMap::FromJson:";
+
+	if (!j.is_object()) {
+		log->error("{} Expected an object.", logContext);
+		return nullptr;
+	}
+
+	const int width = j.value<int>("Width", 0);
+	const int height = j.value<int>("Height", 0);
+
+	if (width <= 0 || height <= 0) {
+		log->error("{} Width and Height must be greater than 0.", logContext);
+		return nullptr;
+	}
+
+	b2Vec2 origin = b2Vec2_zero;
+
+	if (j.find("Origin") != j.end() && j["Origin"].is_array() && j["Origin"].size() == 2) {
+		origin.Set(j["Origin"][0], j["Origin"][1]);
+	}
+
+	auto tileMap = std::make_unique<TileMap>(width, height, j.value<float>("TileSize", 1.0f), origin);
+
+	if (j.find("Types") != j.end() && j["Types"].is_array())
+	{
+		for (const auto& typeJson : j["Types"])
+		{
+			const int index = tileMap->AddType(typeJson.value<std::string>("Name", "Unnamed Type"));
+
+			if (index < 0) {
+				log->error("{} Too many Types. Only the first {} were kept.", logContext, tileMap->GetTypeCount());
+				break;
+			}
+
+			if (typeJson.find("Colour") != typeJson.end()) {
+				sf::Color colour;
+				if (ColourUtils::DeserializeSFColorFromJson(colour, typeJson["Colour"])) {
+					tileMap->SetTypeColor(index, colour);
+				}
+			}
+
+			tileMap->SetTypeHeight(index, typeJson.value<float>("Height", 1.0f));
+			tileMap->SetTypeOpaque(index, typeJson.value<bool>("Opaque", true));
+
+			const std::string textureFilename = typeJson.value<std::string>("Texture", "");
+
+			if (!textureFilename.empty())
+			{
+				auto texture = textureLibrary.LoadTexture(textureFilename);
+
+				if (!texture) {
+					log->error("{} Couldn't load texture {}.", logContext, textureFilename);
+				}
+
+				tileMap->SetTypeTexture(index, texture, textureFilename);
+			}
+		}
+	}
+
+	if (j.find("Tiles") != j.end() && j["Tiles"].is_array())
+	{
+		const auto& tiles = j["Tiles"];
+
+		if ((int)tiles.size() != width * height) {
+			log->error(
+				"{} Expected {} Tiles, found {}. The map will be partly empty.",
+				logContext,
+				width * height,
+				tiles.size());
+		}
+
+		const int count = std::min((int)tiles.size(), width * height);
+
+		for (int i = 0; i < count; ++i)
+		{
+			const int tile = tiles[i].is_number_integer() ? tiles[i].get<int>() : 0;
+
+			tileMap->mTiles[i] = (std::uint8_t)(tile > 0 && tile <= tileMap->GetTypeCount() ? tile : 0);
+		}
+	}
+
+	return tileMap;
+}
+
+void TileMap::EditorImGuiControls(TextureLibrary& textureLibrary)
+{
+	{
+		int size[2] = { mWidth, mHeight };
+		if (ImGui::InputInt2("Size (Tiles)", size, ImGuiInputTextFlags_EnterReturnsTrue)) {
+			Resize(size[0], size[1]);
+		}
+	}
+
+	if (ImGui::DragFloat("Tile Size", &mTileSize, 0.05f, 0.1f, 16.0f)) {
+		mTileSize = std::max(mTileSize, b2_linearSlop);
+		Changed();
+	}
+
+	if (ImGui::DragFloat2("Origin", &mOrigin.x, 0.1f)) {
+		Changed();
+	}
+
+	auto tileNameGetter = [](void* data, int index, const char** itemText)
+	{
+		auto& types = *static_cast<std::vector<std::unique_ptr<TileType>>*>(data);
+
+		if (index < 0) return false;
+		if (index > (int)types.size()) return false;
+
+		*itemText = index == 0 ? "(Empty)" : types[index - 1]->name.c_str();
+
+		return true;
+	};
+
+	ImGui::ListBox("Tiles", &mSelectedTile, tileNameGetter, &mTypes, GetTypeCount() + 1);
+
+	if (ImGui::Button("Add Type")) {
+		const int index = AddType("Unnamed Type");
+		if (index >= 0) {
+			mSelectedTile = index + 1;
+		}
+	}
+
+	if (mSelectedTile <= 0 || mSelectedTile > GetTypeCount()) return;
+
+	const int typeIndex = mSelectedTile - 1;
+	TileType& type = *mTypes[typeIndex];
+
+	ImGui::SameLine();
+
+	if (ImGui::Button("Remove Type")) {
+		RemoveType(typeIndex);
+		return;
+	}
+
+	ImGui::AutoIndent indent;
+
+	{
+		std::string name = type.name;
+		if (ImGui::InputText<64>("Name", name)) {
+			SetTypeName(typeIndex, name);
+		}
+	}
+
+	{
+		sf::Color colour = type.renderData.GetColor();
+		ColourUtils::ImGuiColourEdit("Colour", colour);
+		if (colour != type.renderData.GetColor()) {
+			SetTypeColor(typeIndex, colour);
+		}
+	}
+
+	{
+		float height = type.renderData.GetHeight();
+		if (ImGui::SliderFloat("Height", &height, 0.5f, 8.0f)) {
+			SetTypeHeight(typeIndex, height);
+		}
+	}
+
+	{
+		bool opaque = type.renderData.mOpaque;
+		if (ImGui::Checkbox("Opaque", &opaque)) {
+			SetTypeOpaque(typeIndex, opaque);
+		}
+	}
+
+	if (type.renderData.GetTexture()) {
+		ImGui::Text("Texture: %s", type.textureFilename.c_str());
+
+		if (ImGui::Button("Remove Texture")) {
+			SetTypeTexture(typeIndex, nullptr, "");
+		}
+	}
+	else {
+		ImGui::InputText<128>("Texture Filename", mTextureFilenameInput);
+
+		if (ImGui::Button("Try to Load") && !mTextureFilenameInput.empty()) {
+			SetTypeTexture(typeIndex, textureLibrary.LoadTexture(mTextureFilenameInput), mTextureFilenameInput);
+		}
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Common/b2Math.h>
+#include <json.hpp>
+#include <SFML/Graphics/Color.hpp>
+
+#include "Quiver/Graphics/FixtureRenderData.h"
+
+namespace sf {
+class Texture;
+}
+
+namespace qvr {
+
+class RenderProxyRayCastCallback;
+class TextureLibrary;
+
+// A grid of square tiles for levels, or the parts of them, that are made of grid-aligned walls.
+// Rays walk the grid a cell at a time instead of going through the RenderProxyIndex, so a ray
+// costs the same however many walls there are. The World gives it one static body for collision.
+//
+// Tile 0 is empty. Any other tile n is a wall of type n - 1.
+class TileMap
+{
+public:
+	struct TileType
+	{
+		std::string name;
+
+		// Serialization-only.
+		std::string textureFilename;
+
+		FixtureRenderData renderData;
+	};
+
+	static const int MaxTypeCount = 255;
+
+	TileMap(const int width, const int height, const float tileSize = 1.0f, const b2Vec2& origin = b2Vec2_zero);
+
+	int GetWidth() const { return mWidth; }
+	int GetHeight() const { return mHeight; }
+	float GetTileSize() const { return mTileSize; }
+
+	// The corner of tile (0, 0) with the lowest coordinates.
+	const b2Vec2& GetOrigin() const { return mOrigin; }
+
+	int GetTile(const int x, const int y) const { return mTiles[y * mWidth + x]; }
+
+	void SetTile(const int x, const int y, const int tile);
+
+	// Returns false if the point isn't on the grid.
+	bool GetTileCoords(const b2Vec2& point, int& x, int& y) const;
+
+	// Keeps whatever tiles are still inside the grid.
+	void Resize(const int width, const int height);
+
+	int GetTypeCount() const { return (int)mTypes.size(); }
+
+	const TileType& GetType(const int index) const { return *mTypes[index]; }
+
+	// Returns the new type's index, or -1 if there are already MaxTypeCount.
+	int AddType(const std::string& name);
+
+	// Tiles of the type become empty, and tiles of later types move down one.
+	bool RemoveType(const int index);
+
+	void SetTypeName(const int index, const std::string& name);
+	void SetTypeColor(const int index, const sf::Color color);
+	void SetTypeHeight(const int index, const float height);
+	void SetTypeOpaque(const int index, const bool opaque);
+	void SetTypeTexture(const int index, const std::shared_ptr<sf::Texture>& texture, const std::string& filename);
+
+	// Changes whenever anything about the map does. Never the same for two different TileMaps.
+	unsigned GetGeneration() const { return mGeneration; }
+
+	// Reports the walls that the segment from point1 to point2 crosses into, nearest first, with
+	// the same contract as RenderProxyIndex::RayCast. Tiles of type n get reported with slot
+	// slotBase + n. A ray that starts inside a wall doesn't see that wall.
+	void RayCast(
+		RenderProxyRayCastCallback& callback,
+		const b2Vec2& point1,
+		const b2Vec2& point2,
+		const int slotBase,
+		float32 maxFraction = 1.0f) const;
+
+	// Where a point on a wall face is across the face's tile, from 0 to 1, going left to right
+	// as seen from in front of the face.
+	float GetFaceCoordinate(const b2Vec2& point, const b2Vec2& normal) const;
+
+	// Covers every wall tile with as few non-overlapping boxes as a greedy merge finds.
+	std::vector<b2AABB> GetSolidRects() const;
+
+	nlohmann::json ToJson() const;
+
+	static std::unique_ptr<TileMap> FromJson(const nlohmann::json& j, TextureLibrary& textureLibrary);
+
+	void EditorImGuiControls(TextureLibrary& textureLibrary);
+
+	// WorldEditor-only: what the paint tool lays down.
+	int GetSelectedTile() const { return mSelectedTile; }
+
+private:
+	void Changed();
+
+	int mWidth;
+	int mHeight;
+	float mTileSize;
+	b2Vec2 mOrigin;
+
+	std::vector<std::uint8_t> mTiles;
+
+	// FixtureRenderData can't be moved, and the renderer holds on to pointers into it.
+	std::vector<std::unique_ptr<TileType>> mTypes;
+
+	unsigned mGeneration;
+
+	// WorldEditor-only stuff:
+
+	int mSelectedTile = 1;
+
+	std::string mTextureFilenameInput;
+};
+
+}
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "World.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <fstream>
 #include <sstream>
 #include <chrono>
@@ -15,8 +17,8 @@
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <ImGui/imgui.h>
 #include <json.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
-#include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Sprite.hpp>
 #include <spdlog/spdlog.h>
 
@@ -35,6 +37,8 @@
 #include "Quiver/Graphics/Camera2D.h"
 #include "Quiver/Graphics/Camera3D.h"
 #include "Quiver/Graphics/ColourUtils.h"
+#include "Quiver/Graphics/RayPacket.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
 #include "Quiver/Graphics/TextureLibrary.h"
 #include "Quiver/Graphics/WorldRaycastRenderer.h"
 #include "Quiver/Graphics/WorldUiRenderer.h"
@@ -43,7 +47,9 @@
 #include "Quiver/Misc/ImGuiHelpers.h"
 #include "Quiver/Misc/JsonHelpers.h"
 #include "Quiver/Misc/Profiler.h"
+#include "Quiver/Misc/WorkerPool.h"
 #include "Quiver/Physics/ContactListener.h"
+#include "Quiver/World/TileMap.h"
 #include "Quiver/World/WorldContext.h"
 
 namespace qvr {
@@ -104,13 +110,62 @@ World::World(
 	, mPhysicsWorld(std::make_unique<b2World>(b2Vec2_zero))
 	, mAudioLibrary(std::make_unique<AudioLibrary>())
 	, mTextureLibrary(std::make_unique<TextureLibrary>())
+	, mRenderProxies(std::make_unique<RenderProxyIndex>())
 {
 	mPhysicsWorld->SetContactListener(mContactListener.get());
 }
 
 World::~World() {}
 
-static Profiler sStepProfiler(512);
+TileMap& World::CreateTileMap(const int width, const int height, const float tileSize)
+{
+	mTileMap = std::make_unique<TileMap>(width, height, tileSize);
+
+	SyncTileMapBody();
+
+	return *mTileMap;
+}
+
+void World::RemoveTileMap()
+{
+	mTileMap.reset();
+
+	SyncTileMapBody();
+}
+
+void World::SyncTileMapBody()
+{
+	if (mTileMap && mTileMapBody && mTileMap->GetGeneration() == mTileMapBodyGeneration) return;
+
+	if (mTileMapBody) {
+		mPhysicsWorld->DestroyBody(mTileMapBody);
+		mTileMapBody = nullptr;
+	}
+
+	if (!mTileMap) return;
+
+	b2BodyDef bodyDef;
+	bodyDef.type = b2_staticBody;
+
+	mTileMapBody = mPhysicsWorld->CreateBody(&bodyDef);
+	mTileMapBodyGeneration = mTileMap->GetGeneration();
+
+	// Boxes rather than one fixture per tile, so there are no seams between tiles for things
+	// to catch on, and fewer proxies in the broad-phase.
+	for (const b2AABB& rect : mTileMap->GetSolidRects())
+	{
+		b2PolygonShape box;
+		box.SetAsBox(
+			0.5f * (rect.upperBound.x - rect.lowerBound.x),
+			0.5f * (rect.upperBound.y - rect.lowerBound.y),
+			rect.GetCenter(),
+			0.0f);
+
+		mTileMapBody->CreateFixture(&box, 0.0f);
+	}
+}
+
+Profiler sStepProfiler(512);
 
 void World::TakeStep(qvr::RawInputDevices& inputDevices)
 {
@@ -120,6 +175,8 @@ void World::TakeStep(qvr::RawInputDevices& inputDevices)
 
 	// Update physics world.
 	{
+		SyncTileMapBody();
+
 		int velocity_iterations = 8;
 		int position_iterations = 2;
 		mPhysicsWorld->Step(GetTimestep().count(), velocity_iterations, position_iterations);
@@ -127,6 +184,8 @@ void World::TakeStep(qvr::RawInputDevices& inputDevices)
 
 	mAnimators.Animate(duration_cast<Animation::TimeUnit>(GetTimestep()));
 
+	mParticles.Update(GetTimestep().count());
+
 	mTotalTime += GetTimestep();
 
 	UpdateAudioComponents();
@@ -165,83 +224,24 @@ void World::SetPaused(const bool paused)
 
 void World::RenderDebug(sf::RenderTarget & target, const Camera2D & camera)
 {
+	SyncTileMapBody();
+
 	b2DrawSFML debugDraw;
 	debugDraw.mTarget = &target;
 	debugDraw.SetFlags(b2Draw::e_shapeBit | b2Draw::e_centerOfMassBit);
 	debugDraw.mCamera = camera;
 	mPhysicsWorld->SetDebugDraw(&debugDraw);
 	mPhysicsWorld->DrawDebugData();
+
+	mSectors.DebugDraw(debugDraw);
 }
 
 Profiler sPreRenderProfiler(512);
 Profiler sRenderProfiler(512);
 Profiler sColumnsProfiler(512);
 
-void DrawGradientRectVertical(
-	sf::RenderTarget& target,
-	const sf::Vector2i topLeft,
-	const sf::Vector2i bottomRight,
-	const sf::Color topColor,
-	const sf::Color bottomColor,
-	const int steps = 1)
-{
-	auto lerp = [](float v0, float v1, float t) -> float {
-		return (1 - t) * v0 + t * v1;
-	};
-
-	auto smoothStep = [lerp](float a, float b, float t) -> float {
-		return lerp(a, b, (t * t)*(3 - (2 * t)));
-	};
-
-	auto accelerate = [lerp](float a, float b, float t) -> float {
-		return lerp(a, b, t * t);
-	};
-
-	auto lerpUint8 = [](sf::Uint8 a, sf::Uint8 b, float t) -> sf::Uint8 {
-		return (sf::Uint8)((1 - t) * a + t * b);
-	};
-
-	auto lerpColor = [lerpUint8](sf::Color c0, sf::Color c1, float t) -> sf::Color {
-		return sf::Color(
-			lerpUint8(c0.r, c1.r, t),
-			lerpUint8(c0.g, c1.g, t),
-			lerpUint8(c0.b, c1.b, t),
-			lerpUint8(c0.a, c1.a, t));
-	};
-
-	auto smoothStepColor = [lerpColor](sf::Color a, sf::Color b, float t) -> sf::Color {
-		return lerpColor(a, b, (t * t)*(3 - (2 * t)));
-	};
-
-	for (int step = 0; step < steps; step++) {
-		const float t = ((float)step) / steps;
-		const float t2 = ((float)step + 1) / steps;
-
-		const int subRectTop = (int)lerp((float)topLeft.y, (float)bottomRight.y, t);
-		const int subRectBottom = (int)lerp((float)topLeft.y, (float)bottomRight.y, t2);
-
-		const sf::Color subRectTopColor = lerpColor(topColor, bottomColor, t);
-		const sf::Color subRectBottomColor = lerpColor(topColor, bottomColor, t2);
-
-		sf::Vertex verts[4] =
-		{
-			sf::Vertex(
-				sf::Vector2f((float)topLeft.x, (float)subRectTop),
-				subRectTopColor),
-			sf::Vertex(
-				sf::Vector2f((float)topLeft.x, (float)subRectBottom),
-				subRectBottomColor),
-			sf::Vertex(
-				sf::Vector2f((float)bottomRight.x, (float)subRectBottom),
-				subRectBottomColor),
-			sf::Vertex(
-				sf::Vector2f((float)bottomRight.x, (float)subRectTop),
-				subRectTopColor)
-		};
-
-		target.draw(verts, 4, sf::PrimitiveType::Quads);
-	}
-}
+// Lives in WorldRaycastRenderer.cpp.
+extern Profiler sRaycastProfiler;
 
 void World::Render3D(
 	sf::RenderTarget & target, 
@@ -251,7 +251,9 @@ void World::Render3D(
 	{
 		ProfilerScope ps(sPreRenderProfiler);
 
-		UpdateDetachedRenderComponents(camera);
+		UpdateDetachedRenderComponents();
+
+		mRenderProxies->Synchronize();
 	}
 
 	const sf::Vector2u targetSize = target.getSize();
@@ -260,83 +262,68 @@ void World::Render3D(
 		sColumnsProfiler.Resize(targetSize.x);
 	}
 
-	// Draw ground.
 	{
-		sf::RectangleShape rect;
-		const int top = (targetSize.y / 2) + GetPitchOffsetInPixels(camera, targetSize.y);
-		rect.setPosition(0.0f, (float)top);
-		rect.setSize(sf::Vector2f((float)targetSize.x, (float)(targetSize.y - top)));
-		rect.setFillColor(groundColor * mAmbientLight.mColor);
-		target.draw(rect);
-
-		// Draw distance-shade on top of it.
-		{
-			rect.setPosition(0.0f, (float)top);
+		ProfilerScope ps(sRenderProfiler);
 
-			auto horizontalMetresToPixels = [](
-				const int targetHeight,
-				const float distanceMetres,
-				const float cameraHeightMetres) -> int
-			{
-				return (int)((targetHeight / distanceMetres) * cameraHeightMetres);
-			};
+		// The rays get cast on the raycast renderer's worker threads while we draw the ground
+		// and sky (and cast the floor). Nothing from here on changes the World.
+		raycastRenderer.BeginFrame(*this, camera, mRenderSettings, targetSize);
 
-			const int maxIntensityPoint = horizontalMetresToPixels(
-				targetSize.y,
-				mFog.GetMaxDistance(),
-				camera.GetHeight());
+		// Draw the ground, fog and sky.
+		mBackground.Draw(target, camera, mFog, groundColor * mAmbientLight.mColor, skyColor);
 
-			rect.setSize(sf::Vector2f((float)targetSize.x, (float)maxIntensityPoint));
+		// There's no seeing the sky with a ceiling in the way.
+		if (!mFloorCaster.HasCeiling()) {
+			mSky.Render(target, camera);
+		}
 
-			const sf::Color maxIntensityColor(
-				mFog.GetColor().r,
-				mFog.GetColor().g,
-				mFog.GetColor().b,
-				(sf::Uint8)(mFog.GetMaxIntensity() * 255));
+		mFloorCaster.Render(target, camera, mFog, mAmbientLight);
 
-			rect.setFillColor(maxIntensityColor);
+		raycastRenderer.SubmitFrame(target);
+	}
 
-			target.draw(rect);
+	// Render stuff that goes on top of the 3D image (effects, HUD, weapons...)
+	camera.DrawOverlay(target);
+}
 
-			const int minIntensityPoint = horizontalMetresToPixels(
-				targetSize.y,
-				mFog.GetMinDistance(),
-				camera.GetHeight());
+void World::Render3D(
+	sf::Image& image,
+	const Camera3D& camera,
+	WorldRaycastRenderer& raycastRenderer)
+{
+	// Not profiled, so that screenshots don't throw off the dynamic resolution.
+	UpdateDetachedRenderComponents();
 
-			const sf::Color minIntensityColor = mFog.GetColor();
+	mRenderProxies->Synchronize();
 
-			DrawGradientRectVertical(
-				target,
-				sf::Vector2i(0, (top + maxIntensityPoint)),
-				sf::Vector2i((int)targetSize.x, (top + minIntensityPoint)),
-				maxIntensityColor,
-				minIntensityColor,
-				1);
-		}
-	}
-	// Draw sky.
-	{
-		// Draw background
-		{
-			sf::RectangleShape rect;
-			rect.setPosition(0.0f, 0.0f);
-			const float height = (float)(targetSize.y / 2) + GetPitchOffsetInPixels(camera, targetSize.y);
-			rect.setSize(sf::Vector2f((float)targetSize.x, height));
-			rect.setFillColor(skyColor);
-			target.draw(rect);
-		}
+	const sf::Vector2u targetSize = image.getSize();
 
-		mSky.Render(target, camera);
-	}
+	raycastRenderer.BeginFrame(*this, camera, mRenderSettings, targetSize);
 
-	{
-		ProfilerScope ps(sRenderProfiler);
+	// Over black, like the window, in case the sky is see-through.
+	const auto opaque = [](const sf::Color color) {
+		return sf::Color(
+			(sf::Uint8)(color.r * color.a / 255),
+			(sf::Uint8)(color.g * color.a / 255),
+			(sf::Uint8)(color.b * color.a / 255));
+	};
+
+	const sf::Color sky = opaque(skyColor);
+	const sf::Color ground = opaque(groundColor * mAmbientLight.mColor);
 
-		raycastRenderer.Render(*this, camera, mRenderSettings, target);
+	const int horizon = std::min(
+		std::max((int)(targetSize.y / 2) + GetPitchOffsetInPixels(camera, targetSize.y), 0),
+		(int)targetSize.y);
+
+	image.create(targetSize.x, targetSize.y, sky);
+
+	for (unsigned y = horizon; y < targetSize.y; ++y) {
+		for (unsigned x = 0; x < targetSize.x; ++x) {
+			image.setPixel(x, y, ground);
+		}
 	}
 
-	// Render stuff that goes on top of the 3D image (effects, HUD, weapons...)
-	camera.DrawOverlay(target);
+	raycastRenderer.SubmitFrame(image);
 }
 
 bool World::RegisterUiRenderer(WorldUiRenderer& renderer)
@@ -463,6 +450,18 @@ bool World::ToJson(nlohmann::json & j) const {
 
 	mSky.ToJson(j["Sky"]);
 
+	if (mFloorCaster.IsEnabled()) {
+		j["FloorCasting"] = mFloorCaster.ToJson();
+	}
+
+	if (mTileMap) {
+		j["TileMap"] = mTileMap->ToJson();
+	}
+
+	if (!mSectors.IsEmpty()) {
+		j["Sectors"] = mSectors.ToJson();
+	}
+
 	j[animationsFieldName] = mAnimators;
 
 	unsigned serializedEntityCount = 0;
@@ -512,7 +511,29 @@ World::World(
 	}
 
 	if (j.find("Sky") != j.end()) {
-		mSky.FromJson(j["Sky"]);
+		mSky.FromJson(j["Sky"], *mTextureLibrary);
+	}
+
+	if (j.find("FloorCasting") != j.end()) {
+		if (!mFloorCaster.FromJson(j["FloorCasting"], *mTextureLibrary)) {
+			log->error("Failed to deserialize the FloorCasting.");
+		}
+	}
+
+	if (j.find("TileMap") != j.end()) {
+		mTileMap = TileMap::FromJson(j["TileMap"], *mTextureLibrary);
+
+		if (!mTileMap) {
+			log->error("Failed to deserialize the TileMap.");
+		}
+
+		SyncTileMapBody();
+	}
+
+	if (j.find("Sectors") != j.end()) {
+		if (!mSectors.FromJson(j["Sectors"])) {
+			log->error("Failed to deserialize the Sectors.");
+		}
 	}
 
 	mAmbientLight = FromJson(j.value<nlohmann::json>("AmbientLight", {}));
@@ -685,11 +706,10 @@ bool World::UnregisterDetachedRenderComponent(const RenderComponent& renderCompo
 	return false;
 }
 
-void World::UpdateDetachedRenderComponents(const Camera3D& camera)
+void World::UpdateDetachedRenderComponents()
 {
 	for (auto renderComp : mDetachedRenderComponents) {
-		renderComp.get().UpdateDetachedBodyPosition();
-		renderComp.get().UpdateDetachedBodyRotation(camera.GetRotation());
+		renderComp.get().UpdateDetachedSpritePosition();
 	}
 }
 
@@ -832,93 +852,158 @@ void World::GuiControls() {
 
 		ColourUtils::ImGuiColourEdit("BG Colour", skyColor);
 
-		mSky.EditorImGuiControls();
+		mSky.EditorImGuiControls(*mTextureLibrary);
+	}
+
+	if (ImGui::CollapsingHeader("Floor and Ceiling")) {
+		ImGui::AutoIndent indent;
+
+		mFloorCaster.EditorImGuiControls(*mTextureLibrary);
+	}
+
+	if (ImGui::CollapsingHeader("Tile Map")) {
+		ImGui::AutoIndent indent;
+
+		if (mTileMap) {
+			if (ImGui::Button("Remove Tile Map")) {
+				RemoveTileMap();
+			}
+			else {
+				mTileMap->EditorImGuiControls(*mTextureLibrary);
+			}
+		}
+		else {
+			ImGui::Text("This World has no Tile Map.");
+
+			if (ImGui::Button("Create Tile Map")) {
+				TileMap& tileMap = CreateTileMap(32, 32);
+				tileMap.AddType("Wall");
+			}
+		}
+	}
+
+	if (ImGui::CollapsingHeader("Sectors")) {
+		ImGui::AutoIndent indent;
+		mSectors.EditorImGuiControls();
 	}
 
 	if (ImGui::CollapsingHeader("Raycast Renderer")) {
 		ImGui::AutoIndent indent;
 
 		ImGui::SliderFloat("Ray Length", &mRenderSettings.m_RayLength, 1.0f, 100.0f);
+
+		ImGui::Checkbox("Fog Culling", &mRenderSettings.m_FogCulling);
+
+		if (mRenderSettings.m_FogCulling &&
+			mFog.GetOpaqueDistance() == std::numeric_limits<float>::infinity())
+		{
+			ImGui::SameLine();
+			ImGui::Text("(Fog is never opaque, so nothing is culled)");
+		}
+
+		ImGui::SliderInt(
+			"Raycast Threads",
+			&mRenderSettings.m_RaycastThreadCount,
+			0,
+			(int)WorkerPool::GetHardwareThreadCount());
+
+		if (mRenderSettings.m_RaycastThreadCount == 0) {
+			ImGui::SameLine();
+			ImGui::Text("(All)");
+		}
+
+		ImGui::Checkbox("Ray Packets", &mRenderSettings.m_UseRayPackets);
+
+		if (mRenderSettings.m_UseRayPackets) {
+			const RayPacketKernel kernel = GetBestRayPacketKernel();
+			ImGui::SameLine();
+			ImGui::Text("(%s, %d rays)", ToString(kernel), GetRayPacketWidth(kernel));
+		}
+
+		ImGui::Checkbox("Incremental Raycast", &mRenderSettings.m_IncrementalRaycast);
+
+		ImGui::Checkbox("Texture Atlas", &mRenderSettings.m_UseTextureAtlas);
+
+		if (mRenderSettings.m_UseTextureAtlas && mRenderSettings.m_Mipmaps) {
+			ImGui::SameLine();
+			ImGui::Text("(Mipmaps are on, so textures stay off the atlas)");
+		}
+
+		ImGui::Checkbox("Mipmaps", &mRenderSettings.m_Mipmaps);
+
+		ImGui::Checkbox("Merge Column Spans", &mRenderSettings.m_MergeColumnSpans);
+
+		ImGui::Checkbox("Opaque Depth Pass", &mRenderSettings.m_OpaqueDepthPass);
+
+		ImGui::Checkbox("Dynamic Resolution", &mRenderSettings.m_DynamicResolution);
+
+		if (mRenderSettings.m_DynamicResolution)
+		{
+			ImGui::AutoIndent indent2;
+
+			ImGui::SliderFloat("Target Frame Time (ms)", &mRenderSettings.m_TargetFrameTime, 4.0f, 33.0f);
+
+			if (ImGui::SliderFloat("Min Scale", &mRenderSettings.m_MinResolutionScale, 0.05f, 1.0f)) {
+				mRenderSettings.m_MaxResolutionScale =
+					std::max(mRenderSettings.m_MaxResolutionScale, mRenderSettings.m_MinResolutionScale);
+			}
+
+			if (ImGui::SliderFloat("Max Scale", &mRenderSettings.m_MaxResolutionScale, 0.05f, 1.0f)) {
+				mRenderSettings.m_MinResolutionScale =
+					std::min(mRenderSettings.m_MinResolutionScale, mRenderSettings.m_MaxResolutionScale);
+			}
+		}
 	}
 }
 
+namespace {
+
+void PlotProfiler(const char* label, Profiler& profiler)
+{
+	const std::string s = fmt::format(
+		"n: {}, avg: {}ms",
+		profiler.BufferSize(),
+		profiler.GetAverage().count());
+
+	ImGui::PlotLines(
+		label,
+		[](void* data, int idx)->float
+		{
+			auto profiler = (Profiler*)data;
+
+			Profiler::SampleUnit sample = profiler->GetSample(idx);
+
+			return sample.count();
+		},
+		&profiler,
+		profiler.BufferSize(),
+		0,
+		s.c_str(),
+		FLT_MAX,
+		FLT_MAX,
+		ImVec2(0, 80));
+}
+
+}
+
 void World::GuiPerformanceInfo()
 {
 	if (ImGui::CollapsingHeader("Render3D"))
 	{
 		ImGui::AutoIndent indent;
 
-		std::string s = fmt::format(
-			"n: {}, avg: {}ms",
-			sPreRenderProfiler.BufferSize(),
-			sPreRenderProfiler.GetAverage().count());
+		PlotProfiler("Pre-Render", sPreRenderProfiler);
+		PlotProfiler("Render3D", sRenderProfiler);
+		PlotProfiler("Raycast", sRaycastProfiler);
 
-		ImGui::PlotLines(
-			"Pre-Render",
-			[](void* data, int idx)->float
-			{
-				auto profiler = (Profiler*)data;
-
-				Profiler::SampleUnit sample = profiler->GetSample(idx);
-
-				return sample.count();
-			},
-			&sPreRenderProfiler,
-			sPreRenderProfiler.BufferSize(),
-			0,
-			s.c_str(),
-			FLT_MAX,
-			FLT_MAX,
-			ImVec2(0, 80));
-
-		s = fmt::format(
-			"n: {}, avg: {}ms",
-			sRenderProfiler.BufferSize(),
-			sRenderProfiler.GetAverage().count());
-
-		ImGui::PlotLines(
-			"Render3D",
-			[](void* data, int idx)->float {
-				auto profiler = (Profiler*)data;
-
-				Profiler::SampleUnit sample = profiler->GetSample(idx);
-
-				return sample.count();
-			},
-			&sRenderProfiler,
-			sRenderProfiler.BufferSize(),
-			0,
-			s.c_str(),
-			FLT_MAX,
-			FLT_MAX,
-			ImVec2(0, 80));
+		ImGui::Text("Background rebuilds: %u", mBackground.GetRebuildCount());
 	}
 
 	if (ImGui::CollapsingHeader("TakeStep"))
 	{
 		ImGui::AutoIndent indent;
 
-		std::string s = fmt::format(
-			"n: {}, avg: {}ms",
-			sStepProfiler.BufferSize(),
-			sStepProfiler.GetAverage().count());
-
-		ImGui::PlotLines(
-			"TakeStep",
-			[](void* data, int idx)->float {
-				auto profiler = (Profiler*)data;
-
-				Profiler::SampleUnit sample = profiler->GetSample(idx);
-
-				return sample.count();
-			},
-			&sStepProfiler,
-			sStepProfiler.BufferSize(),
-			0,
-			s.c_str(),
-			FLT_MAX,
-			FLT_MAX,
-			ImVec2(0, 80));
+		PlotProfiler("TakeStep", sStepProfiler);
 	}
 }
 
@@ -14,10 +14,15 @@
 #include "Quiver/Entity/CustomComponent/CustomComponentUpdater.h"
 #include "Quiver/Entity/EntityId.h"
 #include "Quiver/Entity/EntityPrefab.h"
+#include "Quiver/Graphics/BackgroundCache.h"
+#include "Quiver/Graphics/FloorCaster.h"
 #include "Quiver/Graphics/Fog.h"
 #include "Quiver/Graphics/Light.h"
+#include "Quiver/Graphics/ParticleSystem.h"
+#include "Quiver/Graphics/PointLights.h"
 #include "Quiver/Graphics/RenderSettings.h"
 #include "Quiver/Graphics/Sky.h"
+#include "Quiver/World/SectorGraph.h"
 #include "Quiver/World/WorldContext.h"
 
 struct b2Transform;
@@ -28,6 +33,7 @@ class b2Shape;
 class b2World;
 
 namespace sf {
+class Image;
 class RenderTarget;
 }
 
@@ -45,7 +51,9 @@ class Entity;
 class EntityPrefab;
 class RawInputDevices;
 class RenderComponent;
+class RenderProxyIndex;
 class TextureLibrary;
+class TileMap;
 class World;
 class WorldContext;
 class WorldRaycastRenderer;
@@ -90,6 +98,15 @@ public:
 		const Camera3D& camera,
 		WorldRaycastRenderer& raycastRenderer);
 
+	// Renders on the CPU, at the image's size, with WorldRaycastRenderer's software rasterizer.
+	// The ground and sky are flat colours, without the fog, sky layers or floor casting, which
+	// all need GL. Works without a window as long as the texture atlas is off and nothing has
+	// a texture that hasn't been copied back from GL already.
+	void Render3D(
+		sf::Image& image,
+		const Camera3D& camera,
+		WorldRaycastRenderer& raycastRenderer);
+
 	void RenderUI(sf::RenderTarget& target);
 
 	Entity* CreateEntity(const b2Shape & shape, const b2Vec2 & position, const float angle = 0.0f);
@@ -124,7 +141,30 @@ public:
 	bool RegisterDetachedRenderComponent(const RenderComponent& renderComponent);
 	bool UnregisterDetachedRenderComponent(const RenderComponent& renderComponent);
 
-	void UpdateDetachedRenderComponents(const Camera3D& camera);
+	// Billboards face the camera by themselves, so this only has to move them.
+	void UpdateDetachedRenderComponents();
+
+	RenderProxyIndex&       GetRenderProxies()       { return *mRenderProxies.get(); }
+	const RenderProxyIndex& GetRenderProxies() const { return *mRenderProxies.get(); }
+
+	PointLightIndex&       GetPointLights()       { return mPointLights; }
+	const PointLightIndex& GetPointLights() const { return mPointLights; }
+
+	ParticleSystem&       GetParticles()       { return mParticles; }
+	const ParticleSystem& GetParticles() const { return mParticles; }
+
+	const RenderSettings& GetRenderSettings() const { return mRenderSettings; }
+
+	// nullptr if the World doesn't have one.
+	TileMap*       GetTileMap()       { return mTileMap.get(); }
+	const TileMap* GetTileMap() const { return mTileMap.get(); }
+
+	// Replaces any existing TileMap.
+	TileMap& CreateTileMap(const int width, const int height, const float tileSize = 1.0f);
+	void RemoveTileMap();
+
+	SectorGraph&       GetSectors()       { return mSectors; }
+	const SectorGraph& GetSectors() const { return mSectors; }
 
 	bool RegisterAudioComponent(const AudioComponent& audioComponent);
 	bool UnregisterAudioComponent(const AudioComponent& audioComponent);
@@ -189,6 +229,9 @@ private:
 
 	void UpdateAudioComponents();
 
+	// Rebuilds the TileMap's static body if the map has changed since it was last built.
+	void SyncTileMapBody();
+
 	std::chrono::duration<float> mTimestep = std::chrono::duration<float>(1.0f / 60.0f);
 
 	int mStepCount = 0;
@@ -216,6 +259,17 @@ private:
 	std::unique_ptr<b2ContactListener> mContactListener;
 	std::unique_ptr<AudioLibrary>      mAudioLibrary;
 	std::unique_ptr<TextureLibrary>    mTextureLibrary;
+	std::unique_ptr<RenderProxyIndex>  mRenderProxies;
+	std::unique_ptr<TileMap>           mTileMap;
+
+	// Before mEntities, so that their RenderComponents can take their lights out of it.
+	PointLightIndex mPointLights;
+
+	ParticleSystem mParticles;
+
+	// Has no user data, unlike the bodies of Entities.
+	b2Body* mTileMapBody = nullptr;
+	unsigned mTileMapBodyGeneration = 0;
 
 	std::vector<std::reference_wrapper<Camera3D>>        mCameras;
 	std::vector<std::reference_wrapper<RenderComponent>> mDetachedRenderComponents;
@@ -226,8 +280,14 @@ private:
 
 	CustomComponentUpdater m_CustomComponentUpdater;
 
+	BackgroundCache mBackground;
+
 	Sky mSky;
 
+	FloorCaster mFloorCaster;
+
+	SectorGraph mSectors;
+
 	RenderSettings mRenderSettings;
 
 	ApplicationStateCreator mNextApplicationStateFactory;
@@ -0,0 +1,141 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "Quiver/Graphics/ColumnDepthSort.h"
+
+using namespace qvr;
+
+namespace {
+
+struct Hit {
+	float distance;
+	int column;
+	int id;
+};
+
+const auto GetDistance = [](const Hit& hit) { return hit.distance; };
+
+// Something shaped like a frame's worth of intersections: lots of columns with a few hits each.
+std::vector<std::vector<Hit>> GenerateColumns(
+	const int columnCount,
+	const int maxHitsPerColumn,
+	const unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<int> hitCount(0, maxHitsPerColumn);
+	std::uniform_real_distribution<float> distance(0.0f, 1.0f);
+
+	std::vector<std::vector<Hit>> columns(columnCount);
+
+	int id = 0;
+	for (int column = 0; column < columnCount; ++column) {
+		const int n = hitCount(rng);
+		for (int i = 0; i < n; ++i) {
+			columns[column].push_back(Hit{ distance(rng), column, id++ });
+		}
+	}
+
+	return columns;
+}
+
+}
+
+TEST_CASE("SortBackToFront", "[Graphics]")
+{
+	SECTION("Empty and single-element ranges are left alone") {
+		std::vector<Hit> hits;
+		SortBackToFront(hits.begin(), hits.end(), GetDistance);
+		REQUIRE(hits.empty());
+
+		hits.push_back(Hit{ 0.5f, 0, 0 });
+		SortBackToFront(hits.begin(), hits.end(), GetDistance);
+		REQUIRE(hits[0].id == 0);
+	}
+
+	SECTION("Furthest comes first") {
+		for (auto& column : GenerateColumns(64, 32, 1)) {
+			SortBackToFront(column.begin(), column.end(), GetDistance);
+
+			REQUIRE(std::is_sorted(column.begin(), column.end(),
+				[](const Hit& a, const Hit& b) { return a.distance > b.distance; }));
+		}
+	}
+
+	SECTION("Equal distances keep their order") {
+		std::vector<Hit> hits = { {0.5f, 0, 0}, {0.7f, 0, 1}, {0.5f, 0, 2}, {0.5f, 0, 3} };
+
+		SortBackToFront(hits.begin(), hits.end(), GetDistance);
+
+		REQUIRE(hits[0].id == 1);
+		REQUIRE(hits[1].id == 0);
+		REQUIRE(hits[2].id == 2);
+		REQUIRE(hits[3].id == 3);
+	}
+}
+
+// Hidden; run with: QuiverTests "[benchmark]"
+TEST_CASE("SortBackToFront per column vs std::sort over the whole frame", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<float, std::milli>;
+
+	const int columnCount = 1920;
+	const int iterations = 50;
+
+	const auto columns = GenerateColumns(columnCount, 32, 2);
+
+	Milliseconds perColumnTime(0);
+	Milliseconds globalSortTime(0);
+
+	std::vector<Hit> perColumnResult;
+	std::vector<Hit> globalSortResult;
+
+	for (int i = 0; i < iterations; ++i)
+	{
+		auto unsorted = columns;
+
+		{
+			const auto start = Clock::now();
+
+			perColumnResult.clear();
+			for (auto& column : unsorted) {
+				SortBackToFront(column.begin(), column.end(), GetDistance);
+				perColumnResult.insert(perColumnResult.end(), column.begin(), column.end());
+			}
+
+			perColumnTime += Clock::now() - start;
+		}
+
+		{
+			const auto start = Clock::now();
+
+			globalSortResult.clear();
+			for (const auto& column : columns) {
+				globalSortResult.insert(globalSortResult.end(), column.begin(), column.end());
+			}
+			std::sort(globalSortResult.begin(), globalSortResult.end(),
+				[](const Hit& a, const Hit& b) { return a.distance > b.distance; });
+
+			globalSortTime += Clock::now() - start;
+		}
+	}
+
+	WARN(
+		globalSortResult.size() << " intersections over " << columnCount << " columns. "
+		<< "Per-column: " << (perColumnTime / iterations).count() << "ms, "
+		<< "std::sort: " << (globalSortTime / iterations).count() << "ms");
+
+	// Same hits, and every column is still painted back-to-front.
+	REQUIRE(perColumnResult.size() == globalSortResult.size());
+
+	for (int column = 0; column < columnCount; ++column) {
+		std::vector<int> fromPerColumn, fromGlobal;
+		for (const Hit& hit : perColumnResult) if (hit.column == column) fromPerColumn.push_back(hit.id);
+		for (const Hit& hit : globalSortResult) if (hit.column == column) fromGlobal.push_back(hit.id);
+		REQUIRE(fromPerColumn == fromGlobal);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include <catch.hpp>
+
+#include <random>
+
+#include "Quiver/Graphics/ColumnProjection.h"
+
+using namespace qvr;
+
+TEST_CASE("ProjectColumns matches the scalar projection", "[ColumnProjection]")
+{
+	ColumnProjection projection;
+	projection.cameraPosition = b2Vec2(3.0f, -2.0f);
+	projection.cameraForwards = b2Vec2(0.6f, 0.8f);
+	projection.cameraRight = b2Vec2(-0.8f, 0.6f);
+	projection.targetHeight = 480.0f;
+	projection.cameraHeightOffset = 0.1f;
+	projection.cameraPitchOffset = -20.0f;
+	projection.horizon = 0.5f * projection.targetHeight + projection.cameraPitchOffset;
+	projection.cameraHeightOffsetTerm = 2.0f * projection.cameraHeightOffset;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> unit(0.05f, 1.0f);
+
+	ColumnBatch batch;
+
+	// Not a multiple of four, so the scalar tail gets used too.
+	const int count = 103;
+
+	for (int i = 0; i < count; ++i) {
+		const b2Vec2 sprite(coordinate(rng), coordinate(rng));
+		const float radius = unit(rng);
+		const b2Vec2 point = sprite + (2.0f * unit(rng) - 1.0f) * radius * projection.cameraRight;
+
+		batch.Add(point, unit(rng), unit(rng) - 0.5f, sprite, radius, 16.0f * i, 64.0f);
+	}
+
+	ProjectColumns(projection, batch);
+
+	REQUIRE(batch.distance.size() == count);
+	REQUIRE(batch.u.size() == count);
+
+	for (int i = 0; i < count; ++i) {
+		const b2Vec2 point(batch.pointX[i], batch.pointY[i]);
+		const float distance = projection.GetDistance(point);
+
+		float top, bottom;
+		projection.GetTopAndBottom(distance, batch.height[i], batch.groundOffset[i], top, bottom);
+
+		const b2Vec2 left =
+			b2Vec2(batch.spriteX[i], batch.spriteY[i]) - batch.spriteRadius[i] * projection.cameraRight;
+		const float u =
+			(point - left).Length() / (2.0f * batch.spriteRadius[i]) * batch.textureWidth[i] + batch.textureLeft[i];
+
+		CHECK(batch.distance[i] == Approx(distance));
+		CHECK(batch.top[i] == Approx(top).epsilon(1e-4));
+		CHECK(batch.bottom[i] == Approx(bottom).epsilon(1e-4));
+		CHECK(batch.u[i] == Approx(u).epsilon(1e-4));
+	}
+
+	batch.Clear();
+	ProjectColumns(projection, batch);
+
+	CHECK(batch.Size() == 0);
+	CHECK(batch.top.empty());
+}
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "Quiver/Graphics/ColumnRasterizer.h"
+
+using namespace qvr;
+
+namespace {
+
+RasterHit MakeHit(const float top, const float bottom, const std::uint8_t alpha = 255)
+{
+	RasterHit hit;
+	hit.top = top;
+	hit.bottom = bottom;
+	hit.distance = 1.0f;
+	hit.u = 0.0f;
+	hit.vTop = 0.0f;
+	hit.vBottom = bottom - top;
+	hit.normalX = 0.0f;
+	hit.normalY = 0.0f;
+	hit.color[0] = 255;
+	hit.color[1] = 255;
+	hit.color[2] = 255;
+	hit.color[3] = alpha;
+	hit.texture = nullptr;
+	return hit;
+}
+
+}
+
+TEST_CASE("ColumnMajorTexture stores texels column by column", "[ColumnRasterizer]")
+{
+	// 2 wide, 3 high. Red is the x, green is the y.
+	std::vector<std::uint8_t> pixels;
+	for (std::uint8_t y = 0; y < 3; ++y) {
+		for (std::uint8_t x = 0; x < 2; ++x) {
+			pixels.insert(pixels.end(), { x, y, 0, 255 });
+		}
+	}
+
+	ColumnMajorTexture texture;
+	texture.Assign(2, 3, pixels.data());
+
+	REQUIRE(texture.width == 2);
+	REQUIRE(texture.height == 3);
+
+	for (unsigned x = 0; x < 2; ++x) {
+		for (unsigned y = 0; y < 3; ++y) {
+			CHECK(texture.GetColumn(x)[4 * y] == x);
+			CHECK(texture.GetColumn(x)[4 * y + 1] == y);
+		}
+	}
+}
+
+TEST_CASE("RasterizeColumn covers the pixels whose centres are inside the hit", "[ColumnRasterizer]")
+{
+	std::vector<std::uint8_t> column(4 * 8, 0);
+
+	const RasterHit hit = MakeHit(1.6f, 5.5f);
+
+	RasterizeColumn(column.data(), 8, &hit, 1, ColumnLighting());
+
+	// Centres at 2.5, 3.5 and 4.5 are in; 1.5 and 5.5 are out.
+	const std::uint8_t expected[8] = { 0, 0, 255, 255, 255, 0, 0, 0 };
+
+	for (unsigned y = 0; y < 8; ++y) {
+		CHECK(column[4 * y] == expected[y]);
+	}
+}
+
+TEST_CASE("RasterizeColumn samples column-major textures", "[ColumnRasterizer]")
+{
+	// 2 wide, 4 high. Red is the row.
+	std::vector<std::uint8_t> pixels;
+	for (std::uint8_t y = 0; y < 4; ++y) {
+		for (std::uint8_t x = 0; x < 2; ++x) {
+			pixels.insert(pixels.end(), { std::uint8_t(y * 50), std::uint8_t(x * 100), 0, 255 });
+		}
+	}
+
+	ColumnMajorTexture texture;
+	texture.Assign(2, 4, pixels.data());
+
+	// Stretched over 8 pixels, so each texel covers two.
+	RasterHit hit = MakeHit(0.0f, 8.0f);
+	hit.u = 1.5f;
+	hit.vBottom = 4.0f;
+	hit.texture = &texture;
+
+	std::vector<std::uint8_t> column(4 * 8, 0);
+
+	RasterizeColumn(column.data(), 8, &hit, 1, ColumnLighting());
+
+	for (unsigned y = 0; y < 8; ++y) {
+		CHECK(column[4 * y] == (y / 2) * 50);
+		CHECK(column[4 * y + 1] == 100);
+	}
+
+	SECTION("Coordinates off the texture clamp to its edges")
+	{
+		hit.u = 7.0f;
+		hit.vTop = -4.0f;
+		hit.vBottom = 12.0f;
+
+		RasterizeColumn(column.data(), 8, &hit, 1, ColumnLighting());
+
+		CHECK(column[0] == 0);
+		CHECK(column[1] == 100);
+		CHECK(column[4 * 7] == 150);
+	}
+}
+
+TEST_CASE("RasterizeColumn samples smaller mips further away", "[ColumnRasterizer]")
+{
+	// 1 wide, 32 high, in stripes a texel high. Red is the stripe.
+	std::vector<std::uint8_t> pixels;
+	for (unsigned y = 0; y < 32; ++y) {
+		pixels.insert(pixels.end(), { std::uint8_t(y % 2 ? 200 : 0), 0, 0, 255 });
+	}
+
+	ColumnMajorTexture texture;
+	texture.Assign(1, 32, pixels.data());
+	texture.GenerateMips();
+
+	RasterHit hit = MakeHit(0.0f, 32.0f);
+	hit.vBottom = 32.0f;
+	hit.texture = &texture;
+
+	std::vector<std::uint8_t> column(4 * 32, 0);
+
+	SECTION("Up close, every stripe shows") {
+		RasterizeColumn(column.data(), 32, &hit, 1, ColumnLighting());
+
+		for (unsigned y = 0; y < 32; ++y) {
+			CHECK(column[4 * y] == (y % 2 ? 200 : 0));
+		}
+	}
+
+	SECTION("Far off, they blur together") {
+		hit.bottom = 4.0f;
+
+		RasterizeColumn(column.data(), 32, &hit, 1, ColumnLighting());
+
+		for (unsigned y = 0; y < 4; ++y) {
+			CHECK(column[4 * y] == 100);
+		}
+	}
+}
+
+TEST_CASE("RasterizeColumn lights like the column shader", "[ColumnRasterizer]")
+{
+	std::vector<std::uint8_t> column(4, 0);
+
+	ColumnLighting lighting;
+	lighting.ambientColor[0] = 0.5f;
+	lighting.ambientColor[1] = 0.5f;
+	lighting.ambientColor[2] = 0.5f;
+
+	RasterHit hit = MakeHit(0.0f, 1.0f);
+
+	SECTION("Ambient")
+	{
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+
+		CHECK(column[0] == 128);
+		CHECK(column[3] == 255);
+	}
+
+	SECTION("Directional light only lights faces that point towards it")
+	{
+		lighting.directionalColor[0] = 0.25f;
+		lighting.directionalDirection[0] = -1.0f;
+
+		hit.normalX = 1.0f;
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+		CHECK(column[0] == 191);
+		CHECK(column[1] == 128);
+
+		hit.normalX = -1.0f;
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+		CHECK(column[0] == 128);
+	}
+
+	SECTION("Fog goes from nothing at its min distance to its max intensity")
+	{
+		lighting.fogColor[2] = 1.0f;
+		lighting.fogMinDistance = 10.0f;
+		lighting.fogMaxDistance = 20.0f;
+		lighting.fogMaxIntensity = 0.4f;
+
+		hit.distance = 5.0f;
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+		CHECK(column[2] == 128);
+
+		hit.distance = 12.5f;
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+		CHECK(column[2] == 191);
+
+		hit.distance = 100.0f;
+		RasterizeColumn(column.data(), 1, &hit, 1, lighting);
+		CHECK(column[2] == 230);
+	}
+}
+
+TEST_CASE("RasterizeColumn blends translucent hits over what's behind them", "[ColumnRasterizer]")
+{
+	std::vector<std::uint8_t> column(4 * 2, 0);
+
+	RasterHit hits[2] = { MakeHit(0.0f, 2.0f), MakeHit(1.0f, 2.0f, 51) };
+	hits[0].color[1] = 0;
+	hits[0].color[2] = 0;
+	hits[1].color[0] = 0;
+
+	RasterizeColumn(column.data(), 2, hits, 2, ColumnLighting());
+
+	// Only the back one.
+	CHECK(column[0] == 255);
+	CHECK(column[1] == 0);
+	CHECK(column[3] == 255);
+
+	// A fifth of the front one.
+	CHECK(column[4] == 204);
+	CHECK(column[5] == 51);
+	CHECK(column[6] == 51);
+	CHECK(column[7] == 255);
+}
\ No newline at end of file
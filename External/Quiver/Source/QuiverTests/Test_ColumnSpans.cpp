@@ -0,0 +1,247 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Quiver/Graphics/ColumnProjection.h"
+#include "Quiver/Graphics/ColumnSpans.h"
+
+using namespace qvr;
+
+namespace {
+
+// Hits, laid out the way the raycast renderer lays them out.
+struct Hits
+{
+	std::vector<float> x, normalX, normalY, distance, top, bottom, u;
+	std::vector<int> proxy;
+	// Optional. RGBA, 4 per hit.
+	std::vector<std::uint8_t> color;
+
+	void Add(const float column, const int proxyId, const b2Vec2& normal, const float d, const float t, const float b, const float texU) {
+		x.push_back(column);
+		proxy.push_back(proxyId);
+		normalX.push_back(normal.x);
+		normalY.push_back(normal.y);
+		distance.push_back(d);
+		top.push_back(t);
+		bottom.push_back(b);
+		u.push_back(texU);
+	}
+
+	ColumnSpanInput GetInput() const {
+		ColumnSpanInput input;
+		input.count = x.size();
+		input.x = x.data();
+		input.proxy = proxy.data();
+		input.normalX = normalX.data();
+		input.normalY = normalY.data();
+		input.distance = distance.data();
+		input.top = top.data();
+		input.bottom = bottom.data();
+		input.u = u.data();
+		input.color = color.empty() ? nullptr : color.data();
+		return input;
+	}
+};
+
+// A camera at the origin looking along +x, with a 90 degree field of view over columnCount columns.
+struct Scene
+{
+	static const int columnCount = 16;
+
+	ColumnProjection projection;
+
+	Scene() {
+		projection.targetHeight = 100.0f;
+		projection.horizon = 50.0f;
+	}
+
+	b2Vec2 RayDirection(const int column) const {
+		const float screenX = -1.0f + 2.0f * column / columnCount;
+		return b2Vec2(1.0f, screenX);
+	}
+
+	// Where the column's ray crosses the line through a and b, as a fraction from a to b.
+	float Intersect(const int column, const b2Vec2& a, const b2Vec2& b) const {
+		const b2Vec2 d = RayDirection(column);
+		const b2Vec2 e = b - a;
+		// Solve a + s * e = t * d for s.
+		return -b2Cross(a, d) / b2Cross(e, d);
+	}
+
+	// A wall from a to b, with a texture 64 texels wide stretched along it.
+	void AddWall(Hits& hits, const int column, const int proxyId, const b2Vec2& a, const b2Vec2& b) const {
+		const float s = Intersect(column, a, b);
+		const b2Vec2 point = a + s * (b - a);
+		const float distance = projection.GetDistance(point);
+
+		float top, bottom;
+		projection.GetTopAndBottom(distance, 1.0f, 0.0f, top, bottom);
+
+		const b2Vec2 edge = b - a;
+		const b2Vec2 normal = b2Vec2(edge.y, -edge.x);
+
+		hits.Add((float)column, proxyId, normal, distance, top, bottom, 64.0f * s);
+	}
+};
+
+// True if every column's hits get drawn in the order they came in.
+bool PaintsBackToFront(const Hits& hits, const std::vector<ColumnSpan>& spans)
+{
+	std::vector<int> drawnAt(hits.x.size(), -1);
+
+	for (int i = 0; i < (int)spans.size(); ++i)
+	{
+		const ColumnSpan& span = spans[i];
+
+		for (unsigned hit = 0; hit < hits.x.size(); ++hit)
+		{
+			const bool inSpan =
+				hits.proxy[hit] == hits.proxy[span.first] &&
+				hits.normalX[hit] == hits.normalX[span.first] &&
+				hits.normalY[hit] == hits.normalY[span.first] &&
+				hits.x[hit] >= hits.x[span.first] &&
+				hits.x[hit] <= hits.x[span.last];
+
+			if (inSpan) {
+				if (drawnAt[hit] >= 0) return false;
+				drawnAt[hit] = i;
+			}
+		}
+	}
+
+	for (unsigned hit = 0; hit < hits.x.size(); ++hit)
+	{
+		if (drawnAt[hit] < 0) return false;
+
+		if (hit > 0 && hits.x[hit] == hits.x[hit - 1] && drawnAt[hit] <= drawnAt[hit - 1]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+TEST_CASE("ColumnSpanBuilder", "[Graphics]")
+{
+	Scene scene;
+	Hits hits;
+	ColumnSpanBuilder builder;
+	std::vector<ColumnSpan> spans;
+
+	SECTION("A flat wall becomes one span") {
+		for (int column = 0; column < Scene::columnCount; ++column) {
+			scene.AddWall(hits, column, 1, b2Vec2(3.0f, -5.0f), b2Vec2(8.0f, 5.0f));
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 1);
+		REQUIRE(spans[0].first == 0);
+		REQUIRE(spans[0].last == Scene::columnCount - 1);
+	}
+
+	SECTION("Things in front are drawn after the wall behind them") {
+		for (int column = 0; column < Scene::columnCount; ++column)
+		{
+			scene.AddWall(hits, column, 1, b2Vec2(8.0f, -10.0f), b2Vec2(8.0f, 10.0f));
+
+			if (column >= 5 && column <= 9) {
+				scene.AddWall(hits, column, 2, b2Vec2(2.0f, -1.0f), b2Vec2(2.0f, 1.0f));
+			}
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 2);
+		REQUIRE(PaintsBackToFront(hits, spans));
+		REQUIRE(hits.proxy[spans[0].first] == 1);
+		REQUIRE(hits.proxy[spans[1].first] == 2);
+	}
+
+	SECTION("Texture coordinates that don't follow the wall split it up") {
+		for (int column = 0; column < Scene::columnCount; ++column) {
+			scene.AddWall(hits, column, 1, b2Vec2(3.0f, -5.0f), b2Vec2(8.0f, 5.0f));
+			hits.u.back() = 4.0f * column * column;
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() > 1);
+		REQUIRE(PaintsBackToFront(hits, spans));
+	}
+
+	SECTION("Colours have to interpolate along the span too") {
+		for (int column = 0; column < Scene::columnCount; ++column) {
+			scene.AddWall(hits, column, 1, b2Vec2(3.0f, -5.0f), b2Vec2(8.0f, 5.0f));
+
+			// Brighter in the middle, like a light shining on the wall there.
+			const int bump = 16 * std::max(0, 4 - std::abs(column - Scene::columnCount / 2));
+			for (int c = 0; c < 4; ++c) {
+				hits.color.push_back((std::uint8_t)(c == 3 ? 255 : 100 + bump));
+			}
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() > 1);
+		REQUIRE(PaintsBackToFront(hits, spans));
+
+		// The same colour all the way along doesn't split it.
+		std::fill(hits.color.begin(), hits.color.end(), (std::uint8_t)200);
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 1);
+	}
+
+	SECTION("Different normals aren't merged") {
+		for (int column = 0; column < Scene::columnCount; ++column)
+		{
+			if (column < 8) {
+				scene.AddWall(hits, column, 1, b2Vec2(3.0f, -5.0f), b2Vec2(6.0f, 0.0f));
+			}
+			else {
+				scene.AddWall(hits, column, 1, b2Vec2(6.0f, 0.0f), b2Vec2(3.0f, 5.0f));
+			}
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 2);
+	}
+
+	SECTION("Crossing things fall back to a span per hit") {
+		// Proxy 1 is behind proxy 2 in the first column and in front of it in the second.
+		hits.Add(0.0f, 1, b2Vec2(-1.0f, 0.0f), 5.0f, 10.0f, 90.0f, 0.0f);
+		hits.Add(0.0f, 2, b2Vec2(-1.0f, 0.0f), 4.0f, 10.0f, 90.0f, 0.0f);
+		hits.Add(1.0f, 2, b2Vec2(-1.0f, 0.0f), 5.0f, 10.0f, 90.0f, 0.0f);
+		hits.Add(1.0f, 1, b2Vec2(-1.0f, 0.0f), 4.0f, 10.0f, 90.0f, 0.0f);
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 4);
+
+		for (unsigned i = 0; i < spans.size(); ++i) {
+			REQUIRE(spans[i].first == i);
+			REQUIRE(spans[i].last == i);
+		}
+	}
+
+	SECTION("Gaps between columns split spans") {
+		for (int column = 0; column < Scene::columnCount; ++column) {
+			if (column == 7) continue;
+			scene.AddWall(hits, column, 1, b2Vec2(3.0f, -5.0f), b2Vec2(8.0f, 5.0f));
+		}
+
+		builder.Build(hits.GetInput(), spans);
+
+		REQUIRE(spans.size() == 2);
+		REQUIRE(PaintsBackToFront(hits, spans));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include <catch.hpp>
+
+#include "Quiver/Graphics/DynamicResolution.h"
+#include "Quiver/Graphics/RenderSettings.h"
+
+using namespace qvr;
+
+namespace {
+
+// Pretends the render takes costAtFullScale, scaled linearly, and runs the controller
+// until it settles.
+float Settle(
+	DynamicResolution& controller,
+	const RenderSettings& settings,
+	const float stepTime,
+	const float costAtFullScale)
+{
+	for (int frame = 0; frame < 1000; ++frame)
+	{
+		controller.Update(
+			settings,
+			Profiler::SampleUnit(stepTime),
+			Profiler::SampleUnit(costAtFullScale * controller.GetScale()));
+	}
+
+	return controller.GetScale();
+}
+
+}
+
+TEST_CASE("DynamicResolution", "[Graphics]")
+{
+	RenderSettings settings;
+	settings.m_DynamicResolution = true;
+	settings.m_TargetFrameTime = 10.0f;
+	settings.m_MinResolutionScale = 0.25f;
+	settings.m_MaxResolutionScale = 1.0f;
+
+	DynamicResolution controller;
+	controller.Reset(settings, 1.0f);
+
+	SECTION("Stays at full resolution when there's time to spare") {
+		REQUIRE(Settle(controller, settings, 2.0f, 4.0f) == 1.0f);
+	}
+
+	SECTION("Shrinks until the render fits what the step leaves") {
+		const float scale = Settle(controller, settings, 2.0f, 16.0f);
+
+		REQUIRE(scale < 0.5f + 0.05f);
+		REQUIRE(scale > 0.5f * 0.8f - 0.05f);
+	}
+
+	SECTION("Grows back when things get cheaper") {
+		Settle(controller, settings, 2.0f, 16.0f);
+
+		REQUIRE(Settle(controller, settings, 2.0f, 4.0f) == 1.0f);
+	}
+
+	SECTION("Never leaves its bounds") {
+		REQUIRE(Settle(controller, settings, 2.0f, 1000.0f) == settings.m_MinResolutionScale);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "Quiver/Graphics/FloorCaster.h"
+
+using namespace qvr;
+
+namespace {
+
+FloorRow MakeRow(const float startU, const float startV, const float stepU, const float stepV)
+{
+	FloorRow row;
+	row.startU = startU;
+	row.startV = startV;
+	row.stepU = stepU;
+	row.stepV = stepV;
+
+	for (int c = 0; c < 4; ++c) {
+		row.scale[c] = 256;
+		row.add[c] = 0;
+	}
+
+	return row;
+}
+
+}
+
+TEST_CASE("FloorCaster", "[Graphics]")
+{
+	// Not a power of two either way, so wrapping can't be done with a mask.
+	const unsigned width = 5;
+	const unsigned height = 3;
+
+	std::vector<std::uint8_t> pixels(4 * width * height);
+	for (unsigned i = 0; i < width * height; ++i) {
+		pixels[4 * i + 0] = (std::uint8_t)(i * 17);
+		pixels[4 * i + 1] = (std::uint8_t)(255 - i * 11);
+		pixels[4 * i + 2] = (std::uint8_t)(i * 3 + 40);
+		pixels[4 * i + 3] = 255;
+	}
+
+	FloorTexture texture;
+	texture.Assign(width, height, pixels.data());
+
+	REQUIRE(texture.texels.size() == width * height);
+
+	SECTION("The texture starts out as a single white texel") {
+		FloorTexture blank;
+
+		REQUIRE(blank.width == 1);
+		REQUIRE(blank.height == 1);
+		REQUIRE(blank.texels.size() == 1);
+		REQUIRE(blank.texels[0] == 0xffffffffu);
+	}
+
+	SECTION("Mips go down to 1 by 1") {
+		REQUIRE(texture.mips.size() == 2);
+		CHECK(texture.mips[0].width == 2);
+		CHECK(texture.mips[0].height == 1);
+		CHECK(texture.mips[1].width == 1);
+		CHECK(texture.mips[1].height == 1);
+
+		CHECK(&texture.GetMip(0) == &texture);
+		CHECK(&texture.GetMip(5) == &texture.mips[1]);
+
+		FloorTexture blank;
+		CHECK(blank.mips.empty());
+		CHECK(&blank.GetMip(2) == &blank);
+	}
+
+	SECTION("Rows step through the texture and wrap around it") {
+		// Counting lengths that aren't a multiple of 4, so the leftovers get filled in too.
+		std::vector<std::uint32_t> row(7);
+		CastFloorRow(row.data(), 7, MakeRow(0.5f, 1.5f, 1.0f, 0.0f), texture);
+
+		for (unsigned i = 0; i < 7; ++i) {
+			REQUIRE(row[i] == texture.texels[1 * width + i % width]);
+		}
+
+		// Backwards, from negative coordinates.
+		CastFloorRow(row.data(), 7, MakeRow(-0.5f, -0.5f, -1.0f, -1.0f), texture);
+
+		REQUIRE(row[0] == texture.texels[2 * width + 4]);
+		REQUIRE(row[1] == texture.texels[1 * width + 3]);
+		REQUIRE(row[2] == texture.texels[0 * width + 2]);
+		REQUIRE(row[3] == texture.texels[2 * width + 1]);
+	}
+
+	SECTION("Scale and add are per channel and saturate") {
+		FloorRow shaded = MakeRow(0.5f, 0.5f, 0.0f, 0.0f);
+		shaded.scale[0] = 128;
+		shaded.scale[1] = 0;
+		shaded.scale[2] = 256;
+		shaded.scale[3] = 0;
+		shaded.add[0] = 10;
+		shaded.add[1] = 20;
+		shaded.add[2] = 255;
+		shaded.add[3] = 255;
+
+		std::uint32_t pixel[4];
+		CastFloorRow(pixel, 4, shaded, texture);
+
+		const std::uint8_t* channels = (const std::uint8_t*)pixel;
+
+		REQUIRE(channels[0] == (pixels[0] * 128 >> 8) + 10);
+		REQUIRE(channels[1] == 20);
+		REQUIRE(channels[2] == 255);
+		REQUIRE(channels[3] == 255);
+
+		REQUIRE(pixel[1] == pixel[0]);
+		REQUIRE(pixel[3] == pixel[0]);
+	}
+
+	SECTION("The kernel matches the scalar version exactly") {
+		std::mt19937 random(4321);
+		std::uniform_real_distribution<float> starts(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> steps(-0.7f, 0.7f);
+		std::uniform_int_distribution<int> scales(0, 256);
+		std::uniform_int_distribution<int> adds(0, 255);
+		std::uniform_int_distribution<unsigned> counts(0, 67);
+
+		std::vector<std::uint32_t> fast(67);
+		std::vector<std::uint32_t> slow(67);
+
+		for (int trial = 0; trial < 500; ++trial)
+		{
+			FloorRow row = MakeRow(starts(random), starts(random), steps(random), steps(random));
+
+			for (int c = 0; c < 4; ++c) {
+				row.scale[c] = (std::uint16_t)scales(random);
+				row.add[c] = (std::uint16_t)adds(random);
+			}
+
+			const unsigned count = counts(random);
+
+			CastFloorRow(fast.data(), count, row, texture);
+			CastFloorRowScalar(slow.data(), count, row, texture);
+
+			for (unsigned i = 0; i < count; ++i) {
+				REQUIRE(fast[i] == slow[i]);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include <catch.hpp>
+
+#include <limits>
+
+#include "Quiver/Graphics/Fog.h"
+#include "Quiver/Graphics/RenderSettings.h"
+
+using namespace qvr;
+
+TEST_CASE("Fog", "[Graphics]")
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	Fog fog;
+	fog.SetMaxDistance(30.0f);
+	fog.SetMinDistance(10.0f);
+
+	SECTION("Only white fog at full intensity hides what's behind it") {
+		fog.SetColor(sf::Color::White);
+		fog.SetMaxIntensity(1.0f);
+
+		REQUIRE(fog.GetOpaqueDistance() == 30.0f);
+
+		fog.SetMaxIntensity(0.9f);
+
+		REQUIRE(fog.GetOpaqueDistance() == infinity);
+
+		// Adds nothing at all.
+		fog.SetColor(sf::Color::Black);
+		fog.SetMaxIntensity(1.0f);
+
+		REQUIRE(fog.GetOpaqueDistance() == infinity);
+
+		fog.SetColor(sf::Color(255, 128, 0));
+
+		REQUIRE(fog.GetOpaqueDistance() == infinity);
+	}
+
+	SECTION("Fog culling only shortens rays that the fog would hide") {
+		RenderSettings settings;
+		settings.m_RayLength = 50.0f;
+		settings.m_FogCulling = true;
+
+		fog.SetColor(sf::Color::White);
+
+		REQUIRE(settings.GetRayLength(fog) == 30.0f);
+		// Towards the edge of the screen, at 60 degrees.
+		REQUIRE(settings.GetRayLength(fog, 0.5f) == 50.0f);
+
+		fog.SetColor(sf::Color::Black);
+
+		REQUIRE(settings.GetRayLength(fog) == 50.0f);
+
+		fog.SetColor(sf::Color::White);
+		settings.m_FogCulling = false;
+
+		REQUIRE(settings.GetRayLength(fog) == 50.0f);
+	}
+}
\ No newline at end of file
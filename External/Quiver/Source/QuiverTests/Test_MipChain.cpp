@@ -0,0 +1,88 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "Quiver/Graphics/ColumnRasterizer.h"
+#include "Quiver/Graphics/MipChain.h"
+
+using namespace qvr;
+
+TEST_CASE("DownsampleMip averages each 2 by 2 block", "[Graphics]")
+{
+	// 3 wide, 2 high. The odd column out gets left out.
+	const std::vector<std::uint8_t> pixels = {
+		0, 10, 20, 255,   100, 10, 20, 255,   255, 255, 255, 255,
+		50, 30, 20, 255,  51, 30, 20, 0,      255, 255, 255, 255,
+	};
+
+	std::vector<std::uint8_t> mip;
+	DownsampleMip(pixels.data(), 3, 2, mip);
+
+	REQUIRE(mip.size() == 4);
+	CHECK(mip[0] == 50);
+	CHECK(mip[1] == 20);
+	CHECK(mip[2] == 20);
+	CHECK(mip[3] == 191);
+
+	SECTION("A side 1 texel long stays 1 texel long") {
+		const std::vector<std::uint8_t> tall = {
+			0, 0, 0, 0,
+			100, 0, 0, 0,
+			200, 0, 0, 0,
+			255, 0, 0, 0,
+		};
+
+		DownsampleMip(tall.data(), 1, 4, mip);
+
+		REQUIRE(mip.size() == 8);
+		CHECK(mip[0] == 50);
+		CHECK(mip[4] == 228);
+	}
+}
+
+TEST_CASE("Mip levels come from texels per pixel", "[Graphics]")
+{
+	CHECK(GetMipLevel(0.25f) == 0);
+	CHECK(GetMipLevel(1.0f) == 0);
+	CHECK(GetMipLevel(1.4f) == 0);
+	CHECK(GetMipLevel(1.5f) == 1);
+	CHECK(GetMipLevel(4.0f) == 2);
+	CHECK(GetMipLevel(64.0f) == 6);
+
+	// 64 texels over 8 pixels.
+	CHECK(GetColumnTexelsPerPixel(0.0f, 64.0f, 10.0f, 18.0f) == 8.0f);
+	// Upside down views step backwards, but just as far.
+	CHECK(GetColumnTexelsPerPixel(64.0f, 0.0f, 10.0f, 18.0f) == 8.0f);
+	// Capped so the view is still MinMipTexelsPerView texels high.
+	CHECK(GetColumnTexelsPerPixel(0.0f, 64.0f, 10.0f, 11.0f) == 64.0f / MinMipTexelsPerView);
+	CHECK(GetColumnTexelsPerPixel(0.0f, 4.0f, 10.0f, 11.0f) == 1.0f);
+	CHECK(GetColumnTexelsPerPixel(0.0f, 64.0f, 10.0f, 10.0f) == 1.0f);
+}
+
+TEST_CASE("ColumnMajorTexture mips go down to 1 by 1", "[Graphics]")
+{
+	const std::vector<std::uint8_t> pixels(4 * 5 * 3, 128);
+
+	ColumnMajorTexture texture;
+	texture.Assign(5, 3, pixels.data());
+
+	REQUIRE(texture.mips.empty());
+	REQUIRE(&texture.GetMip(3) == &texture);
+
+	texture.GenerateMips();
+
+	REQUIRE(texture.mips.size() == 2);
+	CHECK(texture.mips[0].width == 2);
+	CHECK(texture.mips[0].height == 1);
+	CHECK(texture.mips[1].width == 1);
+	CHECK(texture.mips[1].height == 1);
+	CHECK(texture.mips[1].texels.size() == 4);
+
+	CHECK(&texture.GetMip(0) == &texture);
+	CHECK(&texture.GetMip(1) == &texture.mips[0]);
+	CHECK(&texture.GetMip(10) == &texture.mips[1]);
+
+	texture.Assign(5, 3, pixels.data());
+
+	CHECK(texture.mips.empty());
+}
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include <catch.hpp>
+
+#include <vector>
+
+#include "Quiver/Graphics/ColumnProjection.h"
+#include "Quiver/Graphics/ParticleSystem.h"
+
+using namespace qvr;
+
+namespace {
+
+ParticleEmitter MakeEmitter(const b2Vec2& position, const float height)
+{
+	ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.height = height;
+	emitter.lifetime = 10.0f;
+	return emitter;
+}
+
+}
+
+TEST_CASE("ParticleSystem", "[Graphics]")
+{
+	ParticleSystem particles(16);
+
+	REQUIRE(particles.GetCapacity() == 16);
+	REQUIRE(particles.GetCount() == 0);
+
+	SECTION("Particles that don't fit are dropped") {
+		REQUIRE(particles.Emit(MakeEmitter(b2Vec2_zero, 0.5f), 10) == 10);
+		REQUIRE(particles.Emit(MakeEmitter(b2Vec2_zero, 0.5f), 10) == 6);
+
+		REQUIRE(particles.GetCount() == 16);
+		REQUIRE(particles.GetDroppedCount() == 4);
+	}
+
+	SECTION("Particles move, fall, and land on the floor") {
+		ParticleEmitter emitter = MakeEmitter(b2Vec2(1.0f, 2.0f), 0.5f);
+		emitter.velocity = b2Vec2(1.0f, -1.0f);
+		emitter.verticalVelocity = 0.5f;
+		emitter.gravity = 1.0f;
+		emitter.growth = 0.5f;
+
+		// Not a multiple of 4, so the leftovers get moved too.
+		particles.Emit(emitter, 7);
+
+		particles.Update(0.5f);
+
+		for (unsigned i = 0; i < particles.GetCount(); ++i) {
+			REQUIRE(particles.GetPositionX()[i] == Approx(1.5f));
+			REQUIRE(particles.GetPositionY()[i] == Approx(1.5f));
+			REQUIRE(particles.GetVerticalVelocity()[i] == Approx(0.0f));
+			REQUIRE(particles.GetHeight()[i] == Approx(0.5f));
+			REQUIRE(particles.GetSize()[i] == Approx(emitter.size + 0.25f));
+		}
+
+		for (int step = 0; step < 10; ++step) {
+			particles.Update(0.5f);
+		}
+
+		for (unsigned i = 0; i < particles.GetCount(); ++i) {
+			REQUIRE(particles.GetHeight()[i] == 0.0f);
+			REQUIRE(particles.GetVerticalVelocity()[i] == 0.0f);
+		}
+
+		// Stopped where they landed.
+		const float x = particles.GetPositionX()[0];
+		particles.Update(0.5f);
+		REQUIRE(particles.GetPositionX()[0] == x);
+	}
+
+	SECTION("Particles are removed when their time is up") {
+		ParticleEmitter shortLived = MakeEmitter(b2Vec2(1.0f, 0.0f), 0.5f);
+		shortLived.lifetime = 1.0f;
+
+		particles.Emit(shortLived, 5);
+		particles.Emit(MakeEmitter(b2Vec2(2.0f, 0.0f), 0.5f), 3);
+
+		particles.Update(0.5f);
+		REQUIRE(particles.GetCount() == 8);
+
+		particles.Update(0.5f);
+		REQUIRE(particles.GetCount() == 3);
+
+		for (unsigned i = 0; i < particles.GetCount(); ++i) {
+			REQUIRE(particles.GetPositionX()[i] == 2.0f);
+		}
+	}
+
+	SECTION("Emitting over time averages out to the rate") {
+		ParticleSystem many(100000);
+
+		for (int step = 0; step < 1000; ++step) {
+			many.EmitOverTime(MakeEmitter(b2Vec2_zero, 0.5f), 30.0f, 1.0f / 60.0f);
+		}
+
+		REQUIRE(many.GetCount() > 400);
+		REQUIRE(many.GetCount() < 600);
+	}
+}
+
+TEST_CASE("ProjectParticles", "[Graphics]")
+{
+	// Looking along +x, with a 90 degree field of view, and the camera's eye half way up.
+	ColumnProjection projection;
+	projection.targetHeight = 100.0f;
+	projection.horizon = 50.0f;
+
+	const b2Vec2 viewPlane(0.0f, 1.0f);
+
+	std::vector<float> columnDepth(200, 20.0f);
+
+	ParticleSystem particles(64);
+	std::vector<ScreenParticle> screenParticles;
+
+	const auto project = [&]() {
+		ProjectParticles(particles, projection, viewPlane, columnDepth, screenParticles);
+	};
+
+	SECTION("A particle straight ahead lands in the middle of the screen") {
+		ParticleEmitter emitter = MakeEmitter(b2Vec2(5.0f, 0.0f), 0.5f);
+		emitter.size = 0.2f;
+		particles.Emit(emitter, 1);
+
+		project();
+
+		REQUIRE(screenParticles.size() == 1);
+
+		const ScreenParticle& particle = screenParticles[0];
+
+		REQUIRE(particle.depth == Approx(5.0f));
+		REQUIRE(0.5f * (particle.left + particle.right) == Approx(100.0f));
+		REQUIRE(0.5f * (particle.top + particle.bottom) == Approx(50.0f));
+		// A metre at 5 metres is a fifth of the screen's height, and of half its width.
+		REQUIRE(particle.right - particle.left == Approx(0.2f * 100.0f / 5.0f));
+		REQUIRE(particle.bottom - particle.top == Approx(0.2f * 100.0f / 5.0f));
+	}
+
+	SECTION("Particles behind the camera, off screen or behind walls are left out") {
+		particles.Emit(MakeEmitter(b2Vec2(-5.0f, 0.0f), 0.5f), 1);
+		particles.Emit(MakeEmitter(b2Vec2(5.0f, 20.0f), 0.5f), 1);
+		particles.Emit(MakeEmitter(b2Vec2(5.0f, 0.0f), 5.0f), 1);
+		particles.Emit(MakeEmitter(b2Vec2(30.0f, 0.0f), 0.5f), 1);
+
+		project();
+
+		REQUIRE(screenParticles.empty());
+
+		// With a wall in the way of the middle of the screen.
+		particles.Clear();
+		particles.Emit(MakeEmitter(b2Vec2(5.0f, 0.0f), 0.5f), 1);
+		particles.Emit(MakeEmitter(b2Vec2(5.0f, 2.5f), 0.5f), 1);
+
+		for (unsigned column = 90; column < 110; ++column) {
+			columnDepth[column] = 3.0f;
+		}
+
+		project();
+
+		REQUIRE(screenParticles.size() == 1);
+		REQUIRE(screenParticles[0].left > 110.0f);
+	}
+
+	SECTION("Particles come back to front, and fade with age") {
+		// More than 4, so some go through the leftovers.
+		for (int i = 0; i < 6; ++i) {
+			ParticleEmitter emitter = MakeEmitter(b2Vec2(2.0f + (i * 7) % 6, 0.1f * i), 0.5f);
+			emitter.color = sf::Color(255, 255, 255, 200);
+			particles.Emit(emitter, 1);
+		}
+
+		particles.Update(5.0f);
+
+		project();
+
+		REQUIRE(screenParticles.size() == 6);
+
+		for (unsigned i = 1; i < screenParticles.size(); ++i) {
+			REQUIRE(screenParticles[i - 1].depth >= screenParticles[i].depth);
+		}
+
+		for (const ScreenParticle& particle : screenParticles) {
+			REQUIRE(particle.color.a == 100);
+		}
+	}
+}
\ No newline at end of file
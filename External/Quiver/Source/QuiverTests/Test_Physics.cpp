@@ -1,16 +1,57 @@
 #include <catch.hpp>
 
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Dynamics/b2WorldCallbacks.h>
 
 #include "Quiver/Entity/Entity.h"
 #include "Quiver/Entity/CustomComponent/CustomComponent.h"
 #include "Quiver/Entity/PhysicsComponent/PhysicsComponent.h"
 #include "Quiver/Entity/PhysicsComponent/PhysicsComponentDef.h"
+#include "Quiver/Input/Keyboard.h"
+#include "Quiver/Input/Mouse.h"
+#include "Quiver/Input/RawInput.h"
+#include "Quiver/World/TileMap.h"
 #include "Quiver/World/World.h"
 
 using namespace qvr;
 
+namespace {
+
+class NoKeyboard : public Keyboard
+{
+public:
+	bool IsDown  (const KeyboardKey key) const override { return false; }
+	bool JustDown(const KeyboardKey key) const override { return false; }
+	bool JustUp  (const KeyboardKey key) const override { return false; }
+};
+
+class NoJoysticks : public JoystickProvider
+{
+public:
+	const Joystick* GetJoystick(const JoystickIndex index) const override { return nullptr; }
+};
+
+class ClosestFixture : public b2RayCastCallback
+{
+public:
+	b2Fixture* fixture = nullptr;
+
+	float32 ReportFixture(
+		b2Fixture* f,
+		const b2Vec2& point,
+		const b2Vec2& normal,
+		float32 fraction)
+		override
+	{
+		fixture = f;
+		return fraction;
+	}
+};
+
+}
+
 TEST_CASE("PhysicsComponent creation and cleanup", "[Physics]")
 {
 	CustomComponentTypeLibrary types;
@@ -33,4 +74,47 @@ TEST_CASE("PhysicsComponent creation and cleanup", "[Physics]")
 	entity.reset();
 
 	REQUIRE(world.GetPhysicsWorld()->GetBodyCount() == 0);
+}
+
+TEST_CASE("Rays through a TileMap wall hit a body with no Entity", "[Physics]")
+{
+	CustomComponentTypeLibrary types;
+	FixtureFilterBitNames filterBitNames;
+
+	WorldContext worldContext(types, filterBitNames);
+
+	World world(worldContext);
+
+	// A wall in the middle tile, with an Entity behind it.
+	TileMap& tileMap = world.CreateTileMap(3, 1);
+	tileMap.AddType("Brick");
+	tileMap.SetTile(1, 0, 1);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.25f;
+
+	auto entity = std::make_unique<Entity>(
+		world,
+		PhysicsComponentDef(circle, b2Vec2(2.5f, 0.5f), 0.0f));
+
+	// The TileMap's body is rebuilt when the World steps.
+	Mouse mouse;
+	NoKeyboard keyboard;
+	NoJoysticks joysticks;
+	RawInputDevices inputDevices(mouse, keyboard, joysticks);
+
+	world.TakeStep(inputDevices);
+
+	ClosestFixture throughWall;
+	world.GetPhysicsWorld()->RayCast(&throughWall, b2Vec2(0.5f, 0.5f), b2Vec2(2.9f, 0.5f));
+
+	REQUIRE(throughWall.fixture);
+	REQUIRE(throughWall.fixture->GetBody()->GetUserData() == nullptr);
+	REQUIRE(GetEntityFromFixture(*throughWall.fixture) == nullptr);
+
+	ClosestFixture pastWall;
+	world.GetPhysicsWorld()->RayCast(&pastWall, b2Vec2(2.05f, 0.5f), b2Vec2(2.9f, 0.5f));
+
+	REQUIRE(pastWall.fixture);
+	REQUIRE(GetEntityFromFixture(*pastWall.fixture) == entity.get());
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "Quiver/Graphics/PointLights.h"
+
+using namespace qvr;
+
+namespace {
+
+PointLight MakeLight(const float radius, const sf::Color color = sf::Color::White)
+{
+	PointLight light;
+	light.SetRadius(radius);
+	light.SetColor(color);
+	return light;
+}
+
+}
+
+TEST_CASE("PointLightIndex", "[Graphics]")
+{
+	PointLightIndex lights;
+
+	const PointLightId a = lights.Add(b2Vec2(1.0f, 0.0f), MakeLight(1.0f));
+	const PointLightId b = lights.Add(b2Vec2(2.0f, 0.0f), MakeLight(2.0f));
+	const PointLightId c = lights.Add(b2Vec2(3.0f, 0.0f), MakeLight(3.0f));
+
+	REQUIRE(lights.GetCount() == 3);
+	REQUIRE((a != b));
+	REQUIRE((b != c));
+
+	SECTION("Removing a light leaves the others where they were") {
+		REQUIRE(lights.Remove(a));
+		REQUIRE_FALSE(lights.Remove(a));
+
+		REQUIRE(lights.GetCount() == 2);
+		REQUIRE(lights.GetLight(a) == nullptr);
+		REQUIRE(lights.GetLight(b)->GetRadius() == 2.0f);
+		REQUIRE(lights.GetLight(c)->GetRadius() == 3.0f);
+
+		REQUIRE(lights.SetPosition(c, b2Vec2(5.0f, 5.0f)));
+
+		std::vector<float> xs;
+		lights.ForEach([&](const b2Vec2& position, const PointLight&) {
+			xs.push_back(position.x);
+		});
+
+		REQUIRE(xs.size() == 2);
+		REQUIRE(std::count(xs.begin(), xs.end(), 2.0f) == 1);
+		REQUIRE(std::count(xs.begin(), xs.end(), 5.0f) == 1);
+	}
+
+	SECTION("Lights can be changed") {
+		REQUIRE(lights.SetLight(b, MakeLight(7.0f)));
+		REQUIRE(lights.GetLight(b)->GetRadius() == 7.0f);
+		REQUIRE_FALSE(lights.SetLight(InvalidPointLightId, MakeLight(1.0f)));
+	}
+}
+
+TEST_CASE("PointLightClusters", "[Graphics]")
+{
+	// Looking along +x, with a 90 degree field of view.
+	const b2Vec2 cameraPosition(0.0f, 0.0f);
+	const b2Vec2 forwards(1.0f, 0.0f);
+	const b2Vec2 viewPlane(0.0f, 1.0f);
+	const unsigned columnCount = 8 * PointLightClusters::sm_ClusterWidth;
+
+	PointLightIndex lights;
+	PointLightClusters clusters;
+
+	const auto build = [&]() {
+		clusters.Build(lights, cameraPosition, forwards, viewPlane, columnCount, 50.0f);
+	};
+
+	const auto gather = [&](const unsigned column, const b2Vec2& point, const b2Vec2& normal) {
+		float rgb[3] = { 0.0f, 0.0f, 0.0f };
+		clusters.Gather(column, point, normal, rgb);
+		return rgb[0];
+	};
+
+	const unsigned middle = columnCount / 2;
+
+	SECTION("No lights, no light") {
+		build();
+
+		REQUIRE(clusters.IsEmpty());
+		REQUIRE(gather(middle, b2Vec2(5.0f, 0.0f), b2Vec2(-1.0f, 0.0f)) == 0.0f);
+	}
+
+	SECTION("Lights behind the camera or out of range are left out") {
+		lights.Add(b2Vec2(-5.0f, 0.0f), MakeLight(2.0f));
+		lights.Add(b2Vec2(60.0f, 0.0f), MakeLight(2.0f));
+		lights.Add(b2Vec2(5.0f, 40.0f), MakeLight(2.0f));
+
+		build();
+
+		REQUIRE(clusters.GetVisibleLightCount() == 0);
+	}
+
+	SECTION("Light fades with distance, and only reaches surfaces that face it") {
+		lights.Add(b2Vec2(5.0f, 0.0f), MakeLight(2.0f, sf::Color(255, 128, 0)));
+
+		build();
+
+		REQUIRE(clusters.GetVisibleLightCount() == 1);
+
+		const b2Vec2 facing(-1.0f, 0.0f);
+
+		const float near = gather(middle, b2Vec2(5.5f, 0.0f), facing);
+		const float far = gather(middle, b2Vec2(6.5f, 0.0f), facing);
+
+		REQUIRE(near > far);
+		REQUIRE(far > 0.0f);
+		REQUIRE(near == Approx((1.0f - 0.25f / 4.0f) * (1.0f - 0.25f / 4.0f)));
+
+		REQUIRE(gather(middle, b2Vec2(7.5f, 0.0f), facing) == 0.0f);
+		REQUIRE(gather(middle, b2Vec2(5.5f, 0.0f), b2Vec2(1.0f, 0.0f)) == 0.0f);
+
+		float rgb[3] = { 0.0f, 0.0f, 0.0f };
+		clusters.Gather(middle, b2Vec2(5.5f, 0.0f), facing, rgb);
+		REQUIRE(rgb[1] == Approx(rgb[0] * 128.0f / 255.0f));
+		REQUIRE(rgb[2] == 0.0f);
+
+		// Columns well off to the side can't see it.
+		REQUIRE(gather(0, b2Vec2(5.5f, 0.0f), facing) == 0.0f);
+	}
+
+	SECTION("A light around the camera reaches every column") {
+		lights.Add(b2Vec2(0.5f, 0.0f), MakeLight(3.0f));
+
+		build();
+
+		for (unsigned column = 0; column < columnCount; column += PointLightClusters::sm_ClusterWidth) {
+			REQUIRE(gather(column, b2Vec2(1.0f, 0.0f), b2Vec2(-1.0f, 0.0f)) > 0.0f);
+		}
+	}
+
+	SECTION("Clusters keep the nearest lights when there are too many") {
+		const unsigned lightCount = 4 * PointLightClusters::sm_MaxLightsPerCluster;
+
+		for (unsigned i = 0; i < lightCount; ++i) {
+			lights.Add(b2Vec2(40.0f - i, 0.0f), MakeLight(0.5f));
+		}
+
+		build();
+
+		REQUIRE(clusters.GetMaxLightsInACluster() == PointLightClusters::sm_MaxLightsPerCluster);
+		REQUIRE(clusters.GetDroppedCount() > 0);
+
+		const b2Vec2 facing(-1.0f, 0.0f);
+		const unsigned nearest = lightCount - 1;
+		const float nearestX = 40.0f - nearest;
+
+		REQUIRE(gather(middle, b2Vec2(nearestX, 0.0f), facing) > 0.0f);
+		REQUIRE(gather(middle, b2Vec2(40.0f, 0.0f), facing) == 0.0f);
+	}
+}
\ No newline at end of file
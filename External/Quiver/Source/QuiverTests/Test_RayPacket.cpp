@@ -0,0 +1,151 @@
+#include <catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <Box2D/Collision/Shapes/b2ChainShape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2EdgeShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+
+#include "Quiver/Graphics/RayPacket.h"
+
+using namespace qvr;
+
+namespace {
+
+// Fans of rays like the ones the raycast renderer casts, from random points around the origin.
+std::vector<RayPacket> GeneratePackets(const int count, const int size, const unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> position(-6.0f, 6.0f);
+	std::uniform_real_distribution<float> angle(-b2_pi, b2_pi);
+	std::uniform_real_distribution<float> spread(0.0f, 0.2f);
+	std::uniform_real_distribution<float> length(0.5f, 20.0f);
+	std::uniform_real_distribution<float> maxFraction(0.0f, 1.0f);
+
+	std::vector<RayPacket> packets(count);
+
+	for (RayPacket& packet : packets)
+	{
+		packet.origin.Set(position(rng), position(rng));
+		packet.size = size;
+
+		const float firstAngle = angle(rng);
+		const float angleStep = spread(rng) / size;
+		const float rayLength = length(rng);
+
+		for (int i = 0; i < RayPacket::MaxSize; ++i)
+		{
+			const float a = firstAngle + angleStep * i;
+			packet.endX[i] = packet.origin.x + std::cos(a) * rayLength;
+			packet.endY[i] = packet.origin.y + std::sin(a) * rayLength;
+			// Mostly whole rays, with some clipped and some finished ones.
+			const int kind = i % 4;
+			packet.maxFraction[i] = kind == 3 ? -1.0f : kind == 2 ? maxFraction(rng) : 1.0f;
+		}
+	}
+
+	return packets;
+}
+
+void RequireMatchesScalar(
+	const b2Shape& shape,
+	const b2Transform& transform,
+	const RayPacketKernel kernel)
+{
+	for (int32 childIndex = 0; childIndex < shape.GetChildCount(); ++childIndex)
+	{
+		for (const RayPacket& packet : GeneratePackets(500, GetRayPacketWidth(kernel), 1234))
+		{
+			RayPacketHits hits;
+			RayCastPacket(shape, childIndex, transform, packet, hits, kernel);
+
+			for (int i = 0; i < packet.size; ++i)
+			{
+				bool expectHit = false;
+				b2RayCastOutput expected;
+
+				if (packet.maxFraction[i] >= 0.0f) {
+					b2RayCastInput input;
+					input.p1 = packet.origin;
+					input.p2.Set(packet.endX[i], packet.endY[i]);
+					input.maxFraction = packet.maxFraction[i];
+
+					expectHit = shape.RayCast(&expected, input, transform, childIndex);
+				}
+
+				const bool hit = (hits.mask & (1u << i)) != 0;
+
+				REQUIRE(hit == expectHit);
+
+				if (hit && expectHit) {
+					REQUIRE(hits.fraction[i] == Approx(expected.fraction).epsilon(1e-4));
+					REQUIRE(hits.normalX[i] == Approx(expected.normal.x).epsilon(1e-4));
+					REQUIRE(hits.normalY[i] == Approx(expected.normal.y).epsilon(1e-4));
+				}
+			}
+		}
+	}
+}
+
+}
+
+TEST_CASE("Ray packet kernels match b2Shape::RayCast", "[Graphics]")
+{
+	const b2Transform transform(b2Vec2(0.5f, -0.25f), b2Rot(0.3f));
+
+	std::vector<RayPacketKernel> kernels;
+
+	for (const auto kernel : { RayPacketKernel::Scalar, RayPacketKernel::SSE, RayPacketKernel::AVX })
+	{
+		if (IsRayPacketKernelSupported(kernel)) {
+			kernels.push_back(kernel);
+		}
+	}
+
+	REQUIRE(IsRayPacketKernelSupported(RayPacketKernel::Scalar));
+	REQUIRE(IsRayPacketKernelSupported(GetBestRayPacketKernel()));
+
+	for (const RayPacketKernel kernel : kernels)
+	{
+		INFO("Kernel: " << ToString(kernel));
+
+		SECTION(std::string("Circle ") + ToString(kernel)) {
+			b2CircleShape circle;
+			circle.m_p.Set(0.5f, 1.0f);
+			circle.m_radius = 1.5f;
+
+			RequireMatchesScalar(circle, transform, kernel);
+		}
+
+		SECTION(std::string("Polygon ") + ToString(kernel)) {
+			b2PolygonShape box;
+			box.SetAsBox(2.0f, 1.0f, b2Vec2(1.0f, 0.0f), 0.5f);
+
+			RequireMatchesScalar(box, transform, kernel);
+		}
+
+		SECTION(std::string("Edge ") + ToString(kernel)) {
+			b2EdgeShape edge;
+			edge.Set(b2Vec2(-3.0f, -1.0f), b2Vec2(2.0f, 2.0f));
+
+			RequireMatchesScalar(edge, transform, kernel);
+		}
+
+		SECTION(std::string("Chain ") + ToString(kernel)) {
+			const b2Vec2 vertices[] = {
+				b2Vec2(-4.0f, -4.0f),
+				b2Vec2(4.0f, -4.0f),
+				b2Vec2(4.0f, 4.0f),
+				b2Vec2(-4.0f, 3.0f)
+			};
+
+			b2ChainShape chain;
+			chain.CreateChain(vertices, 4);
+
+			RequireMatchesScalar(chain, transform, kernel);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,322 @@
+#include <catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+
+#include "Quiver/Graphics/FixtureRenderData.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
+
+using namespace qvr;
+
+namespace {
+
+class CollectHits : public RenderProxyRayCastCallback
+{
+public:
+	std::vector<const FixtureRenderData*> hits;
+	std::vector<int> slots;
+
+	float32 ReportProxy(
+		const FixtureRenderData& renderData,
+		const int slot,
+		const b2Vec2& point,
+		const b2Vec2& normal,
+		float32 fraction) override
+	{
+		hits.push_back(&renderData);
+		slots.push_back(slot);
+		return 1.0f;
+	}
+};
+
+std::vector<const FixtureRenderData*> CastRay(
+	const RenderProxyIndex& index,
+	const b2Vec2& from,
+	const b2Vec2& to,
+	const RenderProxySet set = RenderProxySet::All)
+{
+	CollectHits callback;
+	index.RayCast(callback, from, to, set);
+
+	for (size_t i = 0; i < callback.hits.size(); ++i) {
+		REQUIRE(&index.GetRenderData(callback.slots[i]) == callback.hits[i]);
+	}
+
+	return callback.hits;
+}
+
+}
+
+TEST_CASE("RenderProxyIndex", "[Graphics]")
+{
+	b2World physicsWorld(b2Vec2_zero);
+
+	b2BodyDef bodyDef;
+	bodyDef.type = b2_dynamicBody;
+	bodyDef.position.Set(0.0f, 5.0f);
+	b2Body* body = physicsWorld.CreateBody(&bodyDef);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.5f;
+	b2Fixture* visibleFixture = body->CreateFixture(&circle, 1.0f);
+
+	// A big sensor, like the ones enemies use to look for the player.
+	b2CircleShape sensorCircle;
+	sensorCircle.m_radius = 5.0f;
+	b2FixtureDef sensorDef;
+	sensorDef.shape = &sensorCircle;
+	sensorDef.isSensor = true;
+	body->CreateFixture(&sensorDef);
+
+	RenderProxyIndex index;
+	FixtureRenderData visibleRenderData;
+
+	const RenderProxyId attachedId = index.AddAttached(*visibleFixture, visibleRenderData);
+
+	REQUIRE(attachedId.get() != InvalidRenderProxyId.get());
+	REQUIRE(index.GetProxyCount() == 1);
+
+	SECTION("Rays only hit fixtures that were added") {
+		const auto hits = CastRay(index, b2Vec2(0.0f, 0.0f), b2Vec2(0.0f, 10.0f));
+
+		REQUIRE(hits.size() == 1);
+		REQUIRE(hits[0] == &visibleRenderData);
+	}
+
+	SECTION("Attached proxies follow their bodies after Synchronize") {
+		body->SetTransform(b2Vec2(20.0f, 5.0f), 0.0f);
+
+		index.Synchronize();
+
+		REQUIRE(CastRay(index, b2Vec2(0.0f, 0.0f), b2Vec2(0.0f, 10.0f)).empty());
+		REQUIRE(CastRay(index, b2Vec2(20.0f, 0.0f), b2Vec2(20.0f, 10.0f)).size() == 1);
+	}
+
+	SECTION("Billboards don't need a body, and aren't ray cast") {
+		FixtureRenderData spriteRenderData;
+
+		const int bodyCount = physicsWorld.GetBodyCount();
+
+		const RenderProxyId billboardId = index.AddBillboard(b2Vec2(-10.0f, 5.0f), 0.5f, spriteRenderData);
+
+		REQUIRE(physicsWorld.GetBodyCount() == bodyCount);
+		REQUIRE(index.GetProxyCount() == 2);
+
+		REQUIRE(CastRay(index, b2Vec2(-10.0f, 0.0f), b2Vec2(-10.0f, 10.0f)).empty());
+
+		int billboardCount = 0;
+		int billboardSlot = -1;
+		b2Vec2 billboardPosition;
+		float billboardHalfWidth = 0.0f;
+
+		const auto findBillboard = [&]() {
+			billboardCount = 0;
+
+			index.ForEachBillboard([&](const int slot, const b2Vec2& position, const float halfWidth) {
+				billboardCount++;
+				billboardSlot = slot;
+				billboardPosition = position;
+				billboardHalfWidth = halfWidth;
+			});
+		};
+
+		findBillboard();
+
+		REQUIRE(billboardCount == 1);
+		REQUIRE(&index.GetRenderData(billboardSlot) == &spriteRenderData);
+		REQUIRE(billboardPosition.x == -10.0f);
+		REQUIRE(billboardPosition.y == 5.0f);
+		REQUIRE(billboardHalfWidth == 0.5f);
+
+		SECTION("They can be moved") {
+			REQUIRE(index.SetBillboardPosition(billboardId, b2Vec2(-30.0f, 5.0f)));
+
+			findBillboard();
+
+			REQUIRE(billboardPosition.x == -30.0f);
+			REQUIRE(billboardPosition.y == 5.0f);
+		}
+
+		SECTION("They can be resized") {
+			REQUIRE(index.SetBillboardHalfWidth(billboardId, 2.0f));
+
+			findBillboard();
+
+			REQUIRE(billboardHalfWidth == 2.0f);
+		}
+
+		SECTION("They don't count as dynamic") {
+			int boundsCount = 0;
+			index.ForEachDynamicBounds([&](const b2AABB&) { boundsCount++; });
+
+			REQUIRE(boundsCount == 1);
+		}
+
+		REQUIRE(index.Remove(billboardId));
+
+		findBillboard();
+
+		REQUIRE(billboardCount == 0);
+	}
+
+	SECTION("Static and dynamic proxies can be cast on their own") {
+		b2BodyDef staticBodyDef;
+		staticBodyDef.position.Set(0.0f, 8.0f);
+		b2Body* staticBody = physicsWorld.CreateBody(&staticBodyDef);
+
+		b2PolygonShape box;
+		box.SetAsBox(1.0f, 0.5f);
+		b2Fixture* wallFixture = staticBody->CreateFixture(&box, 0.0f);
+
+		FixtureRenderData wallRenderData;
+
+		const unsigned generationBefore = index.GetStaticGeneration();
+
+		const RenderProxyId wallId = index.AddAttached(*wallFixture, wallRenderData);
+
+		REQUIRE(index.GetStaticGeneration() != generationBefore);
+
+		const b2Vec2 from(0.0f, 0.0f);
+		const b2Vec2 to(0.0f, 10.0f);
+
+		REQUIRE(CastRay(index, from, to).size() == 2);
+		REQUIRE(CastRay(index, from, to, RenderProxySet::Static) == std::vector<const FixtureRenderData*>{ &wallRenderData });
+		REQUIRE(CastRay(index, from, to, RenderProxySet::Dynamic) == std::vector<const FixtureRenderData*>{ &visibleRenderData });
+
+		SECTION("Only static changes change the static generation") {
+			const unsigned generation = index.GetStaticGeneration();
+
+			body->SetTransform(b2Vec2(1.0f, 5.0f), 0.0f);
+			index.Synchronize();
+			index.RenderDataChanged(attachedId);
+
+			REQUIRE(index.GetStaticGeneration() == generation);
+
+			index.RenderDataChanged(wallId);
+
+			REQUIRE(index.GetStaticGeneration() != generation);
+		}
+
+		SECTION("Proxies swap trees when their body changes type") {
+			staticBody->SetType(b2_dynamicBody);
+			index.Synchronize();
+
+			REQUIRE(CastRay(index, from, to, RenderProxySet::Static).empty());
+			REQUIRE(CastRay(index, from, to, RenderProxySet::Dynamic).size() == 2);
+		}
+
+		SECTION("Dynamic bounds only cover dynamic proxies") {
+			int boundsCount = 0;
+
+			index.ForEachDynamicBounds([&](const b2AABB& aabb)
+			{
+				REQUIRE(aabb.Contains(visibleFixture->GetAABB(0)));
+				boundsCount++;
+			});
+
+			REQUIRE(boundsCount == 1);
+		}
+
+		SECTION("Removing a proxy moves the last one into its slot") {
+			const unsigned generation = index.GetStaticGeneration();
+
+			REQUIRE(index.Remove(attachedId));
+
+			REQUIRE(index.GetProxyCount() == 1);
+			REQUIRE(&index.GetRenderData(0) == &wallRenderData);
+			REQUIRE(index.GetStaticGeneration() != generation);
+			REQUIRE(CastRay(index, from, to) == std::vector<const FixtureRenderData*>{ &wallRenderData });
+		}
+
+		REQUIRE(index.Remove(wallId));
+	}
+
+	SECTION("Removed proxies are gone") {
+		REQUIRE(index.Remove(attachedId));
+		REQUIRE(index.Remove(attachedId) == false);
+		REQUIRE(index.GetProxyCount() == 0);
+		REQUIRE(CastRay(index, b2Vec2(0.0f, 0.0f), b2Vec2(0.0f, 10.0f)).empty());
+	}
+}
+
+TEST_CASE("RenderProxyIndex ray packets find the same hits as single rays", "[Graphics]")
+{
+	b2World physicsWorld(b2Vec2_zero);
+
+	RenderProxyIndex index;
+
+	// A room full of pillars and crates.
+	std::vector<std::unique_ptr<FixtureRenderData>> renderDatas;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+	std::uniform_real_distribution<float> size(0.2f, 2.0f);
+	std::uniform_real_distribution<float> angle(-b2_pi, b2_pi);
+
+	for (int i = 0; i < 200; ++i)
+	{
+		b2BodyDef bodyDef;
+		bodyDef.position.Set(position(rng), position(rng));
+		bodyDef.angle = angle(rng);
+		b2Body* body = physicsWorld.CreateBody(&bodyDef);
+
+		b2CircleShape circle;
+		circle.m_radius = size(rng);
+
+		b2PolygonShape box;
+		box.SetAsBox(size(rng), size(rng));
+
+		const b2Shape& shape = (i % 2) ? (const b2Shape&)circle : (const b2Shape&)box;
+
+		renderDatas.push_back(std::make_unique<FixtureRenderData>());
+
+		index.AddAttached(*body->CreateFixture(&shape, 1.0f), *renderDatas.back());
+	}
+
+	const b2Vec2 origin(1.0f, -2.0f);
+
+	const RayPacketKernel kernel = GetBestRayPacketKernel();
+	const int packetWidth = GetRayPacketWidth(kernel);
+
+	const int rayCount = 256;
+
+	for (int first = 0; first < rayCount; first += packetWidth)
+	{
+		std::array<CollectHits, RayPacket::MaxSize> packetCallbacks;
+		std::array<RenderProxyRayCastCallback*, RayPacket::MaxSize> callbacks;
+		std::array<b2Vec2, RayPacket::MaxSize> ends;
+
+		for (int i = 0; i < packetWidth; ++i)
+		{
+			const float a = (2.0f * b2_pi * (first + i)) / rayCount;
+			ends[i] = origin + 50.0f * b2Vec2(std::cos(a), std::sin(a));
+			callbacks[i] = &packetCallbacks[i];
+		}
+
+		index.RayCastPacket(callbacks.data(), origin, ends.data(), packetWidth, kernel);
+
+		for (int i = 0; i < packetWidth; ++i)
+		{
+			CollectHits single;
+			index.RayCast(single, origin, ends[i]);
+
+			auto packetHits = packetCallbacks[i].hits;
+			auto singleHits = single.hits;
+
+			std::sort(packetHits.begin(), packetHits.end());
+			std::sort(singleHits.begin(), singleHits.end());
+
+			REQUIRE(packetHits == singleHits);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include <catch.hpp>
+
+#include "Quiver/Misc/Logging.h"
+#include "Quiver/World/SectorGraph.h"
+
+using namespace qvr;
+
+namespace {
+
+b2AABB Box(const float minX, const float minY, const float maxX, const float maxY) {
+	b2AABB box;
+	box.lowerBound.Set(minX, minY);
+	box.upperBound.Set(maxX, maxY);
+	return box;
+}
+
+}
+
+TEST_CASE("SectorGraph", "[World]")
+{
+	qvr::InitLoggers(spdlog::level::off);
+
+	SectorGraph sectors;
+
+	REQUIRE(sectors.IsEmpty());
+
+	// Two rooms side by side, and a third north of the second.
+	REQUIRE(sectors.AddSector(Box(0.0f, 0.0f, 10.0f, 10.0f), "West") == 0);
+	REQUIRE(sectors.AddSector(Box(10.0f, 0.0f, 20.0f, 10.0f), "East") == 1);
+	REQUIRE(sectors.AddSector(Box(10.0f, 10.0f, 20.0f, 20.0f), "North") == 2);
+
+	SECTION("Sectors can't overlap or be empty") {
+		REQUIRE(sectors.AddSector(Box(5.0f, 5.0f, 15.0f, 15.0f)) == -1);
+		REQUIRE(sectors.AddSector(Box(30.0f, 0.0f, 30.0f, 10.0f)) == -1);
+		REQUIRE(sectors.GetSectorCount() == 3);
+	}
+
+	SECTION("Points are in the sector that contains them") {
+		REQUIRE(sectors.GetSectorAt(b2Vec2(5.0f, 5.0f)) == 0);
+		REQUIRE(sectors.GetSectorAt(b2Vec2(15.0f, 15.0f)) == 2);
+		REQUIRE(sectors.GetSectorAt(b2Vec2(-5.0f, 5.0f)) == -1);
+	}
+
+	SECTION("Nothing gets through an edge without a portal") {
+		REQUIRE(sectors.GetPortalCount() == 0);
+
+		REQUIRE(sectors.Clip(b2Vec2(5.0f, 5.0f), b2Vec2(15.0f, 5.0f), 0) == Approx(0.5f));
+		REQUIRE_FALSE(sectors.CanSee(b2Vec2(5.0f, 5.0f), b2Vec2(15.0f, 5.0f)));
+		REQUIRE(sectors.CanSee(b2Vec2(2.0f, 2.0f), b2Vec2(8.0f, 8.0f)));
+	}
+
+	SECTION("Nothing blocks a segment that starts outside every sector") {
+		REQUIRE(sectors.Clip(b2Vec2(-5.0f, 5.0f), b2Vec2(15.0f, 5.0f), -1) == 1.0f);
+		REQUIRE(sectors.CanSee(b2Vec2(-5.0f, 5.0f), b2Vec2(15.0f, 5.0f)));
+	}
+
+	SECTION("Portals get derived along shared edges") {
+		REQUIRE(sectors.DeriveAllPortals() == 2);
+		REQUIRE(sectors.GetPortalCount() == 2);
+		REQUIRE(sectors.DeriveAllPortals() == 0);
+
+		REQUIRE(sectors.GetSector(1).portals.size() == 2);
+		REQUIRE(sectors.GetSector(0).portals.size() == 1);
+
+		SECTION("Segments go from sector to sector through portals") {
+			REQUIRE(sectors.CanSee(b2Vec2(5.0f, 5.0f), b2Vec2(15.0f, 5.0f)));
+			REQUIRE(sectors.CanSee(b2Vec2(15.0f, 5.0f), b2Vec2(15.0f, 15.0f)));
+
+			// West to North goes through East, along the way.
+			REQUIRE(sectors.CanSee(b2Vec2(5.0f, 1.0f), b2Vec2(19.0f, 19.0f)));
+
+			// West to North straight across the corner West shares with nothing.
+			REQUIRE(sectors.Clip(b2Vec2(5.0f, 5.0f), b2Vec2(15.0f, 15.0f), 0) == Approx(0.5f));
+
+			// Out of the world entirely.
+			REQUIRE(sectors.Clip(b2Vec2(15.0f, 5.0f), b2Vec2(25.0f, 5.0f), 1) == Approx(0.5f));
+		}
+
+		SECTION("Removing a sector takes its portals with it") {
+			REQUIRE(sectors.RemoveSector(0));
+			REQUIRE(sectors.GetSectorCount() == 2);
+			REQUIRE(sectors.GetPortalCount() == 1);
+			REQUIRE(sectors.GetSector(0).name == "East");
+
+			const SectorGraph::Portal& portal = sectors.GetPortal(0);
+			REQUIRE(((portal.sectors[0] == 0 && portal.sectors[1] == 1) ||
+				(portal.sectors[0] == 1 && portal.sectors[1] == 0)));
+			REQUIRE(sectors.GetSector(0).portals.size() == 1);
+		}
+
+		SECTION("JSON round trip") {
+			SectorGraph copy;
+			REQUIRE(copy.FromJson(sectors.ToJson()));
+
+			REQUIRE(copy.GetSectorCount() == 3);
+			REQUIRE(copy.GetPortalCount() == 2);
+			REQUIRE(copy.GetSector(2).name == "North");
+			REQUIRE(copy.GetSector(2).bounds.upperBound.y == Approx(20.0f));
+			REQUIRE(copy.CanSee(b2Vec2(5.0f, 1.0f), b2Vec2(19.0f, 19.0f)));
+
+			REQUIRE_FALSE(copy.FromJson(nlohmann::json::array()));
+			REQUIRE(copy.IsEmpty());
+		}
+	}
+
+	SECTION("Portals can cover part of an edge") {
+		REQUIRE(sectors.AddPortal(0, 1, b2Vec2(10.0f, 4.0f), b2Vec2(10.0f, 6.0f)) == 0);
+		REQUIRE(sectors.AddPortal(0, 2, b2Vec2(10.0f, 12.0f), b2Vec2(10.0f, 14.0f)) == -1);
+		REQUIRE(sectors.AddPortal(0, 1, b2Vec2(10.0f, 8.0f), b2Vec2(10.0f, 12.0f)) == -1);
+
+		REQUIRE(sectors.CanSee(b2Vec2(5.0f, 5.0f), b2Vec2(15.0f, 5.0f)));
+		REQUIRE_FALSE(sectors.CanSee(b2Vec2(5.0f, 1.0f), b2Vec2(15.0f, 1.0f)));
+	}
+
+	SECTION("The generation changes along with the graph") {
+		const unsigned generation = sectors.GetGeneration();
+
+		sectors.DeriveAllPortals();
+		REQUIRE(sectors.GetGeneration() != generation);
+
+		SectorGraph other;
+		REQUIRE(other.GetGeneration() != sectors.GetGeneration());
+	}
+}
\ No newline at end of file
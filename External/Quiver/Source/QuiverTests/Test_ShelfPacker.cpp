@@ -0,0 +1,82 @@
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "Quiver/Graphics/ShelfPacker.h"
+
+using namespace qvr;
+
+namespace {
+
+struct PackedRect {
+	unsigned x, y, width, height;
+};
+
+bool Overlap(const PackedRect& a, const PackedRect& b) {
+	return
+		a.x < b.x + b.width && b.x < a.x + a.width &&
+		a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+}
+
+TEST_CASE("ShelfPacker", "[Graphics]")
+{
+	ShelfPacker packer(256, 256);
+
+	unsigned x, y;
+
+	SECTION("Things that are too big don't fit") {
+		REQUIRE_FALSE(packer.Insert(257, 1, x, y));
+		REQUIRE_FALSE(packer.Insert(1, 257, x, y));
+		REQUIRE(packer.Insert(256, 256, x, y));
+		REQUIRE(x == 0);
+		REQUIRE(y == 0);
+		REQUIRE_FALSE(packer.Insert(1, 1, x, y));
+	}
+
+	SECTION("Short things go on the shortest shelf they fit on") {
+		REQUIRE(packer.Insert(200, 64, x, y));
+
+		// Not enough room left next to the first one.
+		REQUIRE(packer.Insert(100, 16, x, y));
+		REQUIRE(x == 0);
+		REQUIRE(y == 64);
+
+		REQUIRE(packer.Insert(50, 10, x, y));
+		REQUIRE(x == 100);
+		REQUIRE(y == 64);
+
+		REQUIRE(packer.Insert(50, 32, x, y));
+		REQUIRE(x == 200);
+		REQUIRE(y == 0);
+	}
+
+	SECTION("Packed rectangles stay inside and never overlap") {
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<unsigned> size(1, 40);
+
+		std::vector<PackedRect> packed;
+
+		for (int i = 0; i < 200; ++i)
+		{
+			PackedRect rect;
+			rect.width = size(rng);
+			rect.height = size(rng);
+
+			if (!packer.Insert(rect.width, rect.height, rect.x, rect.y)) continue;
+
+			REQUIRE(rect.x + rect.width <= 256);
+			REQUIRE(rect.y + rect.height <= 256);
+
+			for (const PackedRect& other : packed) {
+				REQUIRE_FALSE(Overlap(rect, other));
+			}
+
+			packed.push_back(rect);
+		}
+
+		REQUIRE(packed.size() > 20);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include "Quiver/Graphics/RenderProxyIndex.h"
+#include "Quiver/Graphics/TextureLibrary.h"
+#include "Quiver/Misc/Logging.h"
+#include "Quiver/World/TileMap.h"
+
+using namespace qvr;
+
+namespace {
+
+class CollectTileHits : public RenderProxyRayCastCallback
+{
+public:
+	struct Hit {
+		int slot;
+		b2Vec2 point;
+		b2Vec2 normal;
+		float32 fraction;
+	};
+
+	std::vector<Hit> hits;
+
+	// What ReportProxy returns. Less than 0 means 'the hit's own fraction'.
+	float32 result = 1.0f;
+
+	float32 ReportProxy(
+		const FixtureRenderData& renderData,
+		const int slot,
+		const b2Vec2& point,
+		const b2Vec2& normal,
+		float32 fraction) override
+	{
+		hits.push_back({ slot, point, normal, fraction });
+		return result < 0.0f ? fraction : result;
+	}
+};
+
+}
+
+TEST_CASE("TileMap", "[World]")
+{
+	qvr::InitLoggers(spdlog::level::off);
+
+	TileMap tileMap(10, 5);
+
+	REQUIRE(tileMap.AddType("Brick") == 0);
+	REQUIRE(tileMap.AddType("Stone") == 1);
+
+	const int slotBase = 100;
+
+	SECTION("An empty map reports nothing") {
+		CollectTileHits callback;
+		tileMap.RayCast(callback, b2Vec2(0.5f, 2.5f), b2Vec2(9.5f, 2.5f), slotBase);
+
+		REQUIRE(callback.hits.empty());
+	}
+
+	SECTION("Walls are reported where the ray crosses into them") {
+		tileMap.SetTile(5, 2, 1);
+		tileMap.SetTile(8, 2, 2);
+
+		CollectTileHits callback;
+		tileMap.RayCast(callback, b2Vec2(0.5f, 2.5f), b2Vec2(9.5f, 2.5f), slotBase);
+
+		REQUIRE(callback.hits.size() == 2);
+
+		REQUIRE(callback.hits[0].slot == slotBase);
+		REQUIRE(callback.hits[0].fraction == Approx(4.5f / 9.0f));
+		REQUIRE(callback.hits[0].point.x == Approx(5.0f));
+		REQUIRE(callback.hits[0].point.y == Approx(2.5f));
+		REQUIRE(callback.hits[0].normal.x == Approx(-1.0f));
+		REQUIRE(callback.hits[0].normal.y == Approx(0.0f));
+
+		REQUIRE(callback.hits[1].slot == slotBase + 1);
+		REQUIRE(callback.hits[1].fraction == Approx(7.5f / 9.0f));
+
+		SECTION("Returning the fraction clips the ray") {
+			CollectTileHits clipping;
+			clipping.result = -1.0f;
+			tileMap.RayCast(clipping, b2Vec2(0.5f, 2.5f), b2Vec2(9.5f, 2.5f), slotBase);
+
+			REQUIRE(clipping.hits.size() == 1);
+			REQUIRE(clipping.hits[0].slot == slotBase);
+		}
+
+		SECTION("Returning 0 stops the ray") {
+			CollectTileHits stopping;
+			stopping.result = 0.0f;
+			tileMap.RayCast(stopping, b2Vec2(9.5f, 2.5f), b2Vec2(0.5f, 2.5f), slotBase);
+
+			REQUIRE(stopping.hits.size() == 1);
+			REQUIRE(stopping.hits[0].slot == slotBase + 1);
+			REQUIRE(stopping.hits[0].normal.x == Approx(1.0f));
+		}
+
+		SECTION("Walls past maxFraction aren't reported") {
+			CollectTileHits clipped;
+			tileMap.RayCast(clipped, b2Vec2(0.5f, 2.5f), b2Vec2(9.5f, 2.5f), slotBase, 0.45f);
+
+			REQUIRE(clipped.hits.empty());
+		}
+
+		SECTION("A ray that starts inside a wall doesn't see it") {
+			CollectTileHits inside;
+			tileMap.RayCast(inside, b2Vec2(5.5f, 2.5f), b2Vec2(9.5f, 2.5f), slotBase);
+
+			REQUIRE(inside.hits.size() == 1);
+			REQUIRE(inside.hits[0].slot == slotBase + 1);
+		}
+	}
+
+	SECTION("Rays from outside the grid hit the wall they come in through") {
+		tileMap.SetTile(3, 0, 1);
+
+		CollectTileHits callback;
+		tileMap.RayCast(callback, b2Vec2(3.5f, -2.0f), b2Vec2(3.5f, 2.0f), slotBase);
+
+		REQUIRE(callback.hits.size() == 1);
+		REQUIRE(callback.hits[0].fraction == Approx(0.5f));
+		REQUIRE(callback.hits[0].normal.x == Approx(0.0f));
+		REQUIRE(callback.hits[0].normal.y == Approx(-1.0f));
+
+		CollectTileHits missing;
+		tileMap.RayCast(missing, b2Vec2(-5.0f, -2.0f), b2Vec2(-1.0f, 2.0f), slotBase);
+
+		REQUIRE(missing.hits.empty());
+	}
+
+	SECTION("Diagonal rays report walls nearest first") {
+		for (int i = 1; i < 5; ++i) {
+			tileMap.SetTile(i, i, 1);
+			tileMap.SetTile(i + 1, i, 2);
+		}
+
+		CollectTileHits callback;
+		tileMap.RayCast(callback, b2Vec2(0.2f, 0.1f), b2Vec2(9.9f, 4.9f), slotBase);
+
+		REQUIRE(!callback.hits.empty());
+
+		for (size_t i = 1; i < callback.hits.size(); ++i) {
+			REQUIRE(callback.hits[i - 1].fraction <= callback.hits[i].fraction);
+		}
+
+		// The reported point is on the edge of the tile, on the side the normal points to.
+		for (const auto& hit : callback.hits) {
+			int x, y;
+			REQUIRE(tileMap.GetTileCoords(hit.point - 0.01f * hit.normal, x, y));
+			REQUIRE(tileMap.GetTile(x, y) == hit.slot - slotBase + 1);
+		}
+	}
+
+	SECTION("Face coordinates run left to right as seen from in front") {
+		// Seen from the west, looking east, north (+y) is on the right.
+		REQUIRE(tileMap.GetFaceCoordinate(b2Vec2(5.0f, 2.25f), b2Vec2(-1.0f, 0.0f)) == Approx(0.25f));
+		REQUIRE(tileMap.GetFaceCoordinate(b2Vec2(6.0f, 2.25f), b2Vec2(1.0f, 0.0f)) == Approx(0.75f));
+		REQUIRE(tileMap.GetFaceCoordinate(b2Vec2(5.25f, 2.0f), b2Vec2(0.0f, -1.0f)) == Approx(0.75f));
+	}
+
+	SECTION("Removing a type empties its tiles and renumbers the rest") {
+		tileMap.SetTile(0, 0, 1);
+		tileMap.SetTile(1, 0, 2);
+
+		REQUIRE(tileMap.RemoveType(0));
+		REQUIRE(tileMap.GetTypeCount() == 1);
+		REQUIRE(tileMap.GetTile(0, 0) == 0);
+		REQUIRE(tileMap.GetTile(1, 0) == 1);
+	}
+
+	SECTION("Resizing keeps the tiles that are still on the grid") {
+		tileMap.SetTile(2, 1, 2);
+		tileMap.SetTile(9, 4, 1);
+
+		tileMap.Resize(4, 8);
+
+		REQUIRE(tileMap.GetWidth() == 4);
+		REQUIRE(tileMap.GetHeight() == 8);
+		REQUIRE(tileMap.GetTile(2, 1) == 2);
+	}
+
+	SECTION("The generation changes along with the map") {
+		const unsigned generation = tileMap.GetGeneration();
+
+		tileMap.SetTile(0, 0, 0);
+		REQUIRE(tileMap.GetGeneration() == generation);
+
+		tileMap.SetTile(0, 0, 1);
+		REQUIRE(tileMap.GetGeneration() != generation);
+
+		TileMap other(10, 5);
+		REQUIRE(other.GetGeneration() != tileMap.GetGeneration());
+	}
+
+	SECTION("Solid rects cover every wall exactly once") {
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> tiles(0, 2);
+
+		int solidCount = 0;
+
+		for (int y = 0; y < tileMap.GetHeight(); ++y) {
+			for (int x = 0; x < tileMap.GetWidth(); ++x) {
+				const int tile = tiles(random);
+				tileMap.SetTile(x, y, tile);
+				if (tile) solidCount++;
+			}
+		}
+
+		const std::vector<b2AABB> rects = tileMap.GetSolidRects();
+
+		REQUIRE(rects.size() <= (size_t)solidCount);
+
+		float area = 0.0f;
+		for (const b2AABB& rect : rects) {
+			const b2Vec2 extents = rect.upperBound - rect.lowerBound;
+			area += extents.x * extents.y;
+		}
+
+		REQUIRE(area == Approx((float)solidCount));
+
+		for (int y = 0; y < tileMap.GetHeight(); ++y) {
+			for (int x = 0; x < tileMap.GetWidth(); ++x) {
+				const b2Vec2 centre((float)x + 0.5f, (float)y + 0.5f);
+
+				int coveredBy = 0;
+				for (const b2AABB& rect : rects) {
+					if (centre.x > rect.lowerBound.x && centre.x < rect.upperBound.x &&
+						centre.y > rect.lowerBound.y && centre.y < rect.upperBound.y)
+					{
+						coveredBy++;
+					}
+				}
+
+				REQUIRE(coveredBy == (tileMap.GetTile(x, y) ? 1 : 0));
+			}
+		}
+	}
+
+	SECTION("JSON round trip") {
+		tileMap.SetTile(4, 3, 2);
+		tileMap.SetTypeHeight(1, 2.5f);
+		tileMap.SetTypeOpaque(0, false);
+
+		TextureLibrary textureLibrary;
+
+		const auto copy = TileMap::FromJson(tileMap.ToJson(), textureLibrary);
+
+		REQUIRE(copy);
+		REQUIRE(copy->GetWidth() == 10);
+		REQUIRE(copy->GetHeight() == 5);
+		REQUIRE(copy->GetTypeCount() == 2);
+		REQUIRE(copy->GetType(1).name == "Stone");
+		REQUIRE(copy->GetType(1).renderData.GetHeight() == Approx(2.5f));
+		REQUIRE(copy->ToJson()["Types"][0]["Opaque"] == false);
+		REQUIRE(copy->GetTile(4, 3) == 2);
+		REQUIRE(copy->GetTile(3, 4) == 0);
+
+		REQUIRE_FALSE(TileMap::FromJson(nlohmann::json::object(), textureLibrary));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include <catch.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "Quiver/Misc/WorkerPool.h"
+
+using namespace qvr;
+
+TEST_CASE("WorkerPool", "[Misc]")
+{
+	for (const unsigned threadCount : { 1u, 2u, 4u })
+	{
+		WorkerPool pool(threadCount);
+
+		REQUIRE(pool.GetThreadCount() == threadCount);
+
+		SECTION("ParallelFor visits every index exactly once") {
+			for (const unsigned count : { 0u, 1u, 15u, 16u, 17u, 1000u })
+			{
+				std::vector<std::atomic<int>> visits(count);
+				for (auto& v : visits) v = 0;
+
+				// Catch's assertion macros aren't thread-safe, so just record what happened.
+				pool.ParallelFor(count, 16, [&visits](const unsigned begin, const unsigned end)
+				{
+					for (unsigned i = begin; i < end; ++i) {
+						visits[i]++;
+					}
+				});
+
+				for (auto& v : visits) {
+					REQUIRE(v == 1);
+				}
+			}
+		}
+
+		SECTION("ParallelFor can be called repeatedly") {
+			std::atomic<unsigned> total{ 0 };
+
+			for (int i = 0; i < 100; ++i) {
+				pool.ParallelFor(64, 4, [&total](const unsigned begin, const unsigned end)
+				{
+					total += end - begin;
+				});
+			}
+
+			REQUIRE(total == 6400);
+		}
+
+		SECTION("ParallelForAsync visits every index exactly once, with or without help") {
+			for (const bool help : { false, true })
+			{
+				std::vector<std::atomic<int>> visits(1000);
+				for (auto& v : visits) v = 0;
+
+				pool.ParallelForAsync(1000, 16, [&visits](const unsigned begin, const unsigned end)
+				{
+					for (unsigned i = begin; i < end; ++i) {
+						visits[i]++;
+					}
+				});
+
+				if (help) {
+					while (pool.RunChunk()) {}
+				}
+
+				pool.Wait();
+
+				for (auto& v : visits) {
+					REQUIRE(v == 1);
+				}
+
+				// Nothing left once Wait returns.
+				pool.ParallelFor(16, 16, [](unsigned, unsigned) {});
+			}
+		}
+	}
+}
\ No newline at end of file
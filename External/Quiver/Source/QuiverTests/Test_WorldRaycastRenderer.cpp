@@ -0,0 +1,133 @@
+#include <catch.hpp>
+
+#include <SFML/Graphics/Image.hpp>
+
+#include "Quiver/Entity/CustomComponent/CustomComponent.h"
+#include "Quiver/Graphics/Camera3D.h"
+#include "Quiver/Graphics/FixtureRenderData.h"
+#include "Quiver/Graphics/ParticleSystem.h"
+#include "Quiver/Graphics/RenderProxyIndex.h"
+#include "Quiver/Graphics/WorldRaycastRenderer.h"
+#include "Quiver/Misc/Logging.h"
+#include "Quiver/World/TileMap.h"
+#include "Quiver/World/World.h"
+#include "Quiver/World/WorldContext.h"
+
+using namespace qvr;
+
+TEST_CASE("WorldRaycastRenderer draws a World into an sf::Image without GL", "[Graphics]")
+{
+	qvr::InitLoggers(spdlog::level::off);
+
+	CustomComponentTypeLibrary types;
+	FixtureFilterBitNames filterBitNames;
+
+	WorldContext worldContext(types, filterBitNames);
+
+	// The atlas needs GL to draw its pages.
+	World world(
+		worldContext,
+		nlohmann::json{
+			{"SkyColour", 0x000000FFu},
+			{"GroundColour", 0x00FF00FFu},
+			{"RenderSettings", {{"UseTextureAtlas", false}, {"RaycastThreadCount", 2}}}
+		});
+
+	// A red wall right across the view, 2.5 metres in front of the camera.
+	TileMap& tileMap = world.CreateTileMap(5, 5);
+	tileMap.AddType("Brick");
+	tileMap.SetTypeColor(0, sf::Color::Red);
+	for (int x = 0; x < 5; ++x) {
+		tileMap.SetTile(x, 3, 1);
+	}
+
+	// Looking along +y, from the middle of the bottom row.
+	Camera3D camera;
+	camera.SetPosition(b2Vec2(2.5f, 0.5f));
+
+	// A blue speck in the middle of the view, half way to the wall.
+	ParticleEmitter emitter;
+	emitter.position = b2Vec2(2.5f, 2.0f);
+	emitter.height = 0.5f;
+	emitter.size = 0.2f;
+	emitter.lifetime = 10.0f;
+	emitter.color = sf::Color::Blue;
+	world.GetParticles().Emit(emitter, 1);
+
+	// More than one chunk of columns.
+	sf::Image image;
+	image.create(64, 64);
+
+	WorldRaycastRenderer renderer;
+
+	world.Render3D(image, camera, renderer);
+
+	REQUIRE(image.getSize() == sf::Vector2u(64, 64));
+
+	// Sky above the wall, and ground below it.
+	CHECK(image.getPixel(3, 0) == sf::Color::Black);
+	CHECK(image.getPixel(60, 63) == sf::Color::Green);
+
+	// The wall, a little fogged, in every column.
+	const auto checkWall = [&image]() {
+		for (unsigned x = 0; x < 64; x += 7) {
+			const sf::Color wall = image.getPixel(x, 24);
+			CHECK(wall.r > 200);
+			CHECK((int)wall.r - (int)wall.b > 100);
+		}
+	};
+
+	checkWall();
+
+	// The particle, in front of it.
+	CHECK(image.getPixel(32, 32) == sf::Color::Blue);
+
+	SECTION("Rendering again gives the same image") {
+		sf::Image again;
+		again.create(64, 64);
+
+		world.Render3D(again, camera, renderer);
+
+		for (unsigned y = 0; y < 64; ++y) {
+			for (unsigned x = 0; x < 64; ++x) {
+				REQUIRE(again.getPixel(x, y) == image.getPixel(x, y));
+			}
+		}
+	}
+
+	SECTION("Cached walls stay put when dynamic proxies come and go") {
+		REQUIRE(world.GetRenderSettings().m_IncrementalRaycast);
+
+		// White, and behind the camera, so it never shows up itself.
+		FixtureRenderData billboardData;
+
+		const RenderProxyId billboard =
+			world.GetRenderProxies().AddBillboard(b2Vec2(2.5f, -1.0f), 0.5f, billboardData);
+
+		world.Render3D(image, camera, renderer);
+
+		checkWall();
+
+		// Cast the walls again, with the billboard taking up a slot.
+		camera.SetPosition(b2Vec2(2.5f, 0.6f));
+
+		world.Render3D(image, camera, renderer);
+
+		checkWall();
+
+		REQUIRE(world.GetRenderProxies().Remove(billboard));
+
+		world.Render3D(image, camera, renderer);
+
+		checkWall();
+	}
+
+	SECTION("Turning round shows the sky and ground only") {
+		camera.SetRotation(b2_pi);
+
+		world.Render3D(image, camera, renderer);
+
+		CHECK(image.getPixel(32, 24) == sf::Color::Black);
+		CHECK(image.getPixel(32, 40) == sf::Color::Green);
+	}
+}
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include <algorithm>
 #include <cassert>
 
+#include <Box2D/Common/b2Math.h>
 #include <Quiver/Entity/RenderComponent/RenderComponent.h>
+#include <Quiver/Graphics/ParticleSystem.h>
 
 #include "Damage.h"
 #include "MovementSpeed.h"
@@ -181,3 +183,72 @@ void ApplyEffect(const ActiveEffect & effect, qvr::RenderComponent & renderCompo
 				sf::Color::Blue));
 	}
 }
+
+
+void ApplyEffect(
+	const ActiveEffect& effect,
+	const b2Vec2& position,
+	const std::chrono::duration<float> deltaTime,
+	qvr::ParticleSystem& particles)
+{
+	qvr::ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.positionSpread = 0.2f;
+	emitter.heightSpread = 0.3f;
+
+	switch (effect.type)
+	{
+	case +ActiveEffectType::None: assert(false); break;
+	case +ActiveEffectType::Burning:
+	{
+		// Flames that flicker upwards and shrink away...
+		emitter.height = 0.35f;
+		emitter.velocitySpread = 0.1f;
+		emitter.verticalVelocity = 0.3f;
+		emitter.verticalVelocitySpread = 0.15f;
+		emitter.gravity = -0.5f;
+		emitter.lifetime = 0.5f;
+		emitter.lifetimeSpread = 0.2f;
+		emitter.size = 0.06f;
+		emitter.growth = -0.08f;
+		emitter.color = sf::Color(255, 140, 40);
+		particles.EmitOverTime(emitter, 60.0f, deltaTime.count());
+
+		// ...and smoke that drifts up over them.
+		emitter.height = 0.6f;
+		emitter.verticalVelocity = 0.2f;
+		emitter.gravity = -0.1f;
+		emitter.lifetime = 1.2f;
+		emitter.size = 0.05f;
+		emitter.growth = 0.1f;
+		emitter.color = sf::Color(60, 60, 60, 128);
+		particles.EmitOverTime(emitter, 15.0f, deltaTime.count());
+		break;
+	}
+	case +ActiveEffectType::Poisoned:
+	{
+		emitter.height = 0.4f;
+		emitter.velocitySpread = 0.05f;
+		emitter.verticalVelocity = 0.2f;
+		emitter.verticalVelocitySpread = 0.05f;
+		emitter.lifetime = 0.8f;
+		emitter.lifetimeSpread = 0.3f;
+		emitter.size = 0.04f;
+		emitter.color = sf::Color(80, 220, 60, 200);
+		particles.EmitOverTime(emitter, 12.0f, deltaTime.count());
+		break;
+	}
+	case +ActiveEffectType::Frozen:
+	{
+		emitter.height = 0.6f;
+		emitter.velocitySpread = 0.05f;
+		emitter.gravity = 0.3f;
+		emitter.lifetime = 1.0f;
+		emitter.lifetimeSpread = 0.3f;
+		emitter.size = 0.03f;
+		emitter.color = sf::Color(200, 230, 255, 220);
+		particles.EmitOverTime(emitter, 10.0f, deltaTime.count());
+		break;
+	}
+	}
+}
@@ -5,8 +5,11 @@
 
 #include "External/enum.h"
 
+struct b2Vec2;
+
 namespace qvr
 {
+class ParticleSystem;
 class RenderComponent;
 }
 
@@ -46,4 +49,11 @@ bool UpdateEffect(ActiveEffect& activeEffect, const std::chrono::duration<float>
 
 void ApplyEffect(const ActiveEffect& activeEffect, DamageCount& damage);
 void ApplyEffect(const ActiveEffect& effect, MovementSpeed& speed);
-void ApplyEffect(const ActiveEffect& effect, qvr::RenderComponent& renderComponent);
\ No newline at end of file
+void ApplyEffect(const ActiveEffect& effect, qvr::RenderComponent& renderComponent);
+
+// Gives off whatever particles the effect makes, from something standing at position.
+void ApplyEffect(
+	const ActiveEffect& effect,
+	const b2Vec2& position,
+	const std::chrono::duration<float> deltaTime,
+	qvr::ParticleSystem& particles);
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include "Damage.h"
 #include "Effects.h"
 #include "FirePropagation.h"
+#include "ParticleBursts.h"
 #include "Misc/GuiUtils.h"
 #include "Misc/Utils.h"
 #include "Player/CrossbowBolt.h"
@@ -50,6 +51,11 @@ public:
 		b2Fixture& myFixture, 
 		b2Fixture& otherFixture) override
 	{
+		EmitImpactSparks(
+			GetEntity().GetWorld().GetParticles(),
+			GetEntity().GetPhysics()->GetPosition(),
+			GetEntity().GetGraphics()->GetColor());
+
 		this->SetRemoveFlag(true);
 	}
 
@@ -271,6 +277,11 @@ void Enemy::OnStep(const std::chrono::duration<float> timestep)
 			ApplyEffect(effect, m_Damage);
 		}
 		ApplyEffect(effect, *GetEntity().GetGraphics());
+		ApplyEffect(
+			effect,
+			GetEntity().GetPhysics()->GetPosition(),
+			timestep,
+			GetEntity().GetWorld().GetParticles());
 	}
 
 	RemoveExpiredEffects(m_ActiveEffects);
@@ -279,6 +290,10 @@ void Enemy::OnStep(const std::chrono::duration<float> timestep)
 	{
 		log->debug("{} Dying - received {}/{} damage", logCtx, m_Damage.damage, m_Damage.max);
 		SetAnimation(m_DieAnim, AnimatorRepeatSetting::Never);
+		EmitDeathBurst(
+			GetEntity().GetWorld().GetParticles(),
+			GetEntity().GetPhysics()->GetPosition(),
+			sf::Color(120, 20, 20));
 		GetEntity().GetPhysics()->GetBody().DestroyFixture(m_Sensor);
 		// Remove the CustomComponent, but not the Entity.
 		GetEntity().AddCustomComponent(nullptr);
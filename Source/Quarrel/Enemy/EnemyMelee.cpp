@@ -16,6 +16,7 @@
 #include "FirePropagation.h"
 #include "Gravity.h"
 #include "MovementSpeed.h"
+#include "ParticleBursts.h"
 #include "Misc/GuiUtils.h"
 #include "Misc/Utils.h"
 
@@ -221,12 +222,22 @@ void EnemyMelee::OnStep(const seconds deltaTime)
 		}
 		ApplyEffect(effect, *GetEntity().GetGraphics());
 		ApplyEffect(effect, movementSpeed);
+		ApplyEffect(
+			effect,
+			GetEntity().GetPhysics()->GetPosition(),
+			deltaTime,
+			GetEntity().GetWorld().GetParticles());
 	}
 
 	RemoveExpiredEffects(activeEffects);
 
 	if (HasExceededLimit(damageCounter)) {
 		DestroyAttackSwipeFixture();
+
+		EmitDeathBurst(
+			GetEntity().GetWorld().GetParticles(),
+			GetEntity().GetPhysics()->GetPosition(),
+			sf::Color(120, 20, 20));
 		
 		GetEntity().GetGraphics()->SetAnimation(
 			dieAnimation,
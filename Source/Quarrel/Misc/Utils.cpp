@@ -43,13 +43,12 @@ uint16 GetMaskBits(const b2Fixture& fixture) {
 
 qvr::CustomComponent* GetCustomComponent(const b2Fixture* fixture)
 {
-	// Not every Fixture is guaranteed to have a RenderComponent,
-	// but every Body is guaranteed to have a PhysicsComponent.
-	const auto physicsComp = (qvr::PhysicsComponent*)fixture->GetBody()->GetUserData();
+	// Bodies that don't belong to an Entity, like the TileMap's, don't have one either.
+	const qvr::Entity* entity = qvr::GetEntityFromFixture(*fixture);
 
-	assert(physicsComp);
+	if (!entity) return nullptr;
 
-	return physicsComp->GetEntity().GetCustomComponent();
+	return entity->GetCustomComponent();
 }
 
 qvr::Entity* GetPlayerFromFixture(const b2Fixture* fixture)
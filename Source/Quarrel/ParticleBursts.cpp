@@ -0,0 +1,46 @@
+#include "ParticleBursts.h"
+
+#include <Box2D/Common/b2Math.h>
+#include <Quiver/Graphics/ParticleSystem.h>
+
+void EmitImpactSparks(
+	qvr::ParticleSystem& particles,
+	const b2Vec2& position,
+	const sf::Color& color)
+{
+	qvr::ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.height = 0.5f;
+	emitter.velocitySpread = 1.5f;
+	emitter.verticalVelocity = 0.5f;
+	emitter.verticalVelocitySpread = 0.8f;
+	emitter.gravity = 3.0f;
+	emitter.lifetime = 0.4f;
+	emitter.lifetimeSpread = 0.15f;
+	emitter.size = 0.02f;
+	emitter.color = color;
+
+	particles.Emit(emitter, 24);
+}
+
+void EmitDeathBurst(
+	qvr::ParticleSystem& particles,
+	const b2Vec2& position,
+	const sf::Color& color)
+{
+	qvr::ParticleEmitter emitter;
+	emitter.position = position;
+	emitter.positionSpread = 0.15f;
+	emitter.height = 0.4f;
+	emitter.heightSpread = 0.2f;
+	emitter.velocitySpread = 1.0f;
+	emitter.verticalVelocity = 1.0f;
+	emitter.verticalVelocitySpread = 0.6f;
+	emitter.gravity = 4.0f;
+	emitter.lifetime = 1.5f;
+	emitter.lifetimeSpread = 0.5f;
+	emitter.size = 0.04f;
+	emitter.color = color;
+
+	particles.Emit(emitter, 150);
+}
\ No newline at end of file
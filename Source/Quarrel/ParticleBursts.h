@@ -0,0 +1,22 @@
+#pragma once
+
+#include <SFML/Graphics/Color.hpp>
+
+struct b2Vec2;
+
+namespace qvr
+{
+class ParticleSystem;
+}
+
+// Something hit something else at position.
+void EmitImpactSparks(
+	qvr::ParticleSystem& particles,
+	const b2Vec2& position,
+	const sf::Color& color);
+
+// Something standing at position died.
+void EmitDeathBurst(
+	qvr::ParticleSystem& particles,
+	const b2Vec2& position,
+	const sf::Color& color);
\ No newline at end of file
@@ -407,6 +407,15 @@ Entity* MakeCrossbowBolt(
 		}
 
 		projRenderComp->SetAnimation(animation);
+
+		// Burning bolts light up what they fly past.
+		if (effect.appliesEffect == +ActiveEffectType::Burning)
+		{
+			PointLight light;
+			light.SetColor(sf::Color(255, 170, 80));
+			light.SetRadius(2.5f);
+			projRenderComp->SetLight(light);
+		}
 	}
 
 	// Set up CustomComponent
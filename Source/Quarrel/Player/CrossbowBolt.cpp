@@ -12,6 +12,7 @@
 #include "External/enum_json.h"
 
 #include "Misc/Utils.h"
+#include "ParticleBursts.h"
 
 using namespace qvr;
 
@@ -70,7 +71,15 @@ public:
 		lifetimeLeft -= deltaTime;
 		if (lifetimeLeft < 0s) {
 			GetEntity().GetWorld().RemoveEntityImmediate(GetEntity());
+			return;
 		}
+
+		// Gives off the same flames as anything it sets on fire.
+		ApplyEffect(
+			{ +ActiveEffectType::Burning, lifetimeLeft, 0s },
+			GetEntity().GetPhysics()->GetPosition(),
+			deltaTime,
+			GetEntity().GetWorld().GetParticles());
 	}
 
 	std::string GetTypeName() const { return "Fire"; };
@@ -95,6 +104,14 @@ void CrossbowBolt::OnStep(const std::chrono::duration<float> deltaTime)
 		renderComp.SetHeight(1.0f);
 		renderComp.SetGroundOffset(0.0f);
 		renderComp.SetColor(sf::Color::White);
+
+		{
+			PointLight light;
+			light.SetColor(sf::Color(255, 150, 60));
+			light.SetRadius(4.0f);
+			light.SetIntensity(1.5f);
+			renderComp.SetLight(light);
+		}
 		
 		PhysicsComponent& physicsComp = *GetEntity().GetPhysics();
 
@@ -113,6 +130,11 @@ void CrossbowBolt::OnStep(const std::chrono::duration<float> deltaTime)
 	}
 	else
 	{
+		EmitImpactSparks(
+			GetEntity().GetWorld().GetParticles(),
+			GetEntity().GetPhysics()->GetPosition(),
+			sf::Color(255, 230, 180));
+
 		GetEntity().GetWorld().RemoveEntityImmediate(GetEntity());
 	}
 }